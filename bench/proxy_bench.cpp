@@ -0,0 +1,229 @@
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "core/topology/cpu_topology.h"
+
+/*
+ * proxy_bench: closed-loop HTTP/1.1 throughput check for the proxies.
+ *
+ *   proxy_bench serve <port> [body_bytes] [threads]
+ *       Backend that answers every request with a fixed 200 and closes.
+ *
+ *   proxy_bench load <port> [connections] [seconds]
+ *       Each connection: connect, send GET, read until close, repeat.
+ *       Prints completed requests per second. Not keep-alive: every
+ *       request pays a fresh connect to the proxy, since coro_proxy
+ *       serves one request per connection.
+ *
+ *   proxy_bench numa [megabytes]
+ *       Dependent-load latency from every node's CPUs to every node's
+ *       memory: what a connection pays when its buffers live on the
+ *       other socket. Pair it with the proxy's "[numa] remote=" count.
+ *
+ * Typical run (backend on 19100, proxy configured with backend_port=19100):
+ *   proxy_bench serve 19100 &
+ *   echo_cm bench.conf > /dev/null &      # or coro_proxy bench.conf
+ *   proxy_bench load 18080 64 10
+ */
+
+static int connect_to(uint16_t port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    sockaddr_in sa{};
+    sa.sin_family = AF_INET;
+    sa.sin_port = htons(port);
+    sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&sa), sizeof(sa)) < 0) {
+        ::close(fd);
+        return -1;
+    }
+    int one = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+static int serve(uint16_t port, size_t body_bytes, int threads) {
+    int lfd = ::socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    ::setsockopt(lfd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    sockaddr_in sa{};
+    sa.sin_family = AF_INET;
+    sa.sin_port = htons(port);
+    sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::bind(lfd, reinterpret_cast<sockaddr*>(&sa), sizeof(sa)) < 0 ||
+        ::listen(lfd, 4096) < 0) {
+        std::cerr << "serve: cannot listen on " << port << "\n";
+        return 1;
+    }
+
+    std::string response = "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nContent-Length: " +
+                           std::to_string(body_bytes) + "\r\nConnection: close\r\n\r\n" +
+                           std::string(body_bytes, 'x');
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([lfd, &response] {
+            char buf[4096];
+            while (true) {
+                int fd = ::accept(lfd, nullptr, nullptr);
+                if (fd < 0) {
+                    continue;
+                }
+                std::string req;
+                ssize_t n;
+                while ((n = ::read(fd, buf, sizeof(buf))) > 0) {
+                    req.append(buf, n);
+                    if (req.find("\r\n\r\n") != std::string::npos) {
+                        break;
+                    }
+                }
+                (void)!::write(fd, response.data(), response.size());
+                ::close(fd);
+            }
+        });
+    }
+    for (auto& w : workers) {
+        w.join();
+    }
+    return 0;
+}
+
+static int load(uint16_t port, int conns, int seconds) {
+    static const char kRequest[] = "GET / HTTP/1.1\r\nHost: bench\r\n\r\n";
+
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> done{0};
+    std::atomic<uint64_t> errors{0};
+
+    std::vector<std::thread> clients;
+    for (int c = 0; c < conns; ++c) {
+        clients.emplace_back([&] {
+            char buf[16384];
+            while (!stop.load(std::memory_order_relaxed)) {
+                int fd = connect_to(port);
+                if (fd < 0) {
+                    errors.fetch_add(1);
+                    continue;
+                }
+                bool ok = ::write(fd, kRequest, sizeof(kRequest) - 1) > 0;
+                size_t got = 0;
+                ssize_t n;
+                while (ok && (n = ::read(fd, buf, sizeof(buf))) > 0) {
+                    got += n;
+                }
+                ::close(fd);
+                (ok && got > 0 ? done : errors).fetch_add(1);
+            }
+        });
+    }
+
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+    stop = true;
+    for (auto& t : clients) {
+        t.join();
+    }
+
+    std::cout << "requests=" << done.load() << " errors=" << errors.load()
+              << " rps=" << done.load() / seconds << "\n";
+    return 0;
+}
+
+// Random cyclic walk over a buffer much larger than the caches, so every
+// step is a dependent miss served by the memory under test
+static double chase_ns(const CpuTopology& topo, int cpu_node, int mem_node, size_t mb) {
+    double ns = 0;
+    std::thread t([&] {
+        // First touch while preferring mem_node places the pages there
+        topo.bind_current_thread(mem_node);
+        size_t n = (mb << 20) / sizeof(uint32_t);
+        std::vector<uint32_t> next(n);
+        for (size_t i = 0; i < n; ++i) {
+            next[i] = static_cast<uint32_t>(i);
+        }
+        uint64_t seed = 88172645463325252ull;
+        for (size_t i = n - 1; i > 0; --i) {       // Sattolo: one single cycle
+            seed ^= seed << 13;
+            seed ^= seed >> 7;
+            seed ^= seed << 17;
+            size_t j = seed % i;
+            std::swap(next[i], next[j]);
+        }
+
+        topo.bind_current_thread(cpu_node);
+        const size_t steps = 10000000;
+        uint32_t p = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < steps; ++i) {
+            p = next[p];
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        ns = std::chrono::duration<double, std::nano>(elapsed).count() / steps;
+
+        volatile uint32_t sink = p;     // keep the walk from being optimized out
+        (void)sink;
+    });
+    t.join();
+    return ns;
+}
+
+static int numa(size_t mb) {
+    CpuTopology topo;
+    if (!topo.load()) {
+        std::cerr << "numa: cannot read CPU topology\n";
+        return 1;
+    }
+
+    std::cout << "nodes=" << topo.node_count() << " buffer_mb=" << mb << "\n";
+    for (size_t cpu = 0; cpu < topo.node_count(); ++cpu) {
+        if (topo.cpus(static_cast<int>(cpu)).empty()) {
+            continue;
+        }
+        for (size_t mem = 0; mem < topo.node_count(); ++mem) {
+            std::cout << "cpu_node=" << cpu << " mem_node=" << mem << " ns_per_load="
+                      << chase_ns(topo, static_cast<int>(cpu), static_cast<int>(mem), mb)
+                      << (cpu == mem ? "" : "  (remote)") << "\n";
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc >= 2 && std::string(argv[1]) == "numa") {
+        return numa(argc > 2 ? std::atoi(argv[2]) : 256);
+    }
+    if (argc < 3) {
+        std::cerr << "usage: proxy_bench serve <port> [body_bytes] [threads]\n"
+                  << "       proxy_bench load <port> [connections] [seconds]\n"
+                  << "       proxy_bench numa [megabytes]\n";
+        return 2;
+    }
+
+    std::string mode = argv[1];
+    uint16_t port = static_cast<uint16_t>(std::atoi(argv[2]));
+
+    if (mode == "serve") {
+        return serve(port, argc > 3 ? std::atoi(argv[3]) : 1024, argc > 4 ? std::atoi(argv[4]) : 4);
+    }
+    if (mode == "load") {
+        return load(port, argc > 3 ? std::atoi(argv[3]) : 32, argc > 4 ? std::atoi(argv[4]) : 5);
+    }
+
+    std::cerr << "unknown mode " << mode << "\n";
+    return 2;
+}
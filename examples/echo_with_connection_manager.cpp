@@ -1,45 +1,611 @@
+#include <chrono>
+#include <csignal>
+#include <cstring>
 #include <iostream>
+#include <memory>
+#include <vector>
+#include <arpa/inet.h>
 #include <errno.h>
+#include <unistd.h>
 
+#include "admin/admin_server.h"
+#include "admin/json_writer.h"
+#include "admission/admission_control.h"
+#include "admission/rate_limiter.h"
+#include "balancer/outlier_detector.h"
+#include "config/config.h"
+#include "config/config_reloader.h"
 #include "core/event_loop/epoll_loop.h"
+#include "core/event_loop/signal_fd.h"
+#include "core/executor/work_stealing_pool.h"
 #include "core/socket/acceptor.h"
+#include "core/socket/socket.h"
+#include "core/topology/cpu_topology.h"
 #include "connection/connection_manager.h"
+#include "dns/dns_resolver.h"
+#include "stats/shm_stats.h"
+#ifdef PROXY_TLS
+#include "tls/tls_context.h"
+#endif
+#include "trace/trace_writer.h"
+#include "access_log/access_log_writer.h"
+#include "upgrade/handoff.h"
 
-int main() {
-    Acceptor acceptor;
-    acceptor.listen(8080);
+/*
+ * Usage: echo_cm [config_file]
+ *
+ * Without a config file the built-in defaults are used.
+ * With one, SIGHUP reloads it without dropping connections.
+ *
+ * If upgrade_socket is set, starting a second instance with the same
+ * config takes over the listening socket from the running one, which
+ * then stops accepting and drains for up to drain_timeout_ms. The admin
+ * port follows once the old process has let go of it.
+ *
+ * SIGTERM or SIGINT starts the same drain without a successor; a second
+ * one closes whatever is left immediately.
+ *
+ * SIGUSR1 reopens access_log, after an external tool has moved it away.
+ *
+ * On a multi-socket host, run one instance per NUMA node, started in node
+ * order, each with its own numa_node and reuseport = on.
+ */
+// How often a new process retries an admin port its predecessor still holds
+static constexpr uint64_t kAdminRetryMs = 1000;
+// How long the listener stays paused after accept runs out of fds
+static constexpr uint64_t kAcceptBackoffMs = 100;
+
+static uint64_t steady_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// One line per interval; each line covers only that interval
+static void log_loop_stats(EpollLoop& loop) {
+    const LoopStats& st = loop.stats();
+    std::cout << "[loop] iterations=" << st.iterations
+              << " batch p50/p99/max=" << st.batch.percentile(0.5) << "/"
+              << st.batch.percentile(0.99) << "/" << st.batch.max()
+              << " wait_us p50/p99=" << st.wait_us.percentile(0.5) << "/"
+              << st.wait_us.percentile(0.99)
+              << " busy_us p50/p99/max=" << st.busy_us.percentile(0.5) << "/"
+              << st.busy_us.percentile(0.99) << "/" << st.busy_us.max()
+              << " capacity=" << loop.batch_capacity()
+              << " grows=" << st.grows << " shrinks=" << st.shrinks
+              << " spins=" << st.spins << "\n";
+    loop.reset_stats();
+}
+
+// Current window of the same histograms, for the admin endpoint
+static void write_loop_stats(JsonWriter& out, const EpollLoop& loop) {
+    const LoopStats& st = loop.stats();
+    out.key("loop").begin_object();
+    out.key("iterations").value(st.iterations);
+    out.key("batch_p50").value(st.batch.percentile(0.5));
+    out.key("batch_p99").value(st.batch.percentile(0.99));
+    out.key("batch_max").value(st.batch.max());
+    out.key("wait_us_p50").value(st.wait_us.percentile(0.5));
+    out.key("wait_us_p99").value(st.wait_us.percentile(0.99));
+    out.key("busy_us_p50").value(st.busy_us.percentile(0.5));
+    out.key("busy_us_p99").value(st.busy_us.percentile(0.99));
+    out.key("busy_us_max").value(st.busy_us.max());
+    out.key("capacity").value(loop.batch_capacity());
+    out.key("spins").value(st.spins);
+    out.key("wakeups").value(loop.wakeups());
+    out.end_object();
+}
+
+// Counters and the connection table for proxy_top; table is scratch
+// space reused between calls
+static void publish_shm_stats(ShmStatsWriter& shm, const ConnectionManager& manager,
+                              std::vector<ShmConnEntry>& table) {
+    uint64_t now = steady_ms();
+    const TrafficStats& t = manager.traffic();
+
+    ShmCounters c{};
+    c.updated_unix_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    c.accepted = t.accepted;
+    c.requests = t.requests;
+    for (int i = 0; i < 6; ++i)
+        c.responses[i] = t.responses[i];
+    c.bytes_in = t.bytes_in;
+    c.bytes_out = t.bytes_out;
+    c.retries_granted = manager.retry_budget().granted();
+    c.retries_denied = manager.retry_budget().denied();
+#ifdef PROXY_TLS
+    if (const TlsContext* tls = manager.tls()) {
+        const TlsStats& ts = tls->stats();
+        c.tls_handshakes = ts.handshakes;
+        c.tls_handshake_failures = ts.handshake_failures;
+        c.tls_resumed = ts.resumed;
+        c.tls_handshake_ns = ts.handshake_ns;
+        c.tls_ktls_tx = ts.ktls_tx;
+        c.tls_ktls_rx = ts.ktls_rx;
+    }
+#endif
+    c.active = static_cast<uint32_t>(manager.active_count());
+    c.tunnels = static_cast<uint32_t>(manager.tunnel_count());
+    c.draining = manager.draining() ? 1 : 0;
+
+    table.clear();
+    manager.for_each_connection([&](const Connection& conn) {
+        if (table.size() == shm.conn_slots())
+            return;
+        ShmConnEntry e{};
+        e.bytes_in = conn.bytes_in_;
+        e.bytes_out = conn.bytes_out_;
+        e.conn_id = conn.trace_.conn_id;
+        e.age_ms = static_cast<uint32_t>(now - conn.accepted_ms_);
+        e.upstream_addr = conn.upstream_addr_;
+        e.upstream_port = conn.upstream_port_;
+        e.state = static_cast<uint8_t>(conn.state_);
+        e.fd = conn.client_fd();
+        if (conn.peer_.ss_family == AF_INET) {
+            e.family = AF_INET;
+            std::memcpy(e.client, &reinterpret_cast<const sockaddr_in&>(conn.peer_).sin_addr, 4);
+        } else if (conn.peer_.ss_family == AF_INET6) {
+            e.family = AF_INET6;
+            std::memcpy(e.client, &reinterpret_cast<const sockaddr_in6&>(conn.peer_).sin6_addr, 16);
+        }
+        table.push_back(e);
+    });
+
+    shm.publish(0, c, table.data(), table.size());
+}
+
+int main(int argc, char** argv) {
+    // A peer that vanished mid-write (or mid-splice, which has no
+    // MSG_NOSIGNAL) must surface as EPIPE, not kill the process
+    std::signal(SIGPIPE, SIG_IGN);
+
+    // Before any thread exists, so none of them can take these instead
+    SignalFd signals({SIGTERM, SIGINT, SIGUSR1});
+
+    auto initial = std::make_shared<ProxyConfig>();
+    std::string config_path = argc > 1 ? argv[1] : "";
+
+    if (!config_path.empty()) {
+        std::string err;
+        if (!ConfigLoader::load_file(config_path, *initial, err)) {
+            std::cerr << "[config] " << err << "\n";
+            return 1;
+        }
+    }
+
+    // Before any other thread or pool exists: they all inherit the
+    // node's CPUs and fill their memory there
+    CpuTopology topology;
+    const int numa_node = initial->numa_node;
+    if (numa_node >= 0) {
+        if (!topology.load() || !topology.bind_current_thread(numa_node)) {
+            std::cerr << "[numa] cannot bind to node " << numa_node << "\n";
+            return 1;
+        }
+        std::cout << "[numa] bound to node " << numa_node << " of "
+                  << topology.node_count() << " ("
+                  << topology.cpus(numa_node).size() << " cpu(s))\n";
+    }
+    uint64_t numa_accepts = 0;
+    uint64_t numa_remote = 0;       // handshake taken by another node's CPU
+
+    ConfigStore store(initial);
+    ConfigReloader reloader(config_path, store);
 
     EpollLoop loop;
-    ConnectionManager manager(loop);
+    bool config_changed = false;
+    reloader.subscribe(&loop, [&config_changed] { config_changed = true; });
+
+    if (!config_path.empty() && !reloader.start()) {
+        std::cerr << "[config] failed to start reloader\n";
+        return 1;
+    }
+
+    Acceptor acceptor;
+    FDWrapper upgrade_channel;
+    std::vector<int> inherited;
+
+    if (!initial->upgrade_socket.empty() &&
+        HandoffClient::receive(initial->upgrade_socket, inherited, upgrade_channel)) {
+        if (!acceptor.adopt(inherited[0])) {
+            std::cerr << "[upgrade] inherited fd is not a listening socket\n";
+            return 1;
+        }
+        std::cout << "[upgrade] received listening socket from old process\n";
+    } else if (!acceptor.listen(initial->listen_port, initial->listen_backlog,
+                                initial->reuseport)) {
+        std::cerr << "[proxy] failed to listen on port "
+                  << initial->listen_port << "\n";
+        return 1;
+    }
+
+    // Accepted sockets inherit the client profile from the listener
+    if (!initial->client_socket.apply(acceptor.fd()))
+        std::cerr << "[proxy] some client_socket options were rejected\n";
+
+    if (numa_node >= 0 && initial->reuseport) {
+        if (!acceptor.steer_by_cpu(topology.cpu_nodes()))
+            std::cerr << "[numa] cannot steer accepts by CPU, using the kernel hash\n";
+    }
+
+    bool draining = false;
+    uint64_t drain_deadline = 0;
+    uint64_t next_drain_log_ms = 0;
+
+    ConfigSnapshot active = initial;
+
+    // Declared before manager: closing connections still push traces
+    TraceWriter tracer;
+    TraceRing* trace_ring = nullptr;
+    if (!active->trace_file.empty()) {
+        std::string err;
+        if (!tracer.open(active->trace_file, err)) {
+            std::cerr << "[trace] " << err << "\n";
+            return 1;
+        }
+        trace_ring = tracer.make_ring(0);
+        tracer.start();
+        std::cout << "[trace] writing to " << active->trace_file << "\n";
+    }
+
+    // Same lifetime rule as the tracer
+    AccessLogWriter access_log;
+    AccessLogRing* access_ring = nullptr;
+    if (!active->access_log.empty()) {
+        std::string err;
+        if (!access_log.open(active->access_log, active->access_log_max_bytes, err)) {
+            std::cerr << "[access] " << err << "\n";
+            return 1;
+        }
+        access_ring = access_log.make_ring(0);
+        access_log.start();
+        std::cout << "[access] writing to " << active->access_log << "\n";
+    }
+
+    // One worker here, but outcomes still go through the shared board
+    // exactly as they would with one manager per loop thread
+    HealthBoard health(active->health_sync_ms);
+
+    ConnectionManager manager(loop, active);
+    manager.set_tracer(trace_ring);
+    manager.set_access_log(access_ring);
+    manager.set_health_board(&health);
+
+    loop.set_batch_limits(32, active->event_batch_max);
+    loop.set_busy_poll(active->busy_poll_us);
+    uint64_t next_stats_ms = steady_ms() + active->loop_stats_interval_ms;
+
+#ifdef PROXY_TLS
+    TlsContext tls;
+    if (!active->tls_cert.empty()) {
+        std::string err;
+        if (!tls.init(active->tls_cert, active->tls_key,
+                      active->tls_session_cache_size, active->tls_ktls,
+                      active->http2, err)) {
+            std::cerr << "[tls] " << err << "\n";
+            return 1;
+        }
+        manager.set_tls(&tls);
+        std::cout << "[tls] terminating TLS\n";
+    }
+#else
+    if (!active->tls_cert.empty()) {
+        std::cerr << "[tls] built without PROXY_TLS\n";
+        return 1;
+    }
+#endif
+
+    sockaddr_in nameserver = DnsResolver::system_nameserver();
+    if (!active->dns_server.empty())
+        inet_pton(AF_INET, active->dns_server.c_str(), &nameserver.sin_addr);
+
+    DnsResolver resolver(loop, nameserver);
+    resolver.set_callback([&manager](const std::string& host, bool ok, uint32_t addr) {
+        manager.on_dns_result(host, ok, addr);
+    });
+    manager.set_resolver(&resolver);
+
+    // Declared after manager: workers are joined before connections die
+    std::unique_ptr<WorkStealingPool> workers;
+    if (active->worker_threads > 0) {
+        workers = std::make_unique<WorkStealingPool>(active->worker_threads);
+        manager.set_executor(workers.get());
+        std::cout << "[proxy] " << active->worker_threads << " worker thread(s)\n";
+    }
+
+    // Names are resolved in the background so requests hit a warm cache
+    in_addr literal{};
+    if (inet_pton(AF_INET, active->backend_host.c_str(), &literal) != 1)
+        resolver.watch(active->backend_host, steady_ms());
+
+    AdmissionControl admission(loop, nullptr, active->max_connections,
+                               active->max_accepts_per_wakeup);
+    // Rebuilt when a reload changes the rates (or turns limiting on/off)
+    std::unique_ptr<RateLimiter> limiter;
+    uint32_t limiter_rate = active->rate_limit_per_sec;
+    uint32_t limiter_burst = active->rate_limit_burst;
+    if (limiter_rate > 0)
+        limiter = std::make_unique<RateLimiter>(limiter_rate, limiter_burst);
+    manager.set_rate_limiter(limiter.get());
+
+    ShmStatsWriter shm_stats;
+    std::vector<ShmConnEntry> shm_table;
+    uint64_t next_shm_ms = 0;
+    const bool shm_on = !active->stats_shm.empty();
+    if (shm_on) {
+        std::string err;
+        if (!shm_stats.create(active->stats_shm, 1, active->stats_shm_connections, err)) {
+            std::cerr << "[stats] " << err << "\n";
+            return 1;
+        }
+        std::cout << "[stats] publishing to shm " << active->stats_shm << "\n";
+    }
+
+    // Declared after manager and workers: stopped before either goes away
+    AdminServer admin;
+    const uint16_t admin_port = active->admin_port;
+    uint64_t next_admin_retry_ms = 0;       // 0: listening, or no admin port
+    if (admin_port > 0) {
+        admin.add_worker(&loop, [&](JsonWriter& out, bool connections) {
+            write_loop_stats(out, loop);
+            if (workers) {
+                out.key("executor").begin_object();
+                out.key("threads").value(workers->threads());
+                out.key("executed").value(workers->executed());
+                out.key("steals").value(workers->steals());
+                out.end_object();
+            }
+            if (trace_ring) {
+                out.key("trace").begin_object();
+                out.key("written").value(tracer.written());
+                out.key("dropped").value(tracer.dropped());
+                out.end_object();
+            }
+            if (access_ring) {
+                out.key("access_log").begin_object();
+                out.key("written").value(access_log.written());
+                out.key("dropped").value(access_log.dropped());
+                out.key("rotations").value(access_log.rotations());
+                out.key("write_errors").value(access_log.write_errors());
+                out.end_object();
+            }
+            manager.snapshot(out, connections);
+        });
+        if (admin.start(admin_port)) {
+            std::cout << "[admin] listening on 127.0.0.1:" << admin.port() << "\n";
+        } else {
+            // During an upgrade the old process holds the port until it
+            // has handed over; never let the admin port cost traffic
+            std::cerr << "[admin] cannot listen on 127.0.0.1:" << admin_port
+                      << ", retrying\n";
+            next_admin_retry_ms = steady_ms() + kAdminRetryMs;
+        }
+    }
+
+    // Listener already gone (handed over, or closed on a signal)
+    auto begin_drain = [&](const char* why) {
+        draining = true;
+        drain_deadline = steady_ms() + active->drain_timeout_ms;
+        next_drain_log_ms = steady_ms() + 1000;
+        std::cout << "[drain] " << why << ", draining "
+                  << manager.active_count() << " connection(s)\n";
+        manager.start_drain(drain_deadline);
+    };
+
+    // Everything that can fail has succeeded: only now may the old
+    // process stop accepting. Exiting before this point closes the
+    // channel unacknowledged, and the old process keeps serving.
+    if (upgrade_channel.valid()) {
+        if (!HandoffClient::ack(upgrade_channel.get()))
+            std::cerr << "[upgrade] could not ack, old process gone?\n";
+        upgrade_channel.reset();
+    }
+
+    // After the ack: until then the path belongs to the old process,
+    // which must stay upgradable if we fail
+    HandoffServer handoff;
+    if (!initial->upgrade_socket.empty() && !handoff.listen(initial->upgrade_socket)) {
+        std::cerr << "[upgrade] cannot bind " << initial->upgrade_socket << "\n";
+    }
 
     loop.add(acceptor.fd(), EPOLLIN, nullptr);
-    std::cout << "[proxy] listening on port 8080\n";
+    if (handoff.fd() >= 0)
+        loop.add(handoff.fd(), EPOLLIN, &handoff);
+    loop.add(signals.fd(), EPOLLIN, &signals);
+    std::cout << "[proxy] listening on port " << initial->listen_port << "\n";
 
     while (true) {
-        int n = loop.wait(1000);
-        if (n <= 0)
+        if (draining) {
+            if (manager.active_count() == 0) {
+                std::cout << "[drain] drained, exiting\n";
+                return 0;
+            }
+            if (steady_ms() >= drain_deadline) {
+                std::cout << "[drain] deadline reached, closing "
+                          << manager.active_count() << " connection(s)\n";
+                manager.close_all();
+                manager.sweep_closed();
+                return 0;
+            }
+            if (steady_ms() >= next_drain_log_ms) {
+                const DrainStats& ds = manager.drain_stats();
+                std::cout << "[drain] " << manager.active_count() << " of "
+                          << ds.at_start << " connection(s) left, "
+                          << (drain_deadline - steady_ms()) << " ms to deadline\n";
+                next_drain_log_ms = steady_ms() + 1000;
+            }
+        }
+
+        // Posted tasks (worker completions, reload notices) run in here
+        // A paused listener may be backing off, so check again soon
+        int n = loop.wait(draining || admission.listener_paused() ? 100 : 1000);
+        resolver.tick(steady_ms());
+        manager.tick(steady_ms());
+        if (n < 0)
             continue;
 
         for (int i = 0; i < loop.ready_count(); ++i) {
             const epoll_event& ev = loop.event_at(i);
 
             if (ev.data.ptr == nullptr) {
-                while (true) {
-                    int cfd = acceptor.accept();
+                uint64_t now_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count();
+
+                // Rejected clients count against the budget too, so a
+                // flood cannot pin the loop inside this accept loop
+                size_t budget = admission.accept_budget(manager.active_count());
+                while (budget > 0) {
+                    sockaddr_in peer{};
+                    int cfd = acceptor.accept(&peer);
                     if (cfd < 0) {
-                        if (errno == EAGAIN || errno == EWOULDBLOCK)
-                            break;
+                        // Out of fds the client stays queued and the
+                        // listener stays readable: back off, retry later
+                        if (errno == EMFILE || errno == ENFILE)
+                            admission.back_off(acceptor.fd(), steady_ms(), kAcceptBackoffMs);
                         break;
                     }
+                    --budget;
+
+                    // Behind a PROXY header the peer is the load balancer:
+                    // the manager limits by the source the header names
+                    if (limiter && !active->proxy_protocol &&
+                        !limiter->allow(peer.sin_addr.s_addr, now_us)) {
+                        ::close(cfd);
+                        continue;
+                    }
+
+                    if (numa_node >= 0) {
+                        ++numa_accepts;
+                        int cpu = Socket::incoming_cpu(cfd);
+                        if (cpu >= 0 && topology.node_of(cpu) != numa_node)
+                            ++numa_remote;
+                    }
 
                     std::cout << "[proxy] new client fd=" << cfd << "\n";
-                    manager.add_client(cfd);
+                    manager.add_client(cfd, &peer);
+                }
+
+                admission.update(acceptor.fd(), manager.active_count(), steady_ms());
+            } else if (ev.data.ptr == &handoff) {
+                int pfd = handoff.accept_and_send({acceptor.fd()});
+                if (pfd >= 0)
+                    loop.add(pfd, EPOLLIN | EPOLLRDHUP, &upgrade_channel);
+            } else if (ev.data.ptr == &upgrade_channel) {
+                int pfd = handoff.peer_fd();
+                if (!handoff.read_ack()) {
+                    if (handoff.peer_fd() < 0)
+                        loop.remove(pfd);
+                    continue;
                 }
+
+                // New process owns the listener now: stop accepting, drain
+                loop.remove(pfd);
+                loop.remove(handoff.fd());
+                handoff.close();
+                loop.remove(acceptor.fd());
+                acceptor.close();
+
+                // Free the admin port for the successor as well
+                admin.stop();
+                next_admin_retry_ms = 0;
+
+                begin_drain("handed over to new process");
+            } else if (ev.data.ptr == &signals) {
+                while (int sig = signals.read()) {
+                    if (sig == SIGUSR1) {
+                        std::cout << "[access] reopening log\n";
+                        access_log.reopen();
+                        continue;
+                    }
+                    if (draining) {
+                        std::cout << "[drain] signal " << sig << " again, not waiting\n";
+                        drain_deadline = 0;
+                        continue;
+                    }
+
+                    // Stop accepting; the backlog is reset, so a load
+                    // balancer retries those clients elsewhere
+                    loop.remove(acceptor.fd());
+                    acceptor.close();
+                    if (handoff.fd() >= 0) {
+                        loop.remove(handoff.fd());
+                        handoff.close();
+                    }
+                    begin_drain(sig == SIGTERM ? "SIGTERM" : "SIGINT");
+                }
+            } else if (ev.data.ptr == &resolver) {
+                resolver.handle_readable(steady_ms());
             } else {
                 manager.handle_event(ev.data.ptr, ev.events);
             }
         }
 
+        if (config_changed) {
+            config_changed = false;
+
+            ConfigSnapshot next = store.current();
+            if (next->listen_port != active->listen_port) {
+                std::cerr << "[config] listen_port change requires restart\n";
+            }
+            if (next->listen_backlog != active->listen_backlog) {
+                acceptor.set_backlog(next->listen_backlog);
+            }
+            if (acceptor.fd() >= 0 && !next->client_socket.apply(acceptor.fd()))
+                std::cerr << "[config] some client_socket options were rejected\n";
+
+            if (inet_pton(AF_INET, next->backend_host.c_str(), &literal) != 1)
+                resolver.watch(next->backend_host, steady_ms());
+
+            active = next;
+            manager.set_config(active);
+            loop.set_batch_limits(32, active->event_batch_max);
+            loop.set_busy_poll(active->busy_poll_us);
+            next_stats_ms = steady_ms() + active->loop_stats_interval_ms;
+            admission.set_limits(active->max_connections,
+                                 active->max_accepts_per_wakeup);
+
+            // New rates start every client with a full bucket
+            if (limiter_rate != active->rate_limit_per_sec ||
+                limiter_burst != active->rate_limit_burst) {
+                limiter.reset();
+                if (active->rate_limit_per_sec > 0) {
+                    limiter = std::make_unique<RateLimiter>(active->rate_limit_per_sec,
+                                                            active->rate_limit_burst);
+                }
+                limiter_rate = active->rate_limit_per_sec;
+                limiter_burst = active->rate_limit_burst;
+                manager.set_rate_limiter(limiter.get());
+            }
+            std::cout << "[proxy] config snapshot applied\n";
+        }
+
+        if (active->loop_stats_interval_ms > 0 && steady_ms() >= next_stats_ms) {
+            log_loop_stats(loop);
+            if (numa_node >= 0) {
+                std::cout << "[numa] accepts=" << numa_accepts
+                          << " remote=" << numa_remote << "\n";
+                numa_accepts = 0;
+                numa_remote = 0;
+            }
+            next_stats_ms = steady_ms() + active->loop_stats_interval_ms;
+        }
+
+        if (shm_on && steady_ms() >= next_shm_ms) {
+            publish_shm_stats(shm_stats, manager, shm_table);
+            next_shm_ms = steady_ms() + active->stats_shm_interval_ms;
+        }
+
+        if (next_admin_retry_ms != 0 && steady_ms() >= next_admin_retry_ms) {
+            if (admin.start(admin_port)) {
+                std::cout << "[admin] listening on 127.0.0.1:" << admin.port() << "\n";
+                next_admin_retry_ms = 0;
+            } else {
+                next_admin_retry_ms = steady_ms() + kAdminRetryMs;
+            }
+        }
+
         manager.sweep_closed();
+        if (!draining)
+            admission.update(acceptor.fd(), manager.active_count(), steady_ms());
     }
 }
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "access_record.h"
+#include "core/buffer/spsc_ring.h"
+
+/*
+ * AccessLogRing
+ * -------------
+ * SpscRing of access records, tagged with the worker that feeds it.
+ *
+ * Core rules:
+ * - One ring per event loop: the loop thread is the only producer, the
+ *   access-log writer thread the only consumer
+ * - A full ring drops the record and counts it (logging must never
+ *   stall traffic)
+ */
+class AccessLogRing : public SpscRing<AccessRecord> {
+public:
+    explicit AccessLogRing(uint32_t worker, size_t capacity = 8192)
+        : SpscRing(capacity),
+          worker_(worker) {}
+
+    uint32_t worker() const { return worker_; }
+
+private:
+    uint32_t worker_;
+};
@@ -0,0 +1,269 @@
+#include "access_log_writer.h"
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+void append_escaped(std::string& out, const char* s, size_t n) {
+    static const char kHex[] = "0123456789abcdef";
+    for (size_t i = 0; i < n; ++i) {
+        unsigned char c = static_cast<unsigned char>(s[i]);
+        if (c == '"' || c == '\\') {
+            out.push_back('\\');
+            out.push_back(static_cast<char>(c));
+        } else if (c < 0x20 || c >= 0x7f) {
+            // Request bytes are untrusted; keep every line valid JSON
+            char esc[6] = {'\\', 'u', '0', '0', kHex[c >> 4], kHex[c & 0xf]};
+            out.append(esc, sizeof(esc));
+        } else {
+            out.push_back(static_cast<char>(c));
+        }
+    }
+}
+
+void append_uint(std::string& out, uint64_t v) {
+    char buf[24];
+    char* p = buf + sizeof(buf);
+    do {
+        *--p = static_cast<char>('0' + v % 10);
+        v /= 10;
+    } while (v);
+    out.append(p, buf + sizeof(buf) - p);
+}
+
+// "2026-01-02T03:04:05" for the current second; the writer formats
+// thousands of records per second, gmtime_r once per second is enough
+struct SecondCache {
+    time_t sec = -1;
+    char text[24] = {};
+    size_t len = 0;
+
+    void get(uint64_t time_ms, std::string& out) {
+        time_t s = static_cast<time_t>(time_ms / 1000);
+        if (s != sec) {
+            struct tm tm;
+            gmtime_r(&s, &tm);
+            len = std::strftime(text, sizeof(text), "%Y-%m-%dT%H:%M:%S", &tm);
+            sec = s;
+        }
+        out.append(text, len);
+    }
+};
+
+thread_local SecondCache g_second;
+
+} // namespace
+
+AccessLogWriter::AccessLogWriter(unsigned flush_interval_ms)
+    : flush_interval_ms_(flush_interval_ms) {
+}
+
+AccessLogWriter::~AccessLogWriter() {
+    stop();
+}
+
+bool AccessLogWriter::open(const std::string& path, uint64_t max_bytes, std::string& err) {
+    path_ = path;
+    max_bytes_ = max_bytes;
+    if (!open_file()) {
+        err = "cannot open " + path + ": " + std::strerror(errno);
+        return false;
+    }
+    batch_.reserve(kBatchBytes + 1024);
+    return true;
+}
+
+bool AccessLogWriter::open_file() {
+    int fd = ::open(path_.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    file_bytes_ = ::fstat(fd, &st) == 0 ? static_cast<uint64_t>(st.st_size) : 0;
+
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+    fd_ = fd;
+    return true;
+}
+
+AccessLogRing* AccessLogWriter::make_ring(uint32_t worker, size_t capacity) {
+    rings_.push_back(std::make_unique<AccessLogRing>(worker, capacity));
+    return rings_.back().get();
+}
+
+void AccessLogWriter::start() {
+    thread_ = std::thread([this] { run(); });
+}
+
+void AccessLogWriter::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        stopping_ = true;
+    }
+    cv_.notify_one();
+
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+
+    if (fd_ >= 0) {
+        drain();
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+void AccessLogWriter::reopen() {
+    reopen_.store(true, std::memory_order_relaxed);
+    cv_.notify_one();
+}
+
+uint64_t AccessLogWriter::dropped() const {
+    uint64_t n = 0;
+    for (const auto& r : rings_) {
+        n += r->dropped();
+    }
+    return n;
+}
+
+void AccessLogWriter::run() {
+    std::unique_lock<std::mutex> lock(mu_);
+    while (!stopping_) {
+        cv_.wait_for(lock, std::chrono::milliseconds(flush_interval_ms_));
+        lock.unlock();
+        drain();
+        lock.lock();
+    }
+}
+
+size_t AccessLogWriter::drain() {
+    if (fd_ < 0) {
+        return 0;
+    }
+    if (reopen_.exchange(false, std::memory_order_relaxed) && !open_file()) {
+        write_errors_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    size_t n = 0;
+    AccessRecord r;
+
+    for (const auto& ring : rings_) {
+        while (ring->pop(r)) {
+            format(r, ring->worker(), batch_);
+            ++n;
+            if (batch_.size() >= kBatchBytes) {
+                flush(batch_);
+            }
+        }
+    }
+    flush(batch_);
+
+    if (n > 0) {
+        written_.fetch_add(n, std::memory_order_relaxed);
+    }
+    return n;
+}
+
+void AccessLogWriter::flush(std::string& batch) {
+    size_t off = 0;
+    while (off < batch.size()) {
+        ssize_t w = ::write(fd_, batch.data() + off, batch.size() - off);
+        if (w < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            // Disk full or similar: lose this batch rather than stall
+            write_errors_.fetch_add(1, std::memory_order_relaxed);
+            break;
+        }
+        off += static_cast<size_t>(w);
+    }
+    file_bytes_ += off;
+    batch.clear();
+
+    if (max_bytes_ > 0 && file_bytes_ >= max_bytes_) {
+        rotate();
+    }
+}
+
+void AccessLogWriter::rotate() {
+    std::string old = path_ + ".1";
+    if (std::rename(path_.c_str(), old.c_str()) != 0 || !open_file()) {
+        write_errors_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    rotations_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void AccessLogWriter::format(const AccessRecord& r, uint32_t worker, std::string& out) {
+    out.append("{\"time\":\"");
+    g_second.get(r.time_ms, out);
+    char ms[8];
+    int ms_len = std::snprintf(ms, sizeof(ms), ".%03uZ", static_cast<unsigned>(r.time_ms % 1000));
+    out.append(ms, ms_len);
+
+    out.append("\",\"worker\":");
+    append_uint(out, worker);
+    out.append(",\"conn\":");
+    append_uint(out, r.conn_id);
+
+    out.append(",\"client\":\"");
+    char addr[INET6_ADDRSTRLEN] = "-";
+    if (r.family == AF_INET || r.family == AF_INET6) {
+        inet_ntop(r.family, r.client, addr, sizeof(addr));
+    }
+    out.append(addr);
+
+    out.append("\",\"method\":\"");
+    append_escaped(out, r.method, r.method_len);
+    out.append("\",\"target\":\"");
+    size_t target_len = r.target_len < AccessRecord::kTargetBytes ? r.target_len
+                                                                  : AccessRecord::kTargetBytes;
+    append_escaped(out, r.target, target_len);
+    if (r.target_len > target_len) {
+        out.append("...");
+    }
+
+    out.append("\",\"status\":");
+    append_uint(out, r.status);
+    out.append(",\"bytes_in\":");
+    append_uint(out, r.bytes_in);
+    out.append(",\"bytes_out\":");
+    append_uint(out, r.bytes_out);
+    out.append(",\"duration_us\":");
+    append_uint(out, r.duration_us);
+
+    out.append(",\"upstream\":");
+    if (r.upstream_addr != 0) {
+        char up[INET_ADDRSTRLEN];
+        inet_ntop(AF_INET, &r.upstream_addr, up, sizeof(up));
+        out.append("\"");
+        out.append(up);
+        out.append(":");
+        append_uint(out, r.upstream_port);
+        out.append("\"");
+    } else {
+        out.append("null");
+    }
+
+    if (r.flags & AccessRecord::TLS) {
+        out.append(",\"tls\":true");
+    }
+    if (r.flags & AccessRecord::TUNNEL) {
+        out.append(",\"tunnel\":true");
+    }
+    if (r.flags & AccessRecord::RETRIED) {
+        out.append(",\"retried\":true");
+    }
+    out.append("}\n");
+}
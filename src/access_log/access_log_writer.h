@@ -0,0 +1,90 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "access_log_ring.h"
+
+/*
+ * AccessLogWriter
+ * ---------------
+ * Background thread that drains every loop's AccessLogRing and appends
+ * one JSON object per line to the access log.
+ *
+ * Core rules:
+ * - Rings are created with make_ring() before start() and owned here,
+ *   so they outlive the loops that push into them
+ * - Formatting and file I/O happen on this thread only, in batches of up
+ *   to kBatchBytes per write(); a loop never touches the file
+ * - Size rotation: once the file passes max_bytes it is renamed to
+ *   <path>.1 (replacing the previous one) and a new file is started
+ * - reopen() (safe from any thread, e.g. on SIGUSR1) closes and reopens
+ *   path before the next batch, for external rotation tools
+ * - stop() (or the destructor) drains what is left and closes the file
+ *
+ * Non-responsibilities:
+ * - Deciding what is logged (ConnectionManager)
+ * - Compressing or expiring rotated files
+ */
+class AccessLogWriter {
+public:
+    static constexpr size_t kBatchBytes = 256 * 1024;
+
+    explicit AccessLogWriter(unsigned flush_interval_ms = 100);
+    ~AccessLogWriter();
+
+    AccessLogWriter(const AccessLogWriter&) = delete;
+    AccessLogWriter& operator=(const AccessLogWriter&) = delete;
+
+    // Open (append) path; max_bytes = 0 never rotates
+    // Returns false and fills err on failure
+    bool open(const std::string& path, uint64_t max_bytes, std::string& err);
+
+    // One ring per producing loop; call before start()
+    AccessLogRing* make_ring(uint32_t worker, size_t capacity = 8192);
+
+    void start();
+    void stop();
+
+    void reopen();
+
+    uint64_t written() const { return written_.load(std::memory_order_relaxed); }
+    uint64_t rotations() const { return rotations_.load(std::memory_order_relaxed); }
+    uint64_t write_errors() const { return write_errors_.load(std::memory_order_relaxed); }
+    uint64_t dropped() const;
+
+    // One record as a JSON line (exposed for tests)
+    static void format(const AccessRecord& r, uint32_t worker, std::string& out);
+
+private:
+    void run();
+    size_t drain();
+    void flush(std::string& batch);
+    bool open_file();
+    void rotate();
+
+    unsigned flush_interval_ms_;
+    std::string path_;
+    uint64_t max_bytes_{0};
+    int fd_{-1};
+    uint64_t file_bytes_{0};
+
+    std::vector<std::unique_ptr<AccessLogRing>> rings_;
+    std::thread thread_;
+    std::string batch_;
+
+    std::mutex mu_;
+    std::condition_variable cv_;
+    bool stopping_{false};
+
+    std::atomic<bool> reopen_{false};
+    std::atomic<uint64_t> written_{0};
+    std::atomic<uint64_t> rotations_{0};
+    std::atomic<uint64_t> write_errors_{0};
+};
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/*
+ * AccessRecord
+ * ------------
+ * One completed request, as captured on the event loop.
+ *
+ * Core rules:
+ * - Fixed size and trivially copyable: filling one is a few stores and
+ *   two bounded memcpys, never an allocation or a format call
+ * - Method and target are truncated to fit; target_len keeps the
+ *   original length so the writer can mark the cut
+ * - Formatting happens on the writer thread (see AccessLogWriter)
+ */
+struct AccessRecord {
+    static constexpr size_t kMethodBytes = 12;
+    static constexpr size_t kTargetBytes = 128;
+
+    enum Flags : uint8_t {
+        TLS = 1,
+        TUNNEL = 2,
+        RETRIED = 4,
+    };
+
+    uint64_t time_ms = 0;           // wall clock at completion
+    uint64_t bytes_in = 0;          // client -> proxy
+    uint64_t bytes_out = 0;         // proxy -> client
+    uint32_t duration_us = 0;       // request head complete -> close
+    uint32_t conn_id = 0;
+
+    uint32_t upstream_addr = 0;     // network order, 0 = none
+    uint16_t upstream_port = 0;
+    uint16_t status = 0;            // 0 = no response was sent
+
+    uint8_t family = 0;             // AF_INET / AF_INET6, 0 = unknown
+    uint8_t flags = 0;
+    uint8_t method_len = 0;         // 0 = no request was read
+    uint8_t client[16] = {};        // IPv4 in the first 4 bytes
+    uint16_t target_len = 0;        // untruncated length
+
+    char method[kMethodBytes] = {};
+    char target[kTargetBytes] = {};
+
+    // Copy method and target out of the request line at data (the head
+    // the parser framed); leaves both empty if it has no two spaces
+    void set_request_line(const char* data, size_t len) {
+        method_len = 0;
+        target_len = 0;
+
+        const char* eol = static_cast<const char*>(std::memchr(data, '\r', len));
+        size_t line = eol ? static_cast<size_t>(eol - data) : len;
+        const char* sp1 = static_cast<const char*>(std::memchr(data, ' ', line));
+        if (!sp1) {
+            return;
+        }
+        const char* t = sp1 + 1;
+        const char* sp2 = static_cast<const char*>(std::memchr(t, ' ', data + line - t));
+        if (!sp2) {
+            return;
+        }
+
+        size_t m = static_cast<size_t>(sp1 - data);
+        method_len = static_cast<uint8_t>(m < kMethodBytes ? m : kMethodBytes);
+        std::memcpy(method, data, method_len);
+
+        size_t n = static_cast<size_t>(sp2 - t);
+        target_len = static_cast<uint16_t>(n < 0xffff ? n : 0xffff);
+        std::memcpy(target, t, n < kTargetBytes ? n : kTargetBytes);
+    }
+};
@@ -0,0 +1,291 @@
+#include "admin_server.h"
+#include "json_writer.h"
+#include "core/event_loop/epoll_loop.h"
+#include "core/socket/socket.h"
+#include "protocol/http/http_parser.h"
+
+#include <arpa/inet.h>
+#include <chrono>
+#include <errno.h>
+#include <iostream>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+uint64_t now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+const char* reason(int status) {
+    switch (status) {
+    case 200: return "OK";
+    case 400: return "Bad Request";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    default:  return "Error";
+    }
+}
+
+// Admin requests are tiny; anything larger is not one
+constexpr size_t kMaxRequestBytes = 8192;
+
+} // namespace
+
+AdminServer::AdminServer(size_t max_clients, uint64_t idle_timeout_ms)
+    : loop_(std::make_shared<EpollLoop>()),
+      max_clients_(max_clients),
+      idle_timeout_ms_(idle_timeout_ms) {}
+
+AdminServer::~AdminServer() {
+    stop();
+}
+
+void AdminServer::add_worker(EpollLoop* loop, Snapshot snapshot) {
+    workers_.push_back({loop, std::move(snapshot)});
+}
+
+bool AdminServer::start(uint16_t port) {
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    if (!acceptor_.listen(addr, 64)) {
+        return false;
+    }
+
+    loop_->add(acceptor_.fd(), EPOLLIN, nullptr);
+    running_ = true;
+    thread_ = std::thread([this] { run(); });
+    return true;
+}
+
+void AdminServer::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    loop_->post([] {});         // wake the loop so it sees running_
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    requests_.clear();
+    acceptor_.close();
+}
+
+void AdminServer::run() {
+    while (running_.load()) {
+        int n = loop_->wait(200);
+        if (n >= 0) {
+            for (int i = 0; i < loop_->ready_count(); ++i) {
+                const epoll_event& ev = loop_->event_at(i);
+                if (ev.data.ptr == nullptr) {
+                    accept_clients();
+                    continue;
+                }
+
+                auto* r = static_cast<Request*>(ev.data.ptr);
+                if (ev.events & (EPOLLERR | EPOLLHUP)) {
+                    close(r);
+                } else if (ev.events & EPOLLOUT) {
+                    flush(r);
+                } else if (ev.events & EPOLLIN) {
+                    on_readable(r);
+                }
+            }
+        }
+        expire(now_ms());
+    }
+}
+
+void AdminServer::accept_clients() {
+    while (true) {
+        int fd = acceptor_.accept();
+        if (fd < 0) {
+            return;
+        }
+        // Accept and drop rather than leave it queued: the listener is
+        // level-triggered and would keep waking us
+        if (requests_.size() >= max_clients_) {
+            ::close(fd);
+            rejected_.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        auto r = std::make_unique<Request>();
+        r->id = ++next_id_;
+        r->fd.reset(fd);
+        r->deadline_ms = now_ms() + idle_timeout_ms_;
+        loop_->add(fd, EPOLLIN | EPOLLRDHUP, r.get());
+        requests_[r->id] = std::move(r);
+    }
+}
+
+void AdminServer::on_readable(Request* r) {
+    r->in.ensure_capacity(1024);
+    ssize_t n = Socket::read(r->fd.get(), r->in.write_ptr(), r->in.writable_bytes());
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        return;
+    }
+    if (n <= 0 || r->gathering) {
+        // Closed, or talking while we gather: nothing more to say
+        if (n <= 0) {
+            close(r);
+        }
+        return;
+    }
+    r->in.commit(n);
+
+    HttpParser parser;
+    HttpRequestInfo req;
+    HttpParseResult res = parser.parse(r->in.read_ptr(), r->in.readable_bytes(), req);
+    if (res == HttpParseResult::INCOMPLETE) {
+        if (r->in.readable_bytes() > kMaxRequestBytes) {
+            respond(r, 400, "{\"error\":\"request too large\"}");
+        }
+        return;
+    }
+
+    std::pmr::string method;
+    std::pmr::string target;
+    if (res == HttpParseResult::ERROR ||
+        !HttpParser::parse_request_line(r->in.read_ptr(), req.header_bytes, method, target)) {
+        respond(r, 400, "{\"error\":\"bad request\"}");
+        return;
+    }
+    if (method != "GET") {
+        respond(r, 405, "{\"error\":\"only GET\"}");
+        return;
+    }
+
+    if (target == "/stats") {
+        gather(r, false);
+    } else if (target == "/connections") {
+        gather(r, true);
+    } else {
+        respond(r, 404, "{\"error\":\"not found\",\"paths\":[\"/stats\",\"/connections\"]}");
+    }
+}
+
+void AdminServer::gather(Request* r, bool connections) {
+    size_t n = workers_.size();
+    r->gathering = true;
+    r->parts.assign(n, std::string());
+    r->arrived.assign(n, false);
+    r->pending = n;
+    r->deadline_ms = now_ms() + kSnapshotTimeoutMs;
+
+    std::weak_ptr<EpollLoop> home = loop_;
+    for (size_t i = 0; i < n; ++i) {
+        Snapshot snapshot = workers_[i].snapshot;
+        uint32_t id = r->id;
+
+        workers_[i].loop->post([this, home, snapshot, id, i, connections] {
+            JsonWriter out;
+            out.begin_object();
+            out.key("worker").value(i);
+            snapshot(out, connections);
+            out.end_object();
+
+            // Runs on the admin thread, which only exists while this
+            // server does; after stop() the post is simply dropped
+            if (auto loop = home.lock()) {
+                loop->post([this, id, i, json = out.take()]() mutable {
+                    on_part(id, i, std::move(json));
+                });
+            }
+        });
+    }
+
+    if (n == 0) {
+        finish(r);
+    }
+}
+
+void AdminServer::on_part(uint32_t id, size_t worker, std::string json) {
+    auto it = requests_.find(id);
+    if (it == requests_.end()) {
+        return;                 // client left or timed out
+    }
+    Request* r = it->second.get();
+    if (!r->gathering || r->arrived[worker]) {
+        return;
+    }
+    r->parts[worker] = std::move(json);
+    r->arrived[worker] = true;
+    if (--r->pending == 0) {
+        finish(r);
+    }
+}
+
+void AdminServer::finish(Request* r) {
+    r->gathering = false;
+
+    JsonWriter out;
+    out.begin_object();
+    out.key("complete").value(r->pending == 0);
+    out.key("workers").begin_array();
+    for (size_t i = 0; i < r->parts.size(); ++i) {
+        if (r->arrived[i]) {
+            out.raw(r->parts[i]);
+        } else {
+            out.null();
+        }
+    }
+    out.end_array();
+    out.end_object();
+
+    respond(r, 200, out.str());
+}
+
+void AdminServer::respond(Request* r, int status, const std::string& body) {
+    r->out = "HTTP/1.1 " + std::to_string(status) + " " + reason(status) +
+             "\r\nContent-Type: application/json\r\nContent-Length: " +
+             std::to_string(body.size() + 1) + "\r\nConnection: close\r\n\r\n" +
+             body + "\n";
+    r->written = 0;
+    r->deadline_ms = now_ms() + idle_timeout_ms_;   // to take the reply
+    served_.fetch_add(1, std::memory_order_relaxed);
+    flush(r);
+}
+
+void AdminServer::flush(Request* r) {
+    while (r->written < r->out.size()) {
+        ssize_t n = ::send(r->fd.get(), r->out.data() + r->written,
+                           r->out.size() - r->written, MSG_NOSIGNAL);
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            loop_->modify(r->fd.get(), EPOLLOUT, r);
+            return;
+        }
+        if (n <= 0) {
+            close(r);
+            return;
+        }
+        r->written += n;
+    }
+    close(r);
+}
+
+void AdminServer::close(Request* r) {
+    loop_->remove(r->fd.get());
+    requests_.erase(r->id);
+}
+
+void AdminServer::expire(uint64_t now) {
+    std::vector<Request*> late;
+    for (auto& kv : requests_) {
+        Request* r = kv.second.get();
+        if (now >= r->deadline_ms) {
+            late.push_back(r);
+        }
+    }
+    for (Request* r : late) {
+        if (r->gathering) {
+            std::cerr << "[admin] " << r->pending << " worker(s) did not answer in time\n";
+            finish(r);
+        } else {
+            // Never sent a full request, or never read the reply
+            timed_out_.fetch_add(1, std::memory_order_relaxed);
+            close(r);
+        }
+    }
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "core/buffer/buffer.h"
+#include "core/fd/fd_wrapper.h"
+#include "core/socket/acceptor.h"
+
+class EpollLoop;
+class JsonWriter;
+
+/*
+ * AdminServer
+ * -----------
+ * Loopback-only HTTP listener that answers with JSON snapshots of the
+ * proxy's live state:
+ *
+ *   GET /stats         per-worker counters, pools and upstream health
+ *   GET /connections   the same plus every open connection
+ *
+ * Core rules:
+ * - Runs its own EpollLoop on its own thread; admin clients never share
+ *   a loop with traffic
+ * - Worker state is never read from here: each request posts a snapshot
+ *   task to every worker loop, the worker serializes its own state
+ *   between two batches of events and posts the text back. No locks,
+ *   and a worker pays only for the snapshot itself
+ * - A worker that has not answered within kSnapshotTimeoutMs is
+ *   reported as null with "complete": false
+ * - A client that has not sent a full request, or not taken its reply,
+ *   within the idle timeout is closed; past max_clients new clients
+ *   are accepted and closed at once, so a stuck script cannot hold
+ *   admin fds forever
+ * - Workers are registered before start() and their loops must outlive
+ *   the server (stop it first)
+ *
+ * Non-responsibilities:
+ * - Authentication (bind is 127.0.0.1 only)
+ * - Changing any state
+ */
+class AdminServer {
+public:
+    // Writes members into an object the server has already opened;
+    // runs on the worker's loop thread
+    using Snapshot = std::function<void(JsonWriter& out, bool connections)>;
+
+    static constexpr uint64_t kSnapshotTimeoutMs = 1000;
+    static constexpr uint64_t kIdleTimeoutMs = 5000;
+    static constexpr size_t kMaxClients = 32;
+
+    explicit AdminServer(size_t max_clients = kMaxClients,
+                         uint64_t idle_timeout_ms = kIdleTimeoutMs);
+    ~AdminServer();
+
+    AdminServer(const AdminServer&) = delete;
+    AdminServer& operator=(const AdminServer&) = delete;
+
+    void add_worker(EpollLoop* loop, Snapshot snapshot);
+
+    // Listen on 127.0.0.1:port (0 = any free port) and start the thread
+    bool start(uint16_t port);
+    void stop();
+
+    uint16_t port() const { return acceptor_.port(); }
+    uint64_t served() const { return served_.load(std::memory_order_relaxed); }
+    uint64_t rejected() const { return rejected_.load(std::memory_order_relaxed); }
+    uint64_t timed_out() const { return timed_out_.load(std::memory_order_relaxed); }
+
+private:
+    struct Worker {
+        EpollLoop* loop;
+        Snapshot snapshot;
+    };
+
+    struct Request {
+        uint32_t id;
+        FDWrapper fd;
+        Buffer in{1024};
+        std::string out;
+        size_t written = 0;
+
+        // Snapshot parts, one per worker, while gathering
+        std::vector<std::string> parts;
+        std::vector<bool> arrived;
+        size_t pending = 0;
+        bool gathering = false;
+        // Snapshot deadline while gathering, idle deadline otherwise
+        uint64_t deadline_ms = 0;
+    };
+
+    void run();
+    void accept_clients();
+    void on_readable(Request* r);
+    void gather(Request* r, bool connections);
+    void on_part(uint32_t id, size_t worker, std::string json);
+    void finish(Request* r);
+    void respond(Request* r, int status, const std::string& body);
+    void flush(Request* r);
+    void close(Request* r);
+    void expire(uint64_t now_ms);
+
+    // Shared so a worker finishing a snapshot after stop() finds it gone
+    // (weak_ptr) instead of posting into a destroyed loop
+    std::shared_ptr<EpollLoop> loop_;
+    Acceptor acceptor_;
+    std::vector<Worker> workers_;
+    size_t max_clients_;
+    uint64_t idle_timeout_ms_;
+
+    std::unordered_map<uint32_t, std::unique_ptr<Request>> requests_;
+    uint32_t next_id_{0};
+
+    std::atomic<bool> running_{false};
+    std::atomic<uint64_t> served_{0};
+    std::atomic<uint64_t> rejected_{0};
+    std::atomic<uint64_t> timed_out_{0};
+    std::thread thread_;
+};
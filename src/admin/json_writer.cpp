@@ -0,0 +1,125 @@
+#include "json_writer.h"
+
+#include <cmath>
+#include <cstdio>
+
+void JsonWriter::separate() {
+    if (after_key_) {
+        after_key_ = false;
+        return;
+    }
+    if (!first_.empty()) {
+        if (!first_.back()) {
+            out_.push_back(',');
+        }
+        first_.back() = false;
+    }
+}
+
+void JsonWriter::open(char c) {
+    separate();
+    out_.push_back(c);
+    first_.push_back(true);
+}
+
+void JsonWriter::close(char c) {
+    out_.push_back(c);
+    if (!first_.empty()) {
+        first_.pop_back();
+    }
+}
+
+JsonWriter& JsonWriter::begin_object() {
+    open('{');
+    return *this;
+}
+
+JsonWriter& JsonWriter::end_object() {
+    close('}');
+    return *this;
+}
+
+JsonWriter& JsonWriter::begin_array() {
+    open('[');
+    return *this;
+}
+
+JsonWriter& JsonWriter::end_array() {
+    close(']');
+    return *this;
+}
+
+JsonWriter& JsonWriter::key(std::string_view name) {
+    value(name);
+    out_.push_back(':');
+    after_key_ = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::signed_value(int64_t v) {
+    separate();
+    out_.append(std::to_string(v));
+    return *this;
+}
+
+JsonWriter& JsonWriter::unsigned_value(uint64_t v) {
+    separate();
+    out_.append(std::to_string(v));
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(bool v) {
+    separate();
+    out_.append(v ? "true" : "false");
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(double v) {
+    if (!std::isfinite(v)) {
+        return null();
+    }
+    separate();
+    char buf[32];
+    int n = std::snprintf(buf, sizeof(buf), "%.6g", v);
+    out_.append(buf, n);
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(std::string_view v) {
+    static const char kHex[] = "0123456789abcdef";
+
+    separate();
+    out_.push_back('"');
+    for (char ch : v) {
+        unsigned char c = static_cast<unsigned char>(ch);
+        switch (c) {
+        case '"':  out_.append("\\\""); break;
+        case '\\': out_.append("\\\\"); break;
+        case '\n': out_.append("\\n"); break;
+        case '\r': out_.append("\\r"); break;
+        case '\t': out_.append("\\t"); break;
+        default:
+            if (c < 0x20) {
+                out_.append("\\u00");
+                out_.push_back(kHex[c >> 4]);
+                out_.push_back(kHex[c & 0xf]);
+            } else {
+                out_.push_back(ch);
+            }
+        }
+    }
+    out_.push_back('"');
+    return *this;
+}
+
+JsonWriter& JsonWriter::null() {
+    separate();
+    out_.append("null");
+    return *this;
+}
+
+JsonWriter& JsonWriter::raw(std::string_view json) {
+    separate();
+    out_.append(json);
+    return *this;
+}
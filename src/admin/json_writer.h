@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+/*
+ * JsonWriter
+ * ----------
+ * Streaming JSON text builder for introspection snapshots.
+ *
+ * Core rules:
+ * - Commas and quoting are handled here; callers only open, name and
+ *   close (key() before every member of an object)
+ * - Strings are escaped; non-finite numbers become null
+ * - raw() inserts an already serialized value (a worker's snapshot)
+ *
+ * Non-responsibilities:
+ * - Parsing, pretty-printing, validating nesting
+ */
+class JsonWriter {
+public:
+    JsonWriter& begin_object();
+    JsonWriter& end_object();
+    JsonWriter& begin_array();
+    JsonWriter& end_array();
+
+    JsonWriter& key(std::string_view name);
+
+    template <typename T>
+    std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>, JsonWriter&>
+    value(T v) {
+        if constexpr (std::is_signed_v<T>) {
+            return signed_value(static_cast<int64_t>(v));
+        } else {
+            return unsigned_value(static_cast<uint64_t>(v));
+        }
+    }
+    JsonWriter& value(bool v);
+    JsonWriter& value(double v);
+    JsonWriter& value(std::string_view v);
+    JsonWriter& value(const char* v) { return value(std::string_view(v)); }
+    JsonWriter& null();
+    JsonWriter& raw(std::string_view json);
+
+    const std::string& str() const { return out_; }
+    std::string take() { return std::move(out_); }
+
+private:
+    void separate();
+    void open(char c);
+    void close(char c);
+    JsonWriter& signed_value(int64_t v);
+    JsonWriter& unsigned_value(uint64_t v);
+
+    std::string out_;
+    std::vector<bool> first_;       // per open container: nothing written yet
+    bool after_key_{false};
+};
@@ -0,0 +1,64 @@
+#include "admission_control.h"
+#include "core/event_loop/epoll_loop.h"
+
+#include <algorithm>
+#include <iostream>
+
+AdmissionControl::AdmissionControl(EpollLoop& loop, void* listener_tag,
+                                   size_t max_connections,
+                                   size_t max_accepts_per_wakeup)
+    : loop_(loop),
+      listener_tag_(listener_tag),
+      max_connections_(max_connections),
+      max_accepts_per_wakeup_(std::max<size_t>(max_accepts_per_wakeup, 1)) {}
+
+void AdmissionControl::set_limits(size_t max_connections,
+                                  size_t max_accepts_per_wakeup) {
+    max_connections_ = max_connections;
+    max_accepts_per_wakeup_ = std::max<size_t>(max_accepts_per_wakeup, 1);
+}
+
+size_t AdmissionControl::accept_budget(size_t active) const {
+    if (max_connections_ == 0) {
+        return max_accepts_per_wakeup_;
+    }
+    if (active >= max_connections_) {
+        return 0;
+    }
+    return std::min(max_accepts_per_wakeup_, max_connections_ - active);
+}
+
+void AdmissionControl::update(int listen_fd, size_t active, uint64_t now_ms) {
+    if (listen_fd < 0) {
+        return;
+    }
+
+    bool saturated = max_connections_ != 0 && active >= max_connections_;
+    bool backing_off = now_ms < backoff_until_ms_;
+
+    if (saturated && !paused_) {
+        loop_.modify(listen_fd, 0, listener_tag_);
+        paused_ = true;
+        ++pauses_;
+        std::cout << "[admission] max connections reached, pausing accepts\n";
+    } else if (!saturated && !backing_off && paused_) {
+        loop_.modify(listen_fd, EPOLLIN, listener_tag_);
+        paused_ = false;
+        std::cout << "[admission] resuming accepts\n";
+    }
+}
+
+void AdmissionControl::back_off(int listen_fd, uint64_t now_ms, uint64_t backoff_ms) {
+    if (listen_fd < 0) {
+        return;
+    }
+
+    backoff_until_ms_ = now_ms + backoff_ms;
+    if (!paused_) {
+        loop_.modify(listen_fd, 0, listener_tag_);
+        paused_ = true;
+        ++pauses_;
+        std::cout << "[admission] out of file descriptors, pausing accepts for "
+                  << backoff_ms << " ms\n";
+    }
+}
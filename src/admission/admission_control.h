@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+class EpollLoop;
+
+/*
+ * AdmissionControl
+ * ----------------
+ * Global connection limits enforced at the listener.
+ *
+ * Responsibilities:
+ * - Cap accepts per listener wakeup (the rest stay in the kernel queue)
+ * - Pause EPOLLIN on the listener while max_connections is reached
+ * - Resume EPOLLIN once connections drop below the limit
+ * - Back off the listener for a while when accept runs out of fds
+ *
+ * Non-responsibilities:
+ * - Accepting sockets
+ * - Per-client policy (see RateLimiter)
+ *
+ * While paused, new clients wait in the kernel accept queue instead of
+ * costing us a fd and a Connection we would have to reject anyway.
+ * Out of fds (EMFILE / ENFILE) the pending client stays queued and a
+ * level-triggered listener would wake us forever, so the listener is
+ * paused until the backoff expires and update() runs again.
+ */
+class AdmissionControl {
+public:
+    // max_connections == 0 means unlimited
+    // listener_tag is the epoll data ptr the listener is registered with
+    AdmissionControl(EpollLoop& loop, void* listener_tag,
+                     size_t max_connections, size_t max_accepts_per_wakeup);
+
+    // Apply new limits (e.g. after a config reload)
+    void set_limits(size_t max_connections, size_t max_accepts_per_wakeup);
+
+    // How many accepts the caller may perform right now
+    size_t accept_budget(size_t active) const;
+
+    // Re-evaluate listener interest after accepts / closes / ticks
+    void update(int listen_fd, size_t active, uint64_t now_ms);
+
+    // accept failed with EMFILE / ENFILE: pause until now_ms + backoff_ms
+    void back_off(int listen_fd, uint64_t now_ms, uint64_t backoff_ms);
+
+    bool listener_paused() const { return paused_; }
+    uint64_t pause_count() const { return pauses_; }
+
+private:
+    EpollLoop& loop_;
+    void* listener_tag_;
+    size_t max_connections_;
+    size_t max_accepts_per_wakeup_;
+    bool paused_{false};
+    uint64_t pauses_{0};
+    uint64_t backoff_until_ms_{0};
+};
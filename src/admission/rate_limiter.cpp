@@ -0,0 +1,87 @@
+#include "rate_limiter.h"
+
+#include <algorithm>
+
+namespace {
+
+// 64-bit mix (splitmix64 finalizer) so neighbouring addresses spread out
+uint64_t mix(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+} // namespace
+
+RateLimiter::RateLimiter(uint32_t rate_per_sec, uint32_t burst, size_t capacity)
+    : rate_milli_per_sec_(static_cast<uint64_t>(rate_per_sec) * kMilli),
+      burst_milli_(static_cast<uint64_t>(std::max<uint32_t>(burst, 1)) * kMilli),
+      slots_per_shard_(std::max(kProbe, (capacity + kShards - 1) / kShards)) {
+
+    for (Shard& shard : shards_) {
+        shard.slots.reset(new Entry[slots_per_shard_]);
+    }
+}
+
+RateLimiter::Entry& RateLimiter::lookup(Shard& shard, uint32_t key,
+                                        uint64_t hash, uint64_t now_us) {
+    size_t base = static_cast<size_t>(hash % slots_per_shard_);
+    Entry* victim = nullptr;
+
+    for (size_t i = 0; i < kProbe; ++i) {
+        Entry& e = shard.slots[(base + i) % slots_per_shard_];
+        if (e.used && e.key == key) {
+            return e;
+        }
+        if (!e.used) {
+            if (!victim || victim->used) {
+                victim = &e;
+            }
+        } else if (!victim || (victim->used && e.last_us < victim->last_us)) {
+            victim = &e;
+        }
+    }
+
+    if (victim->used) {
+        ++shard.evictions;
+    }
+
+    victim->key = key;
+    victim->used = true;
+    victim->tokens_milli = burst_milli_;
+    victim->last_us = now_us;
+    return *victim;
+}
+
+bool RateLimiter::allow(uint32_t key, uint64_t now_us) {
+    uint64_t hash = mix(key);
+    Shard& shard = shards_[(hash >> 56) % kShards];
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    Entry& e = lookup(shard, key, hash, now_us);
+
+    if (now_us > e.last_us) {
+        uint64_t refill = (now_us - e.last_us) * rate_milli_per_sec_ / 1000000;
+        e.tokens_milli = std::min(burst_milli_, e.tokens_milli + refill);
+        e.last_us = now_us;
+    }
+
+    if (e.tokens_milli < kMilli) {
+        return false;
+    }
+
+    e.tokens_milli -= kMilli;
+    return true;
+}
+
+uint64_t RateLimiter::evictions() const {
+    uint64_t total = 0;
+    for (const Shard& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        total += shard.evictions;
+    }
+    return total;
+}
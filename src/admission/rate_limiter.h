@@ -0,0 +1,65 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+/*
+ * RateLimiter
+ * -----------
+ * Per-client-IP token bucket stored in a fixed-size sharded table.
+ *
+ * Core rules:
+ * - Memory is allocated once at construction, never per client
+ * - Each key hashes to a shard and to a short probe window inside it
+ * - When the window is full, the least recently seen entry is evicted
+ *   (approximate LRU; an evicted client simply starts with a full bucket)
+ * - Time is passed in by the caller, no clock syscalls inside
+ *
+ * Shards are independently locked so several loops can share one limiter
+ * without contending on a single lock.
+ */
+class RateLimiter {
+public:
+    // rate_per_sec: sustained tokens per second per client
+    // burst: bucket size
+    // capacity: total tracked clients (rounded up to a multiple of shards)
+    RateLimiter(uint32_t rate_per_sec, uint32_t burst, size_t capacity = 65536);
+
+    RateLimiter(const RateLimiter&) = delete;
+    RateLimiter& operator=(const RateLimiter&) = delete;
+
+    // Take one token for key (IPv4 address in network order)
+    // Returns false when the client is over its rate
+    bool allow(uint32_t key, uint64_t now_us);
+
+    // Number of entries evicted to make room (for metrics)
+    uint64_t evictions() const;
+
+private:
+    static constexpr size_t kShards = 16;
+    static constexpr size_t kProbe = 8;
+    static constexpr uint64_t kMilli = 1000;
+
+    struct Entry {
+        uint32_t key = 0;
+        bool used = false;
+        uint64_t tokens_milli = 0;   // fixed point, 1 token == 1000
+        uint64_t last_us = 0;
+    };
+
+    struct Shard {
+        mutable std::mutex mutex;
+        std::unique_ptr<Entry[]> slots;
+        uint64_t evictions = 0;
+    };
+
+    Entry& lookup(Shard& shard, uint32_t key, uint64_t hash, uint64_t now_us);
+
+    uint64_t rate_milli_per_sec_;
+    uint64_t burst_milli_;
+    size_t slots_per_shard_;
+    std::array<Shard, kShards> shards_;
+};
@@ -0,0 +1,101 @@
+#include "circuit_breaker.h"
+
+CircuitBreaker::CircuitBreaker(const BreakerPolicy& policy) {
+    set_policy(policy);
+}
+
+void CircuitBreaker::set_policy(const BreakerPolicy& policy) {
+    policy_ = policy;
+    uint32_t n = policy_.min_requests > 0 ? policy_.min_requests : 1;
+    alpha_ = 2.0 / (static_cast<double>(n) + 1.0);
+}
+
+bool CircuitBreaker::allow(uint64_t now_ms) {
+    switch (state_) {
+    case BreakerState::CLOSED:
+        return true;
+
+    case BreakerState::OPEN:
+        if (now_ms < open_until_) {
+            return false;
+        }
+        state_ = BreakerState::HALF_OPEN;
+        probe_in_flight_ = false;
+        // fall through: this request may be the probe
+        [[fallthrough]];
+
+    case BreakerState::HALF_OPEN:
+        if (probe_in_flight_ && now_ms < probe_started_ + policy_.open_ms) {
+            return false;
+        }
+        probe_in_flight_ = true;
+        probe_started_ = now_ms;
+        return true;
+    }
+    return false;
+}
+
+void CircuitBreaker::on_success(uint64_t latency_us, uint64_t now_ms) {
+    if (state_ == BreakerState::HALF_OPEN) {
+        reset();
+        latency_ewma_ = static_cast<double>(latency_us);
+        return;
+    }
+    if (state_ == BreakerState::OPEN) {
+        return;     // straggler from before the trip
+    }
+
+    error_ewma_ += alpha_ * (0.0 - error_ewma_);
+    latency_ewma_ = samples_ == 0
+        ? static_cast<double>(latency_us)
+        : latency_ewma_ + alpha_ * (static_cast<double>(latency_us) - latency_ewma_);
+    ++samples_;
+
+    if (policy_.latency_us > 0 && samples_ >= policy_.min_requests &&
+        latency_ewma_ > static_cast<double>(policy_.latency_us)) {
+        trip(now_ms);
+    }
+}
+
+void CircuitBreaker::on_failure(uint64_t now_ms) {
+    if (state_ == BreakerState::HALF_OPEN) {
+        trip(now_ms);
+        return;
+    }
+    if (state_ == BreakerState::OPEN) {
+        return;
+    }
+
+    error_ewma_ += alpha_ * (1.0 - error_ewma_);
+    ++samples_;
+
+    if (samples_ >= policy_.min_requests && error_ewma_ >= policy_.failure_ratio) {
+        trip(now_ms);
+    }
+}
+
+void CircuitBreaker::force_open(uint64_t now_ms) {
+    if (state_ != BreakerState::OPEN) {
+        trip(now_ms);
+    }
+}
+
+void CircuitBreaker::trip(uint64_t now_ms) {
+    uint64_t factor = 1;
+    for (uint32_t i = 0; i < trips_ && factor < policy_.max_backoff; ++i) {
+        factor *= 2;
+    }
+    ++trips_;
+
+    state_ = BreakerState::OPEN;
+    open_until_ = now_ms + policy_.open_ms * factor;
+    probe_in_flight_ = false;
+}
+
+void CircuitBreaker::reset() {
+    state_ = BreakerState::CLOSED;
+    error_ewma_ = 0.0;
+    samples_ = 0;
+    trips_ = 0;
+    probe_in_flight_ = false;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+
+/*
+ * BreakerState
+ * ------------
+ * CLOSED: traffic flows, outcomes feed the EWMAs
+ * OPEN: upstream ejected until the open interval expires
+ * HALF_OPEN: one probe request at a time decides between the two
+ */
+enum class BreakerState {
+    CLOSED,
+    OPEN,
+    HALF_OPEN
+};
+
+struct BreakerPolicy {
+    double failure_ratio = 0.5;     // error EWMA that trips the breaker
+    uint32_t min_requests = 10;     // outcomes needed before tripping
+    uint64_t latency_us = 0;        // latency EWMA that trips it (0 = off)
+    uint64_t open_ms = 5000;        // first ejection; doubles per re-trip
+    uint32_t max_backoff = 16;      // cap on the doubling (x open_ms)
+};
+
+/*
+ * CircuitBreaker
+ * --------------
+ * Per-upstream health state for one worker.
+ *
+ * Core rules:
+ * - Error rate and latency are EWMAs over recent outcomes, with the
+ *   smoothing derived from min_requests, so one blip cannot trip it
+ * - Consecutive trips back off exponentially; a successful probe
+ *   resets everything
+ * - A probe that never reports (client went away) is written off after
+ *   open_ms so the breaker cannot stick in HALF_OPEN
+ * - Not thread-safe: owned by one loop (see OutlierDetector)
+ */
+class CircuitBreaker {
+public:
+    explicit CircuitBreaker(const BreakerPolicy& policy = BreakerPolicy());
+
+    void set_policy(const BreakerPolicy& policy);
+
+    // May a request go to this upstream now? (counts as the probe
+    // when HALF_OPEN)
+    bool allow(uint64_t now_ms);
+
+    void on_success(uint64_t latency_us, uint64_t now_ms);
+    void on_failure(uint64_t now_ms);
+
+    // Eject without local evidence (outliers seen by other workers)
+    void force_open(uint64_t now_ms);
+
+    BreakerState state() const { return state_; }
+    double error_ewma() const { return error_ewma_; }
+    double latency_ewma_us() const { return latency_ewma_; }
+    uint64_t open_until_ms() const { return open_until_; }
+    uint32_t trips() const { return trips_; }
+
+private:
+    void trip(uint64_t now_ms);
+    void reset();
+
+    BreakerPolicy policy_;
+    double alpha_;
+
+    BreakerState state_{BreakerState::CLOSED};
+    double error_ewma_{0.0};
+    double latency_ewma_{0.0};
+    uint32_t samples_{0};
+
+    uint32_t trips_{0};             // consecutive, reset on recovery
+    uint64_t open_until_{0};
+    bool probe_in_flight_{false};
+    uint64_t probe_started_{0};
+};
@@ -0,0 +1,115 @@
+#include "outlier_detector.h"
+
+HealthBoard::HealthBoard(uint64_t window_ms)
+    : window_ms_(window_ms > 0 ? window_ms : 1) {
+}
+
+void HealthBoard::publish(const std::vector<Counts>& deltas, uint64_t now_ms,
+                          std::vector<Counts>& merged) {
+    std::lock_guard<std::mutex> lock(mu_);
+
+    if (window_start_ == 0) {
+        window_start_ = now_ms;
+    } else if (now_ms >= window_start_ + window_ms_) {
+        // A window idle for longer than one interval is stale, not "previous"
+        if (now_ms >= window_start_ + 2 * window_ms_) {
+            previous_.clear();
+        } else {
+            previous_.swap(current_);
+        }
+        current_.clear();
+        window_start_ = now_ms;
+    }
+
+    for (const Counts& d : deltas) {
+        Window& w = current_[d.key];
+        w.successes += d.successes;
+        w.failures += d.failures;
+    }
+
+    merged.clear();
+    for (const auto& kv : previous_) {
+        merged.push_back({kv.first, kv.second.successes, kv.second.failures});
+    }
+}
+
+void OutlierDetector::set_policy(const BreakerPolicy& policy) {
+    policy_ = policy;
+    for (auto& kv : table_) {
+        kv.second.breaker.set_policy(policy);
+    }
+}
+
+OutlierDetector::Entry& OutlierDetector::entry(uint64_t k) {
+    auto it = table_.find(k);
+    if (it == table_.end()) {
+        it = table_.emplace(k, Entry{CircuitBreaker(policy_)}).first;
+    }
+    return it->second;
+}
+
+bool OutlierDetector::allow(uint32_t addr, uint16_t port, uint64_t now_ms) {
+    auto it = table_.find(key(addr, port));
+    return it == table_.end() || it->second.breaker.allow(now_ms);
+}
+
+void OutlierDetector::on_success(uint32_t addr, uint16_t port, uint64_t latency_us,
+                                 uint64_t now_ms) {
+    Entry& e = entry(key(addr, port));
+    e.breaker.on_success(latency_us, now_ms);
+    ++e.successes;
+}
+
+void OutlierDetector::on_failure(uint32_t addr, uint16_t port, uint64_t now_ms) {
+    Entry& e = entry(key(addr, port));
+    e.breaker.on_failure(now_ms);
+    ++e.failures;
+}
+
+void OutlierDetector::sync(uint64_t now_ms) {
+    if (!board_) {
+        return;
+    }
+
+    deltas_.clear();
+    for (auto& kv : table_) {
+        Entry& e = kv.second;
+        if (e.successes || e.failures) {
+            deltas_.push_back({kv.first, e.successes, e.failures});
+            e.successes = 0;
+            e.failures = 0;
+        }
+    }
+
+    board_->publish(deltas_, now_ms, merged_);
+
+    for (const HealthBoard::Counts& m : merged_) {
+        uint64_t total = m.successes + m.failures;
+        if (total < policy_.min_requests) {
+            continue;
+        }
+        double ratio = static_cast<double>(m.failures) / static_cast<double>(total);
+        if (ratio < policy_.failure_ratio) {
+            continue;
+        }
+        Entry& e = entry(m.key);
+        if (e.breaker.state() == BreakerState::CLOSED) {
+            e.breaker.force_open(now_ms);
+        }
+    }
+}
+
+const CircuitBreaker* OutlierDetector::find(uint32_t addr, uint16_t port) const {
+    auto it = table_.find(key(addr, port));
+    return it == table_.end() ? nullptr : &it->second.breaker;
+}
+
+size_t OutlierDetector::ejected() const {
+    size_t n = 0;
+    for (const auto& kv : table_) {
+        if (kv.second.breaker.state() != BreakerState::CLOSED) {
+            ++n;
+        }
+    }
+    return n;
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "circuit_breaker.h"
+
+/*
+ * HealthBoard
+ * -----------
+ * Fleet-wide view of upstream outcomes, shared by every worker.
+ *
+ * Core rules:
+ * - Workers never touch it per request; they publish counter deltas
+ *   every sync interval (one short critical section per worker)
+ * - Outcomes are summed into fixed windows; readers get the last
+ *   completed window, which every worker has had a chance to fill
+ */
+class HealthBoard {
+public:
+    struct Counts {
+        uint64_t key;
+        uint64_t successes;
+        uint64_t failures;
+    };
+
+    explicit HealthBoard(uint64_t window_ms = 1000);
+
+    HealthBoard(const HealthBoard&) = delete;
+    HealthBoard& operator=(const HealthBoard&) = delete;
+
+    // Add deltas to the current window; fills merged with the last
+    // completed window's totals
+    void publish(const std::vector<Counts>& deltas, uint64_t now_ms,
+                 std::vector<Counts>& merged);
+
+private:
+    struct Window {
+        uint64_t successes{0};
+        uint64_t failures{0};
+    };
+
+    std::mutex mu_;
+    uint64_t window_ms_;
+    uint64_t window_start_{0};
+    std::unordered_map<uint64_t, Window> current_;
+    std::unordered_map<uint64_t, Window> previous_;
+};
+
+/*
+ * OutlierDetector
+ * ---------------
+ * One worker's circuit breakers, keyed by upstream address.
+ *
+ * Core rules:
+ * - Requests consult and update only local breakers (no locking)
+ * - sync() publishes local outcomes to the HealthBoard and ejects
+ *   upstreams the fleet as a whole sees failing, so an outage noticed
+ *   by one worker protects the others within one interval
+ * - Without a board it is purely local
+ */
+class OutlierDetector {
+public:
+    static uint64_t key(uint32_t addr, uint16_t port) {
+        return (static_cast<uint64_t>(addr) << 16) | port;
+    }
+
+    void set_board(HealthBoard* board) { board_ = board; }
+    void set_policy(const BreakerPolicy& policy);
+
+    bool allow(uint32_t addr, uint16_t port, uint64_t now_ms);
+    void on_success(uint32_t addr, uint16_t port, uint64_t latency_us, uint64_t now_ms);
+    void on_failure(uint32_t addr, uint16_t port, uint64_t now_ms);
+
+    void sync(uint64_t now_ms);
+
+    // nullptr if this worker never talked to the upstream
+    const CircuitBreaker* find(uint32_t addr, uint16_t port) const;
+
+    size_t ejected() const;
+
+    // f(addr, port, breaker, successes, failures) for every upstream
+    // this worker has talked to; counts are since the last sync()
+    template <typename F>
+    void for_each(F&& f) const {
+        for (const auto& kv : table_) {
+            f(static_cast<uint32_t>(kv.first >> 16), static_cast<uint16_t>(kv.first & 0xffff),
+              kv.second.breaker, kv.second.successes, kv.second.failures);
+        }
+    }
+
+private:
+    struct Entry {
+        CircuitBreaker breaker;
+        uint64_t successes{0};
+        uint64_t failures{0};
+    };
+
+    Entry& entry(uint64_t k);
+
+    BreakerPolicy policy_;
+    HealthBoard* board_{nullptr};
+    std::unordered_map<uint64_t, Entry> table_;
+
+    // Reused across syncs
+    std::vector<HealthBoard::Counts> deltas_;
+    std::vector<HealthBoard::Counts> merged_;
+};
@@ -0,0 +1,44 @@
+#include "retry_budget.h"
+
+RetryBudget::RetryBudget(uint32_t percent, uint32_t min_per_sec) {
+    configure(percent, min_per_sec);
+}
+
+void RetryBudget::configure(uint32_t percent, uint32_t min_per_sec) {
+    ratio_ = static_cast<double>(percent) / 100.0;
+    min_per_sec_ = min_per_sec;
+
+    double cap = static_cast<double>(min_per_sec) * 10.0;
+    cap_ = cap > 100.0 ? cap : 100.0;
+    if (tokens_ > cap_) {
+        tokens_ = cap_;
+    }
+}
+
+void RetryBudget::on_request() {
+    tokens_ += ratio_;
+    if (tokens_ > cap_) {
+        tokens_ = cap_;
+    }
+}
+
+bool RetryBudget::try_retry(uint64_t now_ms) {
+    uint64_t second = now_ms / 1000;
+    if (second != reserve_second_) {
+        reserve_second_ = second;
+        reserve_ = min_per_sec_;
+    }
+
+    if (tokens_ >= 1.0) {
+        tokens_ -= 1.0;
+        ++granted_;
+        return true;
+    }
+    if (reserve_ > 0) {
+        --reserve_;
+        ++granted_;
+        return true;
+    }
+    ++denied_;
+    return false;
+}
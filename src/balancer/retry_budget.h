@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+
+/*
+ * RetryBudget
+ * -----------
+ * Caps retries to a fraction of regular traffic so that retrying
+ * cannot multiply the load on an upstream that is already failing.
+ *
+ * Core rules:
+ * - Every first attempt deposits `percent`/100 of a token; a retry
+ *   withdraws a whole one
+ * - Deposits are capped (ten seconds' worth at the minimum rate, or
+ *   100 tokens), so a quiet period cannot bank a retry storm
+ * - min_per_sec retries are always available so low-traffic services
+ *   still get retried
+ * - Not thread-safe: one budget per loop
+ */
+class RetryBudget {
+public:
+    RetryBudget(uint32_t percent = 20, uint32_t min_per_sec = 3);
+
+    void configure(uint32_t percent, uint32_t min_per_sec);
+
+    void on_request();
+    bool try_retry(uint64_t now_ms);
+
+    double balance() const { return tokens_; }
+    uint64_t granted() const { return granted_; }
+    uint64_t denied() const { return denied_; }
+
+private:
+    double ratio_;
+    uint32_t min_per_sec_;
+    double cap_;
+
+    double tokens_{0.0};
+    uint32_t reserve_{0};
+    uint64_t reserve_second_{0};
+
+    uint64_t granted_{0};
+    uint64_t denied_{0};
+};
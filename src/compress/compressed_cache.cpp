@@ -0,0 +1,53 @@
+#include "compressed_cache.h"
+
+CompressedCache::CompressedCache(size_t max_entries, size_t max_bytes)
+    : max_entries_(max_entries),
+      max_bytes_(max_bytes) {}
+
+std::shared_ptr<const CompressedCache::Entry> CompressedCache::find(
+    const std::string& key, const std::string& validator) {
+    auto it = map_.find(key);
+    if (it == map_.end()) {
+        return nullptr;
+    }
+
+    if (it->second->second->validator != validator) {
+        // Upstream changed the resource; the stale variant is useless
+        bytes_ -= it->second->second->body.size();
+        lru_.erase(it->second);
+        map_.erase(it);
+        return nullptr;
+    }
+
+    lru_.splice(lru_.begin(), lru_, it->second);
+    ++hits_;
+    return it->second->second;
+}
+
+void CompressedCache::insert(const std::string& key, std::shared_ptr<const Entry> entry) {
+    if (max_entries_ == 0 || entry->body.size() > max_body_bytes()) {
+        return;
+    }
+
+    auto it = map_.find(key);
+    if (it != map_.end()) {
+        bytes_ -= it->second->second->body.size();
+        lru_.erase(it->second);
+        map_.erase(it);
+    }
+
+    bytes_ += entry->body.size();
+    lru_.emplace_front(key, std::move(entry));
+    map_[key] = lru_.begin();
+
+    while (map_.size() > max_entries_ || bytes_ > max_bytes_) {
+        evict_one();
+    }
+}
+
+void CompressedCache::evict_one() {
+    auto& victim = lru_.back();
+    bytes_ -= victim.second->body.size();
+    map_.erase(victim.first);
+    lru_.pop_back();
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+/*
+ * CompressedCache
+ * ---------------
+ * Per-loop LRU of already-compressed response bodies.
+ *
+ * Entries are keyed by request (host + path + coding) and remember the
+ * upstream validator (ETag, else Last-Modified) they were built from.
+ * A lookup only hits when the fresh upstream response carries the same
+ * validator, so the upstream stays authoritative and the cache only
+ * saves the CPU of compressing the same bytes again.
+ *
+ * Bounded by entry count and total body bytes; oldest entries go first.
+ */
+class CompressedCache {
+public:
+    struct Entry {
+        std::string validator;
+        std::string head;       // rewritten response head, CRLFCRLF included
+        std::string body;       // complete encoded body
+    };
+
+    CompressedCache(size_t max_entries, size_t max_bytes);
+
+    // Returns nullptr unless key is cached with this validator
+    std::shared_ptr<const Entry> find(const std::string& key, const std::string& validator);
+
+    void insert(const std::string& key, std::shared_ptr<const Entry> entry);
+
+    size_t size() const { return map_.size(); }
+    size_t bytes() const { return bytes_; }
+    size_t hits() const { return hits_; }
+    size_t max_body_bytes() const { return max_bytes_ / 8; }
+
+private:
+    using Lru = std::list<std::pair<std::string, std::shared_ptr<const Entry>>>;
+
+    void evict_one();
+
+    size_t max_entries_;
+    size_t max_bytes_;
+    size_t bytes_{0};
+    size_t hits_{0};
+
+    Lru lru_;       // front = most recently used
+    std::unordered_map<std::string, Lru::iterator> map_;
+};
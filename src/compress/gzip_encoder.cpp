@@ -0,0 +1,93 @@
+#include "gzip_encoder.h"
+#include "core/buffer/buffer.h"
+
+namespace {
+
+// windowBits + 16 selects the gzip wrapper instead of raw zlib
+constexpr int kGzipWindowBits = 15 + 16;
+constexpr int kMemLevel = 8;
+
+} // namespace
+
+GzipEncoder::GzipEncoder(int level)
+    : level_(level) {
+    valid_ = deflateInit2(&zs_, level, Z_DEFLATED, kGzipWindowBits,
+                          kMemLevel, Z_DEFAULT_STRATEGY) == Z_OK;
+}
+
+GzipEncoder::~GzipEncoder() {
+    if (valid_) {
+        deflateEnd(&zs_);
+    }
+}
+
+bool GzipEncoder::compress(const char* data, size_t len, bool finish, Buffer& out) {
+    if (!valid_) {
+        return false;
+    }
+
+    zs_.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+    zs_.avail_in = static_cast<uInt>(len);
+
+    int flush = finish ? Z_FINISH : Z_NO_FLUSH;
+
+    while (true) {
+        // deflateBound is exact enough for one pass; extra rounds only
+        // happen when the stream holds more pending output than that
+        out.ensure_capacity(deflateBound(&zs_, zs_.avail_in) + 64);
+
+        zs_.next_out = reinterpret_cast<Bytef*>(out.write_ptr());
+        zs_.avail_out = static_cast<uInt>(out.writable_bytes());
+        size_t before = zs_.avail_out;
+
+        int rc = deflate(&zs_, flush);
+        out.commit(before - zs_.avail_out);
+
+        if (rc == Z_STREAM_END) {
+            return true;
+        }
+        if (rc != Z_OK && rc != Z_BUF_ERROR) {
+            return false;
+        }
+        if (zs_.avail_in == 0 && zs_.avail_out != 0) {
+            return !finish || rc == Z_STREAM_END;
+        }
+    }
+}
+
+void GzipEncoder::reset() {
+    if (valid_) {
+        valid_ = deflateReset(&zs_) == Z_OK;
+    }
+}
+
+EncoderPool::EncoderPool(size_t max_idle)
+    : max_idle_(max_idle) {}
+
+std::unique_ptr<GzipEncoder> EncoderPool::acquire(int level) {
+    for (size_t i = idle_.size(); i-- > 0; ) {
+        if (idle_[i]->level() == level) {
+            std::unique_ptr<GzipEncoder> enc = std::move(idle_[i]);
+            idle_[i] = std::move(idle_.back());
+            idle_.pop_back();
+            return enc;
+        }
+    }
+
+    auto enc = std::make_unique<GzipEncoder>(level);
+    if (!enc->valid()) {
+        return nullptr;
+    }
+    ++created_;
+    return enc;
+}
+
+void EncoderPool::release(std::unique_ptr<GzipEncoder> enc) {
+    if (!enc) {
+        return;
+    }
+    enc->reset();
+    if (enc->valid() && idle_.size() < max_idle_) {
+        idle_.push_back(std::move(enc));
+    }
+}
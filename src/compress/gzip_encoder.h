@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include <zlib.h>
+
+class Buffer;
+
+/*
+ * GzipEncoder
+ * -----------
+ * Streaming gzip (RFC 1952) encoder over a single zlib deflate stream.
+ *
+ * Core rules:
+ * - Input may arrive in arbitrary pieces; output is appended to a Buffer
+ * - reset() starts a new member without freeing zlib's ~256KB of state,
+ *   which is what makes pooling worthwhile
+ * - Not thread-safe; owned by one loop at a time
+ */
+class GzipEncoder {
+public:
+    explicit GzipEncoder(int level);
+    ~GzipEncoder();
+
+    GzipEncoder(const GzipEncoder&) = delete;
+    GzipEncoder& operator=(const GzipEncoder&) = delete;
+
+    bool valid() const { return valid_; }
+    int level() const { return level_; }
+
+    // Compress len bytes into out; finish=true writes the gzip trailer
+    // Returns false on a zlib error (the stream must then be reset)
+    bool compress(const char* data, size_t len, bool finish, Buffer& out);
+
+    // Prepare for a new response
+    void reset();
+
+private:
+    z_stream zs_{};
+    int level_;
+    bool valid_{false};
+};
+
+/*
+ * EncoderPool
+ * -----------
+ * Per-loop free list of GzipEncoders.
+ *
+ * acquire() hands out a reset encoder, reusing an idle one when its
+ * level matches; release() keeps at most max_idle encoders around.
+ */
+class EncoderPool {
+public:
+    explicit EncoderPool(size_t max_idle = 32);
+
+    std::unique_ptr<GzipEncoder> acquire(int level);
+    void release(std::unique_ptr<GzipEncoder> enc);
+
+    size_t idle() const { return idle_.size(); }
+    size_t created() const { return created_; }
+
+private:
+    size_t max_idle_;
+    size_t created_{0};
+    std::vector<std::unique_ptr<GzipEncoder>> idle_;
+};
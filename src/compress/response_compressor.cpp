@@ -0,0 +1,355 @@
+#include "response_compressor.h"
+#include "compressed_cache.h"
+#include "gzip_encoder.h"
+#include "core/buffer/buffer.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <strings.h>
+
+namespace {
+
+// A head this large without CRLFCRLF is not a response we will parse
+constexpr size_t kMaxHeadBytes = 64 * 1024;
+
+const std::string* find_header(const HttpHeaders& headers, const char* name) {
+    for (const auto& h : headers) {
+        if (h.first == name) {
+            return &h.second;
+        }
+    }
+    return nullptr;
+}
+
+bool contains_token(const std::string& value, const char* token) {
+    return strcasestr(value.c_str(), token) != nullptr;
+}
+
+// Headers that describe the upstream framing or encoding, replaced by ours
+bool rewritten_header(const std::string& name) {
+    return name == "content-length" || name == "transfer-encoding" ||
+           name == "connection" || name == "keep-alive" ||
+           name == "content-encoding" || name == "vary" || name == "etag";
+}
+
+bool iequals(std::string_view a, const char* b) {
+    return a.size() == std::strlen(b) && strncasecmp(a.data(), b, a.size()) == 0;
+}
+
+} // namespace
+
+ContentCoding ResponseCompressor::negotiate(std::string_view accept_encoding) {
+    // Walk the comma-separated list honouring q=0 ("not acceptable")
+    size_t pos = 0;
+    while (pos < accept_encoding.size()) {
+        size_t comma = accept_encoding.find(',', pos);
+        if (comma == std::string_view::npos) {
+            comma = accept_encoding.size();
+        }
+        std::string_view item = accept_encoding.substr(pos, comma - pos);
+        pos = comma + 1;
+
+        size_t b = item.find_first_not_of(" \t");
+        if (b == std::string_view::npos) {
+            continue;
+        }
+        size_t semi = item.find(';', b);
+        std::string_view coding = item.substr(b, semi == std::string_view::npos
+                                                     ? std::string_view::npos
+                                                     : semi - b);
+        while (!coding.empty() && (coding.back() == ' ' || coding.back() == '\t')) {
+            coding.remove_suffix(1);
+        }
+
+        double q = 1.0;
+        if (semi != std::string_view::npos) {
+            size_t qpos = item.find("q=", semi);
+            if (qpos != std::string_view::npos) {
+                // A qvalue is at most "1.000"; copy it so strtod stays in bounds
+                char num[8] = {};
+                item.copy(num, sizeof(num) - 1, qpos + 2);
+                q = std::strtod(num, nullptr);
+            }
+        }
+
+        if (q > 0 && (iequals(coding, "gzip") || iequals(coding, "x-gzip"))) {
+            return ContentCoding::GZIP;
+        }
+    }
+    return ContentCoding::IDENTITY;
+}
+
+bool ResponseCompressor::compressible_type(const std::string& content_type) {
+    static const char* const kTypes[] = {
+        "text/",
+        "application/json",
+        "application/javascript",
+        "application/xml",
+        "application/xhtml+xml",
+        "application/wasm",
+        "image/svg+xml",
+    };
+
+    for (const char* t : kTypes) {
+        if (strncasecmp(content_type.c_str(), t, std::strlen(t)) == 0) {
+            return true;
+        }
+    }
+
+    // Structured syntax suffixes (RFC 6839): application/problem+json etc.
+    size_t end = content_type.find(';');
+    std::string base = content_type.substr(0, end);
+    return contains_token(base, "+json") || contains_token(base, "+xml");
+}
+
+ResponseCompressor::ResponseCompressor(EncoderPool& pool, CompressedCache* cache, int level,
+                                       size_t min_length, bool head_request,
+                                       std::string cache_key)
+    : pool_(pool),
+      cache_(cache),
+      level_(level),
+      min_length_(min_length),
+      head_request_(head_request),
+      cache_key_(std::move(cache_key)) {
+    parser_.set_head_request(head_request);
+}
+
+ResponseCompressor::~ResponseCompressor() {
+    release_encoder();
+}
+
+void ResponseCompressor::release_encoder() {
+    if (encoder_) {
+        pool_.release(std::move(encoder_));
+    }
+}
+
+bool ResponseCompressor::feed(const char* data, size_t len, Buffer& out) {
+    switch (state_) {
+    case State::PASSTHROUGH:
+        out.append(data, len);
+        return true;
+
+    case State::DONE:
+        // Bytes after a complete response (or after a cache hit) are dropped
+        return true;
+
+    case State::HEAD: {
+        raw_head_.append(data, len);
+
+        ssize_t n = parser_.feed(raw_head_.data(), raw_head_.size(), body_);
+        if (n < 0) {
+            return false;
+        }
+        if (!parser_.head_complete()) {
+            // Body bytes only start after the head; nothing was consumed
+            return raw_head_.size() <= kMaxHeadBytes;
+        }
+
+        // Whatever the parser could not take yet (partial chunk size)
+        std::string rest = raw_head_.substr(n);
+        decide(out);
+        if (state_ == State::COMPRESS && !rest.empty()) {
+            return feed(rest.data(), rest.size(), out);
+        }
+        return state_ != State::COMPRESS || compress_body(parser_.done(), out);
+    }
+
+    case State::COMPRESS: {
+        pending_.append(data, len);
+        ssize_t n = parser_.feed(pending_.data(), pending_.size(), body_);
+        if (n < 0) {
+            return false;
+        }
+        pending_.erase(0, n);
+        return compress_body(parser_.done(), out);
+    }
+    }
+    return false;
+}
+
+bool ResponseCompressor::on_eof(Buffer& out) {
+    switch (state_) {
+    case State::PASSTHROUGH:
+    case State::DONE:
+        return true;
+    case State::HEAD:
+        return false;
+    case State::COMPRESS:
+        if (!parser_.on_eof()) {
+            return false;
+        }
+        return compress_body(true, out);
+    }
+    return false;
+}
+
+void ResponseCompressor::decide(Buffer& out) {
+    validator_ = cache_validator();
+
+    if (!validator_.empty()) {
+        std::shared_ptr<const CompressedCache::Entry> hit = cache_->find(cache_key_, validator_);
+        if (hit) {
+            out.append(hit->head.data(), hit->head.size());
+            out.append(hit->body.data(), hit->body.size());
+            cache_hit_ = true;
+            state_ = State::DONE;
+            return;
+        }
+    }
+
+    if (!should_compress() || !(encoder_ = pool_.acquire(level_))) {
+        out.append(raw_head_.data(), raw_head_.size());
+        raw_head_.clear();
+        body_.clear();
+        state_ = State::PASSTHROUGH;
+        return;
+    }
+
+    std::string head = rewrite_head();
+    out.append(head.data(), head.size());
+    raw_head_.clear();
+
+    caching_ = !validator_.empty();
+    if (caching_) {
+        cached_head_ = std::move(head);
+    }
+    state_ = State::COMPRESS;
+}
+
+bool ResponseCompressor::should_compress() const {
+    if (head_request_ || parser_.status() != 200) {
+        return false;
+    }
+
+    const HttpHeaders& h = parser_.headers();
+
+    const std::string* encoding = find_header(h, "content-encoding");
+    if (encoding && strcasecmp(encoding->c_str(), "identity") != 0) {
+        return false;
+    }
+
+    const std::string* type = find_header(h, "content-type");
+    if (!type || !compressible_type(*type)) {
+        return false;
+    }
+
+    const std::string* cc = find_header(h, "cache-control");
+    if (cc && contains_token(*cc, "no-transform")) {
+        return false;
+    }
+
+    const std::string* length = find_header(h, "content-length");
+    if (length && std::strtoull(length->c_str(), nullptr, 10) < min_length_) {
+        return false;
+    }
+    return true;
+}
+
+std::string ResponseCompressor::cache_validator() const {
+    if (!cache_ || cache_key_.empty() || head_request_ || parser_.status() != 200) {
+        return {};
+    }
+
+    const HttpHeaders& h = parser_.headers();
+
+    // Per-user responses must never be replayed to someone else
+    const std::string* cc = find_header(h, "cache-control");
+    if (cc && (contains_token(*cc, "no-store") || contains_token(*cc, "private"))) {
+        return {};
+    }
+    if (find_header(h, "set-cookie")) {
+        return {};
+    }
+
+    if (const std::string* etag = find_header(h, "etag")) {
+        return "e:" + *etag;
+    }
+    if (const std::string* lm = find_header(h, "last-modified")) {
+        return "m:" + *lm;
+    }
+    return {};
+}
+
+std::string ResponseCompressor::rewrite_head() const {
+    // Keep the upstream status line verbatim (reason phrase included)
+    std::string head = raw_head_.substr(0, raw_head_.find("\r\n") + 2);
+
+    std::string vary = "Accept-Encoding";
+    for (const auto& h : parser_.headers()) {
+        if (h.first == "vary" && !contains_token(h.second, "accept-encoding")) {
+            vary = h.second + ", " + vary;
+        }
+        if (h.first == "etag") {
+            // The encoded bytes differ, so a strong validator must weaken
+            head.append("etag: ");
+            if (h.second.compare(0, 2, "W/") != 0) {
+                head.append("W/");
+            }
+            head.append(h.second).append("\r\n");
+        }
+        if (rewritten_header(h.first)) {
+            continue;
+        }
+        head.append(h.first).append(": ").append(h.second).append("\r\n");
+    }
+
+    head.append("content-encoding: gzip\r\n");
+    head.append("vary: ").append(vary).append("\r\n");
+    // Length is unknown until the encoder finishes: close-delimit the body
+    head.append("connection: close\r\n\r\n");
+    return head;
+}
+
+bool ResponseCompressor::compress_body(bool finish, Buffer& out) {
+    finish_pending_ = finish_pending_ || finish;
+    if (deferred_) {
+        return true;
+    }
+
+    size_t before = out.readable_bytes();
+    if (!encode(out)) {
+        release_encoder();
+        return false;
+    }
+
+    account(out.read_ptr() + before, out.readable_bytes() - before);
+    return true;
+}
+
+bool ResponseCompressor::encode(Buffer& produced) {
+    bool ok = encoder_->compress(body_.data(), body_.size(), finish_pending_, produced);
+    body_.clear();
+    return ok;
+}
+
+void ResponseCompressor::encoded(const Buffer& produced, Buffer& out) {
+    out.append(produced.read_ptr(), produced.readable_bytes());
+    account(produced.read_ptr(), produced.readable_bytes());
+}
+
+void ResponseCompressor::account(const char* data, size_t len) {
+    if (caching_) {
+        if (cached_body_.size() + len > cache_->max_body_bytes()) {
+            caching_ = false;
+            cached_body_.clear();
+            cached_body_.shrink_to_fit();
+        } else {
+            cached_body_.append(data, len);
+        }
+    }
+
+    if (finish_pending_) {
+        release_encoder();
+        state_ = State::DONE;
+
+        if (caching_) {
+            auto entry = std::make_shared<CompressedCache::Entry>();
+            entry->validator = std::move(validator_);
+            entry->head = std::move(cached_head_);
+            entry->body = std::move(cached_body_);
+            cache_->insert(cache_key_, std::move(entry));
+            caching_ = false;
+        }
+    }
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "protocol/http/http_response_parser.h"
+
+class Buffer;
+class CompressedCache;
+class EncoderPool;
+class GzipEncoder;
+
+enum class ContentCoding {
+    IDENTITY,
+    GZIP
+};
+
+/*
+ * ResponseCompressor
+ * ------------------
+ * Body-transform stage between an HTTP/1.1 upstream and the client.
+ *
+ * Responsibilities:
+ * - Decide per response whether to compress (status, type, size, existing
+ *   Content-Encoding, Cache-Control: no-transform)
+ * - Rewrite the response head (Content-Encoding, Vary, weak ETag,
+ *   close-delimited framing)
+ * - Stream the de-chunked body through a pooled GzipEncoder
+ * - Serve and fill the CompressedCache when the response has a validator
+ *
+ * Responses that are not compressed pass through byte-for-byte.
+ *
+ * Deferred mode (encoding on a worker thread):
+ * - feed()/on_eof() only parse and decide; body bytes are held back
+ * - encode_ready() tells the loop there is work; encode() is the pure
+ *   CPU step and may run on any thread while the loop leaves this
+ *   object alone
+ * - encoded() hands the result back on the loop thread (caching and
+ *   returning the encoder to the pool happen there)
+ *
+ * Non-responsibilities:
+ * - Socket I/O and backpressure (the caller decides how much to feed
+ *   per loop iteration)
+ */
+class ResponseCompressor {
+public:
+    // Best coding we support from a request's Accept-Encoding value
+    static ContentCoding negotiate(std::string_view accept_encoding);
+
+    // Content types worth compressing (text, JSON, JS, XML, SVG)
+    static bool compressible_type(const std::string& content_type);
+
+    // cache may be null; cache_key empty disables caching for this response
+    ResponseCompressor(EncoderPool& pool, CompressedCache* cache, int level,
+                       size_t min_length, bool head_request, std::string cache_key);
+    ~ResponseCompressor();
+
+    ResponseCompressor(const ResponseCompressor&) = delete;
+    ResponseCompressor& operator=(const ResponseCompressor&) = delete;
+
+    // Feed raw upstream bytes; bytes for the client are appended to out
+    // Returns false on a malformed response
+    bool feed(const char* data, size_t len, Buffer& out);
+
+    // Upstream closed; completes close-delimited bodies
+    // Returns false if the response was truncated
+    bool on_eof(Buffer& out);
+
+    void set_deferred(bool deferred) { deferred_ = deferred; }
+
+    // Body bytes or the gzip trailer are waiting for encode()
+    bool encode_ready() const {
+        return state_ == State::COMPRESS && (!body_.empty() || finish_pending_);
+    }
+
+    // Compress held-back body bytes into produced (any thread)
+    bool encode(Buffer& produced);
+
+    // Loop thread: append encode() output to out and account for it
+    void encoded(const Buffer& produced, Buffer& out);
+
+    // Complete response written to out (nothing more will be produced)
+    bool done() const { return state_ == State::DONE; }
+
+    bool compressing() const { return encoder_ != nullptr; }
+    bool cache_hit() const { return cache_hit_; }
+
+private:
+    enum class State { HEAD, PASSTHROUGH, COMPRESS, DONE };
+
+    void decide(Buffer& out);
+    bool should_compress() const;
+    std::string cache_validator() const;
+    std::string rewrite_head() const;
+    bool compress_body(bool finish, Buffer& out);
+    void account(const char* data, size_t len);
+    void release_encoder();
+
+    EncoderPool& pool_;
+    CompressedCache* cache_;
+    int level_;
+    size_t min_length_;
+    bool head_request_;
+    std::string cache_key_;
+
+    State state_{State::HEAD};
+    HttpResponseParser parser_;
+    std::string raw_head_;          // raw bytes seen until the head completes
+    std::string pending_;           // raw bytes the parser has not taken yet
+    std::string body_;              // de-chunked body awaiting compression
+    std::unique_ptr<GzipEncoder> encoder_;
+
+    bool deferred_{false};
+    bool finish_pending_{false};
+
+    bool cache_hit_{false};
+    bool caching_{false};
+    std::string validator_;
+    std::string cached_head_;
+    std::string cached_body_;
+};
@@ -0,0 +1,478 @@
+#include "config.h"
+
+#include <arpa/inet.h>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <sstream>
+
+namespace {
+
+std::string trim(const std::string& s) {
+    size_t b = 0;
+    size_t e = s.size();
+    while (b < e && std::isspace(static_cast<unsigned char>(s[b]))) {
+        ++b;
+    }
+    while (e > b && std::isspace(static_cast<unsigned char>(s[e - 1]))) {
+        --e;
+    }
+    return s.substr(b, e - b);
+}
+
+bool parse_unsigned(const std::string& v, unsigned long long max, unsigned long long& out) {
+    if (v.empty() || !std::isdigit(static_cast<unsigned char>(v[0]))) {
+        return false;
+    }
+    errno = 0;
+    char* end = nullptr;
+    unsigned long long n = std::strtoull(v.c_str(), &end, 10);
+    if (errno != 0 || *end != '\0' || n > max) {
+        return false;
+    }
+    out = n;
+    return true;
+}
+
+bool parse_bool(const std::string& v, bool& out) {
+    if (v == "1" || v == "on" || v == "true" || v == "yes") {
+        out = true;
+        return true;
+    }
+    if (v == "0" || v == "off" || v == "false" || v == "no") {
+        out = false;
+        return true;
+    }
+    return false;
+}
+
+// "10.0.0.1:9000, 10.0.0.2:9000"
+bool parse_backends(const std::string& v, std::vector<BackendAddress>& out) {
+    std::vector<BackendAddress> list;
+    std::istringstream in(v);
+    std::string item;
+
+    while (std::getline(in, item, ',')) {
+        item = trim(item);
+        size_t colon = item.rfind(':');
+        if (colon == std::string::npos) {
+            return false;
+        }
+
+        BackendAddress b;
+        unsigned long long port = 0;
+        in_addr a{};
+        if (inet_pton(AF_INET, item.substr(0, colon).c_str(), &a) != 1 ||
+            !parse_unsigned(item.substr(colon + 1), 65535, port) || port == 0) {
+            return false;
+        }
+        b.addr = a.s_addr;
+        b.port = static_cast<uint16_t>(port);
+        list.push_back(b);
+    }
+
+    if (list.empty()) {
+        return false;
+    }
+    out = std::move(list);
+    return true;
+}
+
+// "443, 8443"
+bool parse_ports(const std::string& v, std::vector<uint16_t>& out) {
+    std::vector<uint16_t> list;
+    std::istringstream in(v);
+    std::string item;
+
+    while (std::getline(in, item, ',')) {
+        unsigned long long port = 0;
+        if (!parse_unsigned(trim(item), 65535, port) || port == 0) {
+            return false;
+        }
+        list.push_back(static_cast<uint16_t>(port));
+    }
+
+    if (list.empty()) {
+        return false;
+    }
+    out = std::move(list);
+    return true;
+}
+
+bool header_token(const std::string& s) {
+    if (s.empty()) {
+        return false;
+    }
+    for (char ch : s) {
+        unsigned char c = static_cast<unsigned char>(ch);
+        if (!std::isalnum(c) && !std::strchr("!#$%&'*+-.^_`|~", ch)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// "nodelay notsent_lowat=16384 keepalive=60,10,5" or "none"
+bool parse_socket_options(const std::string& v, bool client, SocketOptions& out) {
+    SocketOptions o;
+    std::istringstream in(v);
+    std::string item;
+    unsigned long long n = 0;
+    const unsigned long long kMax = std::numeric_limits<int32_t>::max();
+
+    while (in >> item) {
+        size_t eq = item.find('=');
+        std::string name = item.substr(0, eq);
+        std::string arg = eq == std::string::npos ? "" : item.substr(eq + 1);
+        bool has_arg = eq != std::string::npos;
+
+        if (name == "none" && !has_arg) {
+            continue;
+        } else if (name == "nodelay" && !has_arg) {
+            o.nodelay = true;
+        } else if (name == "quickack" && !has_arg) {
+            o.quickack = true;
+        } else if (name == "cork" && !has_arg) {
+            o.cork = true;
+        } else if (name == "rcvbuf" && parse_unsigned(arg, kMax, n)) {
+            o.rcvbuf = static_cast<uint32_t>(n);
+        } else if (name == "sndbuf" && parse_unsigned(arg, kMax, n)) {
+            o.sndbuf = static_cast<uint32_t>(n);
+        } else if (name == "notsent_lowat" && parse_unsigned(arg, kMax, n)) {
+            o.notsent_lowat = static_cast<uint32_t>(n);
+        } else if (name == "zerocopy" && client && parse_unsigned(arg, kMax, n)) {
+            o.zerocopy_min_bytes = static_cast<uint32_t>(n);
+        } else if (name == "keepalive" && has_arg) {
+            uint32_t parts[3] = {0, 0, 0};
+            std::istringstream list(arg);
+            std::string part;
+            size_t i = 0;
+            while (std::getline(list, part, ',')) {
+                if (i == 3 || !parse_unsigned(part, 32767, n) || n == 0) {
+                    return false;
+                }
+                parts[i++] = static_cast<uint32_t>(n);
+            }
+            if (i == 0) {
+                return false;
+            }
+            o.keepalive_idle_s = parts[0];
+            o.keepalive_interval_s = parts[1];
+            o.keepalive_count = parts[2];
+        } else {
+            return false;
+        }
+    }
+
+    out = o;
+    return true;
+}
+
+// "remove Name" | "set Name: value" | "add Name: value"
+bool parse_header_rule(const std::string& v, HeaderRule& out) {
+    size_t sp = v.find(' ');
+    if (sp == std::string::npos) {
+        return false;
+    }
+    std::string op = v.substr(0, sp);
+    std::string rest = trim(v.substr(sp + 1));
+
+    HeaderRule r;
+    std::string name = rest;
+    if (op == "remove") {
+        r.op = HeaderRule::Op::REMOVE;
+    } else if (op == "set" || op == "add") {
+        r.op = op == "set" ? HeaderRule::Op::SET : HeaderRule::Op::ADD;
+        size_t colon = rest.find(':');
+        if (colon == std::string::npos) {
+            return false;
+        }
+        name = rest.substr(0, colon);
+        r.line = name + ": " + trim(rest.substr(colon + 1)) + "\r\n";
+    } else {
+        return false;
+    }
+
+    if (!header_token(name)) {
+        return false;
+    }
+    for (char& ch : name) {
+        ch = static_cast<char>(std::tolower(static_cast<unsigned char>(ch)));
+    }
+    r.name = name;
+    out = std::move(r);
+    return true;
+}
+
+} // namespace
+
+bool ConfigLoader::parse(const std::string& text, ProxyConfig& out, std::string& err) {
+    ProxyConfig cfg = out;
+
+    std::istringstream in(text);
+    std::string line;
+    int lineno = 0;
+
+    // Rule lists repeat their key: the first line replaces, later ones append
+    bool request_rules_seen = false;
+    bool response_rules_seen = false;
+
+    while (std::getline(in, line)) {
+        ++lineno;
+
+        size_t hash = line.find('#');
+        if (hash != std::string::npos) {
+            line.resize(hash);
+        }
+        line = trim(line);
+        if (line.empty()) {
+            continue;
+        }
+
+        size_t eq = line.find('=');
+        if (eq == std::string::npos) {
+            err = "line " + std::to_string(lineno) + ": expected key = value";
+            return false;
+        }
+
+        std::string key = trim(line.substr(0, eq));
+        std::string value = trim(line.substr(eq + 1));
+        unsigned long long n = 0;
+        bool ok = true;
+
+        if (key == "listen_port") {
+            ok = parse_unsigned(value, 65535, n) && n > 0;
+            cfg.listen_port = static_cast<uint16_t>(n);
+        } else if (key == "listen_backlog") {
+            ok = parse_unsigned(value, std::numeric_limits<int>::max(), n) && n > 0;
+            cfg.listen_backlog = static_cast<int>(n);
+        } else if (key == "max_connections") {
+            ok = parse_unsigned(value, 1u << 24, n);
+            cfg.max_connections = n;
+        } else if (key == "max_accepts_per_wakeup") {
+            ok = parse_unsigned(value, 1u << 16, n) && n > 0;
+            cfg.max_accepts_per_wakeup = n;
+        } else if (key == "rate_limit_per_sec") {
+            ok = parse_unsigned(value, 1u << 20, n);
+            cfg.rate_limit_per_sec = static_cast<uint32_t>(n);
+        } else if (key == "rate_limit_burst") {
+            ok = parse_unsigned(value, 1u << 20, n) && n > 0;
+            cfg.rate_limit_burst = static_cast<uint32_t>(n);
+        } else if (key == "backend_host") {
+            ok = !value.empty();
+            cfg.backend_host = value;
+        } else if (key == "backends") {
+            ok = parse_backends(value, cfg.backends);
+        } else if (key == "breaker_failure_percent") {
+            ok = parse_unsigned(value, 100, n);
+            cfg.breaker_failure_percent = static_cast<uint32_t>(n);
+        } else if (key == "breaker_min_requests") {
+            ok = parse_unsigned(value, 1u << 20, n) && n > 0;
+            cfg.breaker_min_requests = static_cast<uint32_t>(n);
+        } else if (key == "breaker_open_ms") {
+            ok = parse_unsigned(value, 3600000, n) && n > 0;
+            cfg.breaker_open_ms = static_cast<uint32_t>(n);
+        } else if (key == "breaker_latency_ms") {
+            ok = parse_unsigned(value, 3600000, n);
+            cfg.breaker_latency_ms = static_cast<uint32_t>(n);
+        } else if (key == "health_sync_ms") {
+            ok = parse_unsigned(value, 3600000, n) && n > 0;
+            cfg.health_sync_ms = static_cast<uint32_t>(n);
+        } else if (key == "retry_max") {
+            ok = parse_unsigned(value, 16, n);
+            cfg.retry_max = static_cast<uint32_t>(n);
+        } else if (key == "retry_budget_percent") {
+            ok = parse_unsigned(value, 100, n);
+            cfg.retry_budget_percent = static_cast<uint32_t>(n);
+        } else if (key == "retry_min_per_sec") {
+            ok = parse_unsigned(value, 1u << 20, n);
+            cfg.retry_min_per_sec = static_cast<uint32_t>(n);
+        } else if (key == "mirror_upstream") {
+            std::vector<BackendAddress> list;
+            if (value == "off") {
+                cfg.mirror_upstream = BackendAddress{};
+            } else {
+                ok = parse_backends(value, list) && list.size() == 1;
+                if (ok) {
+                    cfg.mirror_upstream = list[0];
+                }
+            }
+        } else if (key == "mirror_percent") {
+            ok = parse_unsigned(value, 100, n);
+            cfg.mirror_percent = static_cast<uint32_t>(n);
+        } else if (key == "mirror_max_inflight") {
+            ok = parse_unsigned(value, 1u << 16, n);
+            cfg.mirror_max_inflight = static_cast<uint32_t>(n);
+        } else if (key == "mirror_max_bytes") {
+            ok = parse_unsigned(value, 1ull << 32, n);
+            cfg.mirror_max_bytes = n;
+        } else if (key == "mirror_timeout_ms") {
+            ok = parse_unsigned(value, 3600000, n) && n > 0;
+            cfg.mirror_timeout_ms = static_cast<uint32_t>(n);
+        } else if (key == "dns_server") {
+            in_addr probe{};
+            ok = inet_pton(AF_INET, value.c_str(), &probe) == 1;
+            cfg.dns_server = value;
+        } else if (key == "backend_port") {
+            ok = parse_unsigned(value, 65535, n) && n > 0;
+            cfg.backend_port = static_cast<uint16_t>(n);
+        } else if (key == "proxy_protocol") {
+            ok = parse_bool(value, cfg.proxy_protocol);
+        } else if (key == "x_forwarded_for") {
+            ok = parse_bool(value, cfg.x_forwarded_for);
+        } else if (key == "forwarded") {
+            ok = parse_bool(value, cfg.forwarded);
+        } else if (key == "websocket") {
+            ok = parse_bool(value, cfg.websocket);
+        } else if (key == "connect_tunnel") {
+            ok = parse_bool(value, cfg.connect_tunnel);
+        } else if (key == "connect_ports") {
+            ok = parse_ports(value, cfg.connect_ports);
+        } else if (key == "tunnel_idle_ms") {
+            ok = parse_unsigned(value, std::numeric_limits<uint32_t>::max(), n);
+            cfg.tunnel_idle_ms = static_cast<uint32_t>(n);
+        } else if (key == "request_header" || key == "response_header") {
+            bool request = key == "request_header";
+            HeaderRules& rules = request ? cfg.request_headers : cfg.response_headers;
+            bool& seen = request ? request_rules_seen : response_rules_seen;
+            if (!seen) {
+                rules.rules.clear();
+                seen = true;
+            }
+            HeaderRule r;
+            ok = parse_header_rule(value, r);
+            if (ok) {
+                rules.rules.push_back(std::move(r));
+            }
+        } else if (key == "strip_hop_by_hop") {
+            bool strip = false;
+            ok = parse_bool(value, strip);
+            cfg.request_headers.strip_hop_by_hop = strip;
+            cfg.response_headers.strip_hop_by_hop = strip;
+        } else if (key == "client_socket") {
+            ok = parse_socket_options(value, true, cfg.client_socket);
+        } else if (key == "upstream_socket") {
+            ok = parse_socket_options(value, false, cfg.upstream_socket);
+        } else if (key == "http2") {
+            ok = parse_bool(value, cfg.http2);
+        } else if (key == "compression") {
+            ok = parse_bool(value, cfg.compression);
+        } else if (key == "compression_level") {
+            ok = parse_unsigned(value, 9, n) && n > 0;
+            cfg.compression_level = static_cast<int>(n);
+        } else if (key == "compression_min_length") {
+            ok = parse_unsigned(value, 64u << 20, n);
+            cfg.compression_min_length = n;
+        } else if (key == "compression_cache_entries") {
+            ok = parse_unsigned(value, 1u << 24, n);
+            cfg.compression_cache_entries = n;
+        } else if (key == "compression_cache_bytes") {
+            ok = parse_unsigned(value, 4ull << 30, n);
+            cfg.compression_cache_bytes = n;
+        } else if (key == "event_batch_max") {
+            ok = parse_unsigned(value, 1u << 16, n) && n >= 32;
+            cfg.event_batch_max = n;
+        } else if (key == "busy_poll_us") {
+            ok = parse_unsigned(value, 1000000, n);
+            cfg.busy_poll_us = static_cast<uint32_t>(n);
+        } else if (key == "loop_stats_interval_ms") {
+            ok = parse_unsigned(value, std::numeric_limits<uint32_t>::max(), n);
+            cfg.loop_stats_interval_ms = static_cast<uint32_t>(n);
+        } else if (key == "numa_node") {
+            if (value == "off") {
+                cfg.numa_node = -1;
+            } else {
+                ok = parse_unsigned(value, 1023, n);
+                cfg.numa_node = static_cast<int>(n);
+            }
+        } else if (key == "reuseport") {
+            ok = parse_bool(value, cfg.reuseport);
+        } else if (key == "admin_port") {
+            ok = parse_unsigned(value, 65535, n);
+            cfg.admin_port = static_cast<uint16_t>(n);
+        } else if (key == "stats_shm") {
+            ok = value.size() > 1 && value[0] == '/' && value.find('/', 1) == std::string::npos;
+            cfg.stats_shm = value;
+        } else if (key == "stats_shm_interval_ms") {
+            ok = parse_unsigned(value, 3600000, n) && n > 0;
+            cfg.stats_shm_interval_ms = static_cast<uint32_t>(n);
+        } else if (key == "stats_shm_connections") {
+            ok = parse_unsigned(value, 1u << 20, n);
+            cfg.stats_shm_connections = static_cast<uint32_t>(n);
+        } else if (key == "trace_file") {
+            cfg.trace_file = value;
+        } else if (key == "trace_sample_every") {
+            ok = parse_unsigned(value, std::numeric_limits<uint32_t>::max(), n);
+            cfg.trace_sample_every = static_cast<uint32_t>(n);
+        } else if (key == "access_log") {
+            cfg.access_log = value;
+        } else if (key == "access_log_max_bytes") {
+            ok = parse_unsigned(value, std::numeric_limits<uint64_t>::max(), n);
+            cfg.access_log_max_bytes = n;
+        } else if (key == "worker_threads") {
+            ok = parse_unsigned(value, 256, n);
+            cfg.worker_threads = n;
+        } else if (key == "tls_cert") {
+            cfg.tls_cert = value;
+        } else if (key == "tls_key") {
+            cfg.tls_key = value;
+        } else if (key == "tls_session_cache_size") {
+            ok = parse_unsigned(value, 1u << 24, n);
+            cfg.tls_session_cache_size = n;
+        } else if (key == "tls_ktls") {
+            ok = parse_bool(value, cfg.tls_ktls);
+        } else if (key == "upgrade_socket") {
+            cfg.upgrade_socket = value;
+        } else if (key == "drain_timeout_ms") {
+            ok = parse_unsigned(value, std::numeric_limits<uint32_t>::max(), n);
+            cfg.drain_timeout_ms = static_cast<uint32_t>(n);
+        } else if (key == "client_read_buf_size") {
+            ok = parse_unsigned(value, 64u << 20, n) && n > 0;
+            cfg.client_read_buf_size = n;
+        } else if (key == "client_write_buf_size") {
+            ok = parse_unsigned(value, 64u << 20, n) && n > 0;
+            cfg.client_write_buf_size = n;
+        } else if (key == "backend_read_buf_size") {
+            ok = parse_unsigned(value, 64u << 20, n) && n > 0;
+            cfg.backend_read_buf_size = n;
+        } else {
+            err = "line " + std::to_string(lineno) + ": unknown key '" + key + "'";
+            return false;
+        }
+
+        if (!ok) {
+            err = "line " + std::to_string(lineno) + ": invalid value for '" + key + "'";
+            return false;
+        }
+    }
+
+    out = cfg;
+    return true;
+}
+
+bool ConfigLoader::load_file(const std::string& path, ProxyConfig& out, std::string& err) {
+    std::ifstream f(path);
+    if (!f) {
+        err = "cannot open " + path;
+        return false;
+    }
+
+    std::ostringstream ss;
+    ss << f.rdbuf();
+    return parse(ss.str(), out, err);
+}
+
+ConfigStore::ConfigStore(ConfigSnapshot initial)
+    : current_(std::move(initial)) {}
+
+void ConfigStore::publish(ConfigSnapshot next) {
+    std::atomic_store(&current_, std::move(next));
+}
+
+ConfigSnapshot ConfigStore::current() const {
+    return std::atomic_load(&current_);
+}
@@ -0,0 +1,231 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "core/socket/socket_options.h"
+#include "protocol/http/header_rewrite.h"
+
+/*
+ * BackendAddress
+ * --------------
+ * One entry of the "backends" list (IPv4 literal, network byte order).
+ */
+struct BackendAddress {
+    uint32_t addr = 0;
+    uint16_t port = 0;
+};
+
+/*
+ * ProxyConfig
+ * -----------
+ * Immutable snapshot of all tunable proxy settings.
+ *
+ * Core rules:
+ * - Never mutated after publication
+ * - Shared between threads via std::shared_ptr<const ProxyConfig>
+ * - A Connection keeps the snapshot it was created with until it closes
+ */
+struct ProxyConfig {
+    // Listener (applied at startup; listen_port changes need a restart)
+    uint16_t listen_port = 8080;
+    int listen_backlog = 1024;
+
+    // Admission control (0 disables the respective limit)
+    size_t max_connections = 0;
+    size_t max_accepts_per_wakeup = 64;
+    uint32_t rate_limit_per_sec = 0;
+    uint32_t rate_limit_burst = 20;
+
+    // Upstream (backend_host may be an IPv4 literal or a DNS name)
+    std::string backend_host = "127.0.0.1";
+    uint16_t backend_port = 9000;
+
+    // Interchangeable upstreams ("ip:port, ip:port"); when set, requests
+    // are spread across them and backend_host/backend_port are unused
+    std::vector<BackendAddress> backends;
+
+    // Circuit breaking (failure percent 0 disables it): an upstream is
+    // ejected when its error EWMA, or its latency EWMA if the latency
+    // limit is set, crosses the threshold after min_requests outcomes,
+    // for open_ms doubling on each consecutive trip. Workers merge
+    // their outcomes every health_sync_ms.
+    uint32_t breaker_failure_percent = 50;
+    uint32_t breaker_min_requests = 10;
+    uint32_t breaker_open_ms = 5000;
+    uint32_t breaker_latency_ms = 0;
+    uint32_t health_sync_ms = 1000;
+
+    // Idempotent requests that fail before any response byte are retried
+    // (on another upstream when there is one) up to retry_max times,
+    // within a budget of retry_budget_percent of requests plus
+    // retry_min_per_sec
+    uint32_t retry_max = 1;
+    uint32_t retry_budget_percent = 20;
+    uint32_t retry_min_per_sec = 3;
+
+    // Request mirroring: mirror_percent of plain HTTP/1.x requests are
+    // also sent to mirror_upstream ("ip:port", or "off") and the
+    // response discarded. Per worker, at most
+    // mirror_max_inflight shadows holding mirror_max_bytes of request
+    // bytes; past either cap a shadow is skipped. Shadows still
+    // unanswered after mirror_timeout_ms are aborted.
+    BackendAddress mirror_upstream;
+    uint32_t mirror_percent = 100;
+    uint32_t mirror_max_inflight = 64;
+    size_t mirror_max_bytes = 4u << 20;
+    uint32_t mirror_timeout_ms = 5000;
+
+    // DNS server for backend names (applied at startup; empty = resolv.conf)
+    std::string dns_server;
+
+    // Client address handling: require a PROXY protocol v1/v2 header on
+    // every connection (only for listeners behind a load balancer), and
+    // pass the client address upstream as X-Forwarded-For / Forwarded
+    bool proxy_protocol = false;
+    bool x_forwarded_for = false;
+    bool forwarded = false;
+
+    // Tunnels: relay WebSocket upgrades once the backend answers 101 and,
+    // with connect_tunnel, CONNECT to one of connect_ports (anything
+    // else is 403); a tunnel idle for tunnel_idle_ms is closed (0 = never)
+    bool websocket = true;
+    bool connect_tunnel = false;
+    std::vector<uint16_t> connect_ports{443};
+    uint32_t tunnel_idle_ms = 300000;
+
+    // Header edits, one "request_header" / "response_header" line per
+    // rule, applied in order: "set Host: api.internal", "remove Cookie",
+    // "add Via: 1.1 edge". strip_hop_by_hop applies to both directions.
+    HeaderRules request_headers;
+    HeaderRules response_headers;
+
+    // Accept HTTP/2 (h2c prior knowledge, and h2 via ALPN on TLS)
+    bool http2 = true;
+
+    // gzip for HTTP/1.1 responses (cache sizes applied at startup;
+    // entries keyed by URL and revalidated against ETag/Last-Modified)
+    bool compression = false;
+    int compression_level = 6;
+    size_t compression_min_length = 256;
+    size_t compression_cache_entries = 1024;
+    size_t compression_cache_bytes = 32u << 20;
+
+    // Socket tuning, one space-separated profile per side ("none" =
+    // kernel defaults): nodelay, quickack, cork, rcvbuf=N, sndbuf=N,
+    // notsent_lowat=N, keepalive=idle_s[,interval_s[,count]] and, for
+    // clients only, zerocopy=min_bytes. Client changes reach sockets
+    // accepted after the reload.
+    SocketOptions client_socket{/* nodelay */ true};
+    SocketOptions upstream_socket{/* nodelay */ true};
+
+    // Event loop tuning: upper bound for the adaptive epoll batch, spin
+    // time before blocking (also set as SO_BUSY_POLL on proxied sockets;
+    // 0 = off), and how often to log loop histograms (0 = never)
+    size_t event_batch_max = 4096;
+    uint32_t busy_poll_us = 0;
+    uint32_t loop_stats_interval_ms = 0;
+
+    // NUMA placement (applied at startup): numa_node confines every
+    // thread to that node's CPUs and prefers its memory (-1 = off).
+    // reuseport lets one process per node share listen_port; with both
+    // set, a connection goes to the process on the node whose CPU took
+    // it, provided the processes were started in node order
+    int numa_node = -1;
+    bool reuseport = false;
+
+    // Introspection: JSON snapshots on 127.0.0.1:admin_port (applied at
+    // startup; 0 = off), GET /stats or /connections
+    uint16_t admin_port = 0;
+
+    // Shared-memory stats for proxy_top (applied at startup; empty =
+    // off): POSIX shm name, refresh interval and connection table size
+    std::string stats_shm;
+    uint32_t stats_shm_interval_ms = 1000;
+    uint32_t stats_shm_connections = 256;
+
+    // Lifecycle tracing: export file (applied at startup; empty = off)
+    // and sampling rate (trace every Nth connection; 0 = none)
+    std::string trace_file;
+    uint32_t trace_sample_every = 0;
+
+    // Access log: one JSON line per request (applied at startup; empty =
+    // off). Past access_log_max_bytes the file moves to <path>.1 (0 =
+    // never; SIGUSR1 reopens it for external rotation)
+    std::string access_log;
+    uint64_t access_log_max_bytes = 0;
+
+    // Threads that run response encoding off the event loop
+    // (applied at startup; 0 = encode inline on the loop)
+    size_t worker_threads = 0;
+
+    // TLS termination (applied at startup; empty cert = plaintext)
+    std::string tls_cert;
+    std::string tls_key;
+    size_t tls_session_cache_size = 20480;
+    bool tls_ktls = true;
+
+    // Binary upgrade: Unix socket used to hand listening fds to a new
+    // process (empty disables), and how long a drain (after a handover,
+    // SIGTERM or SIGINT) may take before the rest is force-closed
+    std::string upgrade_socket;
+    uint32_t drain_timeout_ms = 30000;
+
+    // Per-connection buffer sizes
+    size_t client_read_buf_size = 4096;
+    size_t client_write_buf_size = 8192;
+    size_t backend_read_buf_size = 8192;
+};
+
+using ConfigSnapshot = std::shared_ptr<const ProxyConfig>;
+
+/*
+ * ConfigLoader
+ * ------------
+ * Parses a "key = value" config file into a ProxyConfig.
+ *
+ * Format:
+ * - One setting per line
+ * - '#' starts a comment
+ * - Unknown keys and malformed values are errors
+ * - Keys not present keep their default values
+ *
+ * Non-responsibilities:
+ * - Publishing snapshots
+ * - Signal handling
+ */
+class ConfigLoader {
+public:
+    // Parse config text
+    // Returns false and fills err on failure (out is left untouched)
+    static bool parse(const std::string& text, ProxyConfig& out, std::string& err);
+
+    // Read and parse a config file (blocking disk I/O, never call on a loop thread)
+    static bool load_file(const std::string& path, ProxyConfig& out, std::string& err);
+};
+
+/*
+ * ConfigStore
+ * -----------
+ * Holds the most recently published ConfigSnapshot.
+ *
+ * publish() and current() are safe to call from any thread.
+ * Event loops should not call current() per request; they cache the
+ * snapshot and refresh it when woken by the reloader.
+ */
+class ConfigStore {
+public:
+    explicit ConfigStore(ConfigSnapshot initial);
+
+    ConfigStore(const ConfigStore&) = delete;
+    ConfigStore& operator=(const ConfigStore&) = delete;
+
+    void publish(ConfigSnapshot next);
+    ConfigSnapshot current() const;
+
+private:
+    ConfigSnapshot current_;
+};
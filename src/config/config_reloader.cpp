@@ -0,0 +1,77 @@
+#include "config_reloader.h"
+
+#include <csignal>
+#include <ctime>
+#include <iostream>
+#include <pthread.h>
+
+ConfigReloader::ConfigReloader(std::string path, ConfigStore& store)
+    : path_(std::move(path)),
+      store_(store) {}
+
+ConfigReloader::~ConfigReloader() {
+    stop();
+}
+
+void ConfigReloader::subscribe(EpollLoop* loop, EpollLoop::Task on_reload) {
+    std::lock_guard<std::mutex> lock(subscribers_mutex_);
+    subscribers_.emplace_back(loop, std::move(on_reload));
+}
+
+bool ConfigReloader::start() {
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGHUP);
+    if (::pthread_sigmask(SIG_BLOCK, &set, nullptr) != 0) {
+        return false;
+    }
+
+    running_.store(true);
+    thread_ = std::thread(&ConfigReloader::run, this);
+    return true;
+}
+
+void ConfigReloader::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void ConfigReloader::run() {
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGHUP);
+
+    // Short timeout so stop() is observed promptly
+    timespec timeout{0, 200 * 1000 * 1000};
+
+    while (running_.load()) {
+        int sig = ::sigtimedwait(&set, nullptr, &timeout);
+        if (sig == SIGHUP) {
+            reload();
+        }
+    }
+}
+
+void ConfigReloader::reload() {
+    // Start from defaults so removed keys fall back rather than linger
+    auto next = std::make_shared<ProxyConfig>();
+    std::string err;
+
+    if (!ConfigLoader::load_file(path_, *next, err)) {
+        std::cerr << "[config] reload failed: " << err
+                  << " (keeping previous config)\n";
+        return;
+    }
+
+    store_.publish(std::move(next));
+    std::cout << "[config] reloaded " << path_ << "\n";
+
+    std::lock_guard<std::mutex> lock(subscribers_mutex_);
+    for (auto& sub : subscribers_) {
+        sub.first->post(sub.second);
+    }
+}
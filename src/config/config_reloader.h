@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "config.h"
+#include "core/event_loop/epoll_loop.h"
+
+/*
+ * ConfigReloader
+ * --------------
+ * Reloads the config file on SIGHUP and publishes a new snapshot.
+ *
+ * Responsibilities:
+ * - Wait for SIGHUP on a dedicated thread (file I/O never runs on a loop)
+ * - Parse the file and publish to ConfigStore
+ * - Post to every subscribed loop so it can pick up the new snapshot
+ *
+ * Non-responsibilities:
+ * - Applying the snapshot (each loop does that on its own thread)
+ * - Rebinding listeners
+ *
+ * A file that fails to parse is logged and the previous snapshot stays live.
+ */
+class ConfigReloader {
+public:
+    ConfigReloader(std::string path, ConfigStore& store);
+    ~ConfigReloader();
+
+    ConfigReloader(const ConfigReloader&) = delete;
+    ConfigReloader& operator=(const ConfigReloader&) = delete;
+
+    // Post on_reload to loop after each successful reload
+    void subscribe(EpollLoop* loop, EpollLoop::Task on_reload);
+
+    // Block SIGHUP in the calling thread and start the reload thread.
+    // Must be called before any other thread is spawned so that every
+    // thread inherits the blocked mask.
+    bool start();
+
+    void stop();
+
+private:
+    void run();
+    void reload();
+
+    std::string path_;
+    ConfigStore& store_;
+
+    std::mutex subscribers_mutex_;
+    std::vector<std::pair<EpollLoop*, EpollLoop::Task>> subscribers_;
+
+    std::atomic<bool> running_{false};
+    std::thread thread_;
+};
@@ -1,3 +1,18 @@
 #include "connection.h"
+#include "h2_frontend.h"
+#include "compress/response_compressor.h"
 
-// All logic handled in ConnectionManager
\ No newline at end of file
+// All logic handled in ConnectionManager
+
+// Out of line so unique_ptr members can hold incomplete types
+Connection::Connection(int cfd, ConfigSnapshot config)
+    : config_(std::move(config)),
+      client_fd_(cfd),
+      client_read_buf(config_->client_read_buf_size),
+      client_write_buf(config_->client_write_buf_size),
+      backend_read_buf(config_->backend_read_buf_size) {
+    std::cout << "[conn] created, client_fd=" << cfd
+              << " state=READING_REQUEST\n";
+}
+
+Connection::~Connection() = default;
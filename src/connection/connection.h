@@ -1,23 +1,110 @@
 #pragma once
 #include <memory>
 #include <iostream>
+#include <sys/socket.h>
 
 #include "core/buffer/buffer.h"
 #include "core/fd/fd_wrapper.h"
+#include "core/memory/arena.h"
+#include "access_log/access_record.h"
+#include "config/config.h"
 #include "connection_state.h"
+#include "tunnel.h"
+#include "trace/conn_trace.h"
+
+#ifdef PROXY_TLS
+#include "tls/tls_session.h"
+#endif
+
+struct ShadowRequest;
+struct UpstreamConn;
+class H2Frontend;
+class ResponseCompressor;
 
 struct Connection {
     struct EpollTag {
         Connection* conn;
         bool is_client;
+        UpstreamConn* upstream = nullptr;   // set for pooled upstream sockets
+        ShadowRequest* shadow = nullptr;    // set for mirrored requests (no conn)
     };
 
+    // Snapshot taken at accept time; reloads never affect a live connection
+    ConfigSnapshot config_;
+
     FDWrapper client_fd_;
     FDWrapper backend_fd_;
 
-    Buffer client_read_buf{4096};
-    Buffer client_write_buf{8192};
-    Buffer backend_read_buf{8192};
+    // Client address: the accepted peer, or the one a PROXY header named
+    sockaddr_storage peer_{};
+
+    Buffer client_read_buf;
+    Buffer client_write_buf;
+    Buffer backend_read_buf;
+
+    // Framed length (head + body) of the request at the front of
+    // client_read_buf; anything past it is a pipelined request
+    size_t request_len_{0};
+
+    // Upstream serving the current request, and what a retry needs:
+    // a copy of the request (empty unless it is idempotent)
+    uint32_t upstream_addr_{0};
+    uint16_t upstream_port_{0};
+    uint64_t backend_start_us_{0};
+    bool backend_responded_{false};
+    unsigned attempts_{0};
+    Buffer retry_request_{0};
+
+    // Request bytes the first writev to the backend could not take
+    // (empty on the fast path, so it never allocates there)
+    Buffer backend_write_buf{0};
+
+#ifdef PROXY_TLS
+    // Present only on TLS listeners
+    std::unique_ptr<TlsSession> tls_;
+#endif
+
+    // Present once the client spoke the HTTP/2 preface
+    std::unique_ptr<H2Frontend> h2_;
+    bool client_out_armed_{false};      // EPOLLOUT registered on client fd
+    bool client_in_paused_{false};      // EPOLLIN dropped: read buffer full mid-exchange
+
+    // MSG_ZEROCOPY sends issued on the client fd and completions reaped:
+    // client_write_buf must not move or change until they match
+    bool zerocopy_{false};
+    uint32_t zc_sent_{0};
+    uint32_t zc_done_{0};
+    bool corked_{false};                // TCP_CORK set on the client fd
+
+    // Present when the HTTP/1.1 request accepted a coding we can produce
+    std::unique_ptr<ResponseCompressor> compress_;
+
+    // Offloaded tasks still referencing this connection; it is only
+    // destroyed once they have all completed
+    unsigned pending_tasks_{0};
+
+    // Set when the request asked for a tunnel; tunnel_ exists once it
+    // is open (state TUNNELING)
+    TunnelRequest tunnel_request_{TunnelRequest::NONE};
+    std::unique_ptr<Tunnel> tunnel_;
+
+    // Scratch memory for the current request's parsed pieces; reset
+    // when the next request completes
+    Arena arena_;
+
+    // For introspection: accept time and client-side bytes (tunnel
+    // bytes are counted per leg)
+    uint64_t accepted_ms_{0};
+    uint64_t bytes_in_{0};
+    uint64_t bytes_out_{0};
+
+    // Lifecycle timestamps (taken only when this connection was sampled)
+    ConnTrace trace_;
+
+    // Access log entry, filled in as the request progresses and pushed
+    // on close (only when an access log is configured)
+    AccessRecord access_;
+    uint64_t request_start_us_{0};
 
     ConnectionState state_{ConnectionState::READING_REQUEST};
     bool closing_{false};
@@ -25,11 +112,8 @@ struct Connection {
     EpollTag client_tag{this, true};
     EpollTag backend_tag{this, false};
 
-    explicit Connection(int cfd)
-        : client_fd_(cfd) {
-        std::cout << "[conn] created, client_fd=" << cfd
-                  << " state=READING_REQUEST\n";
-    }
+    Connection(int cfd, ConfigSnapshot config);
+    ~Connection();
 
     int client_fd() const { return client_fd_.get(); }
     int backend_fd() const { return backend_fd_.get(); }
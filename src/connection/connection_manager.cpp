@@ -1,52 +1,573 @@
 #include "connection_manager.h"
+#include "h2_frontend.h"
+#include "admin/json_writer.h"
+#include "access_log/access_log_ring.h"
+#include "admission/rate_limiter.h"
+#include "compress/response_compressor.h"
+#include "core/executor/work_stealing_pool.h"
+#include "core/memory/arena.h"
 #include "core/socket/socket.h"
+#include "dns/dns_resolver.h"
+#include "protocol/http/forwarded.h"
+#include "protocol/http/header_rewrite.h"
+#include "protocol/http2/h2_frame.h"
+#include "protocol/proxy/proxy_protocol.h"
+#include "trace/trace_ring.h"
 
 #include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <fcntl.h>
 #include <unistd.h>
 #include <errno.h>
+#include <chrono>
+#include <algorithm>
+#include <cstring>
+#include <cctype>
+#include <string_view>
 
-ConnectionManager::ConnectionManager(EpollLoop& loop)
-    : loop_(loop) {}
+namespace {
 
-void ConnectionManager::add_client(int fd) {
-    auto conn = std::make_unique<Connection>(fd);
+// Per wakeup and direction, a tunnel moves at most this many chunks
+// before yielding to other connections
+constexpr size_t kTunnelChunk = 65536;
+constexpr int kTunnelReads = 4;
 
-    loop_.add(fd, EPOLLIN | EPOLLRDHUP, &conn->client_tag);
+// The resolver gives up after its own retries well before this; it
+// bounds a wait even if no answer is ever reported
+constexpr uint64_t kDnsWaitMs = 10000;
+
+uint64_t now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+uint64_t now_us() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// RateLimiter keys are 32 bits: an IPv4 address as is, an IPv6 one by
+// its /64 (what a single client usually controls)
+uint32_t rate_key(const sockaddr_storage& peer) {
+    if (peer.ss_family == AF_INET)
+        return reinterpret_cast<const sockaddr_in&>(peer).sin_addr.s_addr;
+
+    uint32_t w[2] = {};
+    if (peer.ss_family == AF_INET6)
+        std::memcpy(w, &reinterpret_cast<const sockaddr_in6&>(peer).sin6_addr, sizeof(w));
+    return w[0] ^ w[1];
+}
+
+// Safe to replay on another upstream (RFC 9110 9.2.2)
+bool idempotent(std::string_view method) {
+    return method == "GET" || method == "HEAD" || method == "OPTIONS" ||
+           method == "TRACE" || method == "PUT" || method == "DELETE";
+}
+
+// Case-insensitive membership in a comma-separated header list
+bool has_token(std::string_view list, const char* token) {
+    size_t tlen = std::strlen(token);
+    size_t i = 0;
+    while (i < list.size()) {
+        size_t end = list.find(',', i);
+        if (end == std::string_view::npos)
+            end = list.size();
+
+        size_t b = i;
+        size_t e = end;
+        while (b < e && (list[b] == ' ' || list[b] == '\t'))
+            ++b;
+        while (e > b && (list[e - 1] == ' ' || list[e - 1] == '\t'))
+            --e;
+
+        if (e - b == tlen) {
+            size_t k = 0;
+            while (k < tlen && std::tolower(static_cast<unsigned char>(list[b + k])) == token[k])
+                ++k;
+            if (k == tlen)
+                return true;
+        }
+        i = end + 1;
+    }
+    return false;
+}
+
+// Status code of a response starting at buf ("HTTP/1.x NNN"), 0 if
+// the first read did not carry a status line
+uint16_t response_status(const char* buf, size_t n) {
+    if (n < 12 || std::memcmp(buf, "HTTP/1.", 7) != 0 || buf[8] != ' ')
+        return 0;
+    uint16_t status = 0;
+    for (int i = 9; i < 12; ++i) {
+        if (buf[i] < '0' || buf[i] > '9')
+            return 0;
+        status = static_cast<uint16_t>(status * 10 + (buf[i] - '0'));
+    }
+    return status;
+}
+
+} // namespace
+
+ConnectionManager::ConnectionManager(EpollLoop& loop, ConfigSnapshot config)
+    : loop_(loop),
+      config_(std::move(config)),
+      upstreams_(loop),
+      mirror_(loop),
+      compressed_cache_(config_->compression_cache_entries,
+                        config_->compression_cache_bytes) {
+    clock_ms_ = now_ms();
+    apply_upstream_policy();
+}
+
+void ConnectionManager::set_config(ConfigSnapshot config) {
+    config_ = std::move(config);
+    apply_upstream_policy();
+}
+
+void ConnectionManager::apply_upstream_policy() {
+    BreakerPolicy p;
+    p.failure_ratio = config_->breaker_failure_percent / 100.0;
+    p.min_requests = config_->breaker_min_requests;
+    p.latency_us = static_cast<uint64_t>(config_->breaker_latency_ms) * 1000;
+    p.open_ms = config_->breaker_open_ms;
+    outliers_.set_policy(p);
+
+    retry_budget_.configure(config_->retry_budget_percent, config_->retry_min_per_sec);
+}
+
+void ConnectionManager::set_health_board(HealthBoard* board) {
+    outliers_.set_board(board);
+}
+
+void ConnectionManager::tick(uint64_t now) {
+    clock_ms_ = now;
+    expire_tunnels(now);
+    expire_dns_waits(now);
+    mirror_.expire(now);
+
+    if (now < next_sync_ms_)
+        return;
+    outliers_.sync(now);
+    next_sync_ms_ = now + config_->health_sync_ms;
+}
+
+void ConnectionManager::set_resolver(DnsResolver* resolver) {
+    resolver_ = resolver;
+}
+
+void ConnectionManager::set_tls(TlsContext* tls) {
+    tls_ = tls;
+}
+
+void ConnectionManager::set_executor(WorkStealingPool* pool) {
+    pool_ = pool;
+}
+
+void ConnectionManager::set_tracer(TraceRing* ring) {
+    trace_ring_ = ring;
+}
+
+void ConnectionManager::set_access_log(AccessLogRing* ring) {
+    access_ring_ = ring;
+}
+
+void ConnectionManager::add_client(int fd, const sockaddr_in* peer) {
+    auto conn = std::make_unique<Connection>(fd, config_);
+    if (peer)
+        std::memcpy(&conn->peer_, peer, sizeof(*peer));
+    conn->accepted_ms_ = now_ms();
+    conn->trace_.conn_id = ++next_conn_id_;
+    ++traffic_.accepted;
+    conn->trace_.sampled = trace_ring_ && trace_sampler_.sample(config_->trace_sample_every);
+    conn->trace_.mark(TracePoint::ACCEPT);
+    if (config_->busy_poll_us > 0)
+        Socket::set_busy_poll(fd, config_->busy_poll_us);
+
+    bool plain = true;
+#ifdef PROXY_TLS
+    if (tls_) {
+        conn->tls_ = std::make_unique<TlsSession>(*tls_, fd);
+        conn->state_ = ConnectionState::TLS_HANDSHAKE;
+        plain = false;
+    }
+#endif
+
+    // The rest of client_socket was inherited from the listener
+    const SocketOptions& so = config_->client_socket;
+    if (so.quickack)
+        Socket::set_quickack(fd);
+    if (so.zerocopy_min_bytes > 0 && plain)
+        conn->zerocopy_ = Socket::set_zerocopy(fd);
+
+    // The PROXY header is peeked, not read, so a partial one must not
+    // keep a level-triggered fd firing: edge-triggered until it is done
+    uint32_t events = EPOLLIN | EPOLLRDHUP;
+    if (config_->proxy_protocol) {
+        conn->state_ = ConnectionState::READING_PROXY_HEADER;
+        events |= EPOLLET;
+    }
+    loop_.add(fd, events, &conn->client_tag);
 
     std::cout << "[proxy] registered client fd=" << fd << "\n";
     conns_[fd] = std::move(conn);
+    ++active_;
 }
 
 void ConnectionManager::handle_event(void* data, uint32_t events) {
     auto* tag = static_cast<Connection::EpollTag*>(data);
+    if (tag->shadow) {
+        mirror_.handle_event(tag->shadow, events);
+        return;
+    }
+
     Connection* c = tag->conn;
 
     if (!c || c->is_closing())
         return;
 
+    if (tag->upstream) {
+        if (c->h2_) {
+            c->h2_->on_upstream_event(tag->upstream, events);
+            flush_h2(c);
+        }
+        return;
+    }
+
+    if (c->h2_ && tag->is_client) {
+        if (events & (EPOLLERR | EPOLLHUP)) {
+            close_connection(c);
+            return;
+        }
+        if (events & EPOLLOUT)
+            flush_h2(c);
+        // EPOLLRDHUP surfaces as a 0-byte read after buffered frames
+        if (!c->is_closing() && (events & (EPOLLIN | EPOLLRDHUP)))
+            handle_h2_read(c);
+        return;
+    }
+
+    // Tunnel: each fd is the source of one leg and the sink of the other
+    if (c->state_ == ConnectionState::TUNNELING) {
+        if (events & EPOLLERR) {
+            close_connection(c);
+            return;
+        }
+        uint32_t src = events & (EPOLLIN | EPOLLHUP);
+        uint32_t dst = events & (EPOLLOUT | EPOLLHUP);
+        pump_tunnel(c, tag->is_client ? src : dst, tag->is_client ? dst : src);
+        return;
+    }
+
+    // Zerocopy completions queue on the client's error queue and show up
+    // as EPOLLERR; only an empty queue means a real socket error
+    if (tag->is_client && (events & EPOLLERR) && c->zc_done_ != c->zc_sent_) {
+        bool copied = false;
+        if (!Socket::reap_zerocopy(c->client_fd(), c->zc_done_, copied)) {
+            close_connection(c);
+            return;
+        }
+        // The kernel copied anyway (e.g. loopback): plain writes are cheaper
+        if (copied && c->zerocopy_) {
+            c->zerocopy_ = false;
+            ++zerocopy_fallbacks_;
+        }
+        if (c->zc_done_ == c->zc_sent_ && c->state_ == ConnectionState::WRITING_CLIENT &&
+            c->client_write_buf.readable_bytes() == 0) {
+            finish_exchange(c);
+            return;
+        }
+        events &= ~EPOLLERR;
+        if (events == 0)
+            return;
+    }
+
     int fd = tag->is_client ? c->client_fd() : c->backend_fd();
 
     std::cout << "[proxy] epoll event fd=" << fd
               << " events=" << events
               << " state=" << static_cast<int>(c->state_) << "\n";
 
-    if (events & (EPOLLERR | EPOLLHUP | EPOLLRDHUP)) {
-        close_connection(c);
+    // The upstream usually hangs up right behind its last bytes (and a
+    // compressed response still owes the client its trailer), so that
+    // hangup is handled as reads until EOF rather than a hard close
+    bool upstream_eof = !tag->is_client && !(events & EPOLLERR);
+
+    if ((events & (EPOLLERR | EPOLLHUP | EPOLLRDHUP)) && !upstream_eof) {
+        if (tag->is_client)
+            close_connection(c);
+        else
+            on_backend_failure(c);
         return;
     }
 
-    if (tag->is_client && (events & EPOLLIN)) {
+    if (tag->is_client && c->state_ == ConnectionState::READING_PROXY_HEADER) {
+        if (events & EPOLLIN)
+            handle_proxy_header(c);
+    } else if (tag->is_client && c->state_ == ConnectionState::TLS_HANDSHAKE) {
+        if (events & (EPOLLIN | EPOLLOUT))
+            handle_tls_handshake(c);
+    } else if (tag->is_client && (events & EPOLLOUT)) {
+        flush_client(c);
+    } else if (tag->is_client && (events & EPOLLIN)) {
         handle_client_read(c);
-    } else if (!tag->is_client && (events & EPOLLIN)) {
-        handle_backend_read(c);
+    } else if (!tag->is_client && c->tunnel_request_ == TunnelRequest::CONNECT &&
+               c->state_ == ConnectionState::CONNECTING_BACKEND) {
+        if (events & EPOLLOUT)
+            finish_connect_tunnel(c);
+    } else if (!tag->is_client) {
+        if ((events & EPOLLOUT) && c->backend_write_buf.readable_bytes() > 0)
+            flush_backend(c);
+        if (!c->is_closing() && (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP)))
+            handle_backend_read(c);
     }
 }
 
+void ConnectionManager::handle_tls_handshake(Connection* c) {
+#ifdef PROXY_TLS
+    switch (c->tls_->handshake()) {
+    case TlsHandshakeResult::DONE:
+        std::cout << "[tls] handshake done client_fd=" << c->client_fd()
+                  << " ktls_tx=" << c->tls_->ktls_send() << "\n";
+        c->trace_.mark(TracePoint::TLS_DONE);
+        c->state_ = ConnectionState::READING_REQUEST;
+        loop_.modify(c->client_fd(), EPOLLIN | EPOLLRDHUP, &c->client_tag);
+        break;
+    case TlsHandshakeResult::WANT_READ:
+        loop_.modify(c->client_fd(), EPOLLIN | EPOLLRDHUP, &c->client_tag);
+        break;
+    case TlsHandshakeResult::WANT_WRITE:
+        loop_.modify(c->client_fd(), EPOLLOUT | EPOLLRDHUP, &c->client_tag);
+        break;
+    case TlsHandshakeResult::ERROR:
+        close_connection(c);
+        break;
+    }
+#else
+    close_connection(c);
+#endif
+}
+
+void ConnectionManager::handle_proxy_header(Connection* c) {
+    // Peek so a TLS ClientHello behind the header stays in the socket
+    // for OpenSSL, which reads the fd directly
+    Buffer& scratch = c->client_read_buf;
+    size_t want = ProxyProtocol::kRecommendedPeek;
+    ProxyHeader hdr;
+    ProxyHeaderResult res;
+
+    while (true) {
+        scratch.ensure_capacity(want);
+        ssize_t n = ::recv(c->client_fd(), scratch.write_ptr(), want, MSG_PEEK);
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            return;
+        if (n <= 0) {
+            close_connection(c);
+            return;
+        }
+
+        res = ProxyProtocol::parse(scratch.write_ptr(), n, hdr);
+
+        // v2 with TLVs beyond the first peek: the length is known now
+        if (res == ProxyHeaderResult::INCOMPLETE && hdr.header_bytes > want &&
+            static_cast<size_t>(n) == want) {
+            want = hdr.header_bytes;
+            continue;
+        }
+        break;
+    }
+
+    if (res == ProxyHeaderResult::INCOMPLETE)
+        return;
+    if (res == ProxyHeaderResult::ERROR) {
+        std::cout << "[proxy] bad PROXY header client_fd=" << c->client_fd() << "\n";
+        close_connection(c);
+        return;
+    }
+
+    // Now consume exactly the header
+    if (::recv(c->client_fd(), scratch.write_ptr(), hdr.header_bytes, 0) !=
+        static_cast<ssize_t>(hdr.header_bytes)) {
+        close_connection(c);
+        return;
+    }
+
+    if (!hdr.local)
+        c->peer_ = hdr.source;
+
+    std::cout << "[proxy] PROXY v" << hdr.version << " client "
+              << ForwardedSplicer::format_address(c->peer_) << "\n";
+
+    // At accept time the peer was the load balancer, shared by everyone
+    if (limiter_ && !hdr.local && !limiter_->allow(rate_key(c->peer_), now_us())) {
+        std::cout << "[proxy] rate limited client_fd=" << c->client_fd() << "\n";
+        close_connection(c);
+        return;
+    }
+
+    c->state_ = ConnectionState::READING_REQUEST;
+#ifdef PROXY_TLS
+    if (c->tls_)
+        c->state_ = ConnectionState::TLS_HANDSHAKE;
+#endif
+
+    // Back to level-triggered; bytes already queued fire right away
+    loop_.modify(c->client_fd(), EPOLLIN | EPOLLRDHUP, &c->client_tag);
+}
+
+bool ConnectionManager::detect_h2_preface(Connection* c) {
+    size_t len = c->client_read_buf.readable_bytes();
+    size_t n = std::min(len, h2::kPrefaceLen);
+
+    if (std::memcmp(c->client_read_buf.read_ptr(), h2::kPreface, n) != 0)
+        return false;
+
+    // Could still become the preface: wait (it contains a blank line
+    // that HttpParser would otherwise accept as a complete request)
+    if (len < h2::kPrefaceLen)
+        return true;
+
+    std::cout << "[h2] client_fd=" << c->client_fd() << " switching to HTTP/2\n";
+
+    c->h2_ = std::make_unique<H2Frontend>(*c, loop_, upstreams_);
+    c->h2_->set_routing(
+        [this, c](uint32_t& addr, uint16_t& port) { return route_stream(c, addr, port); },
+        [this, c](const UpstreamConn& u, bool ok) { on_stream_outcome(c, u, ok); });
+    c->state_ = ConnectionState::MULTIPLEXING;
+
+    size_t used = 0;
+    bool ok = c->h2_->on_client_data(c->client_read_buf.read_ptr(),
+                                     c->client_read_buf.readable_bytes(), used);
+    c->client_read_buf.consume(used);
+
+    flush_h2(c);
+    if (!ok && !c->is_closing())
+        close_connection(c);
+    return true;
+}
+
+void ConnectionManager::handle_h2_read(Connection* c) {
+    // Several rounds so TLS records buffered inside OpenSSL (invisible
+    // to epoll) are drained too; bounded to keep the loop fair
+    for (int round = 0; round < 8; ++round) {
+        c->client_read_buf.ensure_capacity(16384);
+
+        ssize_t n = client_read(c, c->client_read_buf.write_ptr(),
+                                c->client_read_buf.writable_bytes());
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            break;
+        if (n <= 0) {
+            close_connection(c);
+            return;
+        }
+        c->client_read_buf.commit(n);
+
+        size_t used = 0;
+        bool ok = c->h2_->on_client_data(c->client_read_buf.read_ptr(),
+                                         c->client_read_buf.readable_bytes(), used);
+        c->client_read_buf.consume(used);
+
+        if (!ok) {
+            flush_h2(c);
+            if (!c->is_closing())
+                close_connection(c);
+            return;
+        }
+    }
+
+    flush_h2(c);
+}
+
+void ConnectionManager::flush_h2(Connection* c) {
+    if (c->is_closing())
+        return;
+
+    Buffer& out = c->h2_->output();
+
+    while (out.readable_bytes() > 0) {
+        ssize_t n = client_write(c, out.read_ptr(), out.readable_bytes());
+        if (n > 0) {
+            out.consume(n);
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            break;
+        close_connection(c);
+        return;
+    }
+
+    bool want_out = out.readable_bytes() > 0;
+    if (want_out != c->client_out_armed_) {
+        uint32_t ev = EPOLLIN | EPOLLRDHUP | (want_out ? uint32_t{EPOLLOUT} : 0);
+        loop_.modify(c->client_fd(), ev, &c->client_tag);
+        c->client_out_armed_ = want_out;
+    }
+
+    if (!want_out) {
+        c->h2_->on_client_drained();
+        if (c->h2_->finished())
+            close_connection(c);
+    }
+}
+
+ssize_t ConnectionManager::client_read(Connection* c, void* buf, size_t len) {
+#ifdef PROXY_TLS
+    ssize_t n;
+    if (c->tls_)
+        n = c->tls_->read(buf, len);
+    else
+        n = Socket::read(c->client_fd(), buf, len);
+#else
+    ssize_t n = Socket::read(c->client_fd(), buf, len);
+#endif
+    if (n > 0) {
+        c->bytes_in_ += n;
+        traffic_.bytes_in += n;
+    }
+    return n;
+}
+
+ssize_t ConnectionManager::client_write(Connection* c, const void* buf, size_t len,
+                                       bool zerocopy) {
+    ssize_t n;
+    if (zerocopy)
+        n = Socket::send_zerocopy(c->client_fd(), buf, len);
+#ifdef PROXY_TLS
+    else if (c->tls_)
+        n = c->tls_->write(buf, len);
+#endif
+    else
+        n = Socket::write(c->client_fd(), buf, len);
+
+    if (n > 0) {
+        if (zerocopy) {
+            ++c->zc_sent_;
+            ++zerocopy_sends_;
+        }
+        c->bytes_out_ += n;
+        traffic_.bytes_out += n;
+        c->trace_.mark(TracePoint::CLIENT_FIRST_WRITE);
+    }
+    return n;
+}
+
 void ConnectionManager::handle_client_read(Connection* c) {
     char* wptr = c->client_read_buf.write_ptr();
     size_t cap = c->client_read_buf.writable_bytes();
 
-    ssize_t n = Socket::read(c->client_fd(), wptr, cap);
+    // A pipelined request filled the buffer behind the exchange in
+    // progress: stop reading until finish_exchange() gets to it
+    if (cap == 0 && c->state_ != ConnectionState::READING_REQUEST) {
+        c->client_in_paused_ = true;
+        loop_.modify(c->client_fd(), EPOLLRDHUP | (c->client_out_armed_ ? uint32_t{EPOLLOUT} : 0),
+                     &c->client_tag);
+        return;
+    }
+
+    ssize_t n = client_read(c, wptr, cap);
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        return;
+
     if (n <= 0) {
         close_connection(c);
         return;
@@ -55,6 +576,20 @@ void ConnectionManager::handle_client_read(Connection* c) {
     c->client_read_buf.commit(n);
     std::cout << "[proxy] read " << n << " bytes from client\n";
 
+    // Mid-exchange (parked on DNS or a worker, relaying the response, or
+    // waiting to learn whether an upgrade was accepted): keep buffering.
+    // An upgrade takes these bytes as its first frames, anything else
+    // as the next pipelined request
+    if (c->state_ != ConnectionState::READING_REQUEST)
+        return;
+
+    if (c->config_->http2 && detect_h2_preface(c))
+        return;
+
+    handle_request(c);
+}
+
+void ConnectionManager::handle_request(Connection* c) {
     HttpParser parser;
     HttpRequestInfo req;
 
@@ -64,10 +599,255 @@ void ConnectionManager::handle_client_read(Connection* c) {
         req
     );
 
+    if (res == HttpParseResult::ERROR) {
+        // A chunked body is valid HTTP the proxy cannot frame; anything
+        // else (conflicting or malformed framing) is the client's fault
+        std::cout << "[proxy] " << (req.unsupported_encoding ? "unsupported" : "malformed")
+                  << " request framing\n";
+        reply_error(c, req.unsupported_encoding ? 501 : 400);
+        return;
+    }
     if (res != HttpParseResult::COMPLETE)
         return;
 
     std::cout << "[proxy] HTTP request COMPLETE\n";
+    ++traffic_.requests;
+    c->request_len_ = req.header_bytes + req.body_bytes;
+    c->trace_.mark(TracePoint::REQUEST_HEADERS);
+    if (access_ring_) {
+        c->access_.set_request_line(c->client_read_buf.read_ptr(), req.header_bytes);
+        c->request_start_us_ = now_us();
+    }
+
+    c->state_ = ConnectionState::CONNECTING_BACKEND;
+
+    // Whatever the previous request left in the arena is dead now
+    c->arena_.reset();
+    std::pmr::string target(&c->arena_);
+    c->tunnel_request_ = classify_tunnel(c, req, target);
+    if (c->tunnel_request_ == TunnelRequest::CONNECT) {
+        open_connect_tunnel(c, req, target);
+        return;
+    }
+
+    // An upgraded exchange must reach the client byte for byte
+    if (c->tunnel_request_ == TunnelRequest::NONE)
+        setup_compression(c, req);
+    prepare_retry(c, req);
+
+    uint32_t addr = 0;
+    uint16_t port = 0;
+    if (select_backend(c, addr, port))
+        connect_backend(c, addr, port);
+}
+
+void ConnectionManager::prepare_retry(Connection* c, const HttpRequestInfo& req) {
+    retry_budget_.on_request();
+    c->attempts_ = 0;
+    c->retry_request_.clear();
+
+    if (c->config_->retry_max == 0)
+        return;
+
+    std::pmr::string method(&c->arena_);
+    std::pmr::string target(&c->arena_);
+    const char* data = c->client_read_buf.read_ptr();
+    if (!HttpParser::parse_request_line(data, req.header_bytes, method, target) ||
+        !idempotent(method))
+        return;
+
+    c->retry_request_.append(data, req.header_bytes + req.body_bytes);
+}
+
+bool ConnectionManager::select_backend(Connection* c, uint32_t& addr, uint16_t& port) {
+    const ProxyConfig& cfg = *c->config_;
+
+    if (cfg.backends.empty()) {
+        port = cfg.backend_port;
+        return resolve_backend(c, addr) && admit_upstream(c, addr, port);
+    }
+
+    if (next_backend(c, addr, port))
+        return true;
+
+    std::cout << "[proxy] every upstream is ejected\n";
+    reply_error(c, 503);
+    return false;
+}
+
+bool ConnectionManager::next_backend(Connection* c, uint32_t& addr, uint16_t& port) {
+    const ProxyConfig& cfg = *c->config_;
+    size_t n = cfg.backends.size();
+    uint64_t now = now_ms();
+
+    for (size_t i = 0; i < n; ++i) {
+        const BackendAddress& b = cfg.backends[next_backend_++ % n];
+
+        // A retry goes anywhere but the upstream that just failed
+        if (c->attempts_ > 0 && n > 1 &&
+            b.addr == c->upstream_addr_ && b.port == c->upstream_port_)
+            continue;
+
+        if (cfg.breaker_failure_percent == 0 || outliers_.allow(b.addr, b.port, now)) {
+            addr = b.addr;
+            port = b.port;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ConnectionManager::upstream_allowed(Connection* c, uint32_t addr, uint16_t port) {
+    return c->config_->breaker_failure_percent == 0 ||
+           outliers_.allow(addr, port, now_ms());
+}
+
+bool ConnectionManager::admit_upstream(Connection* c, uint32_t addr, uint16_t port) {
+    if (upstream_allowed(c, addr, port))
+        return true;
+
+    std::cout << "[proxy] upstream ejected, failing fast\n";
+    reply_error(c, 503);
+    return false;
+}
+
+DnsLookup ConnectionManager::lookup_backend(const std::string& host, uint32_t& addr) {
+    in_addr literal{};
+    if (inet_pton(AF_INET, host.c_str(), &literal) == 1) {
+        addr = literal.s_addr;
+        return DnsLookup::HIT;
+    }
+    return resolver_ ? resolver_->lookup(host, addr, now_ms()) : DnsLookup::FAILED;
+}
+
+int ConnectionManager::route_stream(Connection* c, uint32_t& addr, uint16_t& port) {
+    const ProxyConfig& cfg = *c->config_;
+
+    if (!cfg.backends.empty())
+        return next_backend(c, addr, port) ? 0 : 503;
+
+    const std::string& host = cfg.backend_host;
+    port = cfg.backend_port;
+    DnsLookup r = lookup_backend(host, addr);
+    if (r == DnsLookup::FAILED)
+        return 502;
+
+    // One waiter per connection: its parked streams resume together
+    if (r == DnsLookup::PENDING) {
+        if (!c->h2_->parked())
+            park_on_dns(c, host);
+        return -1;
+    }
+
+    return upstream_allowed(c, addr, port) ? 0 : 503;
+}
+
+void ConnectionManager::on_stream_outcome(Connection* c, const UpstreamConn& u, bool ok) {
+    if (c->config_->breaker_failure_percent == 0)
+        return;
+    if (ok)
+        outliers_.on_success(u.addr, u.port, now_us() - u.start_us, now_ms());
+    else
+        outliers_.on_failure(u.addr, u.port, now_ms());
+}
+
+bool ConnectionManager::resolve_backend(Connection* c, uint32_t& addr) {
+    const std::string& host = c->config_->backend_host;
+
+    DnsLookup r = lookup_backend(host, addr);
+    if (r == DnsLookup::HIT)
+        return true;
+
+    if (r == DnsLookup::FAILED) {
+        std::cout << "[proxy] cannot resolve " << host << "\n";
+        reply_error(c, 502);
+        return false;
+    }
+
+    park_on_dns(c, host);
+    return false;
+}
+
+void ConnectionManager::park_on_dns(Connection* c, const std::string& host) {
+    std::cout << "[proxy] waiting for DNS " << host << "\n";
+    pending_dns_[host].push_back({c->client_fd(), clock_ms_});
+}
+
+void ConnectionManager::expire_dns_waits(uint64_t now) {
+    for (auto it = pending_dns_.begin(); it != pending_dns_.end(); ) {
+        std::vector<DnsWaiter>& waiters = it->second;
+        size_t kept = 0;
+        for (const DnsWaiter& w : waiters) {
+            if (now - w.since_ms < kDnsWaitMs) {
+                waiters[kept++] = w;
+                continue;
+            }
+            auto cit = conns_.find(w.fd);
+            if (cit == conns_.end())
+                continue;
+            Connection* c = cit->second.get();
+            if (!c->is_closing() && c->h2_) {
+                std::cout << "[h2] DNS wait for " << it->first << " timed out\n";
+                c->h2_->fail_parked(504);
+                flush_h2(c);
+                continue;
+            }
+            if (!c->is_closing() && c->state_ == ConnectionState::CONNECTING_BACKEND &&
+                c->backend_fd() < 0) {
+                std::cout << "[proxy] DNS wait for " << it->first << " timed out\n";
+                reply_error(c, 504);
+            }
+        }
+        waiters.resize(kept);
+        it = waiters.empty() ? pending_dns_.erase(it) : std::next(it);
+    }
+}
+
+void ConnectionManager::on_dns_result(const std::string& host, bool ok, uint32_t addr) {
+    auto it = pending_dns_.find(host);
+    if (it == pending_dns_.end())
+        return;
+
+    std::vector<DnsWaiter> waiters = std::move(it->second);
+    pending_dns_.erase(it);
+
+    for (const DnsWaiter& w : waiters) {
+        auto cit = conns_.find(w.fd);
+        if (cit == conns_.end())
+            continue;
+
+        Connection* c = cit->second.get();
+        if (!c->is_closing() && c->h2_) {
+            if (ok)
+                c->h2_->resume_parked();
+            else
+                c->h2_->fail_parked(502);
+            flush_h2(c);
+            continue;
+        }
+
+        if (c->is_closing() ||
+            c->state_ != ConnectionState::CONNECTING_BACKEND ||
+            c->backend_fd() >= 0)
+            continue;
+
+        if (!ok)
+            reply_error(c, 502);
+        else if (c->tunnel_request_ == TunnelRequest::CONNECT)
+            connect_backend(c, addr, c->upstream_port_);
+        else if (admit_upstream(c, addr, c->config_->backend_port))
+            connect_backend(c, addr, c->config_->backend_port);
+    }
+}
+
+void ConnectionManager::connect_backend(Connection* c, uint32_t addr, uint16_t port) {
+    c->trace_.mark(TracePoint::BACKEND_RESOLVED);
+
+    c->upstream_addr_ = addr;
+    c->upstream_port_ = port;
+    c->backend_start_us_ = now_us();
+    c->backend_responded_ = false;
+    ++c->attempts_;
 
     int bfd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
     if (bfd < 0) {
@@ -75,39 +855,862 @@ void ConnectionManager::handle_client_read(Connection* c) {
         return;
     }
 
-    sockaddr_in addr{};
-    addr.sin_family = AF_INET;
-    addr.sin_port = htons(9000);
-    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    sockaddr_in sa{};
+    sa.sin_family = AF_INET;
+    sa.sin_port = htons(port);
+    sa.sin_addr.s_addr = addr;
+
+    if (c->config_->busy_poll_us > 0)
+        Socket::set_busy_poll(bfd, c->config_->busy_poll_us);
+    c->config_->upstream_socket.apply(bfd);
 
-    connect(bfd, (sockaddr*)&addr, sizeof(addr));
+    connect(bfd, (sockaddr*)&sa, sizeof(sa));
 
     c->set_backend_fd(bfd);
+
+    // CONNECT is answered only once the target accepted the connection
+    if (c->tunnel_request_ == TunnelRequest::CONNECT) {
+        loop_.add(bfd, EPOLLOUT, &c->backend_tag);
+        return;
+    }
     loop_.add(bfd, EPOLLIN | EPOLLRDHUP, &c->backend_tag);
 
     std::cout << "[proxy] backend socket created fd=" << bfd << "\n";
 
-    Socket::write(
-        bfd,
-        c->client_read_buf.read_ptr(),
-        c->client_read_buf.readable_bytes()
-    );
+    if (!forward_request(c))
+        return;
 
-    c->client_read_buf.clear();
+    c->state_ = ConnectionState::READING_BACKEND;
+    c->trace_.mark(TracePoint::BACKEND_CONNECT);
+}
+
+bool ConnectionManager::forward_request(Connection* c) {
+    const ProxyConfig& cfg = *c->config_;
+    const char* data = c->client_read_buf.read_ptr();
+    size_t len = c->request_len_;
+
+    iovec iov[HeaderEditor::kMaxIov];
+    size_t iovcnt = 1;
+    iov[0].iov_base = const_cast<char*>(data);
+    iov[0].iov_len = len;
+
+    // Edited headers go between spans of the buffered request
+    HeaderEditor editor;
+    if (cfg.x_forwarded_for || cfg.forwarded || !cfg.request_headers.empty()) {
+        HttpParser parser;
+        HttpRequestInfo req;
+        if (parser.parse(data, len, req) == HttpParseResult::COMPLETE) {
+            if (editor.parse(data, req.header_bytes)) {
+                editor.apply(cfg.request_headers);
+
+                char addr[INET6_ADDRSTRLEN];
+                std::string_view client(addr, ForwardedSplicer::format_address(c->peer_, addr));
+                bool v6 = c->peer_.ss_family == AF_INET6;
+                if (cfg.x_forwarded_for && !client.empty())
+                    editor.append_value("X-Forwarded-For", {client});
+                if (cfg.forwarded && !client.empty())
+                    editor.append_value("Forwarded",
+                                        {v6 ? "for=\"[" : "for=", client, v6 ? "]\"" : ""});
+            }
+
+            iovcnt = editor.build(len, iov);
+            if (iovcnt == 0) {
+                std::cout << "[proxy] request head too large to rewrite\n";
+                reply_error(c, 400);
+                return false;
+            }
+        }
+    }
+
+    size_t total = 0;
+    for (size_t i = 0; i < iovcnt; ++i)
+        total += iov[i].iov_len;
+
+    // sendmsg rather than writev: same gather write, plus MSG_NOSIGNAL
+    msghdr msg{};
+    msg.msg_iov = iov;
+    msg.msg_iovlen = iovcnt;
+    ssize_t n = ::sendmsg(c->backend_fd(), &msg, MSG_NOSIGNAL);
+    if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+        // Typically a refused loopback connect, reported right away
+        c->client_read_buf.consume(len);
+        on_backend_failure(c);
+        return false;
+    }
+
+    // The primary has its bytes; the shadow copy must not hold them up.
+    // Retries and tunnels are never mirrored
+    if (cfg.mirror_upstream.port != 0 && c->attempts_ == 1 &&
+        c->tunnel_request_ == TunnelRequest::NONE && mirror_.sample(cfg.mirror_percent))
+        mirror_.submit(cfg, iov, iovcnt, clock_ms_);
+
+    size_t sent = n > 0 ? static_cast<size_t>(n) : 0;
+    if (sent == total) {
+        c->client_read_buf.consume(len);
+        return true;
+    }
+
+    // Connect still in progress or socket full: keep the unsent tail
+    for (size_t i = 0; i < iovcnt; ++i) {
+        const char* base = static_cast<const char*>(iov[i].iov_base);
+        size_t l = iov[i].iov_len;
+        if (sent >= l) {
+            sent -= l;
+            continue;
+        }
+        c->backend_write_buf.append(base + sent, l - sent);
+        sent = 0;
+    }
+    c->client_read_buf.consume(len);
+    loop_.modify(c->backend_fd(), EPOLLIN | EPOLLOUT | EPOLLRDHUP, &c->backend_tag);
+    return true;
+}
+
+void ConnectionManager::flush_backend(Connection* c) {
+    Buffer& out = c->backend_write_buf;
+
+    while (out.readable_bytes() > 0) {
+        ssize_t n = Socket::write(c->backend_fd(), out.read_ptr(), out.readable_bytes());
+        if (n > 0) {
+            out.consume(n);
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            return;
+        close_connection(c);
+        return;
+    }
+
+    loop_.modify(c->backend_fd(), c->client_out_armed_ ? 0 : EPOLLIN | EPOLLRDHUP,
+                 &c->backend_tag);
+}
+
+void ConnectionManager::setup_compression(Connection* c, const HttpRequestInfo& req) {
+    const ProxyConfig& cfg = *c->config_;
+    if (!cfg.compression) {
+        return;
+    }
+
+    const char* head = c->client_read_buf.read_ptr();
+
+    std::pmr::string accept(&c->arena_);
+    if (!HttpParser::find_header(head, req.header_bytes, "Accept-Encoding", accept) ||
+        ResponseCompressor::negotiate(accept) != ContentCoding::GZIP) {
+        return;
+    }
+
+    std::pmr::string method(&c->arena_);
+    std::pmr::string target(&c->arena_);
+    if (!HttpParser::parse_request_line(head, req.header_bytes, method, target)) {
+        return;
+    }
+
+    // Only plain GETs may be answered from the compressed cache
+    std::string key;
+    if (method == "GET") {
+        std::pmr::string host(&c->arena_);
+        HttpParser::find_header(head, req.header_bytes, "Host", host);
+        key.append("gzip ").append(host).append(target);
+    }
+
+    c->compress_ = std::make_unique<ResponseCompressor>(
+        encoders_, &compressed_cache_, cfg.compression_level,
+        cfg.compression_min_length, method == "HEAD", std::move(key));
+    c->compress_->set_deferred(pool_ != nullptr);
 }
 
 void ConnectionManager::handle_backend_read(Connection* c) {
     char buf[8192];
 
     ssize_t n = Socket::read(c->backend_fd(), buf, sizeof(buf));
-    if (n <= 0) {
-        std::cout << "[proxy] backend closed\n";
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        return;
+
+    bool first = !c->backend_responded_;
+    if (first) {
+        // Refused, reset or closed before answering: retryable
+        if (n <= 0) {
+            on_backend_failure(c);
+            return;
+        }
+        c->backend_responded_ = true;
+        c->trace_.mark(TracePoint::BACKEND_FIRST_BYTE);
+        c->access_.status = response_status(buf, n);
+        count_response(c->access_.status);
+        if (c->config_->breaker_failure_percent > 0)
+            outliers_.on_success(c->upstream_addr_, c->upstream_port_,
+                                 now_us() - c->backend_start_us_, now_ms());
+
+        if (c->tunnel_request_ == TunnelRequest::UPGRADE) {
+            c->tunnel_request_ = TunnelRequest::NONE;
+            if (n >= 12 && std::memcmp(buf, "HTTP/1.1 101", 12) == 0) {
+                enter_tunnel(c, buf, n);
+                return;
+            }
+        }
+    }
+
+    if (!c->compress_) {
+        if (n <= 0) {
+            std::cout << "[proxy] backend closed\n";
+            // What the client has not taken yet still goes out first
+            if (n == 0 && c->client_write_buf.readable_bytes() > 0) {
+                loop_.remove(c->backend_fd());
+                c->set_backend_fd(-1);
+                c->state_ = ConnectionState::WRITING_CLIENT;
+                flush_client(c);
+                return;
+            }
+            if (n == 0)
+                finish_exchange(c);
+            else
+                close_connection(c);
+            return;
+        }
+
+        std::cout << "[proxy] read " << n << " bytes from backend\n";
+
+        if (first && (draining_ || !c->config_->response_headers.empty()) &&
+            edit_response_head(c, buf, n))
+            return;
+
+        relay_to_client(c, buf, n);
+        return;
+    }
+
+    // One read per wakeup bounds the encoding work a single large body
+    // can do before other connections get their turn
+    bool ok;
+    if (n > 0) {
+        ok = c->compress_->feed(buf, n, c->client_write_buf);
+    } else {
+        ok = n == 0 && c->compress_->on_eof(c->client_write_buf);
+        loop_.remove(c->backend_fd());
+        c->set_backend_fd(-1);
+    }
+
+    if (!ok) {
+        close_connection(c);
+        return;
+    }
+
+    if (c->compress_->encode_ready()) {
+        offload_encode(c);
+        return;
+    }
+
+    if (c->compress_->done() || c->backend_fd() < 0)
+        c->state_ = ConnectionState::WRITING_CLIENT;
+
+    flush_client(c);
+}
+
+bool ConnectionManager::edit_response_head(Connection* c, const char* buf, size_t n) {
+    static const char kClose[] = "Connection: close\r\n";
+
+    // A head split across reads is relayed as it is
+    const char* end = static_cast<const char*>(memmem(buf, n, "\r\n\r\n", 4));
+    HeaderEditor editor;
+    if (!end || !editor.parse(buf, end - buf + 4))
+        return false;
+
+    editor.apply(c->config_->response_headers);
+
+    // Draining: the client must not reuse this connection
+    if (draining_) {
+        editor.remove("Connection");
+        editor.remove("Keep-Alive");
+        editor.add(kClose, sizeof(kClose) - 1);
+    }
+
+    iovec iov[HeaderEditor::kMaxIov];
+    size_t iovcnt = editor.build(n, iov);
+    if (iovcnt == 0)
+        return false;
+
+    // buf is the caller's stack: what the client cannot take now must be kept
+    for (size_t i = 0; i < iovcnt; ++i)
+        c->client_write_buf.append(static_cast<const char*>(iov[i].iov_base), iov[i].iov_len);
+    flush_client(c);
+    return true;
+}
+
+void ConnectionManager::relay_to_client(Connection* c, const char* buf, size_t n) {
+    Buffer& out = c->client_write_buf;
+
+    // Straight from buf unless earlier bytes are still queued
+    size_t sent = 0;
+    if (out.readable_bytes() == 0) {
+        ssize_t w = client_write(c, buf, n);
+        if (w < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+            close_connection(c);
+            return;
+        }
+        sent = w > 0 ? static_cast<size_t>(w) : 0;
+    }
+    if (sent == n)
+        return;
+
+    // The client is behind (with notsent_lowat, as soon as its unsent
+    // backlog passes the mark): keep the rest and pause the upstream
+    out.append(buf + sent, n - sent);
+    flush_client(c);
+}
+
+void ConnectionManager::offload_encode(Connection* c) {
+    // Head bytes (or a passthrough prefix) go out while the worker runs;
+    // corked, they wait to share a segment with the first encoded bytes
+    if (c->config_->client_socket.cork && !c->corked_)
+        c->corked_ = Socket::set_cork(c->client_fd(), true);
+    flush_client(c);
+    if (c->is_closing())
+        return;
+
+    ResponseCompressor* rc = c->compress_.get();
+    auto produced = std::make_shared<Buffer>(16384);
+    EpollLoop* loop = &loop_;
+
+    // Park: nothing on the loop touches rc until the completion runs
+    if (c->backend_fd() >= 0)
+        loop_.remove(c->backend_fd());
+    c->state_ = ConnectionState::WAITING_WORKER;
+    ++c->pending_tasks_;
+
+    bool queued = pool_->submit([this, c, rc, produced, loop] {
+        bool ok = rc->encode(*produced);
+        loop->post([this, c, produced, ok] {
+            on_encode_done(c, *produced, ok);
+        });
+    });
+
+    if (!queued) {
+        // Pool saturated: pay the cost here rather than queue without bound
+        bool ok = rc->encode(*produced);
+        on_encode_done(c, *produced, ok);
+    }
+}
+
+void ConnectionManager::on_encode_done(Connection* c, const Buffer& produced, bool ok) {
+    --c->pending_tasks_;
+    if (c->is_closing())
+        return;
+
+    if (!ok) {
+        close_connection(c);
+        return;
+    }
+
+    c->compress_->encoded(produced, c->client_write_buf);
+
+    if (c->compress_->done() || c->backend_fd() < 0) {
+        c->state_ = ConnectionState::WRITING_CLIENT;
+    } else {
+        c->state_ = ConnectionState::READING_BACKEND;
+        loop_.add(c->backend_fd(), c->client_out_armed_ ? 0 : EPOLLIN | EPOLLRDHUP,
+                  &c->backend_tag);
+    }
+
+    flush_client(c);
+    if (c->corked_ && !c->is_closing()) {
+        Socket::set_cork(c->client_fd(), false);
+        c->corked_ = false;
+    }
+}
+
+void ConnectionManager::flush_client(Connection* c) {
+    Buffer& out = c->client_write_buf;
+
+    // A complete response is never appended to again, so large
+    // remainders can leave without a copy (see Connection::zc_sent_)
+    bool zc = c->zerocopy_ && c->state_ == ConnectionState::WRITING_CLIENT;
+    uint32_t zc_min = c->config_->client_socket.zerocopy_min_bytes;
+
+    while (out.readable_bytes() > 0) {
+        ssize_t n = client_write(c, out.read_ptr(), out.readable_bytes(),
+                                 zc && out.readable_bytes() >= zc_min);
+        if (n > 0) {
+            out.consume(n);
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            break;
         close_connection(c);
         return;
     }
 
-    std::cout << "[proxy] read " << n << " bytes from backend\n";
-    Socket::write(c->client_fd(), buf, n);
+    bool blocked = out.readable_bytes() > 0;
+
+    // Response fully delivered: serve what the client pipelined, or close
+    if (!blocked && c->state_ == ConnectionState::WRITING_CLIENT) {
+        if (c->zc_done_ == c->zc_sent_) {
+            finish_exchange(c);
+            return;
+        }
+
+        // Zerocopy sends still read from the buffer: only their
+        // completions (EPOLLERR) or a hangup matter from here on
+        if (c->backend_fd() >= 0) {
+            loop_.remove(c->backend_fd());
+            c->set_backend_fd(-1);
+        }
+        loop_.modify(c->client_fd(), EPOLLRDHUP, &c->client_tag);
+        c->client_out_armed_ = false;
+        return;
+    }
+
+    // Backpressure: stop reading the upstream while the client lags
+    if (blocked != c->client_out_armed_) {
+        loop_.modify(c->client_fd(), (c->client_in_paused_ ? 0 : uint32_t{EPOLLIN}) | EPOLLRDHUP |
+                                     (blocked ? uint32_t{EPOLLOUT} : 0),
+                     &c->client_tag);
+        if (c->backend_fd() >= 0 && c->state_ != ConnectionState::WAITING_WORKER)
+            loop_.modify(c->backend_fd(), blocked ? 0 : EPOLLIN | EPOLLRDHUP,
+                         &c->backend_tag);
+        c->client_out_armed_ = blocked;
+    }
+}
+
+void ConnectionManager::on_backend_failure(Connection* c) {
+    // Part of the response is already on its way: nothing to retry
+    if (c->backend_responded_) {
+        close_connection(c);
+        return;
+    }
+
+    // CONNECT targets are arbitrary hosts, not upstreams to eject
+    if (c->config_->breaker_failure_percent > 0 &&
+        c->tunnel_request_ != TunnelRequest::CONNECT)
+        outliers_.on_failure(c->upstream_addr_, c->upstream_port_, now_ms());
+
+    std::cout << "[proxy] backend failed before responding, attempt "
+              << c->attempts_ << "\n";
+
+    if (!retry_backend(c))
+        reply_error(c, 502);
+}
+
+bool ConnectionManager::retry_backend(Connection* c) {
+    if (c->retry_request_.readable_bytes() == 0 ||
+        c->attempts_ > c->config_->retry_max ||
+        !retry_budget_.try_retry(now_ms()))
+        return false;
+
+    loop_.remove(c->backend_fd());
+    c->set_backend_fd(-1);
+    c->backend_write_buf.clear();
+
+    // The forwarded bytes are gone from client_read_buf; replay the copy
+    // ahead of whatever the client has pipelined behind it
+    std::string rest(c->client_read_buf.read_ptr(), c->client_read_buf.readable_bytes());
+    c->client_read_buf.clear();
+    c->client_read_buf.append(c->retry_request_.read_ptr(),
+                              c->retry_request_.readable_bytes());
+    c->client_read_buf.append(rest.data(), rest.size());
+    c->state_ = ConnectionState::CONNECTING_BACKEND;
+
+    uint32_t addr = 0;
+    uint16_t port = 0;
+    if (select_backend(c, addr, port))
+        connect_backend(c, addr, port);
+    return true;
+}
+
+void ConnectionManager::reply_error(Connection* c, int status) {
+    static const char k400[] =
+        "HTTP/1.1 400 Bad Request\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+    static const char k403[] =
+        "HTTP/1.1 403 Forbidden\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+    static const char k501[] =
+        "HTTP/1.1 501 Not Implemented\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+    static const char k502[] =
+        "HTTP/1.1 502 Bad Gateway\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+    static const char k503[] =
+        "HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+    static const char k504[] =
+        "HTTP/1.1 504 Gateway Timeout\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+
+    if (c->backend_fd() >= 0) {
+        loop_.remove(c->backend_fd());
+        c->set_backend_fd(-1);
+    }
+
+    c->access_.status = static_cast<uint16_t>(
+        status == 400 || status == 403 || status == 501 || status == 503 || status == 504
+            ? status : 502);
+    count_response(c->access_.status);
+    switch (status) {
+    case 400:
+        c->client_write_buf.append(k400, sizeof(k400) - 1);
+        break;
+    case 403:
+        c->client_write_buf.append(k403, sizeof(k403) - 1);
+        break;
+    case 501:
+        c->client_write_buf.append(k501, sizeof(k501) - 1);
+        break;
+    case 503:
+        c->client_write_buf.append(k503, sizeof(k503) - 1);
+        break;
+    case 504:
+        c->client_write_buf.append(k504, sizeof(k504) - 1);
+        break;
+    default:
+        c->client_write_buf.append(k502, sizeof(k502) - 1);
+        break;
+    }
+
+    c->state_ = ConnectionState::WRITING_CLIENT;
+    flush_client(c);
+}
+
+TunnelRequest ConnectionManager::classify_tunnel(Connection* c, const HttpRequestInfo& req,
+                                                std::pmr::string& target) {
+    const ProxyConfig& cfg = *c->config_;
+    if (!cfg.websocket && !cfg.connect_tunnel)
+        return TunnelRequest::NONE;
+
+    const char* head = c->client_read_buf.read_ptr();
+    std::pmr::string method(&c->arena_);
+    if (!HttpParser::parse_request_line(head, req.header_bytes, method, target))
+        return TunnelRequest::NONE;
+
+    // With tunnels off, CONNECT goes upstream like any other request
+    if (method == "CONNECT")
+        return cfg.connect_tunnel ? TunnelRequest::CONNECT : TunnelRequest::NONE;
+
+    std::pmr::string upgrade(&c->arena_);
+    std::pmr::string connection(&c->arena_);
+    if (cfg.websocket &&
+        HttpParser::find_header(head, req.header_bytes, "Upgrade", upgrade) &&
+        HttpParser::find_header(head, req.header_bytes, "Connection", connection) &&
+        has_token(upgrade, "websocket") && has_token(connection, "upgrade"))
+        return TunnelRequest::UPGRADE;
+
+    return TunnelRequest::NONE;
+}
+
+void ConnectionManager::open_connect_tunnel(Connection* c, const HttpRequestInfo& req,
+                                            const std::pmr::string& target) {
+    const ProxyConfig& cfg = *c->config_;
+    c->attempts_ = 0;
+    c->retry_request_.clear();
+
+    // authority-form only: host:port (RFC 9110 9.3.6)
+    size_t colon = target.rfind(':');
+    unsigned long port = 0;
+    if (colon != std::pmr::string::npos && colon > 0 && colon + 1 < target.size()) {
+        char* end = nullptr;
+        port = std::strtoul(target.c_str() + colon + 1, &end, 10);
+        if (*end != '\0' || !std::isdigit(static_cast<unsigned char>(target[colon + 1])))
+            port = 0;
+    }
+    if (port == 0 || port > 65535) {
+        reply_error(c, 400);
+        return;
+    }
+    if (std::find(cfg.connect_ports.begin(), cfg.connect_ports.end(), port) ==
+        cfg.connect_ports.end()) {
+        std::cout << "[proxy] CONNECT to port " << port << " refused\n";
+        reply_error(c, 403);
+        return;
+    }
+
+    // The CONNECT head is ours; anything after it belongs to the tunnel
+    c->client_read_buf.consume(req.header_bytes);
+    c->upstream_port_ = static_cast<uint16_t>(port);
+
+    // Resolver keys are plain strings; CONNECT is not the hot path
+    std::string host(target.data(), colon);
+    in_addr literal{};
+    uint32_t addr = 0;
+    if (inet_pton(AF_INET, host.c_str(), &literal) == 1) {
+        addr = literal.s_addr;
+    } else {
+        DnsLookup r = resolver_ ? resolver_->lookup(host, addr, now_ms()) : DnsLookup::FAILED;
+        if (r == DnsLookup::FAILED) {
+            reply_error(c, 502);
+            return;
+        }
+        if (r == DnsLookup::PENDING) {
+            park_on_dns(c, host);
+            return;
+        }
+    }
+
+    connect_backend(c, addr, c->upstream_port_);
+}
+
+void ConnectionManager::finish_connect_tunnel(Connection* c) {
+    static const char k200[] = "HTTP/1.1 200 Connection Established\r\n\r\n";
+
+    int err = 0;
+    socklen_t len = sizeof(err);
+    if (getsockopt(c->backend_fd(), SOL_SOCKET, SO_ERROR, &err, &len) < 0 || err != 0) {
+        on_backend_failure(c);
+        return;
+    }
+
+    c->trace_.mark(TracePoint::BACKEND_CONNECT);
+    c->access_.status = 200;
+    count_response(200);
+    enter_tunnel(c, k200, sizeof(k200) - 1);
+}
+
+void ConnectionManager::enter_tunnel(Connection* c, const char* head, size_t len) {
+    auto t = std::make_unique<Tunnel>();
+
+    // splice() moves raw bytes: the client must be plain TCP, or TLS the
+    // kernel seals and opens itself (kTLS both ways, nothing left in
+    // OpenSSL). A non-data record then fails the splice and ends the
+    // tunnel, as any other relay error does.
+    bool plain = true;
+#ifdef PROXY_TLS
+    plain = !c->tls_ || c->tls_->can_splice();
+#endif
+    t->splice = plain && t->up.open_pipe() && t->down.open_pipe();
+
+    // Whatever was buffered before the switch goes first, in order
+    t->up.buf.append(c->backend_write_buf.read_ptr(), c->backend_write_buf.readable_bytes());
+    t->up.buf.append(c->client_read_buf.read_ptr(), c->client_read_buf.readable_bytes());
+    t->down.buf.append(head, len);
+    c->backend_write_buf.clear();
+    c->client_read_buf.clear();
+
+    t->last_active_ms = clock_ms_;
+    t->idle_pos = tunnels_.insert(tunnels_.end(), c);
+
+    std::cout << "[proxy] tunnel open client_fd=" << c->client_fd()
+              << " splice=" << t->splice << "\n";
+
+    c->tunnel_ = std::move(t);
+    c->state_ = ConnectionState::TUNNELING;
+    pump_tunnel(c, true, true);
+}
+
+void ConnectionManager::pump_tunnel(Connection* c, bool up, bool down) {
+    Tunnel& t = *c->tunnel_;
+    ssize_t moved = 0;
+
+    if (up) {
+        ssize_t n = relay(c, t.up, true);
+        if (n < 0) {
+            close_connection(c);
+            return;
+        }
+        moved += n;
+    }
+    if (down) {
+        ssize_t n = relay(c, t.down, false);
+        if (n < 0) {
+            close_connection(c);
+            return;
+        }
+        moved += n;
+    }
+
+    // Both sides have said all they will say
+    if (t.up.dst_shut && t.down.dst_shut) {
+        close_connection(c);
+        return;
+    }
+
+    if (moved > 0) {
+        t.last_active_ms = clock_ms_;
+        tunnels_.splice(tunnels_.end(), tunnels_, t.idle_pos);
+    }
+    update_tunnel_events(c);
+}
+
+ssize_t ConnectionManager::relay(Connection* c, TunnelLeg& leg, bool to_backend) {
+    int src = to_backend ? c->client_fd() : c->backend_fd();
+    int dst = to_backend ? c->backend_fd() : c->client_fd();
+    bool splice = c->tunnel_->splice;
+    ssize_t moved = 0;
+    int reads = 0;
+
+    leg.dst_blocked = false;
+
+    while (true) {
+        // Held bytes go out before anything new is read
+        while (leg.buf.readable_bytes() > 0 || leg.piped > 0) {
+            ssize_t n;
+            if (leg.buf.readable_bytes() > 0) {
+                n = to_backend
+                    ? Socket::write(dst, leg.buf.read_ptr(), leg.buf.readable_bytes())
+                    : client_write(c, leg.buf.read_ptr(), leg.buf.readable_bytes());
+                if (n > 0)
+                    leg.buf.consume(n);
+            } else {
+                n = ::splice(leg.pipe_rd.get(), nullptr, dst, nullptr, leg.piped,
+                             SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+                if (n > 0)
+                    leg.piped -= n;
+            }
+            if (n > 0) {
+                moved += n;
+                continue;
+            }
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                leg.dst_blocked = true;
+                return moved;
+            }
+            return -1;
+        }
+
+        if (leg.dst_shut || reads == kTunnelReads)
+            return moved;
+        ++reads;
+
+        ssize_t n;
+        if (splice) {
+            n = ::splice(src, nullptr, leg.pipe_wr.get(), nullptr, kTunnelChunk,
+                         SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+            if (n > 0)
+                leg.piped = n;
+        } else {
+            leg.buf.ensure_capacity(kTunnelChunk);
+            n = to_backend
+                ? client_read(c, leg.buf.write_ptr(), leg.buf.writable_bytes())
+                : Socket::read(src, leg.buf.write_ptr(), leg.buf.writable_bytes());
+            if (n > 0)
+                leg.buf.commit(n);
+        }
+
+        if (n > 0) {
+            leg.bytes += n;
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            return moved;
+        if (n < 0)
+            return -1;
+
+        // Source finished and everything it sent is delivered: pass the
+        // half-close on, the other direction keeps going
+        leg.src_eof = true;
+        leg.dst_shut = true;
+#ifdef PROXY_TLS
+        if (!to_backend && c->tls_)
+            c->tls_->shutdown();
+#endif
+        ::shutdown(dst, SHUT_WR);
+        return moved;
+    }
+}
+
+void ConnectionManager::update_tunnel_events(Connection* c) {
+    Tunnel& t = *c->tunnel_;
+
+    uint32_t cev = (t.up.wants_read() ? uint32_t{EPOLLIN} : 0) |
+                   (t.down.dst_blocked ? uint32_t{EPOLLOUT} : 0);
+    uint32_t bev = (t.down.wants_read() ? uint32_t{EPOLLIN} : 0) |
+                   (t.up.dst_blocked ? uint32_t{EPOLLOUT} : 0);
+
+    if (cev != t.client_events) {
+        loop_.modify(c->client_fd(), cev, &c->client_tag);
+        t.client_events = cev;
+    }
+    if (bev != t.backend_events) {
+        loop_.modify(c->backend_fd(), bev, &c->backend_tag);
+        t.backend_events = bev;
+    }
+}
+
+void ConnectionManager::expire_tunnels(uint64_t now) {
+    // Front is the least recently active: stop at the first live one
+    while (!tunnels_.empty()) {
+        Connection* c = tunnels_.front();
+        uint32_t idle = c->config_->tunnel_idle_ms;
+        if (idle == 0 || now - c->tunnel_->last_active_ms < idle)
+            return;
+
+        std::cout << "[proxy] tunnel idle for " << idle << " ms, closing\n";
+        close_connection(c);
+    }
+}
+
+void ConnectionManager::push_access_record(Connection* c) {
+    AccessRecord& r = c->access_;
+    r.time_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    uint64_t us = now_us() - c->request_start_us_;
+    r.duration_us = us < UINT32_MAX ? static_cast<uint32_t>(us) : UINT32_MAX;
+    r.conn_id = c->trace_.conn_id;
+    r.bytes_in = c->bytes_in_;
+    r.bytes_out = c->bytes_out_;
+    r.upstream_addr = c->upstream_addr_;
+    r.upstream_port = c->upstream_port_;
+
+    if (c->peer_.ss_family == AF_INET) {
+        r.family = AF_INET;
+        std::memcpy(r.client, &reinterpret_cast<const sockaddr_in&>(c->peer_).sin_addr, 4);
+    } else if (c->peer_.ss_family == AF_INET6) {
+        r.family = AF_INET6;
+        std::memcpy(r.client, &reinterpret_cast<const sockaddr_in6&>(c->peer_).sin6_addr, 16);
+    }
+
+    r.flags = 0;
+#ifdef PROXY_TLS
+    if (c->tls_)
+        r.flags |= AccessRecord::TLS;
+#endif
+    if (c->tunnel_) {
+        // Spliced bytes never pass through client_read / client_write
+        r.flags |= AccessRecord::TUNNEL;
+        if (c->tunnel_->splice) {
+            r.bytes_in += c->tunnel_->up.bytes;
+            r.bytes_out += c->tunnel_->down.bytes;
+        }
+    }
+    if (c->attempts_ > 1)
+        r.flags |= AccessRecord::RETRIED;
+
+    access_ring_->push(r);
+}
+
+void ConnectionManager::count_response(uint16_t status) {
+    // 0: the backend's first bytes carried no status line
+    if (status >= 100 && status < 600)
+        ++traffic_.responses[status / 100];
+}
+
+void ConnectionManager::record_exchange(Connection* c) {
+    if (access_ring_ && c->access_.method_len > 0)
+        push_access_record(c);
+}
+
+void ConnectionManager::finish_exchange(Connection* c) {
+    // Keep the connection only for a request the client already sent
+    // behind a response relayed in full; an error reply, a drain or a
+    // worker still holding the compressor all end it
+    if (draining_ || !c->backend_responded_ || c->pending_tasks_ != 0 ||
+        c->zc_done_ != c->zc_sent_ || c->client_read_buf.readable_bytes() == 0) {
+        close_connection(c);
+        return;
+    }
+
+    std::cout << "[proxy] response done, serving pipelined request\n";
+    record_exchange(c);
+    c->access_ = AccessRecord();
+
+    if (c->backend_fd() >= 0) {
+        loop_.remove(c->backend_fd());
+        c->set_backend_fd(-1);
+    }
+    c->backend_responded_ = false;
+    c->backend_write_buf.clear();
+    c->compress_.reset();
+    c->tunnel_request_ = TunnelRequest::NONE;
+    if (c->corked_) {
+        Socket::set_cork(c->client_fd(), false);
+        c->corked_ = false;
+    }
+
+    c->client_out_armed_ = false;
+    c->client_in_paused_ = false;
+    loop_.modify(c->client_fd(), EPOLLIN | EPOLLRDHUP, &c->client_tag);
+    c->state_ = ConnectionState::READING_REQUEST;
+    handle_request(c);
 }
 
 void ConnectionManager::close_connection(Connection* c) {
@@ -117,6 +1720,31 @@ void ConnectionManager::close_connection(Connection* c) {
     std::cout << "[proxy] closing client_fd=" << c->client_fd() << "\n";
 
     c->mark_closing();
+    --active_;
+
+    // Closing with zerocopy sends in flight: reset, so the kernel drops
+    // them instead of transmitting from a buffer about to be freed
+    if (c->zc_done_ != c->zc_sent_)
+        Socket::set_abort_on_close(c->client_fd());
+
+    c->trace_.mark(TracePoint::CLOSE);
+    if (c->trace_.sampled)
+        trace_ring_->push(c->trace_);
+    record_exchange(c);
+
+    if (c->tunnel_) {
+        std::cout << "[proxy] tunnel closed up=" << c->tunnel_->up.bytes
+                  << " down=" << c->tunnel_->down.bytes << "\n";
+        tunnels_.erase(c->tunnel_->idle_pos);
+    }
+
+#ifdef PROXY_TLS
+    if (c->tls_)
+        c->tls_->shutdown();
+#endif
+
+    if (c->h2_)
+        c->h2_->shutdown();
     loop_.remove(c->client_fd());
 
     if (c->backend_fd() >= 0)
@@ -124,10 +1752,207 @@ void ConnectionManager::close_connection(Connection* c) {
 }
 
 void ConnectionManager::sweep_closed() {
+    upstreams_.sweep();
+    mirror_.sweep();
+
     for (auto it = conns_.begin(); it != conns_.end(); ) {
-        if (it->second->is_closing())
+        if (it->second->is_closing() && it->second->pending_tasks_ == 0)
             it = conns_.erase(it);
         else
             ++it;
     }
 }
+
+size_t ConnectionManager::active_count() const {
+    return active_;
+}
+
+void ConnectionManager::start_drain(uint64_t deadline_ms) {
+    if (draining_)
+        return;
+    draining_ = true;
+
+    drain_ = DrainStats();
+    drain_.started_ms = now_ms();
+    drain_.deadline_ms = deadline_ms;
+    drain_.at_start = active_;
+
+    for (auto& kv : conns_) {
+        Connection* c = kv.second.get();
+        if (c->is_closing())
+            continue;
+
+        // Open streams finish; flush_h2 closes once the session is done
+        if (c->h2_) {
+            c->h2_->goaway();
+            ++drain_.goaway_sent;
+            flush_h2(c);
+            continue;
+        }
+
+        // Accepted but nothing asked yet
+        if (c->state_ == ConnectionState::READING_REQUEST &&
+            c->client_read_buf.readable_bytes() == 0) {
+            ++drain_.closed_idle;
+            close_connection(c);
+        }
+    }
+
+    std::cout << "[drain] " << drain_.at_start << " connection(s), "
+              << drain_.closed_idle << " idle closed, "
+              << drain_.goaway_sent << " GOAWAY sent\n";
+}
+
+void ConnectionManager::close_all() {
+    if (draining_)
+        drain_.forced += active_;
+
+    for (auto& kv : conns_)
+        close_connection(kv.second.get());
+}
+
+void ConnectionManager::snapshot(JsonWriter& out, bool connections) const {
+    static const char* const kBreaker[] = {"CLOSED", "OPEN", "HALF_OPEN"};
+    uint64_t now = now_ms();
+
+    out.key("active").value(active_);
+    out.key("tunnels").value(tunnels_.size());
+    out.key("pending_dns").value(pending_dns_.size());
+    out.key("draining").value(draining_);
+    if (draining_) {
+        out.key("drain").begin_object();
+        out.key("at_start").value(drain_.at_start);
+        out.key("closed_idle").value(drain_.closed_idle);
+        out.key("goaway_sent").value(drain_.goaway_sent);
+        out.key("ms_to_deadline").value(drain_.deadline_ms > now ? drain_.deadline_ms - now : 0);
+        out.end_object();
+    }
+
+    out.key("zerocopy").begin_object();
+    out.key("sends").value(zerocopy_sends_);
+    out.key("fallbacks").value(zerocopy_fallbacks_);
+    out.end_object();
+
+#ifdef PROXY_TLS
+    if (tls_) {
+        const TlsStats& ts = tls_->stats();
+        out.key("tls").begin_object();
+        out.key("handshakes").value(ts.handshakes);
+        out.key("handshake_failures").value(ts.handshake_failures);
+        out.key("resumed").value(ts.resumed);
+        out.key("handshake_ns").value(ts.handshake_ns);
+        out.key("ktls_tx").value(ts.ktls_tx);
+        out.key("ktls_rx").value(ts.ktls_rx);
+        out.end_object();
+    }
+#endif
+
+    const MirrorStats& ms = mirror_.stats();
+    out.key("mirror").begin_object();
+    out.key("inflight").value(mirror_.inflight());
+    out.key("payload_bytes").value(mirror_.payload_bytes());
+    out.key("started").value(ms.started);
+    out.key("completed").value(ms.completed);
+    out.key("failed").value(ms.failed);
+    out.key("timed_out").value(ms.timed_out);
+    out.key("skipped_inflight").value(ms.skipped_inflight);
+    out.key("skipped_bytes").value(ms.skipped_bytes);
+    out.key("responses").begin_array();
+    for (uint64_t r : ms.responses)
+        out.value(r);
+    out.end_array();
+    out.end_object();
+
+    out.key("retry_budget").begin_object();
+    out.key("balance").value(retry_budget_.balance());
+    out.key("granted").value(retry_budget_.granted());
+    out.key("denied").value(retry_budget_.denied());
+    out.end_object();
+
+    out.key("upstreams").begin_array();
+    outliers_.for_each([&](uint32_t addr, uint16_t port, const CircuitBreaker& b,
+                           uint64_t successes, uint64_t failures) {
+        char ip[INET_ADDRSTRLEN] = {};
+        in_addr a{};
+        a.s_addr = addr;
+        inet_ntop(AF_INET, &a, ip, sizeof(ip));
+
+        out.begin_object();
+        out.key("addr").value(std::string(ip) + ":" + std::to_string(port));
+        out.key("state").value(kBreaker[static_cast<int>(b.state())]);
+        out.key("error_ewma").value(b.error_ewma());
+        out.key("latency_ewma_us").value(b.latency_ewma_us());
+        out.key("trips").value(b.trips());
+        out.key("successes").value(successes);
+        out.key("failures").value(failures);
+        out.end_object();
+    });
+    out.end_array();
+
+    // Buffers are owned per connection; the pools are this loop's
+    size_t buffered = 0;
+    size_t capacity = 0;
+    for (const auto& kv : conns_) {
+        const Connection& c = *kv.second;
+        buffered += c.client_read_buf.readable_bytes() + c.client_write_buf.readable_bytes() +
+                    c.backend_read_buf.readable_bytes() + c.backend_write_buf.readable_bytes();
+        capacity += c.client_read_buf.capacity() + c.client_write_buf.capacity() +
+                    c.backend_read_buf.capacity() + c.backend_write_buf.capacity();
+    }
+    const ArenaChunkPool& arena = ArenaChunkPool::local();
+
+    out.key("pools").begin_object();
+    out.key("buffer_bytes_used").value(buffered);
+    out.key("buffer_bytes_allocated").value(capacity);
+    out.key("arena_chunks_cached").value(arena.cached());
+    out.key("arena_chunks_allocated").value(arena.allocations());
+    out.key("upstream_idle").value(upstreams_.idle_count());
+    out.key("upstream_leased").value(upstreams_.leased_count());
+    out.key("encoders_idle").value(encoders_.idle());
+    out.key("encoders_created").value(encoders_.created());
+    out.key("compressed_cache_entries").value(compressed_cache_.size());
+    out.key("compressed_cache_bytes").value(compressed_cache_.bytes());
+    out.end_object();
+
+    if (!connections)
+        return;
+
+    out.key("connections").begin_array();
+    for (const auto& kv : conns_) {
+        const Connection& c = *kv.second;
+        if (c.is_closing())
+            continue;
+
+        out.begin_object();
+        out.key("id").value(c.trace_.conn_id);
+        out.key("client_fd").value(c.client_fd());
+        out.key("backend_fd").value(c.backend_fd());
+        out.key("peer").value(ForwardedSplicer::format_address(c.peer_));
+        out.key("state").value(to_string(c.state_));
+        out.key("age_ms").value(now - c.accepted_ms_);
+        out.key("bytes_in").value(c.bytes_in_);
+        out.key("bytes_out").value(c.bytes_out_);
+#ifdef PROXY_TLS
+        out.key("tls").value(c.tls_ != nullptr);
+#else
+        out.key("tls").value(false);
+#endif
+        out.key("h2").value(c.h2_ != nullptr);
+        if (c.h2_)
+            out.key("streams").value(c.h2_->open_streams());
+        if (c.tunnel_) {
+            out.key("tunnel").begin_object();
+            out.key("up_bytes").value(c.tunnel_->up.bytes);
+            out.key("down_bytes").value(c.tunnel_->down.bytes);
+            out.key("idle_ms").value(clock_ms_ - c.tunnel_->last_active_ms);
+            out.end_object();
+        }
+        out.key("buffered").value(c.client_read_buf.readable_bytes() +
+                                  c.client_write_buf.readable_bytes() +
+                                  c.backend_read_buf.readable_bytes() +
+                                  c.backend_write_buf.readable_bytes());
+        out.end_object();
+    }
+    out.end_array();
+}
+
@@ -1,25 +1,246 @@
 #pragma once
+#include <list>
 #include <unordered_map>
 #include <memory>
 #include <iostream>
+#include <string>
+#include <vector>
+#include <netinet/in.h>
 
 #include "connection.h"
+#include "shadow_mirror.h"
+#include "upstream_pool.h"
+#include "balancer/outlier_detector.h"
+#include "balancer/retry_budget.h"
+#include "compress/compressed_cache.h"
+#include "compress/gzip_encoder.h"
 #include "core/event_loop/epoll_loop.h"
 #include "protocol/http/http_parser.h"
 
+class AccessLogRing;
+enum class DnsLookup;
+class DnsResolver;
+class JsonWriter;
+class RateLimiter;
+class TlsContext;
+class TraceRing;
+class WorkStealingPool;
+
+/*
+ * DrainStats
+ * ----------
+ * Progress of a graceful shutdown (all zero until start_drain()).
+ * Connections still open are active_count().
+ */
+struct DrainStats {
+    uint64_t started_ms = 0;
+    uint64_t deadline_ms = 0;
+    size_t at_start = 0;        // connections open when the drain began
+    size_t closed_idle = 0;     // closed at once, nothing in flight
+    size_t goaway_sent = 0;     // HTTP/2 clients told to go away
+    size_t forced = 0;          // still open at the deadline
+};
+
+/*
+ * TrafficStats
+ * ------------
+ * Cumulative per-worker counters, for out-of-process monitoring.
+ * Bytes are client-side bytes that passed through user space (spliced
+ * tunnel bytes are not included).
+ */
+struct TrafficStats {
+    uint64_t accepted = 0;
+    uint64_t requests = 0;      // HTTP/1.x request heads parsed
+    uint64_t responses[6] = {}; // by status class, counted when the status
+                                // is known; [0] unused
+    uint64_t bytes_in = 0;
+    uint64_t bytes_out = 0;
+};
+
 class ConnectionManager {
 public:
-    explicit ConnectionManager(EpollLoop& loop);
+    ConnectionManager(EpollLoop& loop, ConfigSnapshot config);
+
+    // Swap the snapshot used for new connections (loop thread only)
+    void set_config(ConfigSnapshot config);
+
+    // Resolver used for non-literal backend hosts (optional)
+    void set_resolver(DnsResolver* resolver);
+
+    // Terminate TLS on every new client when set (PROXY_TLS builds only)
+    void set_tls(TlsContext* tls);
+
+    // Run response encoding on pool; results are posted back to the loop
+    // (optional; without it encoding runs inline on the loop)
+    void set_executor(WorkStealingPool* pool);
+
+    // Publish lifecycle traces of sampled connections to ring
+    // (optional; sampling rate comes from trace_sample_every)
+    void set_tracer(TraceRing* ring);
+
+    // Publish one access record per completed request to ring (optional)
+    void set_access_log(AccessLogRing* ring);
+
+    // Share upstream health with the other workers (optional)
+    void set_health_board(HealthBoard* board);
+
+    // Per-client rate limit for listeners behind a PROXY header: applied
+    // once the header names the real source (the accept loop limits the
+    // others). nullptr turns it off; the limiter must outlive its use
+    void set_rate_limiter(RateLimiter* limiter) { limiter_ = limiter; }
+
+    // Periodic work: closes idle tunnels, answers requests stuck on DNS,
+    // aborts overdue shadow requests and merges upstream health every
+    // health_sync_ms (now_ms doubles as the tunnels' idle clock)
+    void tick(uint64_t now_ms);
+
+    const OutlierDetector& outliers() const { return outliers_; }
+    const RetryBudget& retry_budget() const { return retry_budget_; }
+    const ShadowMirror& mirror() const { return mirror_; }
+
+    // Open WebSocket / CONNECT tunnels
+    size_t tunnel_count() const { return tunnels_.size(); }
 
-    void add_client(int fd);
+    // Resume connections parked on a DNS lookup for host
+    void on_dns_result(const std::string& host, bool ok, uint32_t addr);
+
+    // peer is the accepted address (replaced by a PROXY header if
+    // proxy_protocol is on)
+    void add_client(int fd, const sockaddr_in* peer = nullptr);
     void handle_event(void* data, uint32_t events);
     void sweep_closed();
 
+    // Connections not yet marked closing
+    size_t active_count() const;
+
+    // Graceful shutdown (stop accepting first): idle connections close
+    // now, HTTP/2 clients get GOAWAY and HTTP/1.1 responses from here on
+    // carry Connection: close; in-flight requests run to completion
+    void start_drain(uint64_t deadline_ms);
+    bool draining() const { return draining_; }
+    const DrainStats& drain_stats() const { return drain_; }
+
+    // Force-close every connection (drain deadline reached)
+    void close_all();
+
+    const TrafficStats& traffic() const { return traffic_; }
+
+    // Handshake counters live in the context; null without TLS
+    const TlsContext* tls() const { return tls_; }
+
+    // f(const Connection&) for every connection not yet closing
+    template <typename F>
+    void for_each_connection(F&& f) const {
+        for (const auto& entry : conns_) {
+            if (!entry.second->is_closing())
+                f(*entry.second);
+        }
+    }
+
+    // Write this worker's state as members of an open JSON object:
+    // counters, pools, upstream health and, with connections, one entry
+    // per open connection. Loop thread only (see AdminServer)
+    void snapshot(JsonWriter& out, bool connections) const;
+
 private:
     EpollLoop& loop_;
+    ConfigSnapshot config_;
+    size_t active_{0};
+    DnsResolver* resolver_{nullptr};
+    TlsContext* tls_{nullptr};
+    WorkStealingPool* pool_{nullptr};
+    TraceRing* trace_ring_{nullptr};
+    TraceSampler trace_sampler_;
+    AccessLogRing* access_ring_{nullptr};
+    RateLimiter* limiter_{nullptr};
+    uint32_t next_conn_id_{0};
+
+    // Per-worker upstream health and retry allowance
+    OutlierDetector outliers_;
+    RetryBudget retry_budget_;
+    size_t next_backend_{0};
+    uint64_t next_sync_ms_{0};
+
+    // Open tunnels, least recently active first; clock_ms_ is the last
+    // tick's time, so activity costs no clock read
+    std::list<Connection*> tunnels_;
+    uint64_t clock_ms_{0};
+
+    bool draining_{false};
+    DrainStats drain_;
+    TrafficStats traffic_;
+
+    // MSG_ZEROCOPY sends, and connections that stopped using it because
+    // the kernel copied anyway
+    uint64_t zerocopy_sends_{0};
+    uint64_t zerocopy_fallbacks_{0};
+
+    // Keep-alive HTTP/1.1 upstreams shared by HTTP/2 streams on this loop
+    UpstreamPool upstreams_;
+
+    // Copies of sampled requests in flight to mirror_upstream
+    ShadowMirror mirror_;
+
+    // Response compression state shared by this loop's connections
+    EncoderPool encoders_;
+    CompressedCache compressed_cache_;
+
+    // host -> client fds waiting for resolution, answered 504 if the
+    // resolver has not reported back within kDnsWaitMs
+    struct DnsWaiter {
+        int fd;
+        uint64_t since_ms;
+    };
+    std::unordered_map<std::string, std::vector<DnsWaiter>> pending_dns_;
     std::unordered_map<int, std::unique_ptr<Connection>> conns_;
 
+    void handle_proxy_header(Connection* c);
     void handle_client_read(Connection* c);
+    void handle_request(Connection* c);
+    void finish_exchange(Connection* c);
+    void count_response(uint16_t status);
+    void record_exchange(Connection* c);
     void handle_backend_read(Connection* c);
+    void setup_compression(Connection* c, const HttpRequestInfo& req);
+    bool edit_response_head(Connection* c, const char* buf, size_t n);
+    void flush_client(Connection* c);
+    bool forward_request(Connection* c);
+    void flush_backend(Connection* c);
+    void offload_encode(Connection* c);
+    void on_encode_done(Connection* c, const Buffer& produced, bool ok);
+    void handle_tls_handshake(Connection* c);
+    bool detect_h2_preface(Connection* c);
+    void handle_h2_read(Connection* c);
+    void flush_h2(Connection* c);
+    ssize_t client_read(Connection* c, void* buf, size_t len);
+    ssize_t client_write(Connection* c, const void* buf, size_t len, bool zerocopy = false);
+    void relay_to_client(Connection* c, const char* buf, size_t n);
+    void apply_upstream_policy();
+    void prepare_retry(Connection* c, const HttpRequestInfo& req);
+    bool select_backend(Connection* c, uint32_t& addr, uint16_t& port);
+    bool next_backend(Connection* c, uint32_t& addr, uint16_t& port);
+    bool upstream_allowed(Connection* c, uint32_t addr, uint16_t port);
+    bool admit_upstream(Connection* c, uint32_t addr, uint16_t port);
+    DnsLookup lookup_backend(const std::string& host, uint32_t& addr);
+    bool resolve_backend(Connection* c, uint32_t& addr);
+    int route_stream(Connection* c, uint32_t& addr, uint16_t& port);
+    void on_stream_outcome(Connection* c, const UpstreamConn& u, bool ok);
+    void connect_backend(Connection* c, uint32_t addr, uint16_t port);
+    void on_backend_failure(Connection* c);
+    bool retry_backend(Connection* c);
+    void reply_error(Connection* c, int status);
+    TunnelRequest classify_tunnel(Connection* c, const HttpRequestInfo& req,
+                                  std::pmr::string& target);
+    void open_connect_tunnel(Connection* c, const HttpRequestInfo& req,
+                             const std::pmr::string& target);
+    void finish_connect_tunnel(Connection* c);
+    void enter_tunnel(Connection* c, const char* head, size_t len);
+    void pump_tunnel(Connection* c, bool up, bool down);
+    ssize_t relay(Connection* c, TunnelLeg& leg, bool to_backend);
+    void update_tunnel_events(Connection* c);
+    void expire_tunnels(uint64_t now);
+    void park_on_dns(Connection* c, const std::string& host);
+    void expire_dns_waits(uint64_t now);
+    void push_access_record(Connection* c);
     void close_connection(Connection* c);
 };
@@ -5,5 +5,26 @@ enum class ConnectionState {
     CONNECTING_BACKEND,
     READING_BACKEND,
     WRITING_CLIENT,
+    TLS_HANDSHAKE,
+    MULTIPLEXING,       // HTTP/2: streams proxied via H2Frontend
+    WAITING_WORKER,     // parked until an offloaded task completes
+    READING_PROXY_HEADER,   // waiting for the load balancer's PROXY header
+    TUNNELING,          // upgraded or CONNECT: opaque bytes both ways
     CLOSING
 };
+
+inline const char* to_string(ConnectionState s) {
+    switch (s) {
+    case ConnectionState::READING_REQUEST:      return "READING_REQUEST";
+    case ConnectionState::CONNECTING_BACKEND:   return "CONNECTING_BACKEND";
+    case ConnectionState::READING_BACKEND:      return "READING_BACKEND";
+    case ConnectionState::WRITING_CLIENT:       return "WRITING_CLIENT";
+    case ConnectionState::TLS_HANDSHAKE:        return "TLS_HANDSHAKE";
+    case ConnectionState::MULTIPLEXING:         return "MULTIPLEXING";
+    case ConnectionState::WAITING_WORKER:       return "WAITING_WORKER";
+    case ConnectionState::READING_PROXY_HEADER: return "READING_PROXY_HEADER";
+    case ConnectionState::TUNNELING:            return "TUNNELING";
+    case ConnectionState::CLOSING:              return "CLOSING";
+    }
+    return "UNKNOWN";
+}
@@ -0,0 +1,119 @@
+#include "coro_pipeline.h"
+#include "core/buffer/buffer.h"
+#include "core/coro/async_socket.h"
+#include "core/socket/acceptor.h"
+#include "protocol/http/http_parser.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <iostream>
+
+namespace coro_proxy {
+
+namespace {
+
+// Back-off when accept fails for lack of fds or memory
+constexpr uint64_t kAcceptRetryMs = 100;
+
+// A client gets this long to send a complete request
+constexpr uint64_t kRequestReadMs = 30000;
+
+// Budget for the backend TCP handshake
+constexpr uint64_t kConnectMs = 5000;
+
+// Longest the backend may stay silent while the response streams
+constexpr uint64_t kResponseIdleMs = 60000;
+
+} // namespace
+
+coro::Task<> proxy_connection(coro::Scheduler& sched, int cfd, ConfigSnapshot config) {
+    coro::AsyncSocket client(sched, cfd);
+    Buffer buf(config->client_read_buf_size);
+
+    HttpParser parser;
+    HttpRequestInfo req;
+
+    uint64_t request_deadline = coro::Scheduler::now_ms() + kRequestReadMs;
+    while (true) {
+        if (buf.writable_bytes() == 0) {
+            buf.ensure_capacity(config->client_read_buf_size);
+        }
+
+        ssize_t n = co_await client.read(buf.write_ptr(), buf.writable_bytes(),
+                                         request_deadline);
+        if (n <= 0) {
+            co_return;
+        }
+        buf.commit(n);
+
+        HttpParseResult res = parser.parse(buf.read_ptr(), buf.readable_bytes(), req);
+        if (res == HttpParseResult::COMPLETE) {
+            break;
+        }
+        if (res == HttpParseResult::ERROR) {
+            co_return;
+        }
+    }
+
+    sockaddr_in sa{};
+    sa.sin_family = AF_INET;
+    sa.sin_port = htons(config->backend_port);
+    if (inet_pton(AF_INET, config->backend_host.c_str(), &sa.sin_addr) != 1) {
+        std::cerr << "[coro] backend_host must be an IPv4 literal\n";
+        co_return;
+    }
+
+    int bfd = coro::make_tcp_socket();
+    if (bfd < 0) {
+        co_return;
+    }
+    coro::AsyncSocket backend(sched, bfd);
+
+    if (!co_await backend.connect(sa, coro::Scheduler::now_ms() + kConnectMs)) {
+        co_return;
+    }
+    if (!co_await backend.write_all(buf.read_ptr(), buf.readable_bytes())) {
+        co_return;
+    }
+
+    // The request buffer is done; reuse it for the response stream
+    buf.clear();
+    buf.ensure_capacity(config->backend_read_buf_size);
+
+    // Watch the client while waiting on the backend: a client that
+    // hangs up ends the exchange instead of holding the backend open
+    while (true) {
+        ssize_t n = co_await backend.read(buf.write_ptr(), buf.writable_bytes(),
+                                          coro::Scheduler::now_ms() + kResponseIdleMs,
+                                          &client);
+        if (n <= 0) {
+            co_return;
+        }
+        if (!co_await client.write_all(buf.write_ptr(), n)) {
+            co_return;
+        }
+    }
+}
+
+coro::Task<> accept_loop(coro::Scheduler& sched, Acceptor& acceptor,
+                         const ConfigSnapshot& config) {
+    coro::IoHandle io;
+    io.fd = acceptor.fd();
+    sched.attach(io);
+
+    while (true) {
+        int cfd = acceptor.accept();
+        if (cfd >= 0) {
+            coro::spawn(proxy_connection(sched, cfd, config));
+            continue;
+        }
+
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            co_await coro::readable(io);
+        } else if (errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM) {
+            co_await coro::sleep(sched, kAcceptRetryMs);
+        }
+    }
+}
+
+} // namespace coro_proxy
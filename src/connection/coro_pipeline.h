@@ -0,0 +1,37 @@
+#pragma once
+
+#include "config/config.h"
+#include "core/coro/scheduler.h"
+#include "core/coro/task.h"
+
+class Acceptor;
+
+/*
+ * Coroutine proxy pipeline
+ * ------------------------
+ * The HTTP/1.1 request path of ConnectionManager written as straight-line
+ * coroutines: read the request, connect the backend, forward, stream the
+ * response back. Each connection is one coroutine; its sockets and buffer
+ * live in the (pooled) frame.
+ *
+ * Core rules:
+ * - Every wait is bounded: request read, backend connect and each
+ *   response read have deadlines on the Scheduler's timer heap
+ * - The client is watched while the response is awaited; its hangup
+ *   ends the exchange
+ *
+ * Non-responsibilities (still ConnectionManager only):
+ * - TLS, HTTP/2, compression, DNS names for the backend
+ */
+namespace coro_proxy {
+
+// Serve one accepted client until the backend closes, the client hangs
+// up or a deadline passes
+coro::Task<> proxy_connection(coro::Scheduler& sched, int cfd, ConfigSnapshot config);
+
+// Accept forever, spawning proxy_connection per client; config is read
+// at each accept, so the caller may swap it on reload
+coro::Task<> accept_loop(coro::Scheduler& sched, Acceptor& acceptor,
+                         const ConfigSnapshot& config);
+
+} // namespace coro_proxy
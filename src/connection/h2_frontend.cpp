@@ -0,0 +1,353 @@
+#include "h2_frontend.h"
+#include "connection.h"
+#include "upstream_pool.h"
+#include "core/event_loop/epoll_loop.h"
+#include "core/socket/socket.h"
+#include "protocol/http/forwarded.h"
+
+#include <sys/socket.h>
+#include <errno.h>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+namespace {
+
+// Connection-specific headers never cross an HTTP/2 <-> HTTP/1.1 hop
+bool hop_by_hop(const std::string& name) {
+    return name == "connection" || name == "keep-alive" ||
+           name == "proxy-connection" || name == "transfer-encoding" ||
+           name == "upgrade" || name == "te" || name == "http2-settings";
+}
+
+void build_http1_request(const H2Request& req, const Connection& conn, Buffer& out) {
+    const ProxyConfig& cfg = *conn.config_;
+    std::string head;
+    head.reserve(256);
+    head.append(req.method).append(" ").append(req.path).append(" HTTP/1.1\r\n");
+
+    const HeaderRules& rules = cfg.request_headers;
+
+    bool have_host = false;
+    if (!req.authority.empty() && !rules.removes("host")) {
+        head.append("Host: ").append(req.authority).append("\r\n");
+        have_host = true;
+    }
+
+    // HTTP/2 may split cookies into crumbs; HTTP/1.1 wants one header
+    std::string cookie;
+    std::string xff;
+    std::string fwd;
+    for (const HeaderField& h : req.headers) {
+        if (hop_by_hop(h.first) || h.first == "content-length" || rules.removes(h.first)) {
+            continue;
+        }
+        // Merged with our own entry below
+        if (cfg.x_forwarded_for && h.first == "x-forwarded-for") {
+            xff.append(xff.empty() ? "" : ", ").append(h.second);
+            continue;
+        }
+        if (cfg.forwarded && h.first == "forwarded") {
+            fwd.append(fwd.empty() ? "" : ", ").append(h.second);
+            continue;
+        }
+        if (h.first == "host") {
+            if (have_host) {
+                continue;
+            }
+            have_host = true;
+        }
+        if (h.first == "cookie") {
+            if (!cookie.empty()) {
+                cookie.append("; ");
+            }
+            cookie.append(h.second);
+            continue;
+        }
+        head.append(h.first).append(": ").append(h.second).append("\r\n");
+    }
+    if (!cookie.empty()) {
+        head.append("cookie: ").append(cookie).append("\r\n");
+    }
+    rules.append_lines(head);
+    if (cfg.x_forwarded_for || cfg.forwarded) {
+        ForwardedSplicer::append_lines(head, ForwardedSplicer::format_address(conn.peer_),
+                                       cfg.x_forwarded_for, xff, cfg.forwarded, fwd);
+    }
+
+    if (!req.body.empty() || req.method == "POST" || req.method == "PUT" ||
+        req.method == "PATCH") {
+        head.append("Content-Length: ").append(std::to_string(req.body.size())).append("\r\n");
+    }
+    head.append("\r\n");
+
+    out.append(head.data(), head.size());
+    out.append(req.body.data(), req.body.size());
+}
+
+} // namespace
+
+H2Frontend::H2Frontend(Connection& conn, EpollLoop& loop, UpstreamPool& pool)
+    : conn_(conn),
+      loop_(loop),
+      pool_(pool) {
+
+    session_.set_callbacks(
+        [this](H2Request& req) { on_request(req); },
+        [this](uint32_t id) { on_reset(id); });
+    session_.start();
+}
+
+H2Frontend::~H2Frontend() {
+    shutdown();
+}
+
+void H2Frontend::shutdown() {
+    for (auto& kv : upstreams_) {
+        pool_.release(kv.second, false);
+    }
+    upstreams_.clear();
+}
+
+void H2Frontend::set_routing(Router route, Outcome outcome) {
+    route_ = std::move(route);
+    outcome_ = std::move(outcome);
+}
+
+bool H2Frontend::on_client_data(const char* data, size_t len, size_t& consumed) {
+    ssize_t n = session_.feed(data, len);
+    if (n < 0) {
+        consumed = len;
+        return false;
+    }
+    consumed = static_cast<size_t>(n);
+    return true;
+}
+
+void H2Frontend::on_request(H2Request& req) {
+    uint32_t addr = 0;
+    uint16_t port = 0;
+    int r = route_ ? route_(addr, port) : 502;
+
+    if (r < 0) {
+        std::cout << "[h2] stream " << req.stream_id << " waiting for DNS\n";
+        parked_.push_back(std::move(req));
+        return;
+    }
+    if (r > 0) {
+        session_.submit_headers(req.stream_id, r, {}, true);
+        return;
+    }
+    open_stream(req, addr, port);
+}
+
+void H2Frontend::open_stream(H2Request& req, uint32_t addr, uint16_t port) {
+    uint32_t id = req.stream_id;
+
+    UpstreamConn* u = pool_.acquire(addr, port, &conn_);
+    if (!u) {
+        session_.submit_headers(id, 502, {}, true);
+        return;
+    }
+
+    u->stream_id = id;
+    u->start_us = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    u->parser.set_head_request(req.method == "HEAD");
+    build_http1_request(req, conn_, u->out);
+    upstreams_[id] = u;
+
+    std::cout << "[h2] stream " << id << " " << req.method << " " << req.path
+              << " -> upstream fd=" << u->fd.get() << "\n";
+}
+
+void H2Frontend::resume_parked() {
+    // Routing again may park a stream again; that one waits for the next result
+    std::vector<H2Request> ready;
+    ready.swap(parked_);
+    for (H2Request& req : ready) {
+        on_request(req);
+    }
+}
+
+void H2Frontend::fail_parked(int status) {
+    std::vector<H2Request> failed;
+    failed.swap(parked_);
+    for (const H2Request& req : failed) {
+        session_.submit_headers(req.stream_id, status, {}, true);
+    }
+}
+
+void H2Frontend::on_reset(uint32_t stream_id) {
+    parked_.erase(std::remove_if(parked_.begin(), parked_.end(),
+                                 [stream_id](const H2Request& r) {
+                                     return r.stream_id == stream_id;
+                                 }),
+                  parked_.end());
+
+    auto it = upstreams_.find(stream_id);
+    if (it == upstreams_.end()) {
+        return;
+    }
+    UpstreamConn* u = it->second;
+    upstreams_.erase(it);
+    // Response is abandoned mid-flight; the connection cannot be reused
+    pool_.release(u, false);
+}
+
+void H2Frontend::update_interest(UpstreamConn* u) {
+    uint32_t events = 0;
+    if (!u->connected || u->out.readable_bytes() > 0) {
+        events |= EPOLLOUT;
+    }
+    if (!paused_) {
+        events |= EPOLLIN | EPOLLRDHUP;
+    }
+    loop_.modify(u->fd.get(), events, &u->tag);
+}
+
+void H2Frontend::on_upstream_event(UpstreamConn* u, uint32_t events) {
+    if (!u->connected && (events & (EPOLLOUT | EPOLLERR | EPOLLHUP))) {
+        int err = 0;
+        socklen_t len = sizeof(err);
+        ::getsockopt(u->fd.get(), SOL_SOCKET, SO_ERROR, &err, &len);
+        if (err != 0) {
+            fail_stream(u);
+            return;
+        }
+        u->connected = true;
+    }
+
+    if ((events & EPOLLOUT) && u->out.readable_bytes() > 0) {
+        write_upstream(u);
+        if (!upstreams_.count(u->stream_id)) {
+            return;
+        }
+    }
+
+    if (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+        read_upstream(u);
+        return;
+    }
+
+    update_interest(u);
+}
+
+void H2Frontend::write_upstream(UpstreamConn* u) {
+    while (u->out.readable_bytes() > 0) {
+        ssize_t n = Socket::write(u->fd.get(), u->out.read_ptr(), u->out.readable_bytes());
+        if (n > 0) {
+            u->out.consume(n);
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        }
+        fail_stream(u);
+        return;
+    }
+    update_interest(u);
+}
+
+void H2Frontend::read_upstream(UpstreamConn* u) {
+    uint32_t id = u->stream_id;
+    std::string body;
+
+    // Bounded per event so one large response cannot starve the loop
+    for (int round = 0; round < 4 && !paused_; ++round) {
+        u->in.ensure_capacity(16384);
+        ssize_t n = Socket::read(u->fd.get(), u->in.write_ptr(), u->in.writable_bytes());
+
+        bool eof = n == 0;
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            fail_stream(u);
+            return;
+        }
+        u->in.commit(n);
+
+        ssize_t used = u->parser.feed(u->in.read_ptr(), u->in.readable_bytes(), body);
+        if (used < 0) {
+            fail_stream(u);
+            return;
+        }
+        u->in.consume(used);
+
+        if (eof && !u->parser.on_eof()) {
+            fail_stream(u);
+            return;
+        }
+
+        bool done = u->parser.done();
+
+        if (u->parser.head_complete() && !u->head_sent) {
+            if (outcome_) {
+                outcome_(*u, true);
+            }
+            HeaderList headers;
+            for (const auto& h : u->parser.headers()) {
+                if (!hop_by_hop(h.first)) {
+                    headers.push_back(h);
+                }
+            }
+            bool no_body = done && body.empty();
+            session_.submit_headers(id, u->parser.status(), headers, no_body);
+            u->head_sent = true;
+            if (no_body) {
+                finish(u, true);
+                return;
+            }
+        }
+
+        if (!body.empty() || done) {
+            session_.submit_data(id, body.data(), body.size(), done);
+            body.clear();
+        }
+
+        if (done) {
+            finish(u, !eof);
+            return;
+        }
+        if (eof) {
+            return;
+        }
+
+        if (session_.pending_body_bytes() > kMaxPendingBody) {
+            paused_ = true;
+        }
+    }
+
+    update_interest(u);
+}
+
+void H2Frontend::on_client_drained() {
+    if (!paused_ || session_.pending_body_bytes() > kMaxPendingBody / 2) {
+        return;
+    }
+    paused_ = false;
+    for (auto& kv : upstreams_) {
+        update_interest(kv.second);
+    }
+}
+
+void H2Frontend::finish(UpstreamConn* u, bool reusable) {
+    upstreams_.erase(u->stream_id);
+    pool_.release(u, reusable && u->parser.keep_alive() && u->in.readable_bytes() == 0);
+}
+
+void H2Frontend::fail_stream(UpstreamConn* u) {
+    uint32_t id = u->stream_id;
+    bool head_sent = u->head_sent;
+    if (!head_sent && outcome_) {
+        outcome_(*u, false);
+    }
+    finish(u, false);
+
+    if (head_sent) {
+        session_.reset_stream(id, h2::ErrorCode::INTERNAL_ERROR);
+    } else {
+        session_.submit_headers(id, 502, {}, true);
+    }
+}
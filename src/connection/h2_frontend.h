@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+#include "protocol/http2/h2_session.h"
+
+struct Connection;
+struct UpstreamConn;
+class UpstreamPool;
+class EpollLoop;
+
+/*
+ * H2Frontend
+ * ----------
+ * Bridges one HTTP/2 client connection onto pooled HTTP/1.1 upstreams.
+ *
+ * Responsibilities:
+ * - Drive the H2Session with bytes read from the client
+ * - Translate each request stream into an HTTP/1.1 request on a
+ *   leased UpstreamConn
+ * - Translate upstream responses back into HEADERS / DATA frames
+ * - Apply backpressure: stop reading upstreams while the client is slow
+ *
+ * Non-responsibilities:
+ * - Client socket I/O and TLS (ConnectionManager flushes output())
+ * - Connection lifetime
+ * - Choosing upstreams: the owner's Router applies the same backends,
+ *   DNS and breaker policy as HTTP/1.1 requests get
+ */
+class H2Frontend {
+public:
+    // Stop reading upstream bodies beyond this much unsent client data
+    static constexpr size_t kMaxPendingBody = 256 * 1024;
+
+    // Picks the upstream for a new stream. Returns 0 with addr/port set,
+    // -1 to park the stream until resume_parked() (DNS in flight), or
+    // the HTTP status to answer it with
+    using Router = std::function<int(uint32_t& addr, uint16_t& port)>;
+
+    // How a leased upstream fared before its response head
+    using Outcome = std::function<void(const UpstreamConn& u, bool ok)>;
+
+    H2Frontend(Connection& conn, EpollLoop& loop, UpstreamPool& pool);
+    ~H2Frontend();
+
+    H2Frontend(const H2Frontend&) = delete;
+    H2Frontend& operator=(const H2Frontend&) = delete;
+
+    // Required before any client data is fed
+    void set_routing(Router route, Outcome outcome);
+
+    // Consume client bytes; returns false on a connection error
+    bool on_client_data(const char* data, size_t len, size_t& consumed);
+
+    // Streams parked on DNS: route them again, or answer them all
+    void resume_parked();
+    void fail_parked(int status);
+    bool parked() const { return !parked_.empty(); }
+
+    // Readiness on a leased upstream
+    void on_upstream_event(UpstreamConn* u, uint32_t events);
+
+    // Called after client output was flushed; resumes paused upstreams
+    void on_client_drained();
+
+    // Graceful close: no new streams, open ones run to completion
+    void goaway() { session_.goaway(h2::ErrorCode::NO_ERROR); }
+
+    // Release every upstream (client is going away)
+    void shutdown();
+
+    Buffer& output() { return session_.output(); }
+    bool finished() const { return session_.finished(); }
+    size_t open_streams() const { return session_.open_streams(); }
+
+private:
+    void on_request(H2Request& req);
+    void on_reset(uint32_t stream_id);
+
+    void open_stream(H2Request& req, uint32_t addr, uint16_t port);
+    void write_upstream(UpstreamConn* u);
+    void read_upstream(UpstreamConn* u);
+    void finish(UpstreamConn* u, bool reusable);
+    void fail_stream(UpstreamConn* u);
+    void update_interest(UpstreamConn* u);
+
+    Connection& conn_;
+    EpollLoop& loop_;
+    UpstreamPool& pool_;
+    Router route_;
+    Outcome outcome_;
+    H2Session session_;
+    bool paused_{false};
+
+    // stream id -> leased upstream
+    std::unordered_map<uint32_t, UpstreamConn*> upstreams_;
+
+    // Complete requests waiting for their upstream's name to resolve
+    std::vector<H2Request> parked_;
+};
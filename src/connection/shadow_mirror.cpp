@@ -0,0 +1,221 @@
+#include "shadow_mirror.h"
+#include "core/event_loop/epoll_loop.h"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <errno.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr size_t kReadChunk = 16384;
+
+// Unparsed bytes a shadow may carry between reads (a response head or
+// chunk-size line split across segments)
+constexpr size_t kMaxCarry = 65536;
+
+} // namespace
+
+ShadowMirror::ShadowMirror(EpollLoop& loop)
+    : loop_(loop) {}
+
+bool ShadowMirror::sample(uint32_t percent) {
+    credit_ += percent;
+    if (credit_ < 100) {
+        return false;
+    }
+    credit_ -= 100;
+    return true;
+}
+
+bool ShadowMirror::submit(const ProxyConfig& cfg, const iovec* iov, size_t iovcnt,
+                          uint64_t now_ms) {
+    size_t len = 0;
+    for (size_t i = 0; i < iovcnt; ++i) {
+        len += iov[i].iov_len;
+    }
+
+    if (active_.size() >= cfg.mirror_max_inflight) {
+        ++stats_.skipped_inflight;
+        return false;
+    }
+    if (len > cfg.mirror_max_bytes - std::min(bytes_, cfg.mirror_max_bytes)) {
+        ++stats_.skipped_bytes;
+        return false;
+    }
+
+    int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        ++stats_.failed;
+        return false;
+    }
+    cfg.upstream_socket.apply(fd);
+
+    sockaddr_in sa{};
+    sa.sin_family = AF_INET;
+    sa.sin_port = htons(cfg.mirror_upstream.port);
+    sa.sin_addr.s_addr = cfg.mirror_upstream.addr;
+
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&sa), sizeof(sa)) < 0 &&
+        errno != EINPROGRESS) {
+        ::close(fd);
+        ++stats_.failed;
+        return false;
+    }
+
+    auto payload = std::make_shared<std::string>();
+    payload->reserve(len);
+    for (size_t i = 0; i < iovcnt; ++i) {
+        payload->append(static_cast<const char*>(iov[i].iov_base), iov[i].iov_len);
+    }
+
+    auto s = std::make_unique<ShadowRequest>();
+    s->fd.reset(fd);
+    s->parser.set_head_request(payload->compare(0, 5, "HEAD ") == 0);
+    s->payload = std::move(payload);
+    s->deadline_ms = now_ms + cfg.mirror_timeout_ms;
+    s->tag.shadow = s.get();
+
+    // Written once connected; the primary send already happened
+    loop_.add(fd, EPOLLOUT, &s->tag);
+
+    bytes_ += len;
+    ++stats_.started;
+    ShadowRequest* raw = s.get();
+    active_[raw] = std::move(s);
+    return true;
+}
+
+void ShadowMirror::handle_event(ShadowRequest* s, uint32_t events) {
+    if (active_.find(s) == active_.end()) {
+        return;
+    }
+
+    if (s->payload) {
+        if (events & (EPOLLERR | EPOLLHUP)) {
+            ++stats_.failed;
+            finish(s);
+            return;
+        }
+        if (!(events & EPOLLOUT) || !flush(s)) {
+            return;
+        }
+        loop_.modify(s->fd.get(), EPOLLIN | EPOLLRDHUP, &s->tag);
+        return;
+    }
+
+    read_response(s);
+}
+
+bool ShadowMirror::flush(ShadowRequest* s) {
+    const std::string& p = *s->payload;
+
+    while (s->sent < p.size()) {
+        ssize_t n = ::send(s->fd.get(), p.data() + s->sent, p.size() - s->sent, MSG_NOSIGNAL);
+        if (n > 0) {
+            s->sent += n;
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return false;
+        }
+        ++stats_.failed;
+        finish(s);
+        return false;
+    }
+
+    drop_payload(s);
+    return true;
+}
+
+void ShadowMirror::read_response(ShadowRequest* s) {
+    char buf[kReadChunk];
+
+    while (true) {
+        ssize_t n = ::recv(s->fd.get(), buf, sizeof(buf), 0);
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return;
+        }
+        if (n < 0) {
+            ++stats_.failed;
+            finish(s);
+            return;
+        }
+        if (n == 0) {
+            if (s->parser.on_eof()) {
+                ++stats_.completed;
+                ++stats_.responses[s->parser.status() / 100 % 6];
+            } else {
+                ++stats_.failed;
+            }
+            finish(s);
+            return;
+        }
+
+        const char* data = buf;
+        size_t len = static_cast<size_t>(n);
+        if (!s->carry.empty()) {
+            s->carry.append(buf, len);
+            data = s->carry.data();
+            len = s->carry.size();
+        }
+
+        ssize_t used = s->parser.feed(data, len, discard_);
+        discard_.clear();
+        if (used < 0 || len - used > kMaxCarry) {
+            ++stats_.failed;
+            finish(s);
+            return;
+        }
+        if (data == buf) {
+            s->carry.assign(buf + used, len - used);
+        } else {
+            s->carry.erase(0, used);
+        }
+
+        if (s->parser.done()) {
+            ++stats_.completed;
+            ++stats_.responses[s->parser.status() / 100 % 6];
+            finish(s);
+            return;
+        }
+    }
+}
+
+void ShadowMirror::expire(uint64_t now_ms) {
+    std::vector<ShadowRequest*> late;
+    for (const auto& kv : active_) {
+        if (kv.second->deadline_ms <= now_ms) {
+            late.push_back(kv.first);
+        }
+    }
+    for (ShadowRequest* s : late) {
+        ++stats_.timed_out;
+        finish(s);
+    }
+}
+
+void ShadowMirror::drop_payload(ShadowRequest* s) {
+    if (s->payload) {
+        bytes_ -= s->payload->size();
+        s->payload.reset();
+    }
+}
+
+void ShadowMirror::finish(ShadowRequest* s) {
+    auto it = active_.find(s);
+    if (it == active_.end()) {
+        return;
+    }
+
+    drop_payload(s);
+    loop_.remove(s->fd.get());
+    graveyard_.push_back(std::move(it->second));
+    active_.erase(it);
+}
+
+void ShadowMirror::sweep() {
+    graveyard_.clear();
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <sys/uio.h>
+#include <unordered_map>
+#include <vector>
+
+#include "connection.h"
+#include "core/fd/fd_wrapper.h"
+#include "protocol/http/http_response_parser.h"
+
+class EpollLoop;
+
+/*
+ * ShadowRequest
+ * -------------
+ * One mirrored request on its own connection to the shadow upstream.
+ * The payload is released as soon as it has been written.
+ */
+struct ShadowRequest {
+    FDWrapper fd;
+    std::shared_ptr<const std::string> payload;
+    size_t sent = 0;
+    uint64_t deadline_ms = 0;
+    HttpResponseParser parser;
+    std::string carry;          // response bytes the parser has not taken
+    Connection::EpollTag tag{nullptr, false};
+};
+
+/*
+ * MirrorStats
+ * -----------
+ * Per-worker mirroring outcomes. Skipped shadows never opened a socket.
+ */
+struct MirrorStats {
+    uint64_t started = 0;
+    uint64_t completed = 0;         // whole response read (and discarded)
+    uint64_t failed = 0;            // connect, write or framing error
+    uint64_t timed_out = 0;
+    uint64_t skipped_inflight = 0;  // mirror_max_inflight reached
+    uint64_t skipped_bytes = 0;     // mirror_max_bytes would be exceeded
+    uint64_t responses[6] = {};     // completed, by status class
+};
+
+/*
+ * ShadowMirror
+ * ------------
+ * Per-loop fire-and-forget copies of sampled requests to the shadow
+ * upstream (mirror_upstream), for trying a new backend on real traffic.
+ *
+ * Core rules:
+ * - The primary request never waits on its shadow: submit() runs after
+ *   the primary send, and nothing on the shadow side calls back into
+ *   the connection it came from (which may be gone by then)
+ * - The request bytes (as sent upstream, header edits included) are
+ *   gathered once into an immutable shared payload; partial writes
+ *   resume from an offset, never re-buffer
+ * - Hard caps, checked before anything is allocated: at most
+ *   mirror_max_inflight shadows, holding at most mirror_max_bytes of
+ *   payload. Over a cap the shadow is skipped, never queued
+ * - Responses are framed with HttpResponseParser so the connection can
+ *   be closed as soon as one is complete; bodies go through a single
+ *   per-loop scratch buffer and are dropped
+ * - Finished shadows are destroyed in sweep(), never while an epoll
+ *   batch may still reference their tag
+ *
+ * Non-responsibilities:
+ * - HTTP/2 streams, tunnels and retries (only first attempts of plain
+ *   HTTP/1.x requests are mirrored)
+ * - Comparing shadow responses with primary ones (only status classes
+ *   are counted)
+ */
+class ShadowMirror {
+public:
+    explicit ShadowMirror(EpollLoop& loop);
+
+    ShadowMirror(const ShadowMirror&) = delete;
+    ShadowMirror& operator=(const ShadowMirror&) = delete;
+
+    // Whether the next request is mirrored: percent of calls, evenly
+    // spaced (no randomness, so the rate holds over short windows)
+    bool sample(uint32_t percent);
+
+    // Mirror the request gathered in iov to cfg.mirror_upstream.
+    // False if a cap was hit or the socket could not be opened
+    bool submit(const ProxyConfig& cfg, const iovec* iov, size_t iovcnt, uint64_t now_ms);
+
+    void handle_event(ShadowRequest* s, uint32_t events);
+
+    // Abort shadows past their deadline
+    void expire(uint64_t now_ms);
+
+    // Destroy shadows finished since the last sweep
+    void sweep();
+
+    size_t inflight() const { return active_.size(); }
+    size_t payload_bytes() const { return bytes_; }
+    const MirrorStats& stats() const { return stats_; }
+
+private:
+    bool flush(ShadowRequest* s);
+    void read_response(ShadowRequest* s);
+    void drop_payload(ShadowRequest* s);
+    void finish(ShadowRequest* s);
+
+    EpollLoop& loop_;
+    uint32_t credit_{0};
+    size_t bytes_{0};
+    MirrorStats stats_;
+
+    std::unordered_map<ShadowRequest*, std::unique_ptr<ShadowRequest>> active_;
+    std::vector<std::unique_ptr<ShadowRequest>> graveyard_;
+    std::string discard_;
+};
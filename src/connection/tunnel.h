@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fcntl.h>
+#include <list>
+#include <unistd.h>
+
+#include "core/buffer/buffer.h"
+#include "core/fd/fd_wrapper.h"
+
+struct Connection;
+
+/*
+ * TunnelRequest
+ * -------------
+ * What the current request asked for beyond a plain exchange.
+ */
+enum class TunnelRequest : uint8_t {
+    NONE = 0,
+    UPGRADE,        // Upgrade: websocket, tunnel once the backend says 101
+    CONNECT         // CONNECT host:port, tunnel once the target accepts
+};
+
+/*
+ * TunnelLeg
+ * ---------
+ * One direction of an open tunnel (client to backend, or back).
+ *
+ * Core rules:
+ * - buf is always written first: it holds whatever was buffered before
+ *   the tunnel opened (early client frames, the 101 or 200 head), and
+ *   carries every byte when the leg cannot splice (TLS client)
+ * - Otherwise bytes move source -> pipe -> destination with splice(),
+ *   never entering user space
+ * - A leg whose destination is full stops reading its source; the other
+ *   leg keeps flowing
+ * - Source EOF becomes shutdown(SHUT_WR) on the destination once all
+ *   bytes read have been written
+ */
+struct TunnelLeg {
+    Buffer buf{0};
+    FDWrapper pipe_rd;
+    FDWrapper pipe_wr;
+    size_t piped = 0;           // bytes sitting in the pipe
+
+    bool src_eof = false;
+    bool dst_shut = false;
+    bool dst_blocked = false;
+    uint64_t bytes = 0;
+
+    bool open_pipe() {
+        int p[2];
+        if (::pipe2(p, O_NONBLOCK | O_CLOEXEC) < 0) {
+            return false;
+        }
+        pipe_rd.reset(p[0]);
+        pipe_wr.reset(p[1]);
+        return true;
+    }
+
+    bool wants_read() const { return !src_eof && !dst_blocked; }
+};
+
+/*
+ * Tunnel
+ * ------
+ * Opaque bidirectional relay state of a Connection in TUNNELING.
+ *
+ * Idle tracking is a list ordered by last activity, owned by the
+ * ConnectionManager: activity moves the entry to the back, so expiry
+ * only ever looks at the front.
+ */
+struct Tunnel {
+    TunnelLeg up;               // client -> backend
+    TunnelLeg down;             // backend -> client
+    bool splice = false;
+
+    // Interest currently registered for each fd (~0u = unknown)
+    uint32_t client_events = ~0u;
+    uint32_t backend_events = ~0u;
+
+    uint64_t last_active_ms = 0;
+    std::list<Connection*>::iterator idle_pos;
+};
@@ -0,0 +1,106 @@
+#include "upstream_pool.h"
+#include "core/event_loop/epoll_loop.h"
+
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <errno.h>
+
+UpstreamPool::UpstreamPool(EpollLoop& loop, size_t max_idle)
+    : loop_(loop),
+      max_idle_(max_idle) {}
+
+bool UpstreamPool::still_open(int fd) {
+    char c;
+    ssize_t n = ::recv(fd, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+    // Any readable byte on an idle HTTP/1.1 connection is a protocol
+    // violation or a close; only EAGAIN means "alive and quiet"
+    return n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+}
+
+UpstreamConn* UpstreamPool::acquire(uint32_t addr, uint16_t port, Connection* owner) {
+    std::unique_ptr<UpstreamConn> u;
+
+    // Most recently used first: warmest socket, least likely timed out
+    auto it = idle_.find(key(addr, port));
+    if (it != idle_.end()) {
+        std::vector<std::unique_ptr<UpstreamConn>>& list = it->second;
+        while (!list.empty() && !u) {
+            std::unique_ptr<UpstreamConn> cand = std::move(list.back());
+            list.pop_back();
+            --idle_count_;
+            if (still_open(cand->fd.get())) {
+                u = std::move(cand);
+            } else {
+                graveyard_.push_back(std::move(cand));
+            }
+        }
+        if (list.empty()) {
+            idle_.erase(it);
+        }
+    }
+
+    if (!u) {
+        int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            return nullptr;
+        }
+        owner->config_->upstream_socket.apply(fd);
+
+        sockaddr_in sa{};
+        sa.sin_family = AF_INET;
+        sa.sin_port = htons(port);
+        sa.sin_addr.s_addr = addr;
+
+        if (::connect(fd, reinterpret_cast<sockaddr*>(&sa), sizeof(sa)) < 0 &&
+            errno != EINPROGRESS) {
+            ::close(fd);
+            return nullptr;
+        }
+
+        u = std::make_unique<UpstreamConn>();
+        u->fd.reset(fd);
+        u->addr = addr;
+        u->port = port;
+    }
+
+    u->out.clear();
+    u->in.clear();
+    u->parser.reset();
+    u->head_sent = false;
+    u->start_us = 0;
+    u->stream_id = 0;
+    u->tag.conn = owner;
+    u->tag.is_client = false;
+    u->tag.upstream = u.get();
+
+    loop_.add(u->fd.get(), EPOLLOUT | EPOLLIN | EPOLLRDHUP, &u->tag);
+
+    UpstreamConn* raw = u.get();
+    leased_[raw] = std::move(u);
+    return raw;
+}
+
+void UpstreamPool::release(UpstreamConn* u, bool reusable) {
+    auto it = leased_.find(u);
+    if (it == leased_.end()) {
+        return;
+    }
+
+    std::unique_ptr<UpstreamConn> owned = std::move(it->second);
+    leased_.erase(it);
+
+    loop_.remove(owned->fd.get());
+    owned->tag.conn = nullptr;
+
+    if (reusable && owned->connected && idle_count_ < max_idle_) {
+        ++idle_count_;
+        idle_[key(owned->addr, owned->port)].push_back(std::move(owned));
+    } else {
+        graveyard_.push_back(std::move(owned));
+    }
+}
+
+void UpstreamPool::sweep() {
+    graveyard_.clear();
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "connection.h"
+#include "core/buffer/buffer.h"
+#include "core/fd/fd_wrapper.h"
+#include "protocol/http/http_response_parser.h"
+
+class EpollLoop;
+
+/*
+ * UpstreamConn
+ * ------------
+ * One HTTP/1.1 connection to a backend, leased to a single stream at a time.
+ */
+struct UpstreamConn {
+    FDWrapper fd;
+    uint32_t addr = 0;          // network order
+    uint16_t port = 0;
+    bool connected = false;
+
+    Buffer out{4096};           // request bytes not yet written
+    Buffer in{8192};            // response bytes not yet parsed
+    HttpResponseParser parser;
+    bool head_sent = false;     // response head forwarded to the client
+    uint64_t start_us = 0;      // leased at (for the breakers' latency)
+
+    uint32_t stream_id = 0;
+    Connection::EpollTag tag{nullptr, false};
+};
+
+/*
+ * UpstreamPool
+ * ------------
+ * Per-loop pool of keep-alive HTTP/1.1 connections to backends.
+ *
+ * Core rules:
+ * - Idle connections are not registered with epoll, and are kept per
+ *   (addr, port): leasing one upstream never disturbs another's
+ * - An idle connection is checked for a pending close before reuse
+ * - Released connections are destroyed in sweep(), never while an epoll
+ *   batch may still reference their tag
+ */
+class UpstreamPool {
+public:
+    UpstreamPool(EpollLoop& loop, size_t max_idle = 64);
+
+    UpstreamPool(const UpstreamPool&) = delete;
+    UpstreamPool& operator=(const UpstreamPool&) = delete;
+
+    // Lease a connection for owner; registers it with EPOLLOUT so the
+    // caller learns when it is writable. Returns nullptr on failure.
+    UpstreamConn* acquire(uint32_t addr, uint16_t port, Connection* owner);
+
+    // Give a connection back; reusable connections are parked idle
+    void release(UpstreamConn* u, bool reusable);
+
+    // Destroy connections released since the last sweep
+    void sweep();
+
+    size_t idle_count() const { return idle_count_; }
+    size_t leased_count() const { return leased_.size(); }
+
+private:
+    static bool still_open(int fd);
+    static uint64_t key(uint32_t addr, uint16_t port) {
+        return (static_cast<uint64_t>(addr) << 16) | port;
+    }
+
+    EpollLoop& loop_;
+    size_t max_idle_;
+    size_t idle_count_{0};
+    std::unordered_map<uint64_t, std::vector<std::unique_ptr<UpstreamConn>>> idle_;
+    std::unordered_map<UpstreamConn*, std::unique_ptr<UpstreamConn>> leased_;
+    std::vector<std::unique_ptr<UpstreamConn>> graveyard_;
+};
@@ -56,6 +56,12 @@ void Buffer::consume(size_t bytes) {
     }
 }
 
+void Buffer::append(const char* data, size_t len) {
+    ensure_capacity(len);
+    std::copy(data, data + len, data_.begin() + write_offset_);
+    write_offset_ += len;
+}
+
 void Buffer::clear() {
     read_offset_ = 0;
     write_offset_ = 0;
@@ -39,18 +39,26 @@ public:
     const char* read_ptr() const;
     size_t readable_bytes() const;
 
+    // Bytes currently allocated
+    size_t capacity() const { return data_.size(); }
+
     // Commit bytes written into buffer
     void commit(size_t bytes);
 
     // Consume bytes from buffer
     void consume(size_t bytes);
 
+    // Copy bytes in, growing the buffer if needed
+    void append(const char* data, size_t len);
+
     // Clear buffer completely
     void clear();
 
-private:
+    // Make room for at least `additional` writable bytes
+    // (compacts first, grows only if still short)
     void ensure_capacity(size_t additional);
 
+private:
     std::vector<char> data_;
     size_t read_offset_;
     size_t write_offset_;
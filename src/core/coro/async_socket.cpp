@@ -0,0 +1,131 @@
+#include "async_socket.h"
+
+#include <errno.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace coro {
+
+int make_tcp_socket() {
+    return ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+}
+
+AsyncSocket::AsyncSocket(Scheduler& sched, int fd)
+    : sched_(sched),
+      fd_(fd) {
+    io_.fd = fd;
+    sched_.attach(io_);
+}
+
+AsyncSocket::~AsyncSocket() {
+    sched_.detach(io_);
+}
+
+Task<ssize_t> AsyncSocket::read(void* buf, size_t len) {
+    while (true) {
+        ssize_t n = ::read(fd_.get(), buf, len);
+        if (n >= 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+            co_return n;
+        }
+        co_await readable(io_);
+    }
+}
+
+Task<ssize_t> AsyncSocket::read(void* buf, size_t len, uint64_t deadline_ms,
+                                AsyncSocket* watch) {
+    while (true) {
+        ssize_t n = ::read(fd_.get(), buf, len);
+        if (n >= 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+            co_return n;
+        }
+        // Checked before every suspend: a hangup edge that arrived while
+        // nobody waited on watch is not delivered again
+        if (watch && watch->peer_closed()) {
+            errno = ECONNRESET;
+            co_return -1;
+        }
+        if (!co_await ready_until(sched_, io_, false, deadline_ms,
+                                  watch ? &watch->io_ : nullptr)) {
+            errno = ETIMEDOUT;
+            co_return -1;
+        }
+    }
+}
+
+bool AsyncSocket::peer_closed() const {
+    char c;
+    ssize_t n = ::recv(fd_.get(), &c, 1, MSG_PEEK | MSG_DONTWAIT);
+    return n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK);
+}
+
+Task<bool> AsyncSocket::write_all(const void* buf, size_t len) {
+    const char* p = static_cast<const char*>(buf);
+
+    while (len > 0) {
+        ssize_t n = ::send(fd_.get(), p, len, MSG_NOSIGNAL);
+        if (n > 0) {
+            p += n;
+            len -= n;
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            co_await writable(io_);
+            continue;
+        }
+        co_return false;
+    }
+    co_return true;
+}
+
+Task<bool> AsyncSocket::connect(const sockaddr_in& addr) {
+    if (::connect(fd_.get(), reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) == 0) {
+        co_return true;
+    }
+    if (errno != EINPROGRESS) {
+        co_return false;
+    }
+
+    co_await writable(io_);
+
+    int err = 0;
+    socklen_t len = sizeof(err);
+    if (::getsockopt(fd_.get(), SOL_SOCKET, SO_ERROR, &err, &len) < 0) {
+        co_return false;
+    }
+    co_return err == 0;
+}
+
+Task<bool> AsyncSocket::connect(const sockaddr_in& addr, uint64_t deadline_ms) {
+    if (::connect(fd_.get(), reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) == 0) {
+        co_return true;
+    }
+    if (errno != EINPROGRESS) {
+        co_return false;
+    }
+
+    if (!co_await ready_until(sched_, io_, true, deadline_ms)) {
+        errno = ETIMEDOUT;
+        co_return false;
+    }
+
+    int err = 0;
+    socklen_t len = sizeof(err);
+    if (::getsockopt(fd_.get(), SOL_SOCKET, SO_ERROR, &err, &len) < 0) {
+        co_return false;
+    }
+    co_return err == 0;
+}
+
+Task<int> AsyncSocket::accept(sockaddr_in* peer) {
+    while (true) {
+        socklen_t len = sizeof(sockaddr_in);
+        int fd = ::accept4(fd_.get(), reinterpret_cast<sockaddr*>(peer),
+                           peer ? &len : nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd >= 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+            co_return fd;
+        }
+        co_await readable(io_);
+    }
+}
+
+} // namespace coro
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <netinet/in.h>
+#include <sys/types.h>
+
+#include "core/fd/fd_wrapper.h"
+#include "scheduler.h"
+#include "task.h"
+
+namespace coro {
+
+/*
+ * AsyncSocket
+ * -----------
+ * Non-blocking socket whose operations are awaited instead of called
+ * back.
+ *
+ * Core rules:
+ * - Owns the fd; registered with the Scheduler for its whole lifetime
+ * - At most one reader and one writer may be suspended at a time
+ * - Results follow read(2)/write(2): 0 is EOF, -1 sets errno (never
+ *   EAGAIN, which is absorbed by suspending)
+ */
+class AsyncSocket {
+public:
+    AsyncSocket(Scheduler& sched, int fd);
+    ~AsyncSocket();
+
+    AsyncSocket(const AsyncSocket&) = delete;
+    AsyncSocket& operator=(const AsyncSocket&) = delete;
+
+    int fd() const { return fd_.get(); }
+
+    Task<ssize_t> read(void* buf, size_t len);
+
+    // Write everything or fail; returns false on error
+    Task<bool> write_all(const void* buf, size_t len);
+
+    // Connect a fresh non-blocking socket; returns false on failure
+    Task<bool> connect(const sockaddr_in& addr);
+
+    // Deadline forms (Scheduler::now_ms() time): -1/false with errno
+    // ETIMEDOUT once it passes. When watch is given, read() also fails
+    // with ECONNRESET as soon as watch's peer has closed, so a relay
+    // blocked on one side notices the other side going away.
+    Task<ssize_t> read(void* buf, size_t len, uint64_t deadline_ms,
+                       AsyncSocket* watch = nullptr);
+    Task<bool> connect(const sockaddr_in& addr, uint64_t deadline_ms);
+
+    // True once the peer has closed (EOF or error pending, nothing to read)
+    bool peer_closed() const;
+
+    // Accept on a listening socket; returns the new fd or -1
+    // (sets peer when given)
+    Task<int> accept(sockaddr_in* peer = nullptr);
+
+private:
+    Scheduler& sched_;
+    FDWrapper fd_;
+    IoHandle io_;
+};
+
+// A non-blocking TCP socket ready for AsyncSocket::connect (-1 on failure)
+int make_tcp_socket();
+
+} // namespace coro
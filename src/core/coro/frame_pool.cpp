@@ -0,0 +1,63 @@
+#include "frame_pool.h"
+
+#include <new>
+
+FramePool& FramePool::local() {
+    thread_local FramePool pool;
+    return pool;
+}
+
+FramePool::~FramePool() {
+    for (size_t i = 0; i < kClasses; ++i) {
+        while (FreeNode* n = free_[i]) {
+            free_[i] = n->next;
+            ::operator delete(n);
+        }
+    }
+}
+
+size_t FramePool::class_index(size_t n) {
+    size_t size = kMinClass;
+    size_t i = 0;
+    while (size < n) {
+        size <<= 1;
+        ++i;
+    }
+    return i;
+}
+
+void* FramePool::allocate(size_t n) {
+    if (n > kMaxClass) {
+        ++allocations_;
+        return ::operator new(n);
+    }
+
+    size_t i = class_index(n);
+    if (FreeNode* node = free_[i]) {
+        free_[i] = node->next;
+        --cached_[i];
+        ++reuses_;
+        return node;
+    }
+
+    ++allocations_;
+    return ::operator new(kMinClass << i);
+}
+
+void FramePool::deallocate(void* p, size_t n) noexcept {
+    if (n > kMaxClass) {
+        ::operator delete(p);
+        return;
+    }
+
+    size_t i = class_index(n);
+    if (cached_[i] >= kMaxCached) {
+        ::operator delete(p);
+        return;
+    }
+
+    auto* node = static_cast<FreeNode*>(p);
+    node->next = free_[i];
+    free_[i] = node;
+    ++cached_[i];
+}
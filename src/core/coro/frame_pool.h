@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+/*
+ * FramePool
+ * ---------
+ * Per-thread free lists for coroutine frames.
+ *
+ * Core rules:
+ * - Sizes are rounded up to a power-of-two class (64B .. 4KB); larger
+ *   frames fall back to operator new
+ * - Freed frames are kept for reuse, up to kMaxCached per class, so a
+ *   steady-state proxy allocates no frames at all
+ * - A frame must be freed on the thread that allocated it (each worker
+ *   runs its own loop, so coroutines never migrate)
+ */
+class FramePool {
+public:
+    static constexpr size_t kMinClass = 64;
+    static constexpr size_t kMaxClass = 4096;
+    static constexpr size_t kMaxCached = 1024;
+
+    static FramePool& local();
+
+    void* allocate(size_t n);
+    void deallocate(void* p, size_t n) noexcept;
+
+    size_t allocations() const { return allocations_; }    // served from the heap
+    size_t reuses() const { return reuses_; }                // served from a free list
+
+    ~FramePool();
+
+private:
+    FramePool() = default;
+
+    static size_t class_index(size_t n);
+
+    struct FreeNode {
+        FreeNode* next;
+    };
+
+    static constexpr size_t kClasses = 7;   // 64, 128, ..., 4096
+
+    FreeNode* free_[kClasses] = {};
+    size_t cached_[kClasses] = {};
+    size_t allocations_{0};
+    size_t reuses_{0};
+};
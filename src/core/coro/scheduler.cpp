@@ -0,0 +1,81 @@
+#include "scheduler.h"
+
+#include <chrono>
+
+namespace coro {
+
+Scheduler::Scheduler(EpollLoop& loop)
+    : loop_(loop) {}
+
+void Scheduler::attach(IoHandle& io) {
+    loop_.add(io.fd, EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET, &io);
+}
+
+void Scheduler::detach(IoHandle& io) {
+    loop_.remove(io.fd);
+    io.reader = nullptr;
+    io.writer = nullptr;
+}
+
+void Scheduler::dispatch(void* data, uint32_t events) {
+    auto* io = static_cast<IoHandle*>(data);
+
+    // Take both first: resuming one may finish the coroutine that owns io
+    std::coroutine_handle<> reader;
+    std::coroutine_handle<> writer;
+
+    if (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+        reader = std::exchange(io->reader, nullptr);
+    }
+    if (events & (EPOLLOUT | EPOLLHUP | EPOLLERR)) {
+        writer = std::exchange(io->writer, nullptr);
+    }
+
+    if (reader) {
+        reader.resume();
+    }
+    if (writer) {
+        writer.resume();
+    }
+}
+
+uint64_t Scheduler::add_timer(uint64_t deadline_ms, std::coroutine_handle<> h) {
+    uint64_t id = timer_seq_++;
+    timers_.push(Timer{deadline_ms, id, h});
+    return id;
+}
+
+void Scheduler::cancel_timer(uint64_t id) {
+    cancelled_.insert(id);
+}
+
+int Scheduler::next_timeout_ms(int max_ms) const {
+    if (timers_.empty()) {
+        return max_ms;
+    }
+    uint64_t now = now_ms();
+    uint64_t deadline = timers_.top().deadline;
+    if (deadline <= now) {
+        return 0;
+    }
+    uint64_t wait = deadline - now;
+    return wait < static_cast<uint64_t>(max_ms) ? static_cast<int>(wait) : max_ms;
+}
+
+void Scheduler::run_timers() {
+    uint64_t now = now_ms();
+    while (!timers_.empty() && timers_.top().deadline <= now) {
+        Timer t = timers_.top();
+        timers_.pop();
+        if (cancelled_.erase(t.seq) == 0) {
+            t.h.resume();
+        }
+    }
+}
+
+uint64_t Scheduler::now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace coro
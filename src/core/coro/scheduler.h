@@ -0,0 +1,168 @@
+#pragma once
+
+#include <coroutine>
+#include <cstdint>
+#include <queue>
+#include <unordered_set>
+#include <vector>
+
+#include "core/event_loop/epoll_loop.h"
+
+namespace coro {
+
+/*
+ * IoHandle
+ * --------
+ * epoll registration for one fd, holding the coroutines waiting on it.
+ *
+ * The fd is registered once, edge-triggered, for both directions; the
+ * awaitables always try the syscall before suspending, so no edge is
+ * lost and epoll_ctl is never called per operation.
+ *
+ * Register data.ptr = this; the loop owner passes such events to
+ * Scheduler::dispatch().
+ */
+struct IoHandle {
+    int fd{-1};
+    std::coroutine_handle<> reader;
+    std::coroutine_handle<> writer;
+};
+
+/*
+ * Scheduler
+ * ---------
+ * Resumes coroutines from an EpollLoop: fd readiness and timers.
+ *
+ * Core rules:
+ * - Loop thread only
+ * - Timers are one-shot; a coroutine waiting on a timer must not be
+ *   destroyed before it wakes unless the timer was cancelled first
+ * - A cancelled timer stays in the heap until its deadline and is then
+ *   dropped, so the loop may wake once for it
+ */
+class Scheduler {
+public:
+    explicit Scheduler(EpollLoop& loop);
+
+    EpollLoop& loop() { return loop_; }
+
+    void attach(IoHandle& io);
+    void detach(IoHandle& io);
+
+    // Resume the waiters of an IoHandle-tagged event
+    static void dispatch(void* data, uint32_t events);
+
+    // Returns an id for cancel_timer()
+    uint64_t add_timer(uint64_t deadline_ms, std::coroutine_handle<> h);
+
+    // Forget a timer that has not fired yet
+    void cancel_timer(uint64_t id);
+
+    // Timeout for the next wait(): capped by the earliest timer
+    int next_timeout_ms(int max_ms) const;
+
+    // Resume every coroutine whose deadline has passed
+    void run_timers();
+
+    static uint64_t now_ms();
+
+private:
+    struct Timer {
+        uint64_t deadline;
+        uint64_t seq;       // FIFO among equal deadlines
+        std::coroutine_handle<> h;
+
+        bool operator>(const Timer& o) const {
+            return deadline != o.deadline ? deadline > o.deadline : seq > o.seq;
+        }
+    };
+
+    EpollLoop& loop_;
+    uint64_t timer_seq_{0};
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers_;
+    std::unordered_set<uint64_t> cancelled_;
+};
+
+// co_await readable(sched, io) / writable(): wait for the next edge
+struct ReadyAwaitable {
+    IoHandle& io;
+    bool write;
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> h) noexcept {
+        (write ? io.writer : io.reader) = h;
+    }
+    void await_resume() const noexcept {}
+};
+
+inline ReadyAwaitable readable(IoHandle& io) { return {io, false}; }
+inline ReadyAwaitable writable(IoHandle& io) { return {io, true}; }
+
+// co_await ready_until(sched, io, write, deadline): the next edge on io,
+// on watch's read side when given, or the deadline (Scheduler::now_ms()
+// time), whichever comes first. Yields false on timeout.
+struct DeadlineAwaitable {
+    Scheduler& sched;
+    IoHandle& io;
+    bool write;
+    uint64_t deadline;
+    IoHandle* watch;
+
+    std::coroutine_handle<> self{};
+    uint64_t timer{0};
+    bool expired{false};
+
+    std::coroutine_handle<>& slot() { return write ? io.writer : io.reader; }
+
+    bool await_ready() noexcept {
+        expired = Scheduler::now_ms() >= deadline;
+        return expired;
+    }
+    void await_suspend(std::coroutine_handle<> h) {
+        self = h;
+        slot() = h;
+        if (watch) {
+            watch->reader = h;
+        }
+        timer = sched.add_timer(deadline, h);
+    }
+    bool await_resume() {
+        if (expired) {
+            return false;
+        }
+
+        // dispatch() clears the slot it resumes from; the timer clears none
+        bool woke = slot() != self || (watch && watch->reader != self);
+        if (slot() == self) {
+            slot() = nullptr;
+        }
+        if (watch && watch->reader == self) {
+            watch->reader = nullptr;
+        }
+        if (woke) {
+            sched.cancel_timer(timer);
+        }
+        return woke;
+    }
+};
+
+inline DeadlineAwaitable ready_until(Scheduler& sched, IoHandle& io, bool write,
+                                     uint64_t deadline_ms, IoHandle* watch = nullptr) {
+    return {sched, io, write, deadline_ms, watch};
+}
+
+// co_await sleep(sched, ms)
+struct SleepAwaitable {
+    Scheduler& sched;
+    uint64_t ms;
+
+    bool await_ready() const noexcept { return ms == 0; }
+    void await_suspend(std::coroutine_handle<> h) {
+        sched.add_timer(Scheduler::now_ms() + ms, h);
+    }
+    void await_resume() const noexcept {}
+};
+
+inline SleepAwaitable sleep(Scheduler& sched, uint64_t ms) { return {sched, ms}; }
+
+} // namespace coro
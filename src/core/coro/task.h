@@ -0,0 +1,169 @@
+#pragma once
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <utility>
+
+#include "frame_pool.h"
+
+namespace coro {
+
+template <typename T = void>
+class Task;
+
+namespace detail {
+
+// Shared by every promise: pooled frames, lazy start, resume the awaiter
+// on completion (symmetric transfer, so deep await chains do not grow
+// the stack)
+struct PromiseBase {
+    std::coroutine_handle<> continuation;
+
+    static void* operator new(size_t n) {
+        return FramePool::local().allocate(n);
+    }
+    static void operator delete(void* p, size_t n) noexcept {
+        FramePool::local().deallocate(p, n);
+    }
+
+    struct FinalAwaiter {
+        bool await_ready() const noexcept { return false; }
+
+        template <typename P>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<P> h) noexcept {
+            std::coroutine_handle<> next = h.promise().continuation;
+            return next ? next : std::noop_coroutine();
+        }
+
+        void await_resume() const noexcept {}
+    };
+
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    FinalAwaiter final_suspend() const noexcept { return {}; }
+
+    // The proxy does not use exceptions for control flow
+    void unhandled_exception() const noexcept { std::terminate(); }
+};
+
+template <typename T>
+struct Promise : PromiseBase {
+    T value{};
+
+    Task<T> get_return_object() noexcept;
+    void return_value(T v) noexcept { value = std::move(v); }
+};
+
+template <>
+struct Promise<void> : PromiseBase {
+    Task<void> get_return_object() noexcept;
+    void return_void() const noexcept {}
+};
+
+} // namespace detail
+
+/*
+ * Task<T>
+ * -------
+ * Lazily started coroutine that produces a T for whoever co_awaits it.
+ *
+ * Core rules:
+ * - Nothing runs until the Task is awaited (or handed to spawn())
+ * - The Task owns its frame and destroys it when it goes out of scope
+ * - Awaiting a Task transfers control directly into it, and back out
+ *   when it finishes
+ */
+template <typename T>
+class Task {
+public:
+    using promise_type = detail::Promise<T>;
+    using Handle = std::coroutine_handle<promise_type>;
+
+    explicit Task(Handle h) noexcept : handle_(h) {}
+
+    Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (handle_) {
+                handle_.destroy();
+            }
+            handle_ = std::exchange(other.handle_, {});
+        }
+        return *this;
+    }
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    ~Task() {
+        if (handle_) {
+            handle_.destroy();
+        }
+    }
+
+    auto operator co_await() && noexcept {
+        struct Awaiter {
+            Handle h;
+
+            bool await_ready() const noexcept { return !h || h.done(); }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+                h.promise().continuation = awaiting;
+                return h;
+            }
+
+            T await_resume() noexcept {
+                if constexpr (!std::is_void_v<T>) {
+                    return std::move(h.promise().value);
+                }
+            }
+        };
+        return Awaiter{handle_};
+    }
+
+private:
+    Handle handle_;
+};
+
+namespace detail {
+
+template <typename T>
+Task<T> Promise<T>::get_return_object() noexcept {
+    return Task<T>(std::coroutine_handle<Promise<T>>::from_promise(*this));
+}
+
+inline Task<void> Promise<void>::get_return_object() noexcept {
+    return Task<void>(std::coroutine_handle<Promise<void>>::from_promise(*this));
+}
+
+// Self-owning root: starts eagerly, frees its frame when done
+struct Detached {
+    struct promise_type {
+        static void* operator new(size_t n) {
+            return FramePool::local().allocate(n);
+        }
+        static void operator delete(void* p, size_t n) noexcept {
+            FramePool::local().deallocate(p, n);
+        }
+
+        Detached get_return_object() const noexcept { return {}; }
+        std::suspend_never initial_suspend() const noexcept { return {}; }
+        std::suspend_never final_suspend() const noexcept { return {}; }
+        void return_void() const noexcept {}
+        void unhandled_exception() const noexcept { std::terminate(); }
+    };
+};
+
+inline Detached run_detached(Task<void> task) {
+    co_await std::move(task);
+}
+
+} // namespace detail
+
+// Start task now; it runs until its first suspension and then lives on
+// until it completes (e.g. one per accepted connection)
+inline void spawn(Task<void> task) {
+    detail::run_detached(std::move(task));
+}
+
+} // namespace coro
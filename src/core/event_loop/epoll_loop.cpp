@@ -1,7 +1,13 @@
 #include "epoll_loop.h"
+#include <chrono>
 #include <unistd.h>
 #include <stdexcept>
 
+static uint64_t steady_us() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
 EpollLoop::EpollLoop()
     : epoll_fd_(::epoll_create1(0)),
       events_(128),
@@ -10,6 +16,9 @@ EpollLoop::EpollLoop()
     if (epoll_fd_ < 0) {
         throw std::runtime_error("epoll_create1 failed");
     }
+
+    // Tagged with the WakeupFd itself; wait() filters it out
+    add(wakeup_.fd(), EPOLLIN, &wakeup_);
 }
 
 EpollLoop::~EpollLoop() {
@@ -41,15 +50,137 @@ void EpollLoop::remove(int fd) {
 }
 
 int EpollLoop::wait(int timeout_ms) {
-    ready_ = ::epoll_wait(
-        epoll_fd_,
-        events_.data(),
-        static_cast<int>(events_.size()),
-        timeout_ms
-    );
+    uint64_t start = steady_us();
+    if (last_return_us_ != 0) {
+        stats_.busy_us.record(start - last_return_us_);
+    }
+
+    ready_ = poll(timeout_ms);
+
+    last_return_us_ = steady_us();
+    stats_.wait_us.record(last_return_us_ - start);
+    ++stats_.iterations;
+    if (ready_ < 0) {
+        return ready_;
+    }
+
+    // Sized on the raw count: the wakeup entry occupied a slot too
+    stats_.batch.record(static_cast<uint64_t>(ready_));
+    adapt_batch(ready_);
+
+    for (int i = 0; i < ready_; ++i) {
+        if (events_[i].data.ptr == &wakeup_) {
+            events_[i] = events_[ready_ - 1];
+            --ready_;
+            run_posted();
+            break;
+        }
+    }
     return ready_;
 }
 
+int EpollLoop::poll(int timeout_ms) {
+    int cap = static_cast<int>(events_.size());
+
+    if (busy_poll_us_ > 0 && timeout_ms != 0) {
+        uint64_t deadline = steady_us() + busy_poll_us_;
+        do {
+            ++stats_.spins;
+            int n = ::epoll_wait(epoll_fd_, events_.data(), cap, 0);
+            if (n != 0) {
+                return n;
+            }
+        } while (steady_us() < deadline);
+    }
+
+    return ::epoll_wait(epoll_fd_, events_.data(), cap, timeout_ms);
+}
+
+void EpollLoop::set_batch_limits(size_t min_events, size_t max_events) {
+    if (min_events == 0) {
+        min_events = 1;
+    }
+    if (max_events < min_events) {
+        max_events = min_events;
+    }
+    min_events_ = min_events;
+    max_events_ = max_events;
+
+    // Only called between waits, so no returned events are lost
+    if (events_.size() < min_events_) {
+        events_.resize(min_events_);
+    } else if (events_.size() > max_events_) {
+        events_.resize(max_events_);
+    }
+}
+
+void EpollLoop::adapt_batch(int ready) {
+    size_t cap = events_.size();
+
+    // A full array means events were left in the kernel for next time
+    if (static_cast<size_t>(ready) == cap && cap < max_events_) {
+        events_.resize(cap * 2 < max_events_ ? cap * 2 : max_events_);
+        ++stats_.grows;
+        window_peak_ = 0;
+        window_left_ = kShrinkWindow;
+        return;
+    }
+
+    if (ready > window_peak_) {
+        window_peak_ = ready;
+    }
+    if (--window_left_ > 0) {
+        return;
+    }
+
+    // Shrinking keeps the first ready entries: peak <= cap/4 < cap/2
+    if (static_cast<size_t>(window_peak_) <= cap / 4 && cap > min_events_) {
+        events_.resize(cap / 2 > min_events_ ? cap / 2 : min_events_);
+        ++stats_.shrinks;
+    }
+    window_peak_ = 0;
+    window_left_ = kShrinkWindow;
+}
+
+void EpollLoop::post(Task task) {
+    inbox_.push(std::move(task));
+
+    // Only the first post after a drain pays for the syscall
+    if (!signalled_.exchange(true, std::memory_order_acq_rel)) {
+        wakeups_.fetch_add(1, std::memory_order_relaxed);
+        wakeup_.notify();
+    }
+}
+
+size_t EpollLoop::run_posted() {
+    wakeup_.drain();
+
+    // Clear before popping: a post that lands after this point signals
+    // again, one that landed before is popped below
+    signalled_.store(false, std::memory_order_seq_cst);
+
+    size_t n = 0;
+    Task task;
+    while (true) {
+        MpscQueue<Task>::PopResult r = inbox_.pop(task);
+        if (r == MpscQueue<Task>::PopResult::OK) {
+            task();
+            task = nullptr;
+            ++n;
+            continue;
+        }
+        if (r == MpscQueue<Task>::PopResult::EMPTY_BUSY) {
+            // A producer is mid-push and may have seen signalled_ still
+            // set: re-arm so the next wait() picks its task up
+            if (!signalled_.exchange(true, std::memory_order_acq_rel)) {
+                wakeup_.notify();
+            }
+        }
+        break;
+    }
+    return n;
+}
+
 const epoll_event& EpollLoop::event_at(int i) const {
     return events_[i];
 }
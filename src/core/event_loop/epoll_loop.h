@@ -1,24 +1,93 @@
 #pragma once
 
+#include <atomic>
+#include <cstdint>
+#include <functional>
 #include <vector>
 #include <sys/epoll.h>
 
+#include "loop_stats.h"
+#include "mpsc_queue.h"
+#include "wakeup_fd.h"
+
+/*
+ * EpollLoop
+ * ---------
+ * epoll wrapper plus a cross-thread task inbox.
+ *
+ * post() may be called from any thread. Tasks run on the loop thread
+ * inside wait(), before it returns the ready events; the inbox's own
+ * eventfd is consumed there and never shows up in event_at().
+ *
+ * A burst of posts costs one eventfd write: only the post that finds
+ * the loop not yet signalled writes to it.
+ *
+ * The event array adapts to load: it doubles when a wait() fills it and
+ * halves when a whole window of waits used at most a quarter of it,
+ * staying within the configured batch limits.
+ *
+ * With busy polling enabled, wait() first spins on zero-timeout
+ * epoll_wait for up to busy_poll_us before blocking, trading a core
+ * for lower wakeup latency.
+ */
 class EpollLoop {
 public:
+    using Task = std::function<void()>;
+
     EpollLoop();
     ~EpollLoop();
 
+    EpollLoop(const EpollLoop&) = delete;
+    EpollLoop& operator=(const EpollLoop&) = delete;
+
     void add(int fd, uint32_t events, void* data);
     void modify(int fd, uint32_t events, void* data);
     void remove(int fd);
 
     int wait(int timeout_ms);
 
+    // Bounds for the adaptive event array (current size is clamped)
+    void set_batch_limits(size_t min_events, size_t max_events);
+    size_t batch_capacity() const { return events_.size(); }
+
+    // Spin this long before blocking in wait() (0 disables)
+    void set_busy_poll(uint32_t busy_poll_us) { busy_poll_us_ = busy_poll_us; }
+
+    // Iteration histograms; reset_stats() starts a new measurement window
+    const LoopStats& stats() const { return stats_; }
+    void reset_stats() { stats_ = LoopStats(); }
+
     const epoll_event& event_at(int i) const;
     int ready_count() const;
 
+    // Run task on the loop thread (thread-safe, never blocks)
+    void post(Task task);
+
+    // eventfd writes caused by post() (batching makes this << posts)
+    uint64_t wakeups() const { return wakeups_.load(std::memory_order_relaxed); }
+
 private:
+    static constexpr int kShrinkWindow = 64;
+
+    size_t run_posted();
+    int poll(int timeout_ms);
+    void adapt_batch(int ready);
+
     int epoll_fd_;
     std::vector<epoll_event> events_;
     int ready_;
+
+    size_t min_events_{32};
+    size_t max_events_{4096};
+    int window_peak_{0};
+    int window_left_{kShrinkWindow};
+
+    uint32_t busy_poll_us_{0};
+    uint64_t last_return_us_{0};
+    LoopStats stats_;
+
+    WakeupFd wakeup_;
+    MpscQueue<Task> inbox_;
+    std::atomic<bool> signalled_{false};
+    std::atomic<uint64_t> wakeups_{0};
 };
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+/*
+ * Log2Histogram
+ * -------------
+ * Fixed-size histogram with power-of-two buckets.
+ *
+ * Core rules:
+ * - record() is O(1) and never allocates (safe on the loop's hot path)
+ * - Bucket b holds values in [2^(b-1), 2^b); bucket 0 holds 0
+ * - percentile() reports the upper bound of the bucket it lands in,
+ *   so results are accurate to within a factor of two
+ * - Not thread-safe: owned and read by a single loop thread
+ */
+class Log2Histogram {
+public:
+    static constexpr int kBuckets = 65;
+
+    void record(uint64_t v) {
+        int b = v == 0 ? 0 : 64 - __builtin_clzll(v);
+        ++buckets_[b];
+        ++count_;
+        sum_ += v;
+        if (v > max_) {
+            max_ = v;
+        }
+    }
+
+    // Smallest bucket upper bound covering fraction p (0..1) of samples
+    uint64_t percentile(double p) const {
+        if (count_ == 0) {
+            return 0;
+        }
+        uint64_t want = static_cast<uint64_t>(p * static_cast<double>(count_));
+        if (want == 0) {
+            want = 1;
+        }
+        uint64_t seen = 0;
+        for (int b = 0; b < kBuckets; ++b) {
+            seen += buckets_[b];
+            if (seen >= want) {
+                uint64_t upper = upper_bound(b);
+                return upper < max_ ? upper : max_;
+            }
+        }
+        return max_;
+    }
+
+    uint64_t count() const { return count_; }
+    uint64_t max() const { return max_; }
+    uint64_t mean() const { return count_ ? sum_ / count_ : 0; }
+    uint64_t bucket(int b) const { return buckets_[b]; }
+
+    void reset() { *this = Log2Histogram(); }
+
+    static uint64_t upper_bound(int b) {
+        if (b == 0) {
+            return 0;
+        }
+        if (b >= 64) {
+            return UINT64_MAX;
+        }
+        return (uint64_t(1) << b) - 1;
+    }
+
+private:
+    std::array<uint64_t, kBuckets> buckets_{};
+    uint64_t count_{0};
+    uint64_t sum_{0};
+    uint64_t max_{0};
+};
+
+/*
+ * LoopStats
+ * ---------
+ * Per-iteration measurements recorded by EpollLoop::wait().
+ *
+ * - batch:   ready events returned per epoll_wait
+ * - wait_us: time spent inside wait() (blocked or spinning)
+ * - busy_us: time between wait() returning and the next call, i.e. how
+ *            long the caller spent dispatching the previous batch
+ */
+struct LoopStats {
+    Log2Histogram batch;
+    Log2Histogram wait_us;
+    Log2Histogram busy_us;
+
+    uint64_t iterations{0};
+    uint64_t spins{0};          // zero-timeout polls made in busy-poll mode
+    uint64_t grows{0};
+    uint64_t shrinks{0};
+};
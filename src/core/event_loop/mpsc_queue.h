@@ -0,0 +1,97 @@
+#pragma once
+
+#include <atomic>
+#include <utility>
+
+/*
+ * MpscQueue
+ * ---------
+ * Unbounded lock-free multi-producer, single-consumer queue
+ * (Vyukov's intrusive node queue).
+ *
+ * Core rules:
+ * - push() is wait-free: one atomic exchange plus one release store
+ * - pop() is called by a single consumer thread only
+ * - pop() may return EMPTY_BUSY while a producer is between its two
+ *   steps; the item becomes visible moments later, so the consumer must
+ *   retry later rather than assume the queue is empty
+ */
+template <typename T>
+class MpscQueue {
+public:
+    enum class PopResult { OK, EMPTY, EMPTY_BUSY };
+
+    MpscQueue()
+        : head_(&stub_),
+          tail_(&stub_) {}
+
+    ~MpscQueue() {
+        T discard;
+        while (pop(discard) == PopResult::OK) {
+        }
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    void push(T value) {
+        push_node(new Node(std::move(value)));
+    }
+
+    PopResult pop(T& out) {
+        Node* tail = tail_;
+        Node* next = tail->next.load(std::memory_order_acquire);
+
+        if (tail == &stub_) {
+            if (!next) {
+                return head_.load(std::memory_order_acquire) == &stub_
+                    ? PopResult::EMPTY : PopResult::EMPTY_BUSY;
+            }
+            tail_ = next;
+            tail = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+
+        if (next) {
+            tail_ = next;
+            out = std::move(tail->value);
+            delete tail;
+            return PopResult::OK;
+        }
+
+        if (tail != head_.load(std::memory_order_acquire)) {
+            return PopResult::EMPTY_BUSY;
+        }
+
+        // tail is the last node: park the stub behind it so it can go
+        push_node(&stub_);
+
+        next = tail->next.load(std::memory_order_acquire);
+        if (next) {
+            tail_ = next;
+            out = std::move(tail->value);
+            delete tail;
+            return PopResult::OK;
+        }
+        return PopResult::EMPTY_BUSY;
+    }
+
+private:
+    struct Node {
+        Node() = default;
+        explicit Node(T v) : value(std::move(v)) {}
+
+        std::atomic<Node*> next{nullptr};
+        T value{};
+    };
+
+    void push_node(Node* n) {
+        n->next.store(nullptr, std::memory_order_relaxed);
+        Node* prev = head_.exchange(n, std::memory_order_acq_rel);
+        prev->next.store(n, std::memory_order_release);
+    }
+
+    Node stub_;
+    std::atomic<Node*> head_;   // producers append here
+    Node* tail_;                // consumer pops here
+};
@@ -0,0 +1,36 @@
+#include "signal_fd.h"
+
+#include <pthread.h>
+#include <sys/signalfd.h>
+#include <unistd.h>
+#include <stdexcept>
+
+SignalFd::SignalFd(std::initializer_list<int> signals) {
+    sigset_t set;
+    sigemptyset(&set);
+    for (int sig : signals) {
+        sigaddset(&set, sig);
+    }
+
+    if (::pthread_sigmask(SIG_BLOCK, &set, nullptr) != 0) {
+        throw std::runtime_error("pthread_sigmask failed");
+    }
+
+    fd_.reset(::signalfd(-1, &set, SFD_NONBLOCK | SFD_CLOEXEC));
+    if (!fd_.valid()) {
+        throw std::runtime_error("signalfd failed");
+    }
+}
+
+int SignalFd::fd() const noexcept {
+    return fd_.get();
+}
+
+int SignalFd::read() noexcept {
+    signalfd_siginfo info{};
+    ssize_t n = ::read(fd_.get(), &info, sizeof(info));
+    if (n != static_cast<ssize_t>(sizeof(info))) {
+        return 0;
+    }
+    return static_cast<int>(info.ssi_signo);
+}
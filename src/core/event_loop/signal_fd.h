@@ -0,0 +1,36 @@
+#pragma once
+
+#include <initializer_list>
+#include <signal.h>
+
+#include "core/fd/fd_wrapper.h"
+
+/*
+ * SignalFd
+ * --------
+ * signalfd that turns process signals into EpollLoop readiness.
+ *
+ * Core rules:
+ * - The constructor blocks the signals in the calling thread; create it
+ *   on the main thread before spawning any other thread, so every thread
+ *   inherits the mask and delivery always goes through the fd
+ * - read() is non-blocking and called only by the owning loop thread
+ * - Signals of the same number that arrive before a read() collapse
+ *
+ * Register fd() with EPOLLIN on the loop that should handle them.
+ */
+class SignalFd {
+public:
+    explicit SignalFd(std::initializer_list<int> signals);
+
+    SignalFd(const SignalFd&) = delete;
+    SignalFd& operator=(const SignalFd&) = delete;
+
+    int fd() const noexcept;
+
+    // Next pending signal number, or 0 when none is left
+    int read() noexcept;
+
+private:
+    FDWrapper fd_;
+};
@@ -0,0 +1,29 @@
+#include "wakeup_fd.h"
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <cstdint>
+#include <stdexcept>
+
+WakeupFd::WakeupFd()
+    : fd_(::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) {
+
+    if (!fd_.valid()) {
+        throw std::runtime_error("eventfd failed");
+    }
+}
+
+int WakeupFd::fd() const noexcept {
+    return fd_.get();
+}
+
+void WakeupFd::notify() noexcept {
+    uint64_t one = 1;
+    // EAGAIN means the counter is saturated, the loop is already woken
+    (void)::write(fd_.get(), &one, sizeof(one));
+}
+
+void WakeupFd::drain() noexcept {
+    uint64_t value = 0;
+    (void)::read(fd_.get(), &value, sizeof(value));
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "core/fd/fd_wrapper.h"
+
+/*
+ * WakeupFd
+ * --------
+ * eventfd used to wake an EpollLoop from another thread.
+ *
+ * Core rules:
+ * - notify() is safe to call from any thread
+ * - drain() is called only by the owning loop thread
+ * - Multiple notify() calls before a drain() collapse into one wakeup
+ *
+ * Register fd() with EPOLLIN on the loop that should be woken.
+ */
+class WakeupFd {
+public:
+    WakeupFd();
+
+    WakeupFd(const WakeupFd&) = delete;
+    WakeupFd& operator=(const WakeupFd&) = delete;
+
+    int fd() const noexcept;
+
+    // Signal the owning loop
+    void notify() noexcept;
+
+    // Reset the counter after the loop observed EPOLLIN
+    void drain() noexcept;
+
+private:
+    FDWrapper fd_;
+};
@@ -0,0 +1,124 @@
+#include "work_stealing_pool.h"
+
+namespace {
+
+// Pool and deque index of the calling worker (null pool on other threads)
+thread_local const void* tls_pool = nullptr;
+thread_local size_t tls_index = 0;
+
+} // namespace
+
+WorkStealingPool::WorkStealingPool(size_t threads, size_t queue_capacity)
+    : capacity_(queue_capacity) {
+    if (threads == 0) {
+        threads = 1;
+    }
+
+    workers_.reserve(threads);
+    for (size_t i = 0; i < threads; ++i) {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+    // Start only after the vector is complete: workers scan it to steal
+    for (size_t i = 0; i < threads; ++i) {
+        workers_[i]->thread = std::thread(&WorkStealingPool::run, this, i);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(idle_mu_);
+        stop_.store(true, std::memory_order_release);
+    }
+    idle_cv_.notify_all();
+
+    for (auto& w : workers_) {
+        if (w->thread.joinable()) {
+            w->thread.join();
+        }
+    }
+}
+
+bool WorkStealingPool::submit(Task task) {
+    size_t index;
+    if (tls_pool == this) {
+        index = tls_index;
+    } else {
+        index = next_.fetch_add(1, std::memory_order_relaxed) % workers_.size();
+    }
+
+    Worker& w = *workers_[index];
+    {
+        std::lock_guard<std::mutex> lock(w.mu);
+        if (w.tasks.size() >= capacity_) {
+            return false;
+        }
+        w.tasks.push_back(std::move(task));
+    }
+
+    queued_.fetch_add(1, std::memory_order_release);
+    {
+        // Pairs with the predicate check in run(): no lost wakeups
+        std::lock_guard<std::mutex> lock(idle_mu_);
+    }
+    idle_cv_.notify_one();
+    return true;
+}
+
+bool WorkStealingPool::pop_local(size_t index, Task& out) {
+    Worker& w = *workers_[index];
+    std::lock_guard<std::mutex> lock(w.mu);
+    if (w.tasks.empty()) {
+        return false;
+    }
+    // Newest first: its data is most likely still in this core's cache
+    out = std::move(w.tasks.back());
+    w.tasks.pop_back();
+    return true;
+}
+
+bool WorkStealingPool::steal(size_t thief, Task& out) {
+    size_t n = workers_.size();
+    for (size_t k = 1; k < n; ++k) {
+        Worker& victim = *workers_[(thief + k) % n];
+
+        // try_lock: never wait behind the owner, just move on
+        std::unique_lock<std::mutex> lock(victim.mu, std::try_to_lock);
+        if (!lock.owns_lock() || victim.tasks.empty()) {
+            continue;
+        }
+        out = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+        steals_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+void WorkStealingPool::run(size_t index) {
+    tls_pool = this;
+    tls_index = index;
+
+    while (true) {
+        Task task;
+        if (pop_local(index, task) || steal(index, task)) {
+            queued_.fetch_sub(1, std::memory_order_acq_rel);
+            task();
+            executed_.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(idle_mu_);
+        if (stop_.load(std::memory_order_acquire)) {
+            return;
+        }
+        if (queued_.load(std::memory_order_acquire) == 0) {
+            idle_cv_.wait(lock, [this] {
+                return stop_.load(std::memory_order_acquire) ||
+                       queued_.load(std::memory_order_acquire) > 0;
+            });
+        }
+        if (stop_.load(std::memory_order_acquire)) {
+            return;
+        }
+    }
+}
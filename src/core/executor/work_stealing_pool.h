@@ -0,0 +1,69 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * WorkStealingPool
+ * ----------------
+ * Fixed set of worker threads for CPU-heavy work that must not run on
+ * an event loop (compression, and later handshakes or routing).
+ *
+ * Core rules:
+ * - Every worker owns a bounded deque; the owner pops newest-first,
+ *   idle workers steal oldest-first from the others
+ * - submit() never blocks: a full deque rejects the task and the caller
+ *   runs it inline (backpressure instead of unbounded memory)
+ * - Tasks must not touch loop-owned state; results travel back through
+ *   a CompletionQueue
+ * - The destructor finishes running tasks and drops queued ones
+ */
+class WorkStealingPool {
+public:
+    using Task = std::function<void()>;
+
+    explicit WorkStealingPool(size_t threads, size_t queue_capacity = 1024);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    // Safe from any thread; tasks submitted by a worker stay on its deque
+    // Returns false if the chosen deque is full
+    bool submit(Task task);
+
+    size_t threads() const { return workers_.size(); }
+    uint64_t executed() const { return executed_.load(std::memory_order_relaxed); }
+    uint64_t steals() const { return steals_.load(std::memory_order_relaxed); }
+
+private:
+    struct Worker {
+        std::mutex mu;
+        std::deque<Task> tasks;
+        std::thread thread;
+    };
+
+    void run(size_t index);
+    bool pop_local(size_t index, Task& out);
+    bool steal(size_t thief, Task& out);
+
+    size_t capacity_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+
+    std::atomic<size_t> next_{0};           // round-robin for outside submits
+    std::atomic<size_t> queued_{0};
+    std::atomic<bool> stop_{false};
+    std::atomic<uint64_t> executed_{0};
+    std::atomic<uint64_t> steals_{0};
+
+    // Idle workers sleep here; queued_ is re-checked under the mutex
+    std::mutex idle_mu_;
+    std::condition_variable idle_cv_;
+};
@@ -0,0 +1,115 @@
+#include "arena.h"
+
+#include <cstdint>
+#include <new>
+
+ArenaChunkPool& ArenaChunkPool::local() {
+    thread_local ArenaChunkPool pool;
+    return pool;
+}
+
+ArenaChunkPool::~ArenaChunkPool() {
+    while (FreeNode* n = free_) {
+        free_ = n->next;
+        ::operator delete(n);
+    }
+}
+
+void* ArenaChunkPool::acquire() {
+    if (FreeNode* n = free_) {
+        free_ = n->next;
+        --cached_;
+        ++reuses_;
+        return n;
+    }
+    ++allocations_;
+    return ::operator new(kChunkBytes);
+}
+
+void ArenaChunkPool::release(void* chunk) noexcept {
+    if (cached_ >= kMaxCached) {
+        ::operator delete(chunk);
+        return;
+    }
+    auto* n = static_cast<FreeNode*>(chunk);
+    n->next = free_;
+    free_ = n;
+    ++cached_;
+}
+
+Arena::~Arena() {
+    while (Chunk* c = chunks_head_) {
+        chunks_head_ = c->next;
+        free_chunk(c);
+    }
+}
+
+void Arena::free_chunk(Chunk* c) {
+    if (c->pooled) {
+        ArenaChunkPool::local().release(c);
+    } else {
+        ::operator delete(c);
+    }
+}
+
+void Arena::reset() {
+    Chunk* keep = nullptr;
+    while (Chunk* c = chunks_head_) {
+        chunks_head_ = c->next;
+        if (!keep && c->pooled) {
+            keep = c;
+        } else {
+            free_chunk(c);
+        }
+    }
+
+    chunks_head_ = keep;
+    chunks_ = keep ? 1 : 0;
+    cur_ = keep ? reinterpret_cast<char*>(keep) + kHeader : nullptr;
+    end_ = keep ? reinterpret_cast<char*>(keep) + ArenaChunkPool::kChunkBytes : nullptr;
+    if (keep) {
+        keep->next = nullptr;
+    }
+    used_ = 0;
+}
+
+void* Arena::do_allocate(size_t bytes, size_t align) {
+    auto aligned = [align](char* p) {
+        auto v = reinterpret_cast<uintptr_t>(p);
+        return reinterpret_cast<char*>((v + align - 1) & ~(uintptr_t(align) - 1));
+    };
+
+    if (cur_) {
+        char* p = aligned(cur_);
+        if (p <= end_ && static_cast<size_t>(end_ - p) >= bytes) {
+            cur_ = p + bytes;
+            used_ += bytes;
+            return p;
+        }
+    }
+
+    // Too big for any chunk: a block of its own, off the bump path
+    if (kHeader + bytes + align > ArenaChunkPool::kChunkBytes) {
+        void* raw = ::operator new(kHeader + bytes + align);
+        auto* c = static_cast<Chunk*>(raw);
+        c->pooled = false;
+        c->next = chunks_head_;
+        chunks_head_ = c;
+        ++chunks_;
+        used_ += bytes;
+        return aligned(static_cast<char*>(raw) + kHeader);
+    }
+
+    auto* c = static_cast<Chunk*>(ArenaChunkPool::local().acquire());
+    c->pooled = true;
+    c->next = chunks_head_;
+    chunks_head_ = c;
+    ++chunks_;
+
+    char* base = reinterpret_cast<char*>(c);
+    end_ = base + ArenaChunkPool::kChunkBytes;
+    char* p = aligned(base + kHeader);
+    cur_ = p + bytes;
+    used_ += bytes;
+    return p;
+}
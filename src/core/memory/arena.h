@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+
+/*
+ * ArenaChunkPool
+ * --------------
+ * Per-thread free list of fixed-size arena chunks.
+ *
+ * Core rules:
+ * - Every chunk is kChunkBytes; returned chunks are kept for reuse, up
+ *   to kMaxCached, so a steady-state worker takes no chunks from the heap
+ * - Lock-free by construction: each worker thread has its own pool
+ */
+class ArenaChunkPool {
+public:
+    static constexpr size_t kChunkBytes = 4096;
+    static constexpr size_t kMaxCached = 256;
+
+    static ArenaChunkPool& local();
+
+    void* acquire();
+    void release(void* chunk) noexcept;
+
+    size_t allocations() const { return allocations_; }    // served from the heap
+    size_t reuses() const { return reuses_; }                // served from the free list
+    size_t cached() const { return cached_; }
+
+    ~ArenaChunkPool();
+
+private:
+    ArenaChunkPool() = default;
+
+    struct FreeNode {
+        FreeNode* next;
+    };
+
+    FreeNode* free_{nullptr};
+    size_t cached_{0};
+    size_t allocations_{0};
+    size_t reuses_{0};
+};
+
+/*
+ * Arena
+ * -----
+ * Bump-pointer memory for data that lives for one request: parsed
+ * request-line pieces, header values, routing keys.
+ *
+ * Core rules:
+ * - A std::pmr::memory_resource: pass it to std::pmr containers
+ * - deallocate() is a no-op; memory comes back all at once in reset()
+ * - reset() keeps one chunk, so a request that fits in kChunkBytes
+ *   touches no free list at all; the rest go back to the thread's
+ *   ArenaChunkPool
+ * - Requests larger than a chunk get a dedicated heap block, freed on
+ *   reset()
+ * - Owned by one connection and used on its loop thread only
+ *
+ * Non-responsibilities:
+ * - Running destructors (only trivially destructible data, or pmr
+ *   containers that are gone before reset())
+ */
+class Arena : public std::pmr::memory_resource {
+public:
+    Arena() = default;
+    ~Arena() override;
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    // Forget every allocation; keep one chunk for the next request
+    void reset();
+
+    // Bytes handed out since the last reset()
+    size_t used() const { return used_; }
+    size_t chunks() const { return chunks_; }
+
+protected:
+    void* do_allocate(size_t bytes, size_t align) override;
+    void do_deallocate(void*, size_t, size_t) override {}
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+private:
+    struct Chunk {
+        Chunk* next;
+        bool pooled;            // from ArenaChunkPool, else a heap block
+    };
+
+    static constexpr size_t kHeader =
+        (sizeof(Chunk) + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+
+    void free_chunk(Chunk* c);
+
+    Chunk* chunks_head_{nullptr};   // newest first
+    char* cur_{nullptr};
+    char* end_{nullptr};
+    size_t used_{0};
+    size_t chunks_{0};
+};
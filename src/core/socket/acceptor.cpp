@@ -2,6 +2,7 @@
 #include "socket.h"
 
 #include <arpa/inet.h>
+#include <linux/filter.h>
 #include <sys/socket.h>
 #include <unistd.h>
 #include <cstring>
@@ -10,12 +11,18 @@ Acceptor::Acceptor()
     : listen_fd_(-1) {}
 
 Acceptor::~Acceptor() {
-    if (listen_fd_ >= 0) {
-        ::close(listen_fd_);
-    }
+    close();
+}
+
+bool Acceptor::listen(uint16_t port, int backlog, bool reuseport) {
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = INADDR_ANY;
+    addr.sin_port = htons(port);
+    return listen(addr, backlog, reuseport);
 }
 
-bool Acceptor::listen(uint16_t port, int backlog) {
+bool Acceptor::listen(const sockaddr_in& addr, int backlog, bool reuseport) {
     listen_fd_ = Socket::create_tcp();
     if (listen_fd_ < 0) {
         return false;
@@ -23,13 +30,14 @@ bool Acceptor::listen(uint16_t port, int backlog) {
 
     int opt = 1;
     ::setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    if (reuseport &&
+        ::setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) < 0) {
+        ::close(listen_fd_);
+        listen_fd_ = -1;
+        return false;
+    }
 
-    sockaddr_in addr{};
-    addr.sin_family = AF_INET;
-    addr.sin_addr.s_addr = INADDR_ANY;
-    addr.sin_port = htons(port);
-
-    if (::bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+    if (::bind(listen_fd_, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) < 0) {
         ::close(listen_fd_);
         listen_fd_ = -1;
         return false;
@@ -50,7 +58,67 @@ bool Acceptor::listen(uint16_t port, int backlog) {
     return true;
 }
 
-int Acceptor::accept() {
+bool Acceptor::adopt(int fd) {
+    int accepting = 0;
+    socklen_t len = sizeof(accepting);
+    if (::getsockopt(fd, SOL_SOCKET, SO_ACCEPTCONN, &accepting, &len) < 0 ||
+        !accepting) {
+        return false;
+    }
+
+    if (!Socket::set_nonblocking(fd)) {
+        return false;
+    }
+
+    close();
+    listen_fd_ = fd;
+    return true;
+}
+
+void Acceptor::close() {
+    if (listen_fd_ >= 0) {
+        ::close(listen_fd_);
+        listen_fd_ = -1;
+    }
+}
+
+bool Acceptor::set_backlog(int backlog) {
+    if (listen_fd_ < 0) {
+        return false;
+    }
+    // Calling listen() again on a listening socket only updates the backlog
+    return ::listen(listen_fd_, backlog) == 0;
+}
+
+bool Acceptor::steer_by_cpu(const std::vector<int>& index_of_cpu) {
+    if (listen_fd_ < 0) {
+        return false;
+    }
+
+    // A = receiving CPU; one compare-and-return pair per mapped CPU
+    std::vector<sock_filter> prog;
+    prog.push_back(BPF_STMT(BPF_LD | BPF_W | BPF_ABS, static_cast<uint32_t>(SKF_AD_OFF + SKF_AD_CPU)));
+    for (size_t cpu = 0; cpu < index_of_cpu.size(); ++cpu) {
+        if (index_of_cpu[cpu] < 0) {
+            continue;
+        }
+        prog.push_back(BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, static_cast<uint32_t>(cpu), 0, 1));
+        prog.push_back(BPF_STMT(BPF_RET | BPF_K, static_cast<uint32_t>(index_of_cpu[cpu])));
+    }
+    prog.push_back(BPF_STMT(BPF_RET | BPF_K, 0xffffffffu));     // out of range: hash
+
+    if (prog.size() > BPF_MAXINSNS) {
+        return false;
+    }
+
+    sock_fprog fprog{};
+    fprog.len = static_cast<unsigned short>(prog.size());
+    fprog.filter = prog.data();
+    return ::setsockopt(listen_fd_, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF,
+                        &fprog, sizeof(fprog)) == 0;
+}
+
+int Acceptor::accept(sockaddr_in* peer) {
     sockaddr_in client_addr{};
     socklen_t len = sizeof(client_addr);
 
@@ -67,9 +135,23 @@ int Acceptor::accept() {
         return -1;
     }
 
+    if (peer) {
+        *peer = client_addr;
+    }
+
     return client_fd;
 }
 
 int Acceptor::fd() const {
     return listen_fd_;
+}
+
+uint16_t Acceptor::port() const {
+    sockaddr_in addr{};
+    socklen_t len = sizeof(addr);
+    if (listen_fd_ < 0 ||
+        ::getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&addr), &len) < 0) {
+        return 0;
+    }
+    return ntohs(addr.sin_port);
 }
\ No newline at end of file
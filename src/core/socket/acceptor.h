@@ -1,6 +1,8 @@
 #pragma once
 
 #include <cstdint>
+#include <netinet/in.h>
+#include <vector>
 
 /*
  * Acceptor
@@ -27,17 +29,43 @@ public:
     Acceptor(const Acceptor&) = delete;
     Acceptor& operator=(const Acceptor&) = delete;
 
-    // Bind and start listening
-    bool listen(uint16_t port, int backlog = 1024);
+    // Bind and start listening; with reuseport, other sockets (in this
+    // or another process) may listen on the same port as a group
+    bool listen(uint16_t port, int backlog = 1024, bool reuseport = false);
+
+    // Same, on one local address (e.g. loopback only); port 0 lets the
+    // kernel pick, see port()
+    bool listen(const sockaddr_in& addr, int backlog = 1024, bool reuseport = false);
+
+    // Steer each new connection in this socket's SO_REUSEPORT group to
+    // the member at index_of_cpu[cpu], cpu being the one that received
+    // it. Members are indexed in the order they started listening;
+    // CPUs without an entry, or an index past the group, fall back to
+    // the kernel's hash
+    bool steer_by_cpu(const std::vector<int>& index_of_cpu);
+
+    // Take ownership of an already listening socket (e.g. inherited
+    // from a previous process during a binary upgrade)
+    bool adopt(int fd);
+
+    // Stop listening and close the socket
+    void close();
+
+    // Change the accept queue length of an already listening socket
+    bool set_backlog(int backlog);
 
     // Accept a new connection
+    // If peer is non-null it receives the client address
     // Returns:
     //  >=0 : client fd
     //   -1 : no connection or error (check errno outside)
-    int accept();
+    int accept(sockaddr_in* peer = nullptr);
 
     int fd() const;
 
+    // Bound port in host order, 0 if not listening
+    uint16_t port() const;
+
 private:
     int listen_fd_;
 };
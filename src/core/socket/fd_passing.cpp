@@ -0,0 +1,85 @@
+#include "fd_passing.h"
+
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+ssize_t FdPassing::send(int sock, const void* buf, size_t len,
+                        const std::vector<int>& fds) {
+    if (fds.size() > kMaxFds || len == 0) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    iovec iov{};
+    iov.iov_base = const_cast<void*>(buf);
+    iov.iov_len = len;
+
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * kMaxFds)];
+    std::memset(control, 0, sizeof(control));
+
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+
+    if (!fds.empty()) {
+        msg.msg_control = control;
+        msg.msg_controllen = CMSG_SPACE(sizeof(int) * fds.size());
+
+        cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int) * fds.size());
+        std::memcpy(CMSG_DATA(cmsg), fds.data(), sizeof(int) * fds.size());
+    }
+
+    return ::sendmsg(sock, &msg, MSG_NOSIGNAL);
+}
+
+ssize_t FdPassing::recv(int sock, void* buf, size_t len,
+                        std::vector<int>& fds) {
+    iovec iov{};
+    iov.iov_base = buf;
+    iov.iov_len = len;
+
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * kMaxFds)];
+
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    ssize_t n = ::recvmsg(sock, &msg, MSG_CMSG_CLOEXEC);
+    if (n < 0) {
+        return -1;
+    }
+
+    size_t first_new = fds.size();
+
+    for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) {
+            continue;
+        }
+        size_t count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        const unsigned char* data = CMSG_DATA(cmsg);
+        for (size_t i = 0; i < count; ++i) {
+            int fd;
+            std::memcpy(&fd, data + i * sizeof(int), sizeof(int));
+            fds.push_back(fd);
+        }
+    }
+
+    // Truncated control data means fds were dropped by the kernel
+    if (msg.msg_flags & MSG_CTRUNC) {
+        for (size_t i = first_new; i < fds.size(); ++i) {
+            ::close(fds[i]);
+        }
+        fds.resize(first_new);
+        errno = EMSGSIZE;
+        return -1;
+    }
+
+    return n;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include <sys/types.h>
+
+/*
+ * FdPassing
+ * ---------
+ * Send / receive file descriptors over a Unix domain socket (SCM_RIGHTS).
+ *
+ * Responsibilities:
+ * - Pack fds into ancillary data with a small payload
+ * - Unpack received fds (caller takes ownership)
+ *
+ * Non-responsibilities:
+ * - Creating or connecting the Unix socket
+ * - Deciding which fds to pass
+ */
+class FdPassing {
+public:
+    static constexpr size_t kMaxFds = 16;
+
+    // Send payload plus fds in a single message
+    // Returns bytes sent or -1 (check errno outside)
+    static ssize_t send(int sock, const void* buf, size_t len,
+                        const std::vector<int>& fds);
+
+    // Receive one message; received fds are appended to fds
+    // Returns bytes received, 0 on peer close, -1 on error
+    static ssize_t recv(int sock, void* buf, size_t len,
+                        std::vector<int>& fds);
+};
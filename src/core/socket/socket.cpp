@@ -1,9 +1,20 @@
 #include "socket.h"
 
+#include <cerrno>
 #include <fcntl.h>
+#include <linux/errqueue.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <sys/socket.h>
 #include <unistd.h>
 
+#ifndef SO_ZEROCOPY
+#define SO_ZEROCOPY 60
+#endif
+#ifndef MSG_ZEROCOPY
+#define MSG_ZEROCOPY 0x4000000
+#endif
+
 int Socket::create_tcp() {
     return ::socket(AF_INET, SOCK_STREAM, 0);
 }
@@ -16,6 +27,87 @@ bool Socket::set_nonblocking(int fd) {
     return (::fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0);
 }
 
+bool Socket::set_busy_poll(int fd, unsigned usec) {
+#ifdef SO_BUSY_POLL
+    int v = static_cast<int>(usec);
+    return ::setsockopt(fd, SOL_SOCKET, SO_BUSY_POLL, &v, sizeof(v)) == 0;
+#else
+    (void)fd;
+    (void)usec;
+    return false;
+#endif
+}
+
+int Socket::incoming_cpu(int fd) {
+#ifdef SO_INCOMING_CPU
+    int cpu = -1;
+    socklen_t len = sizeof(cpu);
+    if (::getsockopt(fd, SOL_SOCKET, SO_INCOMING_CPU, &cpu, &len) < 0) {
+        return -1;
+    }
+    return cpu;
+#else
+    (void)fd;
+    return -1;
+#endif
+}
+
+bool Socket::set_quickack(int fd) {
+    int one = 1;
+    return ::setsockopt(fd, IPPROTO_TCP, TCP_QUICKACK, &one, sizeof(one)) == 0;
+}
+
+bool Socket::set_cork(int fd, bool on) {
+    int v = on ? 1 : 0;
+    return ::setsockopt(fd, IPPROTO_TCP, TCP_CORK, &v, sizeof(v)) == 0;
+}
+
+bool Socket::set_zerocopy(int fd) {
+    int one = 1;
+    return ::setsockopt(fd, SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one)) == 0;
+}
+
+bool Socket::set_abort_on_close(int fd) {
+    linger l{1, 0};
+    return ::setsockopt(fd, SOL_SOCKET, SO_LINGER, &l, sizeof(l)) == 0;
+}
+
+ssize_t Socket::send_zerocopy(int fd, const void* buf, size_t len) {
+    return ::send(fd, buf, len, MSG_ZEROCOPY | MSG_NOSIGNAL);
+}
+
+bool Socket::reap_zerocopy(int fd, uint32_t& completed, bool& copied) {
+    bool any = false;
+
+    while (true) {
+        char control[128];
+        msghdr msg{};
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+        if (::recvmsg(fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+            return any;
+        }
+
+        for (cmsghdr* cm = CMSG_FIRSTHDR(&msg); cm; cm = CMSG_NXTHDR(&msg, cm)) {
+            if (!((cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR) ||
+                  (cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR))) {
+                continue;
+            }
+            auto* ee = reinterpret_cast<const sock_extended_err*>(CMSG_DATA(cm));
+            if (ee->ee_origin != SO_EE_ORIGIN_ZEROCOPY || ee->ee_errno != 0) {
+                continue;
+            }
+            // One notification covers sends [ee_info, ee_data]
+            completed += ee->ee_data - ee->ee_info + 1;
+            if (ee->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) {
+                copied = true;
+            }
+            any = true;
+        }
+    }
+}
+
 ssize_t Socket::read(int fd, void* buf, size_t len) {
     return ::read(fd, buf, len);
 }
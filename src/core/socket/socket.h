@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 #include <sys/types.h>
 
 /*
@@ -29,6 +30,40 @@ public:
     // Set O_NONBLOCK on fd
     static bool set_nonblocking(int fd);
 
+    // SO_BUSY_POLL: let blocking receives poll the device queue for up
+    // to usec (raising it above the sysctl default needs CAP_NET_ADMIN)
+    static bool set_busy_poll(int fd, unsigned usec);
+
+    // SO_INCOMING_CPU: CPU that processed the socket's most recent
+    // packet (for an accepted socket, the one that took the handshake),
+    // -1 if unknown
+    static int incoming_cpu(int fd);
+
+    // TCP_QUICKACK: acknowledge at once instead of delaying (the kernel
+    // drops back to delayed ACKs on its own)
+    static bool set_quickack(int fd);
+
+    // TCP_CORK: hold partial segments until uncorked (or 200 ms pass)
+    static bool set_cork(int fd, bool on);
+
+    // SO_ZEROCOPY: allow send_zerocopy() on fd
+    static bool set_zerocopy(int fd);
+
+    // SO_LINGER {on, 0}: close() resets the connection and discards
+    // unsent data instead of transmitting it
+    static bool set_abort_on_close(int fd);
+
+    // send(MSG_ZEROCOPY): the kernel transmits straight from buf, which
+    // must stay unchanged until reap_zerocopy() reports the send done.
+    // Each successful call is one send, numbered from 0 per socket
+    static ssize_t send_zerocopy(int fd, const void* buf, size_t len);
+
+    // Read MSG_ZEROCOPY completions from fd's error queue: adds the number
+    // of sends completed to completed, and sets copied if the kernel fell
+    // back to copying (loopback, devices without scatter-gather).
+    // Returns false if the queue held nothing (a real socket error)
+    static bool reap_zerocopy(int fd, uint32_t& completed, bool& copied);
+
     // Read wrapper
     // Returns:
     //  >0 : bytes read
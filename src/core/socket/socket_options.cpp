@@ -0,0 +1,39 @@
+#include "socket_options.h"
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+namespace {
+
+bool set_int(int fd, int level, int name, int value) {
+    return ::setsockopt(fd, level, name, &value, sizeof(value)) == 0;
+}
+
+} // namespace
+
+bool SocketOptions::apply(int fd) const {
+    bool ok = set_int(fd, IPPROTO_TCP, TCP_NODELAY, nodelay ? 1 : 0);
+
+    if (rcvbuf > 0) {
+        ok &= set_int(fd, SOL_SOCKET, SO_RCVBUF, static_cast<int>(rcvbuf));
+    }
+    if (sndbuf > 0) {
+        ok &= set_int(fd, SOL_SOCKET, SO_SNDBUF, static_cast<int>(sndbuf));
+    }
+    if (notsent_lowat > 0) {
+        ok &= set_int(fd, IPPROTO_TCP, TCP_NOTSENT_LOWAT, static_cast<int>(notsent_lowat));
+    }
+
+    ok &= set_int(fd, SOL_SOCKET, SO_KEEPALIVE, keepalive_idle_s > 0 ? 1 : 0);
+    if (keepalive_idle_s > 0) {
+        ok &= set_int(fd, IPPROTO_TCP, TCP_KEEPIDLE, static_cast<int>(keepalive_idle_s));
+        if (keepalive_interval_s > 0) {
+            ok &= set_int(fd, IPPROTO_TCP, TCP_KEEPINTVL, static_cast<int>(keepalive_interval_s));
+        }
+        if (keepalive_count > 0) {
+            ok &= set_int(fd, IPPROTO_TCP, TCP_KEEPCNT, static_cast<int>(keepalive_count));
+        }
+    }
+    return ok;
+}
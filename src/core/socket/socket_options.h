@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+
+/*
+ * SocketOptions
+ * -------------
+ * Kernel tuning profile for one side of the proxy (clients or upstreams).
+ *
+ * Core rules:
+ * - Zero / false means "leave the kernel default": in particular a fixed
+ *   rcvbuf or sndbuf turns off the kernel's buffer autotuning, so only
+ *   set them after measuring
+ * - The client profile is applied to the listening socket; accepted
+ *   sockets inherit it, so a connection costs no extra syscalls. The
+ *   upstream profile is applied to each upstream socket
+ * - quickack and zerocopy are per connection (see ConnectionManager):
+ *   the kernel leaves quick-ack mode on its own, and a MSG_ZEROCOPY send
+ *   on a socket without SO_ZEROCOPY would never be completed
+ * - cork and zerocopy_min_bytes are proxy behaviour, not socket options;
+ *   apply() ignores them
+ *
+ * Non-responsibilities:
+ * - Deciding when to cork or send zerocopy (ConnectionManager)
+ * - Parsing (ConfigLoader)
+ */
+struct SocketOptions {
+    bool nodelay = false;               // TCP_NODELAY
+    bool quickack = false;              // TCP_QUICKACK once, after accept
+    bool cork = false;                  // TCP_CORK a head until its body follows
+    uint32_t rcvbuf = 0;                // SO_RCVBUF
+    uint32_t sndbuf = 0;                // SO_SNDBUF
+    uint32_t notsent_lowat = 0;         // TCP_NOTSENT_LOWAT
+
+    // SO_KEEPALIVE with TCP_KEEPIDLE / TCP_KEEPINTVL / TCP_KEEPCNT
+    // (keepalive_idle_s = 0: off)
+    uint32_t keepalive_idle_s = 0;
+    uint32_t keepalive_interval_s = 0;
+    uint32_t keepalive_count = 0;
+
+    // Client writes of at least this many bytes use MSG_ZEROCOPY (0 = off)
+    uint32_t zerocopy_min_bytes = 0;
+
+    // Set this profile's socket options on fd. Flags are set either way,
+    // so re-applying after a reload turns them off too; sizes only when
+    // non-zero. False if any setsockopt failed (the rest still apply)
+    bool apply(int fd) const;
+};
@@ -0,0 +1,150 @@
+#include "cpu_topology.h"
+
+#include <dirent.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <fstream>
+
+namespace {
+
+// From <numaif.h>, which needs libnuma's headers
+constexpr int kMpolPreferred = 1;
+
+bool read_line(const std::string& path, std::string& out) {
+    std::ifstream in(path);
+    return static_cast<bool>(std::getline(in, out));
+}
+
+} // namespace
+
+bool CpuTopology::parse_cpu_list(const std::string& text, std::vector<int>& out) {
+    out.clear();
+    size_t i = 0;
+    while (i < text.size()) {
+        size_t end = text.find(',', i);
+        if (end == std::string::npos) {
+            end = text.size();
+        }
+        std::string item = text.substr(i, end - i);
+        i = end + 1;
+
+        while (!item.empty() && (item.back() == '\n' || item.back() == ' ')) {
+            item.pop_back();
+        }
+        if (item.empty()) {
+            continue;
+        }
+
+        char* p = nullptr;
+        long lo = std::strtol(item.c_str(), &p, 10);
+        long hi = lo;
+        if (*p == '-') {
+            hi = std::strtol(p + 1, &p, 10);
+        }
+        if (p == item.c_str() || *p != '\0' || lo < 0 || hi < lo || hi > 65535) {
+            return false;
+        }
+        for (long c = lo; c <= hi; ++c) {
+            out.push_back(static_cast<int>(c));
+        }
+    }
+    return !out.empty();
+}
+
+bool CpuTopology::load(const std::string& root) {
+    nodes_.clear();
+    node_of_cpu_.clear();
+
+    if (DIR* dir = ::opendir((root + "/node").c_str())) {
+        while (dirent* e = ::readdir(dir)) {
+            std::string name = e->d_name;
+            if (name.compare(0, 4, "node") != 0 || name.size() == 4 ||
+                name.find_first_not_of("0123456789", 4) != std::string::npos) {
+                continue;
+            }
+
+            std::string list;
+            std::vector<int> cpus;
+            if (!read_line(root + "/node/" + name + "/cpulist", list) ||
+                !parse_cpu_list(list, cpus)) {
+                continue;           // memory-only node
+            }
+
+            size_t id = std::strtoul(name.c_str() + 4, nullptr, 10);
+            if (id >= nodes_.size()) {
+                nodes_.resize(id + 1);
+            }
+            nodes_[id] = std::move(cpus);
+        }
+        ::closedir(dir);
+    }
+
+    if (nodes_.empty()) {
+        std::string list;
+        std::vector<int> cpus;
+        if (!read_line(root + "/cpu/online", list) || !parse_cpu_list(list, cpus)) {
+            return false;
+        }
+        nodes_.push_back(std::move(cpus));
+    }
+
+    for (size_t n = 0; n < nodes_.size(); ++n) {
+        for (int cpu : nodes_[n]) {
+            if (static_cast<size_t>(cpu) >= node_of_cpu_.size()) {
+                node_of_cpu_.resize(cpu + 1, -1);
+            }
+            node_of_cpu_[cpu] = static_cast<int>(n);
+        }
+    }
+    return true;
+}
+
+const std::vector<int>& CpuTopology::cpus(int node) const {
+    static const std::vector<int> kNone;
+    if (node < 0 || static_cast<size_t>(node) >= nodes_.size()) {
+        return kNone;
+    }
+    return nodes_[node];
+}
+
+int CpuTopology::node_of(int cpu) const {
+    if (cpu < 0 || static_cast<size_t>(cpu) >= node_of_cpu_.size()) {
+        return -1;
+    }
+    return node_of_cpu_[cpu];
+}
+
+bool CpuTopology::bind_current_thread(int node) const {
+    const std::vector<int>& list = cpus(node);
+    if (list.empty()) {
+        return false;
+    }
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : list) {
+        if (cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &set);
+        }
+    }
+    if (::sched_setaffinity(0, sizeof(set), &set) < 0) {
+        return false;
+    }
+
+    // Only meaningful when the kernel knows more than one node; a
+    // single-node fallback has nothing to prefer
+    if (nodes_.size() > 1) {
+        unsigned long mask[16] = {};
+        if (static_cast<size_t>(node) >= sizeof(mask) * 8) {
+            return false;
+        }
+        mask[node / (8 * sizeof(unsigned long))] |= 1ul << (node % (8 * sizeof(unsigned long)));
+        if (::syscall(SYS_set_mempolicy, kMpolPreferred, mask, sizeof(mask) * 8) < 0) {
+            return false;
+        }
+    }
+    return true;
+}
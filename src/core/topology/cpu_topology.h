@@ -0,0 +1,51 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+/*
+ * CpuTopology
+ * -----------
+ * Which CPUs belong to which NUMA node, read from sysfs.
+ *
+ * Core rules:
+ * - load() reads <root>/node/nodeN/cpulist; a host without NUMA
+ *   information (or a container hiding it) becomes a single node 0
+ *   holding every online CPU
+ * - bind_current_thread() restricts the calling thread to one node's
+ *   CPUs and prefers that node's memory. Threads inherit both, so doing
+ *   it first on the main thread places every later thread and every
+ *   pool they fill (first touch) on the node
+ * - Preferred, not strict: allocations still succeed when the node is
+ *   out of memory
+ *
+ * Non-responsibilities:
+ * - Choosing a node (configuration)
+ * - Steering accepted connections (Acceptor)
+ */
+class CpuTopology {
+public:
+    // Read sysfs below root; false only if not even the online CPU
+    // list could be read
+    bool load(const std::string& root = "/sys/devices/system");
+
+    size_t node_count() const { return nodes_.size(); }
+
+    // CPUs of node (empty for an unknown node)
+    const std::vector<int>& cpus(int node) const;
+
+    // Node that cpu belongs to, -1 if unknown
+    int node_of(int cpu) const;
+
+    // node_of() for every CPU, indexed by CPU
+    const std::vector<int>& cpu_nodes() const { return node_of_cpu_; }
+
+    bool bind_current_thread(int node) const;
+
+    // "0-3,8,10-11" -> {0,1,2,3,8,10,11}
+    static bool parse_cpu_list(const std::string& text, std::vector<int>& out);
+
+private:
+    std::vector<std::vector<int>> nodes_;    // index = node id
+    std::vector<int> node_of_cpu_;           // index = cpu
+};
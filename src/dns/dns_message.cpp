@@ -0,0 +1,224 @@
+#include "dns_message.h"
+
+namespace {
+
+constexpr size_t kHeaderLen = 12;
+constexpr uint16_t kTypeA = 1;
+constexpr uint16_t kClassIn = 1;
+
+void put16(std::vector<uint8_t>& out, uint16_t v) {
+    out.push_back(static_cast<uint8_t>(v >> 8));
+    out.push_back(static_cast<uint8_t>(v & 0xff));
+}
+
+void put32(std::vector<uint8_t>& out, uint32_t v) {
+    put16(out, static_cast<uint16_t>(v >> 16));
+    put16(out, static_cast<uint16_t>(v & 0xffff));
+}
+
+uint16_t get16(const uint8_t* p) {
+    return static_cast<uint16_t>((p[0] << 8) | p[1]);
+}
+
+uint32_t get32(const uint8_t* p) {
+    return (static_cast<uint32_t>(get16(p)) << 16) | get16(p + 2);
+}
+
+/*
+ * Advance pos past a (possibly compressed) name.
+ * Compression pointers terminate the name in place, so no jump is needed
+ * to skip it.
+ */
+bool skip_name(const uint8_t* data, size_t len, size_t& pos) {
+    while (pos < len) {
+        uint8_t l = data[pos];
+        if ((l & 0xc0) == 0xc0) {
+            if (pos + 2 > len) {
+                return false;
+            }
+            pos += 2;
+            return true;
+        }
+        if (l & 0xc0) {
+            return false;
+        }
+        pos += 1 + l;
+        if (l == 0) {
+            return pos <= len;
+        }
+    }
+    return false;
+}
+
+/*
+ * Read an uncompressed name (a question's, which nothing precedes that
+ * it could point to) into dotted form.
+ */
+bool read_name(const uint8_t* data, size_t len, size_t& pos, std::string& out) {
+    out.clear();
+    while (pos < len) {
+        uint8_t l = data[pos++];
+        if (l == 0) {
+            return true;
+        }
+        if ((l & 0xc0) || pos + l > len) {
+            return false;
+        }
+        if (!out.empty()) {
+            out.push_back('.');
+        }
+        out.append(reinterpret_cast<const char*>(data + pos), l);
+        pos += l;
+    }
+    return false;
+}
+
+} // namespace
+
+bool DnsMessage::valid_name(const std::string& name) {
+    if (name.empty() || name.size() > 253) {
+        return false;
+    }
+    size_t start = 0;
+    while (start < name.size()) {
+        size_t dot = name.find('.', start);
+        if (dot == std::string::npos) {
+            dot = name.size();
+        }
+        if (dot == start || dot - start > 63) {
+            return false;
+        }
+        start = dot + 1;
+    }
+    return true;
+}
+
+bool DnsMessage::build_query(uint16_t id, const std::string& name,
+                             std::vector<uint8_t>& out) {
+    out.clear();
+    if (!valid_name(name)) {
+        return false;
+    }
+
+    put16(out, id);
+    put16(out, 0x0100);     // RD
+    put16(out, 1);          // QDCOUNT
+    put16(out, 0);
+    put16(out, 0);
+    put16(out, 0);
+
+    size_t start = 0;
+    while (start < name.size()) {
+        size_t dot = name.find('.', start);
+        if (dot == std::string::npos) {
+            dot = name.size();
+        }
+        out.push_back(static_cast<uint8_t>(dot - start));
+        out.insert(out.end(), name.begin() + start, name.begin() + dot);
+        start = dot + 1;
+    }
+    out.push_back(0);
+
+    put16(out, kTypeA);
+    put16(out, kClassIn);
+    return true;
+}
+
+bool DnsMessage::parse_response(const uint8_t* data, size_t len, DnsAnswer& out) {
+    if (len < kHeaderLen) {
+        return false;
+    }
+
+    out.id = get16(data);
+    uint16_t flags = get16(data + 2);
+    uint16_t qdcount = get16(data + 4);
+    uint16_t ancount = get16(data + 6);
+
+    if (!(flags & 0x8000)) {
+        return false;       // not a response
+    }
+    out.rcode = static_cast<uint8_t>(flags & 0x000f);
+    out.addrs.clear();
+    out.ttl = 0;
+
+    out.qname.clear();
+
+    size_t pos = kHeaderLen;
+    for (uint16_t i = 0; i < qdcount; ++i) {
+        bool ok = i == 0 ? read_name(data, len, pos, out.qname) : skip_name(data, len, pos);
+        if (!ok || pos + 4 > len) {
+            return false;
+        }
+        pos += 4;
+    }
+
+    bool have_ttl = false;
+    for (uint16_t i = 0; i < ancount; ++i) {
+        if (!skip_name(data, len, pos) || pos + 10 > len) {
+            return false;
+        }
+        uint16_t type = get16(data + pos);
+        uint16_t cls = get16(data + pos + 2);
+        uint32_t ttl = get32(data + pos + 4);
+        uint16_t rdlen = get16(data + pos + 8);
+        pos += 10;
+
+        if (pos + rdlen > len) {
+            return false;
+        }
+
+        // CNAME records are skipped; the resolver includes the A records
+        // for the chain's target in the same answer section
+        if (type == kTypeA && cls == kClassIn && rdlen == 4) {
+            uint32_t addr;
+            const uint8_t* p = data + pos;
+            addr = static_cast<uint32_t>(p[0]) |
+                   (static_cast<uint32_t>(p[1]) << 8) |
+                   (static_cast<uint32_t>(p[2]) << 16) |
+                   (static_cast<uint32_t>(p[3]) << 24);
+            out.addrs.push_back(addr);
+            if (!have_ttl || ttl < out.ttl) {
+                out.ttl = ttl;
+                have_ttl = true;
+            }
+        }
+        pos += rdlen;
+    }
+
+    return true;
+}
+
+bool DnsMessage::build_response(const uint8_t* query, size_t query_len,
+                                uint8_t rcode,
+                                const std::vector<uint32_t>& addrs,
+                                uint32_t ttl,
+                                std::vector<uint8_t>& out) {
+    if (query_len < kHeaderLen || get16(query + 4) != 1) {
+        return false;
+    }
+
+    size_t qend = kHeaderLen;
+    if (!skip_name(query, query_len, qend) || qend + 4 > query_len) {
+        return false;
+    }
+    qend += 4;
+
+    out.assign(query, query + qend);
+    out[2] = 0x81;                                  // QR | RD
+    out[3] = static_cast<uint8_t>(0x80 | (rcode & 0x0f));   // RA | rcode
+    out[6] = static_cast<uint8_t>(addrs.size() >> 8);
+    out[7] = static_cast<uint8_t>(addrs.size() & 0xff);
+
+    for (uint32_t addr : addrs) {
+        put16(out, 0xc000 | kHeaderLen);    // pointer to question name
+        put16(out, kTypeA);
+        put16(out, kClassIn);
+        put32(out, ttl);
+        put16(out, 4);
+        out.push_back(static_cast<uint8_t>(addr & 0xff));
+        out.push_back(static_cast<uint8_t>((addr >> 8) & 0xff));
+        out.push_back(static_cast<uint8_t>((addr >> 16) & 0xff));
+        out.push_back(static_cast<uint8_t>((addr >> 24) & 0xff));
+    }
+    return true;
+}
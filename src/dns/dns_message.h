@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ * DnsAnswer
+ * ---------
+ * IPv4 addresses from a DNS response plus the smallest TTL among them.
+ */
+struct DnsAnswer {
+    uint16_t id = 0;
+    uint8_t rcode = 0;                 // 0 = NOERROR, 3 = NXDOMAIN
+    std::string qname;                 // first question, dotted, as sent
+    std::vector<uint32_t> addrs;       // network byte order
+    uint32_t ttl = 0;                  // seconds
+};
+
+/*
+ * DnsMessage
+ * ----------
+ * Minimal DNS wire codec for A queries (RFC 1035).
+ *
+ * Responsibilities:
+ * - Build a recursive A query
+ * - Parse A records out of a response, following name compression,
+ *   and the name it answers (so it can be matched to the query)
+ * - Build a response (used by stub servers in tests)
+ *
+ * Non-responsibilities:
+ * - Sockets, retries, caching
+ * - Record types other than A
+ */
+class DnsMessage {
+public:
+    // Whether name fits the wire format (<= 253 bytes, labels 1..63)
+    static bool valid_name(const std::string& name);
+
+    // Encode an A query for name; returns false if name is not encodable
+    static bool build_query(uint16_t id, const std::string& name,
+                            std::vector<uint8_t>& out);
+
+    // Decode a response; returns false on malformed input
+    static bool parse_response(const uint8_t* data, size_t len, DnsAnswer& out);
+
+    // Encode a response echoing the question in query
+    static bool build_response(const uint8_t* query, size_t query_len,
+                               uint8_t rcode,
+                               const std::vector<uint32_t>& addrs,
+                               uint32_t ttl,
+                               std::vector<uint8_t>& out);
+};
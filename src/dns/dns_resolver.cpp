@@ -0,0 +1,264 @@
+#include "dns_resolver.h"
+#include "dns_message.h"
+#include "core/event_loop/epoll_loop.h"
+
+#include <arpa/inet.h>
+#include <strings.h>
+#include <sys/random.h>
+#include <sys/socket.h>
+#include <cerrno>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+// Query IDs are the only secret an off-path spoofer must guess
+uint16_t random_id() {
+    uint16_t id = 0;
+    if (::getrandom(&id, sizeof(id), GRND_NONBLOCK) != sizeof(id)) {
+        // Only before the entropy pool is initialised (early boot)
+        id = static_cast<uint16_t>(
+            std::chrono::steady_clock::now().time_since_epoch().count() * 2654435761u >> 16);
+    }
+    return id;
+}
+
+} // namespace
+
+DnsResolver::DnsResolver(EpollLoop& loop, const sockaddr_in& nameserver)
+    : loop_(loop),
+      nameserver_(nameserver),
+      fd_(::socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0)) {
+
+    if (!fd_.valid()) {
+        throw std::runtime_error("dns socket failed");
+    }
+
+    // Connected UDP: the kernel drops datagrams from other sources
+    if (::connect(fd_.get(), reinterpret_cast<const sockaddr*>(&nameserver_),
+                  sizeof(nameserver_)) < 0) {
+        throw std::runtime_error("dns connect failed");
+    }
+
+    loop_.add(fd_.get(), EPOLLIN, this);
+}
+
+DnsResolver::~DnsResolver() {
+    loop_.remove(fd_.get());
+}
+
+void DnsResolver::set_callback(Callback cb) {
+    callback_ = std::move(cb);
+}
+
+DnsLookup DnsResolver::lookup(const std::string& host, uint32_t& addr, uint64_t now_ms) {
+    auto it = cache_.find(host);
+    if (it == cache_.end()) {
+        // Names come from clients (CONNECT): only valid ones get an
+        // entry, and only while there is room for it
+        if (!DnsMessage::valid_name(host) || !make_room(now_ms)) {
+            return DnsLookup::FAILED;
+        }
+        it = cache_.emplace(host, Entry()).first;
+    }
+    Entry& e = it->second;
+
+    if (!e.addrs.empty() && now_ms < e.expires_ms) {
+        addr = e.addrs[e.next++ % e.addrs.size()];
+        return DnsLookup::HIT;
+    }
+    if (e.pending) {
+        return DnsLookup::PENDING;
+    }
+
+    // Negative entries suppress re-querying until they expire
+    if (now_ms < e.expires_ms) {
+        return DnsLookup::FAILED;
+    }
+    return send_query(host, e, now_ms) ? DnsLookup::PENDING : DnsLookup::FAILED;
+}
+
+bool DnsResolver::evictable(const Entry& e, uint64_t now_ms) {
+    return !e.watched && !e.pending && now_ms >= e.expires_ms;
+}
+
+bool DnsResolver::make_room(uint64_t now_ms) {
+    if (cache_.size() < kMaxEntries) {
+        return true;
+    }
+    for (auto it = cache_.begin(); it != cache_.end(); ) {
+        if (evictable(it->second, now_ms)) {
+            it = cache_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    return cache_.size() < kMaxEntries;
+}
+
+void DnsResolver::watch(const std::string& host, uint64_t now_ms) {
+    Entry& e = cache_[host];
+    e.watched = true;
+    if (!e.pending && now_ms >= e.refresh_ms) {
+        send_query(host, e, now_ms);
+    }
+}
+
+bool DnsResolver::send_query(const std::string& host, Entry& e, uint64_t now_ms) {
+    if (e.pending) {
+        inflight_.erase(e.id);
+        e.pending = false;
+    }
+
+    uint16_t id = random_id();
+    while (inflight_.count(id)) {
+        id = random_id();
+    }
+
+    // Reported to the caller, not through the callback: nobody has
+    // parked on this name yet
+    std::vector<uint8_t> query;
+    if (!DnsMessage::build_query(id, host, query)) {
+        e.attempts = 0;
+        e.expires_ms = now_ms + kNegativeTtlMs;
+        e.refresh_ms = e.expires_ms;
+        return false;
+    }
+
+    e.pending = true;
+    e.id = id;
+    e.sent_ms = now_ms;
+    ++e.attempts;
+    inflight_[id] = host;
+
+    // A full send buffer is treated as a lost datagram; tick() retries
+    ::send(fd_.get(), query.data(), query.size(), 0);
+    return true;
+}
+
+void DnsResolver::complete(const std::string& host, Entry& e, bool ok) {
+    e.pending = false;
+    e.attempts = 0;
+
+    if (callback_) {
+        uint32_t addr = ok ? e.addrs[e.next++ % e.addrs.size()] : 0;
+        callback_(host, ok, addr);
+    }
+}
+
+void DnsResolver::handle_readable(uint64_t now_ms) {
+    uint8_t buf[1500];
+
+    while (true) {
+        ssize_t n = ::recv(fd_.get(), buf, sizeof(buf), 0);
+        if (n < 0) {
+            // EAGAIN ends the batch; ECONNREFUSED (ICMP) waits for retry
+            return;
+        }
+
+        DnsAnswer answer;
+        if (!DnsMessage::parse_response(buf, static_cast<size_t>(n), answer)) {
+            continue;
+        }
+
+        // Late, or spoofed: an answer for another name must not land in
+        // this name's entry even if it guessed the ID
+        auto it = inflight_.find(answer.id);
+        if (it == inflight_.end() || answer.qname.size() != it->second.size() ||
+            strncasecmp(answer.qname.data(), it->second.data(), answer.qname.size()) != 0) {
+            continue;
+        }
+
+        std::string host = std::move(it->second);
+        inflight_.erase(it);
+        Entry& e = cache_[host];
+
+        if (answer.rcode != 0 || answer.addrs.empty()) {
+            // Keep serving a stale-but-known address rather than failing
+            if (e.addrs.empty()) {
+                e.expires_ms = now_ms + kNegativeTtlMs;
+            }
+            e.refresh_ms = now_ms + kNegativeTtlMs;
+            std::cerr << "[dns] no address for " << host << "\n";
+            complete(host, e, !e.addrs.empty());
+            continue;
+        }
+
+        uint64_t ttl_ms = static_cast<uint64_t>(
+            answer.ttl < kMinTtlSec ? kMinTtlSec : answer.ttl) * 1000;
+
+        e.addrs = std::move(answer.addrs);
+        e.expires_ms = now_ms + ttl_ms;
+        // Refresh at 75% of TTL so watched names never expire in use
+        e.refresh_ms = now_ms + ttl_ms * 3 / 4;
+        complete(host, e, true);
+    }
+}
+
+void DnsResolver::tick(uint64_t now_ms) {
+    // Callbacks may call lookup(), which can insert into cache_, so
+    // failures are reported after the walk
+    std::vector<std::string> timed_out;
+
+    for (auto it = cache_.begin(); it != cache_.end(); ) {
+        // Looked up once and expired since: forget it
+        if (evictable(it->second, now_ms)) {
+            it = cache_.erase(it);
+            continue;
+        }
+        const std::string& host = it->first;
+        Entry& e = it->second;
+        ++it;
+
+        if (e.pending) {
+            if (now_ms - e.sent_ms < kRetryMs) {
+                continue;
+            }
+            if (e.attempts >= kMaxAttempts) {
+                timed_out.push_back(host);
+                continue;
+            }
+            send_query(host, e, now_ms);
+            continue;
+        }
+
+        if (e.watched && now_ms >= e.refresh_ms) {
+            send_query(host, e, now_ms);
+        }
+    }
+
+    for (const std::string& host : timed_out) {
+        Entry& e = cache_[host];
+        inflight_.erase(e.id);
+        e.refresh_ms = now_ms + kNegativeTtlMs;
+        if (e.addrs.empty()) {
+            e.expires_ms = now_ms + kNegativeTtlMs;
+        }
+        std::cerr << "[dns] timeout resolving " << host << "\n";
+        complete(host, e, !e.addrs.empty());
+    }
+}
+
+sockaddr_in DnsResolver::system_nameserver() {
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(53);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    std::ifstream f("/etc/resolv.conf");
+    std::string line;
+    while (std::getline(f, line)) {
+        std::istringstream ss(line);
+        std::string key, value;
+        ss >> key >> value;
+        if (key == "nameserver" &&
+            inet_pton(AF_INET, value.c_str(), &addr.sin_addr) == 1) {
+            break;
+        }
+    }
+    return addr;
+}
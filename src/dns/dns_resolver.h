@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <netinet/in.h>
+
+#include "core/fd/fd_wrapper.h"
+
+class EpollLoop;
+
+/*
+ * DnsLookup
+ * ---------
+ * Outcome of DnsResolver::lookup().
+ */
+enum class DnsLookup {
+    HIT,        // addr is set
+    PENDING,    // a query is in flight; the callback reports the result
+    FAILED      // negative entry or unresolvable name; no callback follows
+};
+
+/*
+ * DnsResolver
+ * -----------
+ * Non-blocking A-record resolver living on one EpollLoop.
+ *
+ * Responsibilities:
+ * - Send queries over a non-blocking UDP socket
+ * - Cache answers for their TTL; unwatched entries are dropped once
+ *   expired, and at most kMaxEntries names are held at a time
+ * - Refresh watched names before they expire, so lookups on the request
+ *   path hit the cache
+ * - Retransmit lost queries and report failures
+ * - Accept only answers that match an in-flight query's random ID and
+ *   question name, so an off-path sender has to guess both
+ *
+ * Non-responsibilities:
+ * - /etc/hosts, search domains, TCP fallback
+ * - Blocking resolution of any kind
+ *
+ * Threading: every method must be called on the owning loop thread.
+ * The socket is registered with the loop using `this` as epoll data;
+ * the loop owner calls handle_readable() and tick().
+ */
+class DnsResolver {
+public:
+    // ok == false means the name could not be resolved
+    using Callback = std::function<void(const std::string& host, bool ok, uint32_t addr)>;
+
+    DnsResolver(EpollLoop& loop, const sockaddr_in& nameserver);
+    ~DnsResolver();
+
+    DnsResolver(const DnsResolver&) = delete;
+    DnsResolver& operator=(const DnsResolver&) = delete;
+
+    // Invoked for every completed query
+    void set_callback(Callback cb);
+
+    // Cached address (network order); round-robins over multiple A records.
+    // On miss or expiry starts a query if none is pending and returns
+    // PENDING; FAILED while a negative entry is live, when host is not a
+    // valid name or when the cache is full (the callback never fires
+    // for that lookup)
+    DnsLookup lookup(const std::string& host, uint32_t& addr, uint64_t now_ms);
+
+    // Keep host resolved in the background from now on
+    void watch(const std::string& host, uint64_t now_ms);
+
+    // Drain and process responses
+    void handle_readable(uint64_t now_ms);
+
+    // Retransmit timed-out queries and refresh watched entries
+    void tick(uint64_t now_ms);
+
+    int fd() const { return fd_.get(); }
+
+    // Names currently held (positive, negative or pending)
+    size_t cached() const { return cache_.size(); }
+
+    // First nameserver from resolv.conf, 127.0.0.1 if none (startup only)
+    static sockaddr_in system_nameserver();
+
+private:
+    struct Entry {
+        std::vector<uint32_t> addrs;
+        size_t next = 0;
+        uint64_t expires_ms = 0;
+        uint64_t refresh_ms = 0;
+        bool watched = false;
+
+        bool pending = false;
+        uint16_t id = 0;
+        uint64_t sent_ms = 0;
+        int attempts = 0;
+    };
+
+    static bool evictable(const Entry& e, uint64_t now_ms);
+
+    // Evict expired unwatched entries if the cache is full; false if
+    // still full
+    bool make_room(uint64_t now_ms);
+
+    // False (and a negative entry) if host cannot be encoded
+    bool send_query(const std::string& host, Entry& e, uint64_t now_ms);
+    void complete(const std::string& host, Entry& e, bool ok);
+
+    static constexpr uint64_t kRetryMs = 1000;
+    static constexpr int kMaxAttempts = 3;
+    static constexpr uint64_t kNegativeTtlMs = 5000;
+    static constexpr uint32_t kMinTtlSec = 1;
+    static constexpr size_t kMaxEntries = 4096;
+
+    EpollLoop& loop_;
+    sockaddr_in nameserver_;
+    FDWrapper fd_;
+    Callback callback_;
+
+    std::unordered_map<std::string, Entry> cache_;
+    std::unordered_map<uint16_t, std::string> inflight_;
+};
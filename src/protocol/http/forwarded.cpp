@@ -0,0 +1,52 @@
+#include "forwarded.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <cstring>
+
+std::string ForwardedSplicer::format_address(const sockaddr_storage& addr) {
+    char buf[INET6_ADDRSTRLEN];
+    return std::string(buf, format_address(addr, buf));
+}
+
+size_t ForwardedSplicer::format_address(const sockaddr_storage& addr, char* buf) {
+    const void* src = nullptr;
+    if (addr.ss_family == AF_INET) {
+        src = &reinterpret_cast<const sockaddr_in*>(&addr)->sin_addr;
+    } else if (addr.ss_family == AF_INET6) {
+        src = &reinterpret_cast<const sockaddr_in6*>(&addr)->sin6_addr;
+    }
+    if (!src || !inet_ntop(addr.ss_family, src, buf, INET6_ADDRSTRLEN)) {
+        return 0;
+    }
+    return std::strlen(buf);
+}
+
+std::string ForwardedSplicer::forwarded_node(const std::string& client) {
+    if (client.find(':') != std::string::npos) {
+        return "\"[" + client + "]\"";
+    }
+    return client;
+}
+
+void ForwardedSplicer::append_lines(std::string& head, const std::string& client,
+                                    bool x_forwarded_for, const std::string& existing_xff,
+                                    bool forwarded, const std::string& existing_fwd) {
+    if (client.empty()) {
+        return;
+    }
+    if (x_forwarded_for) {
+        head.append("X-Forwarded-For: ");
+        if (!existing_xff.empty()) {
+            head.append(existing_xff).append(", ");
+        }
+        head.append(client).append("\r\n");
+    }
+    if (forwarded) {
+        head.append("Forwarded: ");
+        if (!existing_fwd.empty()) {
+            head.append(existing_fwd).append(", ");
+        }
+        head.append("for=").append(forwarded_node(client)).append("\r\n");
+    }
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+
+/*
+ * ForwardedSplicer
+ * ----------------
+ * Client address formatting for X-Forwarded-For and Forwarded.
+ *
+ * HTTP/1.1 heads get the values through HeaderEditor::append_value()
+ * (an existing header gets the address appended to its last
+ * occurrence); heads built from scratch use append_lines().
+ *
+ * Non-responsibilities:
+ * - Deciding whether incoming forwarding headers can be trusted
+ */
+class ForwardedSplicer {
+public:
+    // "192.0.2.1" / "2001:db8::1"; empty for unsupported families
+    static std::string format_address(const sockaddr_storage& addr);
+
+    // Same into buf (at least INET6_ADDRSTRLEN bytes); returns the length
+    static size_t format_address(const sockaddr_storage& addr, char* buf);
+
+    // Header lines for a head being built from scratch (HTTP/2 path);
+    // existing values are the client's own headers, empty if absent
+    static void append_lines(std::string& head, const std::string& client,
+                             bool x_forwarded_for, const std::string& existing_xff,
+                             bool forwarded, const std::string& existing_fwd);
+
+    // Forwarded "for=" value: IPv6 must be quoted and bracketed
+    static std::string forwarded_node(const std::string& client);
+};
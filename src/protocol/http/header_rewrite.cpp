@@ -0,0 +1,218 @@
+#include "header_rewrite.h"
+
+#include <cstring>
+#include <strings.h>
+
+namespace {
+
+// Hop-by-hop headers the proxy never needs to pass on (see HeaderRules)
+const char* const kHopByHop[] = {
+    "keep-alive", "proxy-connection", "proxy-authorization", "te", "trailer",
+};
+
+} // namespace
+
+bool HeaderRules::removes(const std::string& name) const {
+    if (strip_hop_by_hop) {
+        for (const char* h : kHopByHop) {
+            if (name == h) {
+                return true;
+            }
+        }
+    }
+    for (const HeaderRule& r : rules) {
+        if (r.op != HeaderRule::Op::ADD && r.name == name) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void HeaderRules::append_lines(std::string& head) const {
+    for (const HeaderRule& r : rules) {
+        if (r.op != HeaderRule::Op::REMOVE) {
+            head.append(r.line);
+        }
+    }
+}
+
+bool HeaderEditor::parse(const char* data, size_t header_bytes) {
+    data_ = data;
+    header_bytes_ = header_bytes;
+    nlines_ = 0;
+    nadded_ = 0;
+    arena_used_ = 0;
+    ok_ = true;
+
+    const char* end = data + header_bytes - 2;      // the blank line
+    const char* p = static_cast<const char*>(std::memchr(data, '\n', header_bytes));
+    if (!p) {
+        ok_ = false;
+        return false;
+    }
+    ++p;
+
+    while (p < end) {
+        const char* nl = static_cast<const char*>(std::memchr(p, '\n', end - p));
+        if (!nl) {
+            break;
+        }
+        if (nlines_ == kMaxLines) {
+            ok_ = false;
+            return false;
+        }
+
+        Line& l = lines_[nlines_++];
+        l.off = static_cast<uint32_t>(p - data);
+        l.end = static_cast<uint32_t>(nl + 1 - data);
+        l.value_end = static_cast<uint32_t>((nl > p && nl[-1] == '\r' ? nl - 1 : nl) - data);
+
+        const char* colon = static_cast<const char*>(std::memchr(p, ':', nl - p));
+        l.name_len = colon && colon - p <= 0xffff ? static_cast<uint16_t>(colon - p) : 0;
+        l.drop = false;
+        l.append = nullptr;
+        l.append_len = 0;
+
+        p = nl + 1;
+    }
+    return true;
+}
+
+bool HeaderEditor::matches(const Line& l, const char* name, size_t name_len) const {
+    return !l.drop && l.name_len == name_len &&
+           strncasecmp(data_ + l.off, name, name_len) == 0;
+}
+
+void HeaderEditor::remove(const char* name) {
+    size_t n = std::strlen(name);
+    for (size_t i = 0; i < nlines_; ++i) {
+        if (matches(lines_[i], name, n)) {
+            lines_[i].drop = true;
+        }
+    }
+}
+
+void HeaderEditor::add(const char* text, size_t len) {
+    if (nadded_ == kMaxAdded) {
+        ok_ = false;
+        return;
+    }
+    added_[nadded_++] = {text, len};
+}
+
+void HeaderEditor::apply(const HeaderRules& rules) {
+    if (rules.strip_hop_by_hop) {
+        for (const char* h : kHopByHop) {
+            remove(h);
+        }
+    }
+    for (const HeaderRule& r : rules.rules) {
+        if (r.op != HeaderRule::Op::ADD) {
+            remove(r.name.c_str());
+        }
+        if (r.op != HeaderRule::Op::REMOVE) {
+            add(r.line.data(), r.line.size());
+        }
+    }
+}
+
+char* HeaderEditor::alloc(size_t n) {
+    if (kArenaBytes - arena_used_ < n) {
+        ok_ = false;
+        return nullptr;
+    }
+    char* p = arena_ + arena_used_;
+    arena_used_ += n;
+    return p;
+}
+
+void HeaderEditor::append_value(const char* name,
+                                std::initializer_list<std::string_view> parts) {
+    size_t name_len = std::strlen(name);
+    size_t value_len = 0;
+    for (std::string_view part : parts) {
+        value_len += part.size();
+    }
+
+    Line* last = nullptr;
+    for (size_t i = 0; i < nlines_; ++i) {
+        if (matches(lines_[i], name, name_len)) {
+            last = &lines_[i];
+        }
+    }
+    bool extend = last && !last->append;
+
+    size_t len = extend ? 2 + value_len : name_len + 2 + value_len + 2;
+    char* p = alloc(len);
+    if (!p) {
+        return;
+    }
+
+    char* w = p;
+    if (extend) {
+        std::memcpy(w, ", ", 2);
+    } else {
+        std::memcpy(w, name, name_len);
+        w += name_len;
+        std::memcpy(w, ": ", 2);
+    }
+    w += 2;
+    for (std::string_view part : parts) {
+        std::memcpy(w, part.data(), part.size());
+        w += part.size();
+    }
+
+    if (extend) {
+        last->append = p;
+        last->append_len = static_cast<uint32_t>(len);
+        return;
+    }
+    std::memcpy(w, "\r\n", 2);
+    add(p, len);
+}
+
+size_t HeaderEditor::build(size_t len, iovec* iov) const {
+    if (!ok_) {
+        return 0;
+    }
+
+    size_t n = 0;
+    size_t span = 0;        // start of the original bytes not yet emitted
+
+    auto emit_span = [&](size_t to) {
+        if (to > span) {
+            iov[n].iov_base = const_cast<char*>(data_ + span);
+            iov[n].iov_len = to - span;
+            ++n;
+        }
+    };
+    auto emit_text = [&](const char* text, size_t text_len) {
+        iov[n].iov_base = const_cast<char*>(text);
+        iov[n].iov_len = text_len;
+        ++n;
+    };
+
+    for (size_t i = 0; i < nlines_; ++i) {
+        const Line& l = lines_[i];
+        if (l.drop) {
+            emit_span(l.off);
+            span = l.end;
+        } else if (l.append) {
+            emit_span(l.value_end);
+            emit_text(l.append, l.append_len);
+            span = l.value_end;
+        }
+    }
+
+    // Added lines go right before the blank line
+    size_t blank = header_bytes_ - 2;
+    if (nadded_ > 0) {
+        emit_span(blank);
+        for (size_t i = 0; i < nadded_; ++i) {
+            emit_text(added_[i].data, added_[i].len);
+        }
+        span = blank;
+    }
+    emit_span(len);
+    return n;
+}
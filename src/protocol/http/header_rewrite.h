@@ -0,0 +1,139 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <sys/uio.h>
+#include <vector>
+
+/*
+ * HeaderRule
+ * ----------
+ * One configured header edit, compiled when the config is parsed.
+ *
+ *   remove Name            drop every occurrence
+ *   set Name: value        drop every occurrence, then add the line
+ *   add Name: value        add the line, keeping existing ones
+ */
+struct HeaderRule {
+    enum class Op : uint8_t { REMOVE, SET, ADD };
+
+    Op op = Op::REMOVE;
+    std::string name;           // lowercase
+    std::string line;           // "Name: value\r\n" (SET / ADD)
+};
+
+/*
+ * HeaderRules
+ * -----------
+ * Ordered edits for one direction (requests or responses).
+ *
+ * strip_hop_by_hop drops Keep-Alive, Proxy-Connection, Proxy-Authorization,
+ * TE and Trailer. Connection, Upgrade and Transfer-Encoding stay: the
+ * proxy forwards framing and upgrades verbatim.
+ */
+struct HeaderRules {
+    std::vector<HeaderRule> rules;
+    bool strip_hop_by_hop = false;
+
+    bool empty() const { return rules.empty() && !strip_hop_by_hop; }
+
+    // Whether a header called name (lowercase) is dropped
+    bool removes(const std::string& name) const;
+
+    // Lines this rule set adds, for heads built from scratch (HTTP/2)
+    void append_lines(std::string& head) const;
+};
+
+/*
+ * HeaderEditor
+ * ------------
+ * Applies header edits to an HTTP/1.x head without copying it.
+ *
+ * Core rules:
+ * - parse() only indexes line offsets; edits only mark lines dropped or
+ *   queue text, and build() emits iovecs over the untouched original
+ *   bytes with the queued text in between, ready for writev()
+ * - Added lines point at rule text owned by the config snapshot; the
+ *   few per-request strings (forwarding values) live in a fixed arena
+ *   inside the editor. Nothing is heap-allocated
+ * - Fixed capacity: a head with more than kMaxLines lines, or edits
+ *   beyond kMaxAdded / kArenaBytes, fail rather than go unapplied
+ * - Keep the editor and the rules alive until the write has completed
+ *
+ * Non-responsibilities:
+ * - Validating the head (the parser already framed it)
+ * - Socket I/O and partial writes
+ */
+class HeaderEditor {
+public:
+    static constexpr size_t kMaxLines = 128;
+    static constexpr size_t kMaxAdded = 16;
+    static constexpr size_t kArenaBytes = 512;
+    static constexpr size_t kMaxIov = 2 * kMaxLines + kMaxAdded + 2;
+
+    HeaderEditor() = default;
+
+    HeaderEditor(const HeaderEditor&) = delete;
+    HeaderEditor& operator=(const HeaderEditor&) = delete;
+
+    // Index data[0, header_bytes), which ends in "\r\n\r\n" and starts
+    // with a request or status line. False if the head has too many lines.
+    bool parse(const char* data, size_t header_bytes);
+
+    void apply(const HeaderRules& rules);
+
+    // Drop every occurrence of name (case-insensitive)
+    void remove(const char* name);
+
+    // Add a complete "Name: value\r\n" line before the blank line;
+    // text is referenced, not copied
+    void add(const char* text, size_t len);
+
+    // Append ", value" to the last occurrence of name, or add
+    // "name: value\r\n" if there is none; value is the concatenation of
+    // parts, copied into the arena
+    void append_value(const char* name, std::initializer_list<std::string_view> parts);
+
+    // False once an edit did not fit; build() then emits nothing
+    bool ok() const { return ok_; }
+
+    // Fill iov (kMaxIov entries) for the whole message data[0, len),
+    // len >= header_bytes. Returns the number of iovecs, 0 if !ok().
+    size_t build(size_t len, iovec* iov) const;
+
+private:
+    struct Line {
+        uint32_t off;           // first byte of the line
+        uint32_t value_end;     // before its CRLF
+        uint32_t end;           // past its CRLF
+        uint16_t name_len;      // 0 when the line has no colon
+        bool drop;
+        const char* append;     // text to insert at value_end
+        uint32_t append_len;
+    };
+
+    struct Text {
+        const char* data;
+        size_t len;
+    };
+
+    bool matches(const Line& l, const char* name, size_t name_len) const;
+    char* alloc(size_t n);
+
+    const char* data_{nullptr};
+    size_t header_bytes_{0};
+
+    Line lines_[kMaxLines];
+    size_t nlines_{0};
+
+    Text added_[kMaxAdded];
+    size_t nadded_{0};
+
+    char arena_[kArenaBytes];
+    size_t arena_used_{0};
+
+    bool ok_{true};
+};
@@ -1,7 +1,8 @@
 #include "http_parser.h"
 
-#include <cstring>
 #include <cctype>
+#include <cstdint>
+#include <cstring>
 
 /*
  * Look for "\r\n\r\n"
@@ -29,13 +30,22 @@ bool HttpParser::find_header_end(
 
 /*
  * Extract Content-Length header (if present)
+ *
+ * Identical duplicates are tolerated (RFC 9110 8.6); anything a
+ * downstream parser might read differently is an error.
  */
 bool HttpParser::parse_content_length(
     const char* headers,
     size_t header_len,
-    size_t& content_length
+    size_t& content_length,
+    bool& present
 ) {
+    static const char kKey[] = "Content-Length";
+    const size_t key_len = sizeof(kKey) - 1;
+
     content_length = 0;
+    present = false;
+    bool seen = false;
 
     const char* p = headers;
     const char* end = headers + header_len;
@@ -48,25 +58,137 @@ bool HttpParser::parse_content_length(
             break;
         }
 
-        // Case-insensitive compare for "Content-Length:"
-        const char* key = "Content-Length:";
-        size_t key_len = std::strlen(key);
-
-        if (static_cast<size_t>(line_end - p) >= key_len &&
-            strncasecmp(p, key, key_len) == 0) {
+        if (static_cast<size_t>(line_end - p) > key_len &&
+            strncasecmp(p, kKey, key_len) == 0) {
 
             const char* value = p + key_len;
-            while (value < line_end && std::isspace(*value)) {
+
+            // "Content-Length :" would be ignored here but honoured by
+            // a lenient upstream
+            if (*value == ' ' || *value == '\t') {
+                present = true;
+                return false;
+            }
+            if (*value != ':') {
+                p = line_end + 1;
+                continue;
+            }
+            ++value;
+            present = true;
+
+            const char* v_end = line_end;
+            while (value < v_end && (*value == ' ' || *value == '\t')) {
                 ++value;
             }
+            while (v_end > value && std::isspace(static_cast<unsigned char>(v_end[-1]))) {
+                --v_end;
+            }
+            if (value == v_end) {
+                return false;
+            }
 
             size_t len = 0;
-            while (value < line_end && std::isdigit(*value)) {
-                len = len * 10 + (*value - '0');
-                ++value;
+            for (; value < v_end; ++value) {
+                if (*value < '0' || *value > '9') {
+                    return false;
+                }
+                size_t digit = static_cast<size_t>(*value - '0');
+                if (len > (SIZE_MAX - digit) / 10) {
+                    return false;
+                }
+                len = len * 10 + digit;
             }
 
+            if (seen && len != content_length) {
+                return false;
+            }
             content_length = len;
+            seen = true;
+        }
+
+        p = line_end + 1;
+    }
+
+    return true;
+}
+
+/*
+ * Detect Transfer-Encoding
+ *
+ * The name is matched up to optional whitespace and the colon, so the
+ * variants some servers tolerate cannot slip past as unknown headers.
+ */
+bool HttpParser::has_transfer_encoding(
+    const char* headers,
+    size_t header_len
+) {
+    static const char kKey[] = "Transfer-Encoding";
+    const size_t key_len = sizeof(kKey) - 1;
+
+    const char* p = headers;
+    const char* end = headers + header_len;
+
+    while (p < end) {
+        const char* line_end = static_cast<const char*>(
+            std::memchr(p, '\n', end - p)
+        );
+        if (!line_end) {
+            break;
+        }
+
+        if (static_cast<size_t>(line_end - p) > key_len &&
+            strncasecmp(p, kKey, key_len) == 0) {
+            const char* c = p + key_len;
+            while (c < line_end && (*c == ' ' || *c == '\t')) {
+                ++c;
+            }
+            if (c < line_end && *c == ':') {
+                return true;
+            }
+        }
+
+        p = line_end + 1;
+    }
+
+    return false;
+}
+
+/*
+ * Generic header lookup (first occurrence wins)
+ */
+bool HttpParser::find_header(
+    const char* headers,
+    size_t header_len,
+    const char* name,
+    std::pmr::string& value
+) {
+    size_t name_len = std::strlen(name);
+
+    const char* p = headers;
+    const char* end = headers + header_len;
+
+    while (p < end) {
+        const char* line_end = static_cast<const char*>(
+            std::memchr(p, '\n', end - p)
+        );
+        if (!line_end) {
+            break;
+        }
+
+        if (static_cast<size_t>(line_end - p) > name_len &&
+            strncasecmp(p, name, name_len) == 0 &&
+            p[name_len] == ':') {
+
+            const char* v = p + name_len + 1;
+            const char* v_end = line_end;
+            while (v < v_end && std::isspace(static_cast<unsigned char>(*v))) {
+                ++v;
+            }
+            while (v_end > v && std::isspace(static_cast<unsigned char>(v_end[-1]))) {
+                --v_end;
+            }
+
+            value.assign(v, v_end);
             return true;
         }
 
@@ -76,6 +198,35 @@ bool HttpParser::parse_content_length(
     return false;
 }
 
+/*
+ * "GET /path HTTP/1.1" -> ("GET", "/path")
+ */
+bool HttpParser::parse_request_line(
+    const char* data,
+    size_t len,
+    std::pmr::string& method,
+    std::pmr::string& target
+) {
+    const char* end = static_cast<const char*>(std::memchr(data, '\n', len));
+    if (!end) {
+        return false;
+    }
+
+    const char* sp1 = static_cast<const char*>(std::memchr(data, ' ', end - data));
+    if (!sp1 || sp1 == data) {
+        return false;
+    }
+
+    const char* sp2 = static_cast<const char*>(std::memchr(sp1 + 1, ' ', end - sp1 - 1));
+    if (!sp2 || sp2 == sp1 + 1) {
+        return false;
+    }
+
+    method.assign(data, sp1);
+    target.assign(sp1 + 1, sp2);
+    return true;
+}
+
 HttpParseResult HttpParser::parse(
     const char* data,
     size_t len,
@@ -88,13 +239,25 @@ HttpParseResult HttpParser::parse(
     }
 
     out.header_bytes = header_end;
+    out.unsupported_encoding = false;
 
     size_t content_length = 0;
-    parse_content_length(data, header_end, content_length);
+    bool has_length = false;
+    bool length_ok = parse_content_length(data, header_end, content_length, has_length);
+
+    if (has_transfer_encoding(data, header_end)) {
+        // Alone it frames a body this parser cannot (chunked); next to
+        // Content-Length the request is ambiguous
+        out.unsupported_encoding = !has_length;
+        return HttpParseResult::ERROR;
+    }
+    if (!length_ok) {
+        return HttpParseResult::ERROR;
+    }
     out.body_bytes = content_length;
 
-    // Check if full body is present
-    if (len < header_end + content_length) {
+    // Check if full body is present (written so a huge length cannot wrap)
+    if (len - header_end < content_length) {
         return HttpParseResult::INCOMPLETE;
     }
 
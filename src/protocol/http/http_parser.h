@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstddef>
+#include <memory_resource>
 #include <string>
 
 /*
@@ -24,6 +25,11 @@ enum class HttpParseResult {
 struct HttpRequestInfo {
     size_t header_bytes = 0;      // Bytes covering headers (\r\n\r\n included)
     size_t body_bytes = 0;        // Expected body length (Content-Length)
+
+    // Set with ERROR when Transfer-Encoding alone framed the body: valid
+    // HTTP this parser does not implement (501), not a malformed or
+    // conflicting request (400)
+    bool unsupported_encoding = false;
 };
 
 /*
@@ -35,6 +41,11 @@ struct HttpRequestInfo {
  * - Detect end of headers
  * - Extract Content-Length if present
  * - Decide when request is complete
+ * - Reject framing that peers could disagree on: malformed or
+ *   overflowing Content-Length, conflicting duplicates, whitespace
+ *   before the colon, and any Transfer-Encoding (bodies are only ever
+ *   framed by Content-Length here; with both present, an upstream
+ *   honouring TE would see a different request boundary)
  *
  * Non-responsibilities:
  * - Socket I/O
@@ -53,6 +64,25 @@ public:
         HttpRequestInfo& out
     );
 
+    // Copy the value of the first header called name (case-insensitive,
+    // name without the colon); headers must cover the request head.
+    // Outputs are pmr strings so a caller can point them at a per-request
+    // Arena (see core/memory/arena.h)
+    static bool find_header(
+        const char* headers,
+        size_t header_len,
+        const char* name,
+        std::pmr::string& value
+    );
+
+    // Split the request line into method and request-target
+    static bool parse_request_line(
+        const char* data,
+        size_t len,
+        std::pmr::string& method,
+        std::pmr::string& target
+    );
+
 private:
     // Helper: find end of headers
     static bool find_header_end(
@@ -61,10 +91,19 @@ private:
         size_t& header_end
     );
 
-    // Helper: extract Content-Length
+    // Helper: a Transfer-Encoding header (any spelling a lenient peer
+    // would accept, "Transfer-Encoding :" included) is present
+    static bool has_transfer_encoding(
+        const char* headers,
+        size_t header_len
+    );
+
+    // Helper: extract Content-Length (0 when absent; present tells)
+    // Returns false if the header is present but unusable
     static bool parse_content_length(
         const char* headers,
         size_t header_len,
-        size_t& content_length
+        size_t& content_length,
+        bool& present
     );
 };
@@ -0,0 +1,238 @@
+#include "http_response_parser.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <strings.h>
+
+namespace {
+
+const char* find_crlf(const char* p, const char* end) {
+    while (p + 1 < end) {
+        const char* cr = static_cast<const char*>(std::memchr(p, '\r', end - p - 1));
+        if (!cr) {
+            return nullptr;
+        }
+        if (cr[1] == '\n') {
+            return cr;
+        }
+        p = cr + 1;
+    }
+    return nullptr;
+}
+
+std::string trim(const char* b, const char* e) {
+    while (b < e && (*b == ' ' || *b == '\t')) {
+        ++b;
+    }
+    while (e > b && (e[-1] == ' ' || e[-1] == '\t')) {
+        --e;
+    }
+    return std::string(b, e);
+}
+
+} // namespace
+
+void HttpResponseParser::reset() {
+    state_ = State::HEAD;
+    body_mode_ = BodyMode::NONE;
+    head_request_ = false;
+    keep_alive_ = false;
+    status_ = 0;
+    headers_.clear();
+    remaining_ = 0;
+}
+
+ssize_t HttpResponseParser::parse_head(const char* data, size_t len) {
+    const char* end = data + len;
+    const char* line_end = find_crlf(data, end);
+    if (!line_end) {
+        return 0;
+    }
+
+    // Find end of header block first so the head is parsed in one pass
+    const char* p = data;
+    const char* head_end = nullptr;
+    while (const char* e = find_crlf(p, end)) {
+        if (e == p) {
+            head_end = e + 2;
+            break;
+        }
+        p = e + 2;
+    }
+    if (!head_end) {
+        return 0;
+    }
+
+    // Status line: HTTP/1.x SP 3DIGIT ...
+    if (line_end - data < 12 || std::strncmp(data, "HTTP/1.", 7) != 0 ||
+        !std::isdigit(static_cast<unsigned char>(data[9])) ||
+        !std::isdigit(static_cast<unsigned char>(data[10])) ||
+        !std::isdigit(static_cast<unsigned char>(data[11]))) {
+        return -1;
+    }
+    bool http11 = data[7] == '1';
+    status_ = (data[9] - '0') * 100 + (data[10] - '0') * 10 + (data[11] - '0');
+
+    headers_.clear();
+    keep_alive_ = http11;
+    bool chunked = false;
+    bool have_length = false;
+    size_t content_length = 0;
+
+    p = line_end + 2;
+    while (p < head_end - 2) {
+        const char* e = find_crlf(p, head_end);
+        const char* colon = static_cast<const char*>(std::memchr(p, ':', e - p));
+        if (!colon || colon == p) {
+            return -1;
+        }
+
+        std::string name(p, colon);
+        std::transform(name.begin(), name.end(), name.begin(),
+                       [](unsigned char c) { return std::tolower(c); });
+        std::string value = trim(colon + 1, e);
+
+        if (name == "content-length") {
+            char* num_end = nullptr;
+            errno = 0;
+            unsigned long long n = std::strtoull(value.c_str(), &num_end, 10);
+            if (value.empty() || errno != 0 || *num_end != '\0' ||
+                (have_length && n != content_length)) {
+                return -1;
+            }
+            have_length = true;
+            content_length = n;
+        } else if (name == "transfer-encoding") {
+            chunked = strcasestr(value.c_str(), "chunked") != nullptr;
+        } else if (name == "connection") {
+            if (strcasestr(value.c_str(), "close")) {
+                keep_alive_ = false;
+            } else if (strcasestr(value.c_str(), "keep-alive")) {
+                keep_alive_ = true;
+            }
+        }
+
+        headers_.emplace_back(std::move(name), std::move(value));
+        p = e + 2;
+    }
+
+    ssize_t consumed = head_end - data;
+
+    if (status_ >= 100 && status_ < 200) {
+        // Interim response, the final one follows
+        headers_.clear();
+        return consumed;
+    }
+
+    if (head_request_ || status_ == 204 || status_ == 304) {
+        body_mode_ = BodyMode::NONE;
+        state_ = State::DONE;
+    } else if (chunked) {
+        body_mode_ = BodyMode::CHUNKED;
+        state_ = State::CHUNK_SIZE;
+    } else if (have_length) {
+        body_mode_ = BodyMode::LENGTH;
+        remaining_ = content_length;
+        state_ = remaining_ ? State::BODY : State::DONE;
+    } else {
+        body_mode_ = BodyMode::UNTIL_CLOSE;
+        state_ = State::BODY;
+    }
+    return consumed;
+}
+
+ssize_t HttpResponseParser::feed(const char* data, size_t len, std::string& body_out) {
+    size_t pos = 0;
+
+    while (pos < len && state_ != State::DONE) {
+        const char* p = data + pos;
+        size_t left = len - pos;
+
+        switch (state_) {
+        case State::HEAD: {
+            ssize_t n = parse_head(p, left);
+            if (n <= 0) {
+                return n < 0 ? -1 : static_cast<ssize_t>(pos);
+            }
+            pos += n;
+            break;
+        }
+        case State::BODY: {
+            size_t n = left;
+            if (body_mode_ == BodyMode::LENGTH) {
+                n = std::min(left, remaining_);
+                remaining_ -= n;
+                if (remaining_ == 0) {
+                    state_ = State::DONE;
+                }
+            }
+            body_out.append(p, n);
+            pos += n;
+            break;
+        }
+        case State::CHUNK_SIZE: {
+            const char* e = find_crlf(p, p + left);
+            if (!e) {
+                return static_cast<ssize_t>(pos);
+            }
+            char* num_end = nullptr;
+            errno = 0;
+            unsigned long long n = std::strtoull(p, &num_end, 16);
+            if (num_end == p || errno != 0 || (num_end < e && *num_end != ';' &&
+                                               *num_end != ' ')) {
+                return -1;
+            }
+            remaining_ = n;
+            state_ = n ? State::CHUNK_DATA : State::TRAILERS;
+            pos += e - p + 2;
+            break;
+        }
+        case State::CHUNK_DATA: {
+            size_t n = std::min(left, remaining_);
+            body_out.append(p, n);
+            remaining_ -= n;
+            pos += n;
+            if (remaining_ == 0) {
+                state_ = State::CHUNK_CRLF;
+            }
+            break;
+        }
+        case State::CHUNK_CRLF:
+            if (left < 2) {
+                return static_cast<ssize_t>(pos);
+            }
+            if (p[0] != '\r' || p[1] != '\n') {
+                return -1;
+            }
+            pos += 2;
+            state_ = State::CHUNK_SIZE;
+            break;
+        case State::TRAILERS: {
+            const char* e = find_crlf(p, p + left);
+            if (!e) {
+                return static_cast<ssize_t>(pos);
+            }
+            if (e == p) {
+                state_ = State::DONE;
+            }
+            pos += e - p + 2;
+            break;
+        }
+        case State::DONE:
+            break;
+        }
+    }
+
+    return static_cast<ssize_t>(pos);
+}
+
+bool HttpResponseParser::on_eof() {
+    if (state_ == State::BODY && body_mode_ == BodyMode::UNTIL_CLOSE) {
+        state_ = State::DONE;
+        return true;
+    }
+    return state_ == State::DONE;
+}
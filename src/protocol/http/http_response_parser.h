@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+#include <sys/types.h>
+
+using HttpHeaders = std::vector<std::pair<std::string, std::string>>;
+
+/*
+ * HttpResponseParser
+ * ------------------
+ * Incremental HTTP/1.x response parser for upstream connections.
+ *
+ * Responsibilities:
+ * - Parse status line and headers
+ * - Decide body framing (none / Content-Length / chunked / until close)
+ * - De-chunk the body
+ * - Report whether the connection may be reused
+ *
+ * Non-responsibilities:
+ * - Socket I/O
+ * - Header normalization beyond lowercasing names
+ *
+ * Interim 1xx responses are skipped.
+ */
+class HttpResponseParser {
+public:
+    HttpResponseParser() = default;
+
+    // Responses to HEAD never carry a body
+    void set_head_request(bool head) { head_request_ = head; }
+
+    // Parse bytes; body bytes are appended to body_out
+    // Returns bytes consumed or -1 on malformed input
+    ssize_t feed(const char* data, size_t len, std::string& body_out);
+
+    // Upstream closed the connection; completes close-delimited bodies
+    // Returns false if the response was truncated
+    bool on_eof();
+
+    bool head_complete() const { return state_ > State::HEAD; }
+    bool done() const { return state_ == State::DONE; }
+
+    int status() const { return status_; }
+    const HttpHeaders& headers() const { return headers_; }
+    bool keep_alive() const { return keep_alive_ && body_mode_ != BodyMode::UNTIL_CLOSE; }
+
+    void reset();
+
+private:
+    enum class State { HEAD, BODY, CHUNK_SIZE, CHUNK_DATA, CHUNK_CRLF, TRAILERS, DONE };
+    enum class BodyMode { NONE, LENGTH, CHUNKED, UNTIL_CLOSE };
+
+    ssize_t parse_head(const char* data, size_t len);
+
+    State state_{State::HEAD};
+    BodyMode body_mode_{BodyMode::NONE};
+    bool head_request_{false};
+    bool keep_alive_{false};
+    int status_{0};
+    HttpHeaders headers_;
+    size_t remaining_{0};
+};
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/*
+ * HTTP/2 framing constants and frame header codec (RFC 9113, section 4).
+ */
+namespace h2 {
+
+constexpr char kPreface[] = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+constexpr size_t kPrefaceLen = sizeof(kPreface) - 1;
+
+constexpr size_t kFrameHeaderLen = 9;
+constexpr uint32_t kDefaultMaxFrameSize = 16384;
+constexpr int32_t kDefaultWindow = 65535;
+constexpr int64_t kMaxWindow = 0x7fffffff;
+
+enum class FrameType : uint8_t {
+    DATA = 0x0,
+    HEADERS = 0x1,
+    PRIORITY = 0x2,
+    RST_STREAM = 0x3,
+    SETTINGS = 0x4,
+    PUSH_PROMISE = 0x5,
+    PING = 0x6,
+    GOAWAY = 0x7,
+    WINDOW_UPDATE = 0x8,
+    CONTINUATION = 0x9
+};
+
+namespace flags {
+constexpr uint8_t END_STREAM = 0x1;
+constexpr uint8_t ACK = 0x1;
+constexpr uint8_t END_HEADERS = 0x4;
+constexpr uint8_t PADDED = 0x8;
+constexpr uint8_t PRIORITY = 0x20;
+}
+
+enum class Setting : uint16_t {
+    HEADER_TABLE_SIZE = 0x1,
+    ENABLE_PUSH = 0x2,
+    MAX_CONCURRENT_STREAMS = 0x3,
+    INITIAL_WINDOW_SIZE = 0x4,
+    MAX_FRAME_SIZE = 0x5,
+    MAX_HEADER_LIST_SIZE = 0x6
+};
+
+enum class ErrorCode : uint32_t {
+    NO_ERROR = 0x0,
+    PROTOCOL_ERROR = 0x1,
+    INTERNAL_ERROR = 0x2,
+    FLOW_CONTROL_ERROR = 0x3,
+    STREAM_CLOSED = 0x5,
+    FRAME_SIZE_ERROR = 0x6,
+    REFUSED_STREAM = 0x7,
+    CANCEL = 0x8,
+    COMPRESSION_ERROR = 0x9,
+    ENHANCE_YOUR_CALM = 0xb
+};
+
+struct FrameHeader {
+    uint32_t length = 0;
+    FrameType type = FrameType::DATA;
+    uint8_t flags = 0;
+    uint32_t stream_id = 0;
+};
+
+inline uint32_t read_u32(const uint8_t* p) {
+    return (static_cast<uint32_t>(p[0]) << 24) |
+           (static_cast<uint32_t>(p[1]) << 16) |
+           (static_cast<uint32_t>(p[2]) << 8) |
+           static_cast<uint32_t>(p[3]);
+}
+
+inline FrameHeader parse_header(const uint8_t* p) {
+    FrameHeader h;
+    h.length = (static_cast<uint32_t>(p[0]) << 16) |
+               (static_cast<uint32_t>(p[1]) << 8) |
+               static_cast<uint32_t>(p[2]);
+    h.type = static_cast<FrameType>(p[3]);
+    h.flags = p[4];
+    h.stream_id = read_u32(p + 5) & 0x7fffffff;
+    return h;
+}
+
+inline void append_u32(std::string& out, uint32_t v) {
+    out.push_back(static_cast<char>(v >> 24));
+    out.push_back(static_cast<char>((v >> 16) & 0xff));
+    out.push_back(static_cast<char>((v >> 8) & 0xff));
+    out.push_back(static_cast<char>(v & 0xff));
+}
+
+inline void append_header(std::string& out, uint32_t length, FrameType type,
+                          uint8_t flags, uint32_t stream_id) {
+    out.push_back(static_cast<char>((length >> 16) & 0xff));
+    out.push_back(static_cast<char>((length >> 8) & 0xff));
+    out.push_back(static_cast<char>(length & 0xff));
+    out.push_back(static_cast<char>(type));
+    out.push_back(static_cast<char>(flags));
+    append_u32(out, stream_id & 0x7fffffff);
+}
+
+} // namespace h2
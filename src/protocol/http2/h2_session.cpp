@@ -0,0 +1,626 @@
+#include "h2_session.h"
+
+#include <algorithm>
+#include <cstring>
+
+using h2::ErrorCode;
+using h2::FrameHeader;
+using h2::FrameType;
+
+namespace {
+
+// Replenish receive windows once this much has been consumed
+constexpr uint32_t kWindowUpdateThreshold = h2::kDefaultWindow / 2;
+
+// Upper bound on an accumulated (HEADERS + CONTINUATION) block
+constexpr size_t kMaxHeaderBlock = 64 * 1024;
+
+} // namespace
+
+H2Session::H2Session(size_t max_body, size_t max_buffered)
+    : decoder_(4096, kMaxHeaderListSize),
+      max_body_(max_body),
+      max_buffered_(max_buffered) {}
+
+void H2Session::set_callbacks(RequestCallback on_request, ResetCallback on_reset) {
+    on_request_ = std::move(on_request);
+    on_reset_ = std::move(on_reset);
+}
+
+void H2Session::emit(const std::string& frame) {
+    output_.append(frame.data(), frame.size());
+}
+
+void H2Session::start() {
+    scratch_.clear();
+    h2::append_header(scratch_, 18, FrameType::SETTINGS, 0, 0);
+    scratch_.push_back(0);
+    scratch_.push_back(static_cast<char>(h2::Setting::MAX_CONCURRENT_STREAMS));
+    h2::append_u32(scratch_, kMaxConcurrentStreams);
+    scratch_.push_back(0);
+    scratch_.push_back(static_cast<char>(h2::Setting::ENABLE_PUSH));
+    h2::append_u32(scratch_, 0);
+    scratch_.push_back(0);
+    scratch_.push_back(static_cast<char>(h2::Setting::MAX_HEADER_LIST_SIZE));
+    h2::append_u32(scratch_, kMaxHeaderListSize);
+    emit(scratch_);
+}
+
+bool H2Session::fail(ErrorCode code) {
+    goaway(code);
+    return false;
+}
+
+void H2Session::goaway(ErrorCode code) {
+    if (goaway_sent_) {
+        return;
+    }
+    goaway_sent_ = true;
+
+    scratch_.clear();
+    h2::append_header(scratch_, 8, FrameType::GOAWAY, 0, 0);
+    h2::append_u32(scratch_, last_stream_id_);
+    h2::append_u32(scratch_, static_cast<uint32_t>(code));
+    emit(scratch_);
+}
+
+bool H2Session::finished() const {
+    return (goaway_sent_ || goaway_received_) && streams_.empty();
+}
+
+ssize_t H2Session::feed(const char* data, size_t len) {
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(data);
+    size_t consumed = 0;
+
+    if (!preface_received_) {
+        size_t n = std::min(len, h2::kPrefaceLen);
+        if (std::memcmp(data, h2::kPreface, n) != 0) {
+            fail(ErrorCode::PROTOCOL_ERROR);
+            return -1;
+        }
+        if (len < h2::kPrefaceLen) {
+            return 0;
+        }
+        preface_received_ = true;
+        consumed = h2::kPrefaceLen;
+    }
+
+    while (len - consumed >= h2::kFrameHeaderLen) {
+        FrameHeader h = h2::parse_header(p + consumed);
+
+        if (h.length > h2::kDefaultMaxFrameSize) {
+            fail(ErrorCode::FRAME_SIZE_ERROR);
+            return -1;
+        }
+        if (len - consumed < h2::kFrameHeaderLen + h.length) {
+            break;
+        }
+
+        if (!process_frame(h, p + consumed + h2::kFrameHeaderLen)) {
+            return -1;
+        }
+        consumed += h2::kFrameHeaderLen + h.length;
+    }
+
+    flush_data();
+    return static_cast<ssize_t>(consumed);
+}
+
+bool H2Session::process_frame(const FrameHeader& h, const uint8_t* payload) {
+    // Nothing may interleave with a header block
+    if (continuation_stream_ && h.type != FrameType::CONTINUATION) {
+        return fail(ErrorCode::PROTOCOL_ERROR);
+    }
+
+    switch (h.type) {
+    case FrameType::DATA:
+        return on_data(h, payload);
+    case FrameType::HEADERS:
+        return on_headers(h, payload);
+    case FrameType::CONTINUATION:
+        return on_continuation(h, payload);
+    case FrameType::SETTINGS:
+        return on_settings(h, payload);
+    case FrameType::WINDOW_UPDATE:
+        return on_window_update(h, payload);
+    case FrameType::RST_STREAM:
+        return on_rst_stream(h, payload);
+    case FrameType::PING:
+        return on_ping(h, payload);
+    case FrameType::GOAWAY:
+        if (h.stream_id != 0 || h.length < 8) {
+            return fail(ErrorCode::PROTOCOL_ERROR);
+        }
+        goaway_received_ = true;
+        return true;
+    case FrameType::PRIORITY:
+        if (h.stream_id == 0 || h.length != 5) {
+            return fail(ErrorCode::PROTOCOL_ERROR);
+        }
+        return true;
+    case FrameType::PUSH_PROMISE:
+        // Clients never push
+        return fail(ErrorCode::PROTOCOL_ERROR);
+    }
+
+    // Unknown frame types are ignored (section 5.5)
+    return true;
+}
+
+bool H2Session::on_headers(const FrameHeader& h, const uint8_t* payload) {
+    if (h.stream_id == 0 || (h.stream_id & 1) == 0) {
+        return fail(ErrorCode::PROTOCOL_ERROR);
+    }
+
+    size_t off = 0;
+    size_t pad = 0;
+    if (h.flags & h2::flags::PADDED) {
+        if (h.length < 1) {
+            return fail(ErrorCode::FRAME_SIZE_ERROR);
+        }
+        pad = payload[0];
+        off = 1;
+    }
+    if (h.flags & h2::flags::PRIORITY) {
+        off += 5;
+    }
+    if (off + pad > h.length) {
+        return fail(ErrorCode::PROTOCOL_ERROR);
+    }
+
+    auto it = streams_.find(h.stream_id);
+    if (it == streams_.end()) {
+        if (h.stream_id <= last_stream_id_) {
+            return fail(ErrorCode::STREAM_CLOSED);
+        }
+        last_stream_id_ = h.stream_id;
+
+        Stream& s = streams_[h.stream_id];
+        s.send_window = peer_initial_window_;
+        s.req.stream_id = h.stream_id;
+        s.refused = goaway_sent_ || streams_.size() > kMaxConcurrentStreams;
+    } else if (it->second.state != StreamState::OPEN) {
+        return fail(ErrorCode::STREAM_CLOSED);
+    } else if (!(h.flags & h2::flags::END_STREAM)) {
+        // Trailers must end the stream
+        return fail(ErrorCode::PROTOCOL_ERROR);
+    }
+
+    header_block_.assign(reinterpret_cast<const char*>(payload + off),
+                         h.length - off - pad);
+
+    if (!(h.flags & h2::flags::END_HEADERS)) {
+        continuation_stream_ = h.stream_id;
+        continuation_end_stream_ = h.flags & h2::flags::END_STREAM;
+        return true;
+    }
+
+    return finish_header_block(h.stream_id, h.flags & h2::flags::END_STREAM);
+}
+
+bool H2Session::on_continuation(const FrameHeader& h, const uint8_t* payload) {
+    if (h.stream_id == 0 || h.stream_id != continuation_stream_) {
+        return fail(ErrorCode::PROTOCOL_ERROR);
+    }
+    if (header_block_.size() + h.length > kMaxHeaderBlock) {
+        return fail(ErrorCode::ENHANCE_YOUR_CALM);
+    }
+
+    header_block_.append(reinterpret_cast<const char*>(payload), h.length);
+
+    if (!(h.flags & h2::flags::END_HEADERS)) {
+        return true;
+    }
+
+    continuation_stream_ = 0;
+    return finish_header_block(h.stream_id, continuation_end_stream_);
+}
+
+bool H2Session::finish_header_block(uint32_t stream_id, bool end_stream) {
+    Stream& s = streams_[stream_id];
+
+    // Always decode: the dynamic table must stay in sync even for
+    // streams we are about to refuse
+    HeaderList fields;
+    if (!decoder_.decode(reinterpret_cast<const uint8_t*>(header_block_.data()),
+                         header_block_.size(), fields)) {
+        return fail(decoder_.list_too_large() ? ErrorCode::ENHANCE_YOUR_CALM
+                                              : ErrorCode::COMPRESSION_ERROR);
+    }
+    header_block_.clear();
+
+    if (s.refused) {
+        reset_stream(stream_id, ErrorCode::REFUSED_STREAM);
+        return true;
+    }
+
+    // Trailers: nothing to forward over HTTP/1.1 without chunking
+    bool trailers = !s.req.method.empty();
+    if (!trailers) {
+        for (HeaderField& f : fields) {
+            if (f.first == ":method") {
+                s.req.method = std::move(f.second);
+            } else if (f.first == ":scheme") {
+                s.req.scheme = std::move(f.second);
+            } else if (f.first == ":authority") {
+                s.req.authority = std::move(f.second);
+            } else if (f.first == ":path") {
+                s.req.path = std::move(f.second);
+            } else if (!f.first.empty() && f.first[0] == ':') {
+                reset_stream(stream_id, ErrorCode::PROTOCOL_ERROR);
+                return true;
+            } else {
+                s.req.headers.push_back(std::move(f));
+            }
+        }
+
+        if (s.req.method.empty() || s.req.path.empty()) {
+            reset_stream(stream_id, ErrorCode::PROTOCOL_ERROR);
+            return true;
+        }
+    }
+
+    if (end_stream) {
+        deliver(stream_id);
+    }
+    return true;
+}
+
+bool H2Session::on_data(const FrameHeader& h, const uint8_t* payload) {
+    if (h.stream_id == 0) {
+        return fail(ErrorCode::PROTOCOL_ERROR);
+    }
+
+    // Flow control covers the whole payload, padding included
+    conn_recv_window_ -= h.length;
+    conn_recv_unacked_ += h.length;
+    if (conn_recv_window_ < 0) {
+        return fail(ErrorCode::FLOW_CONTROL_ERROR);
+    }
+    if (conn_recv_unacked_ >= kWindowUpdateThreshold) {
+        scratch_.clear();
+        h2::append_header(scratch_, 4, FrameType::WINDOW_UPDATE, 0, 0);
+        h2::append_u32(scratch_, conn_recv_unacked_);
+        emit(scratch_);
+        conn_recv_window_ += conn_recv_unacked_;
+        conn_recv_unacked_ = 0;
+    }
+
+    auto it = streams_.find(h.stream_id);
+    if (it == streams_.end()) {
+        if (h.stream_id > last_stream_id_) {
+            return fail(ErrorCode::PROTOCOL_ERROR);
+        }
+        // Already reset or finished on our side
+        return true;
+    }
+
+    Stream& s = it->second;
+    if (s.state != StreamState::OPEN) {
+        reset_stream(h.stream_id, ErrorCode::STREAM_CLOSED);
+        return true;
+    }
+
+    size_t off = 0;
+    size_t pad = 0;
+    if (h.flags & h2::flags::PADDED) {
+        if (h.length < 1) {
+            return fail(ErrorCode::FRAME_SIZE_ERROR);
+        }
+        pad = payload[0];
+        off = 1;
+    }
+    if (off + pad > h.length) {
+        return fail(ErrorCode::PROTOCOL_ERROR);
+    }
+
+    s.recv_window -= h.length;
+    if (s.recv_window < 0) {
+        reset_stream(h.stream_id, ErrorCode::FLOW_CONTROL_ERROR);
+        return true;
+    }
+
+    size_t n = h.length - off - pad;
+    if (s.req.body.size() + n > max_body_) {
+        reset_stream(h.stream_id, ErrorCode::ENHANCE_YOUR_CALM);
+        return true;
+    }
+    if (buffered_body_ + n > max_buffered_) {
+        reset_stream(h.stream_id, ErrorCode::REFUSED_STREAM);
+        return true;
+    }
+    s.req.body.append(reinterpret_cast<const char*>(payload + off), n);
+    buffered_body_ += n;
+
+    if (h.flags & h2::flags::END_STREAM) {
+        deliver(h.stream_id);
+        return true;
+    }
+
+    s.recv_unacked += h.length;
+    if (s.recv_unacked >= kWindowUpdateThreshold) {
+        scratch_.clear();
+        h2::append_header(scratch_, 4, FrameType::WINDOW_UPDATE, 0, h.stream_id);
+        h2::append_u32(scratch_, s.recv_unacked);
+        emit(scratch_);
+        s.recv_window += s.recv_unacked;
+        s.recv_unacked = 0;
+    }
+    return true;
+}
+
+bool H2Session::on_settings(const FrameHeader& h, const uint8_t* payload) {
+    if (h.stream_id != 0) {
+        return fail(ErrorCode::PROTOCOL_ERROR);
+    }
+    if (h.flags & h2::flags::ACK) {
+        return h.length == 0 || fail(ErrorCode::FRAME_SIZE_ERROR);
+    }
+    if (h.length % 6 != 0) {
+        return fail(ErrorCode::FRAME_SIZE_ERROR);
+    }
+
+    for (size_t off = 0; off < h.length; off += 6) {
+        uint16_t id = static_cast<uint16_t>((payload[off] << 8) | payload[off + 1]);
+        uint32_t value = h2::read_u32(payload + off + 2);
+
+        switch (static_cast<h2::Setting>(id)) {
+        case h2::Setting::INITIAL_WINDOW_SIZE: {
+            if (value > h2::kMaxWindow) {
+                return fail(ErrorCode::FLOW_CONTROL_ERROR);
+            }
+            int64_t delta = static_cast<int64_t>(value) - peer_initial_window_;
+            peer_initial_window_ = value;
+            for (auto& kv : streams_) {
+                kv.second.send_window += delta;
+                if (kv.second.send_window > h2::kMaxWindow) {
+                    return fail(ErrorCode::FLOW_CONTROL_ERROR);
+                }
+            }
+            break;
+        }
+        case h2::Setting::MAX_FRAME_SIZE:
+            if (value < h2::kDefaultMaxFrameSize || value > 0xffffff) {
+                return fail(ErrorCode::PROTOCOL_ERROR);
+            }
+            peer_max_frame_ = value;
+            break;
+        case h2::Setting::ENABLE_PUSH:
+            if (value > 1) {
+                return fail(ErrorCode::PROTOCOL_ERROR);
+            }
+            break;
+        default:
+            // HEADER_TABLE_SIZE needs no action: our encoder never indexes
+            break;
+        }
+    }
+
+    scratch_.clear();
+    h2::append_header(scratch_, 0, FrameType::SETTINGS, h2::flags::ACK, 0);
+    emit(scratch_);
+    return true;
+}
+
+bool H2Session::on_window_update(const FrameHeader& h, const uint8_t* payload) {
+    if (h.length != 4) {
+        return fail(ErrorCode::FRAME_SIZE_ERROR);
+    }
+    uint32_t inc = h2::read_u32(payload) & 0x7fffffff;
+
+    if (h.stream_id == 0) {
+        if (inc == 0) {
+            return fail(ErrorCode::PROTOCOL_ERROR);
+        }
+        conn_send_window_ += inc;
+        if (conn_send_window_ > h2::kMaxWindow) {
+            return fail(ErrorCode::FLOW_CONTROL_ERROR);
+        }
+        return true;
+    }
+
+    auto it = streams_.find(h.stream_id);
+    if (it == streams_.end()) {
+        return true;
+    }
+    if (inc == 0) {
+        reset_stream(h.stream_id, ErrorCode::PROTOCOL_ERROR);
+        return true;
+    }
+    it->second.send_window += inc;
+    if (it->second.send_window > h2::kMaxWindow) {
+        reset_stream(h.stream_id, ErrorCode::FLOW_CONTROL_ERROR);
+    }
+    return true;
+}
+
+bool H2Session::on_rst_stream(const FrameHeader& h, const uint8_t*) {
+    if (h.stream_id == 0) {
+        return fail(ErrorCode::PROTOCOL_ERROR);
+    }
+    if (h.length != 4) {
+        return fail(ErrorCode::FRAME_SIZE_ERROR);
+    }
+    if (h.stream_id > last_stream_id_) {
+        return fail(ErrorCode::PROTOCOL_ERROR);
+    }
+
+    if (streams_.count(h.stream_id)) {
+        close_stream(h.stream_id);
+        if (on_reset_) {
+            on_reset_(h.stream_id);
+        }
+    }
+    return true;
+}
+
+bool H2Session::on_ping(const FrameHeader& h, const uint8_t* payload) {
+    if (h.stream_id != 0) {
+        return fail(ErrorCode::PROTOCOL_ERROR);
+    }
+    if (h.length != 8) {
+        return fail(ErrorCode::FRAME_SIZE_ERROR);
+    }
+    if (h.flags & h2::flags::ACK) {
+        return true;
+    }
+
+    scratch_.clear();
+    h2::append_header(scratch_, 8, FrameType::PING, h2::flags::ACK, 0);
+    scratch_.append(reinterpret_cast<const char*>(payload), 8);
+    emit(scratch_);
+    return true;
+}
+
+void H2Session::deliver(uint32_t stream_id) {
+    Stream& s = streams_[stream_id];
+    s.state = StreamState::HALF_CLOSED_REMOTE;
+    buffered_body_ -= s.req.body.size();
+    if (on_request_) {
+        on_request_(s.req);
+    }
+
+    // The callback has taken its copy (and may have closed the stream)
+    auto it = streams_.find(stream_id);
+    if (it != streams_.end()) {
+        std::string().swap(it->second.req.body);
+    }
+}
+
+void H2Session::close_stream(uint32_t stream_id) {
+    auto it = streams_.find(stream_id);
+    if (it == streams_.end()) {
+        return;
+    }
+    if (it->second.state == StreamState::OPEN) {
+        buffered_body_ -= it->second.req.body.size();
+    }
+    pending_bytes_ -= it->second.pending.size() - it->second.pending_off;
+    streams_.erase(it);
+}
+
+void H2Session::reset_stream(uint32_t stream_id, ErrorCode code) {
+    scratch_.clear();
+    h2::append_header(scratch_, 4, FrameType::RST_STREAM, 0, stream_id);
+    h2::append_u32(scratch_, static_cast<uint32_t>(code));
+    emit(scratch_);
+
+    if (streams_.count(stream_id)) {
+        close_stream(stream_id);
+        if (on_reset_) {
+            on_reset_(stream_id);
+        }
+    }
+}
+
+void H2Session::submit_headers(uint32_t stream_id, int status,
+                               const HeaderList& headers, bool end_stream) {
+    if (!streams_.count(stream_id)) {
+        return;
+    }
+
+    HeaderList fields;
+    fields.reserve(headers.size() + 1);
+    fields.emplace_back(":status", std::to_string(status));
+    fields.insert(fields.end(), headers.begin(), headers.end());
+
+    std::string block;
+    HpackEncoder::encode(fields, block);
+
+    // Split across CONTINUATION frames if the block exceeds the peer limit
+    size_t off = 0;
+    bool first = true;
+    do {
+        size_t chunk = std::min<size_t>(block.size() - off, peer_max_frame_);
+        bool last = off + chunk == block.size();
+
+        uint8_t fl = last ? h2::flags::END_HEADERS : 0;
+        if (first && end_stream) {
+            fl |= h2::flags::END_STREAM;
+        }
+
+        scratch_.clear();
+        h2::append_header(scratch_, static_cast<uint32_t>(chunk),
+                          first ? FrameType::HEADERS : FrameType::CONTINUATION,
+                          fl, stream_id);
+        scratch_.append(block, off, chunk);
+        emit(scratch_);
+
+        off += chunk;
+        first = false;
+    } while (off < block.size());
+
+    if (end_stream) {
+        close_stream(stream_id);
+    }
+}
+
+void H2Session::submit_data(uint32_t stream_id, const char* data, size_t len,
+                            bool end_stream) {
+    auto it = streams_.find(stream_id);
+    if (it == streams_.end()) {
+        return;
+    }
+
+    Stream& s = it->second;
+    s.pending.append(data, len);
+    s.end_queued = s.end_queued || end_stream;
+    pending_bytes_ += len;
+
+    flush_data();
+}
+
+void H2Session::flush_data() {
+    if (conn_send_window_ <= 0) {
+        return;
+    }
+
+    for (auto it = streams_.begin(); it != streams_.end(); ) {
+        Stream& s = it->second;
+        uint32_t id = it->first;
+        ++it;
+
+        size_t left = s.pending.size() - s.pending_off;
+        if (left == 0 && !s.end_queued) {
+            continue;
+        }
+
+        while (true) {
+            left = s.pending.size() - s.pending_off;
+            int64_t window = std::min(conn_send_window_, s.send_window);
+            size_t chunk = std::min<size_t>(left, peer_max_frame_);
+            chunk = static_cast<size_t>(std::min<int64_t>(chunk, std::max<int64_t>(window, 0)));
+
+            bool last = s.end_queued && chunk == left;
+            if (chunk == 0 && !(last && left == 0)) {
+                break;
+            }
+
+            scratch_.clear();
+            h2::append_header(scratch_, static_cast<uint32_t>(chunk), FrameType::DATA,
+                              last ? h2::flags::END_STREAM : 0, id);
+            scratch_.append(s.pending, s.pending_off, chunk);
+            emit(scratch_);
+
+            s.pending_off += chunk;
+            s.send_window -= chunk;
+            conn_send_window_ -= chunk;
+            pending_bytes_ -= chunk;
+
+            if (last) {
+                close_stream(id);
+                break;
+            }
+
+            if (s.pending_off == s.pending.size()) {
+                s.pending.clear();
+                s.pending_off = 0;
+                break;
+            }
+        }
+
+        if (conn_send_window_ <= 0) {
+            return;
+        }
+    }
+}
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <sys/types.h>
+
+#include "core/buffer/buffer.h"
+#include "h2_frame.h"
+#include "hpack.h"
+
+/*
+ * H2Request
+ * ---------
+ * A complete request received on one stream.
+ */
+struct H2Request {
+    uint32_t stream_id = 0;
+    std::string method;
+    std::string scheme;
+    std::string authority;
+    std::string path;
+    HeaderList headers;     // regular (non-pseudo) headers, lowercase
+    std::string body;
+};
+
+/*
+ * H2Session
+ * ---------
+ * Server side of one HTTP/2 connection (RFC 9113), without I/O.
+ *
+ * Responsibilities:
+ * - Validate the client preface and exchange SETTINGS
+ * - Bound decoded header lists (kMaxHeaderListSize)
+ * - Parse frames, track per-stream state
+ * - HPACK decode request headers / encode response headers
+ * - Connection- and stream-level flow control in both directions
+ * - PING, RST_STREAM, GOAWAY handling
+ *
+ * Non-responsibilities:
+ * - Socket I/O (caller feeds input and drains output())
+ * - Routing requests anywhere
+ *
+ * Request bodies are buffered per stream up to max_body; a request is
+ * delivered once END_STREAM is seen. Receive windows are replenished as
+ * DATA arrives, so what stays bounded is the buffering: undelivered
+ * bodies on one connection never exceed max_buffered, and a stream that
+ * would cross it is refused (REFUSED_STREAM, safe for the client to
+ * retry) instead of growing the connection's footprint. Responses may be streamed with
+ * submit_headers() followed by any number of submit_data() calls.
+ */
+class H2Session {
+public:
+    using RequestCallback = std::function<void(H2Request& req)>;
+    using ResetCallback = std::function<void(uint32_t stream_id)>;
+
+    static constexpr uint32_t kMaxConcurrentStreams = 100;
+
+    // Advertised as SETTINGS_MAX_HEADER_LIST_SIZE; a decoded block over
+    // it is a connection error (ENHANCE_YOUR_CALM)
+    static constexpr uint32_t kMaxHeaderListSize = 32 * 1024;
+
+    // Default cap on undelivered request bodies per connection
+    static constexpr size_t kMaxBufferedBody = 4 << 20;
+
+    explicit H2Session(size_t max_body = 1 << 20, size_t max_buffered = kMaxBufferedBody);
+
+    void set_callbacks(RequestCallback on_request, ResetCallback on_reset);
+
+    // Queue our SETTINGS (server connection preface)
+    void start();
+
+    // Consume as many complete frames as possible from data
+    // Returns bytes consumed, or -1 on a connection error (a GOAWAY is
+    // queued; flush output() and close)
+    ssize_t feed(const char* data, size_t len);
+
+    // Response head; end_stream for bodiless responses
+    void submit_headers(uint32_t stream_id, int status,
+                        const HeaderList& headers, bool end_stream);
+
+    // Response body; sent as flow-control windows allow
+    void submit_data(uint32_t stream_id, const char* data, size_t len,
+                     bool end_stream);
+
+    void reset_stream(uint32_t stream_id, h2::ErrorCode code);
+    void goaway(h2::ErrorCode code);
+
+    // Bytes waiting to be written to the client
+    Buffer& output() { return output_; }
+
+    // Bytes of response body not yet framed (blocked on flow control)
+    size_t pending_body_bytes() const { return pending_bytes_; }
+
+    // Bytes of request body received on streams not yet delivered
+    size_t buffered_body_bytes() const { return buffered_body_; }
+
+    size_t open_streams() const { return streams_.size(); }
+
+    // GOAWAY exchanged and all streams finished
+    bool finished() const;
+
+private:
+    enum class StreamState { OPEN, HALF_CLOSED_REMOTE };
+
+    struct Stream {
+        StreamState state = StreamState::OPEN;
+        int64_t send_window = h2::kDefaultWindow;
+        int64_t recv_window = h2::kDefaultWindow;
+        uint32_t recv_unacked = 0;
+        bool refused = false;       // over concurrency limit, body dropped
+        H2Request req;
+
+        std::string pending;        // response body awaiting window
+        size_t pending_off = 0;
+        bool end_queued = false;
+    };
+
+    bool process_frame(const h2::FrameHeader& h, const uint8_t* payload);
+    bool on_headers(const h2::FrameHeader& h, const uint8_t* payload);
+    bool on_continuation(const h2::FrameHeader& h, const uint8_t* payload);
+    bool on_data(const h2::FrameHeader& h, const uint8_t* payload);
+    bool on_settings(const h2::FrameHeader& h, const uint8_t* payload);
+    bool on_window_update(const h2::FrameHeader& h, const uint8_t* payload);
+    bool on_rst_stream(const h2::FrameHeader& h, const uint8_t* payload);
+    bool on_ping(const h2::FrameHeader& h, const uint8_t* payload);
+
+    bool finish_header_block(uint32_t stream_id, bool end_stream);
+    void deliver(uint32_t stream_id);
+    void close_stream(uint32_t stream_id);
+    void flush_data();
+    bool fail(h2::ErrorCode code);
+    void emit(const std::string& frame);
+
+    HpackDecoder decoder_;
+    size_t max_body_;
+    size_t max_buffered_;
+    RequestCallback on_request_;
+    ResetCallback on_reset_;
+
+    bool preface_received_{false};
+    bool goaway_sent_{false};
+    bool goaway_received_{false};
+    uint32_t last_stream_id_{0};
+
+    // CONTINUATION sequence in progress (0 = none)
+    uint32_t continuation_stream_{0};
+    bool continuation_end_stream_{false};
+    std::string header_block_;
+
+    int64_t conn_send_window_{h2::kDefaultWindow};
+    int64_t conn_recv_window_{h2::kDefaultWindow};
+    uint32_t conn_recv_unacked_{0};
+    int64_t peer_initial_window_{h2::kDefaultWindow};
+    uint32_t peer_max_frame_{h2::kDefaultMaxFrameSize};
+
+    std::unordered_map<uint32_t, Stream> streams_;
+    size_t pending_bytes_{0};
+    size_t buffered_body_{0};
+
+    Buffer output_{16384};
+    std::string scratch_;
+};
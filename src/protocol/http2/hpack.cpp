@@ -0,0 +1,307 @@
+#include "hpack.h"
+#include "huffman.h"
+
+namespace {
+
+struct StaticEntry {
+    const char* name;
+    const char* value;
+};
+
+// RFC 7541, Appendix A (index 1..61)
+const StaticEntry kStaticTable[] = {
+    {":authority", ""},
+    {":method", "GET"},
+    {":method", "POST"},
+    {":path", "/"},
+    {":path", "/index.html"},
+    {":scheme", "http"},
+    {":scheme", "https"},
+    {":status", "200"},
+    {":status", "204"},
+    {":status", "206"},
+    {":status", "304"},
+    {":status", "400"},
+    {":status", "404"},
+    {":status", "500"},
+    {"accept-charset", ""},
+    {"accept-encoding", "gzip, deflate"},
+    {"accept-language", ""},
+    {"accept-ranges", ""},
+    {"accept", ""},
+    {"access-control-allow-origin", ""},
+    {"age", ""},
+    {"allow", ""},
+    {"authorization", ""},
+    {"cache-control", ""},
+    {"content-disposition", ""},
+    {"content-encoding", ""},
+    {"content-language", ""},
+    {"content-length", ""},
+    {"content-location", ""},
+    {"content-range", ""},
+    {"content-type", ""},
+    {"cookie", ""},
+    {"date", ""},
+    {"etag", ""},
+    {"expect", ""},
+    {"expires", ""},
+    {"from", ""},
+    {"host", ""},
+    {"if-match", ""},
+    {"if-modified-since", ""},
+    {"if-none-match", ""},
+    {"if-range", ""},
+    {"if-unmodified-since", ""},
+    {"last-modified", ""},
+    {"link", ""},
+    {"location", ""},
+    {"max-forwards", ""},
+    {"proxy-authenticate", ""},
+    {"proxy-authorization", ""},
+    {"range", ""},
+    {"referer", ""},
+    {"refresh", ""},
+    {"retry-after", ""},
+    {"server", ""},
+    {"set-cookie", ""},
+    {"strict-transport-security", ""},
+    {"transfer-encoding", ""},
+    {"user-agent", ""},
+    {"vary", ""},
+    {"via", ""},
+    {"www-authenticate", ""},
+};
+
+constexpr size_t kStaticCount = sizeof(kStaticTable) / sizeof(kStaticTable[0]);
+
+// Per-entry accounting overhead (RFC 7541, section 4.1)
+constexpr size_t kEntryOverhead = 32;
+
+size_t entry_size(const HeaderField& f) {
+    return f.first.size() + f.second.size() + kEntryOverhead;
+}
+
+} // namespace
+
+namespace hpack {
+
+bool decode_int(const uint8_t*& p, const uint8_t* end, int prefix_bits, uint64_t& out) {
+    if (p >= end) {
+        return false;
+    }
+    uint64_t max_prefix = (1u << prefix_bits) - 1;
+    out = *p++ & max_prefix;
+    if (out < max_prefix) {
+        return true;
+    }
+
+    int shift = 0;
+    while (p < end) {
+        uint8_t b = *p++;
+        if (shift > 56) {
+            return false;
+        }
+        out += static_cast<uint64_t>(b & 0x7f) << shift;
+        shift += 7;
+        if (!(b & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void encode_int(std::string& out, uint8_t first_byte_flags, int prefix_bits, uint64_t value) {
+    uint64_t max_prefix = (1u << prefix_bits) - 1;
+    if (value < max_prefix) {
+        out.push_back(static_cast<char>(first_byte_flags | value));
+        return;
+    }
+    out.push_back(static_cast<char>(first_byte_flags | max_prefix));
+    value -= max_prefix;
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+bool decode_string(const uint8_t*& p, const uint8_t* end, std::string& out) {
+    if (p >= end) {
+        return false;
+    }
+    bool huffman = *p & 0x80;
+    uint64_t len = 0;
+    if (!decode_int(p, end, 7, len) || len > static_cast<uint64_t>(end - p)) {
+        return false;
+    }
+
+    out.clear();
+    if (huffman) {
+        if (!Huffman::decode(p, len, out)) {
+            return false;
+        }
+    } else {
+        out.assign(reinterpret_cast<const char*>(p), len);
+    }
+    p += len;
+    return true;
+}
+
+void encode_string(std::string& out, const std::string& value) {
+    encode_int(out, 0x00, 7, value.size());
+    out.append(value);
+}
+
+} // namespace hpack
+
+HpackDecoder::HpackDecoder(size_t max_table_size, size_t max_list_size)
+    : max_allowed_(max_table_size),
+      max_size_(max_table_size),
+      size_(0),
+      max_list_size_(max_list_size),
+      list_too_large_(false) {}
+
+bool HpackDecoder::lookup(uint64_t index, HeaderField& out) const {
+    if (index == 0) {
+        return false;
+    }
+    if (index <= kStaticCount) {
+        out.first = kStaticTable[index - 1].name;
+        out.second = kStaticTable[index - 1].value;
+        return true;
+    }
+    uint64_t dyn = index - kStaticCount - 1;
+    if (dyn >= dynamic_.size()) {
+        return false;
+    }
+    out = dynamic_[dyn];
+    return true;
+}
+
+void HpackDecoder::evict_to(size_t limit) {
+    while (size_ > limit && !dynamic_.empty()) {
+        size_ -= entry_size(dynamic_.back());
+        dynamic_.pop_back();
+    }
+}
+
+void HpackDecoder::insert(HeaderField field) {
+    size_t sz = entry_size(field);
+    if (sz > max_size_) {
+        // An entry larger than the table empties it (section 4.4)
+        evict_to(0);
+        return;
+    }
+    evict_to(max_size_ - sz);
+    size_ += sz;
+    dynamic_.push_front(std::move(field));
+}
+
+bool HpackDecoder::decode(const uint8_t* data, size_t len, HeaderList& out) {
+    const uint8_t* p = data;
+    const uint8_t* end = data + len;
+    bool fields_seen = false;
+    size_t list_size = 0;
+    list_too_large_ = false;
+
+    // A short block can expand to many copies of one large table entry
+    auto admit = [&](const HeaderField& f) {
+        list_size += entry_size(f);
+        list_too_large_ = list_size > max_list_size_;
+        return !list_too_large_;
+    };
+
+    while (p < end) {
+        uint8_t b = *p;
+
+        if (b & 0x80) {
+            // Indexed header field
+            uint64_t index = 0;
+            HeaderField f;
+            if (!hpack::decode_int(p, end, 7, index) || !lookup(index, f) || !admit(f)) {
+                return false;
+            }
+            out.push_back(std::move(f));
+            fields_seen = true;
+            continue;
+        }
+
+        if ((b & 0xe0) == 0x20) {
+            // Dynamic table size update, only allowed before any field
+            uint64_t size = 0;
+            if (fields_seen || !hpack::decode_int(p, end, 5, size) ||
+                size > max_allowed_) {
+                return false;
+            }
+            max_size_ = static_cast<size_t>(size);
+            evict_to(max_size_);
+            continue;
+        }
+
+        // Literal: with incremental indexing (01), without (0000),
+        // never indexed (0001)
+        bool index_it = (b & 0xc0) == 0x40;
+        int prefix = index_it ? 6 : 4;
+
+        uint64_t name_index = 0;
+        if (!hpack::decode_int(p, end, prefix, name_index)) {
+            return false;
+        }
+
+        HeaderField f;
+        if (name_index) {
+            HeaderField named;
+            if (!lookup(name_index, named)) {
+                return false;
+            }
+            f.first = std::move(named.first);
+        } else if (!hpack::decode_string(p, end, f.first)) {
+            return false;
+        }
+
+        if (!hpack::decode_string(p, end, f.second) || !admit(f)) {
+            return false;
+        }
+
+        if (index_it) {
+            insert(f);
+        }
+        out.push_back(std::move(f));
+        fields_seen = true;
+    }
+
+    return true;
+}
+
+void HpackEncoder::encode(const HeaderList& headers, std::string& out) {
+    for (const HeaderField& h : headers) {
+        size_t name_index = 0;
+        size_t full_index = 0;
+
+        for (size_t i = 0; i < kStaticCount; ++i) {
+            if (h.first != kStaticTable[i].name) {
+                continue;
+            }
+            if (!name_index) {
+                name_index = i + 1;
+            }
+            if (h.second == kStaticTable[i].value) {
+                full_index = i + 1;
+                break;
+            }
+        }
+
+        if (full_index) {
+            hpack::encode_int(out, 0x80, 7, full_index);
+            continue;
+        }
+
+        // Literal without indexing
+        hpack::encode_int(out, 0x00, 4, name_index);
+        if (!name_index) {
+            hpack::encode_string(out, h.first);
+        }
+        hpack::encode_string(out, h.second);
+    }
+}
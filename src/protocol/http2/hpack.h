@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <utility>
+#include <vector>
+
+using HeaderField = std::pair<std::string, std::string>;
+using HeaderList = std::vector<HeaderField>;
+
+/*
+ * HpackDecoder
+ * ------------
+ * Header block decoder (RFC 7541) with static and dynamic tables.
+ *
+ * Core rules:
+ * - One decoder per connection (the dynamic table is connection state)
+ * - A decoding error is a connection error (COMPRESSION_ERROR)
+ * - Dynamic table size is bounded by our advertised SETTINGS value
+ * - A block decoding to more than max_list_size (name + value + 32 per
+ *   field, as SETTINGS_MAX_HEADER_LIST_SIZE counts it) fails as soon as
+ *   it crosses the limit, before the excess is materialized
+ */
+class HpackDecoder {
+public:
+    explicit HpackDecoder(size_t max_table_size = 4096,
+                          size_t max_list_size = SIZE_MAX);
+
+    // Decode a complete header block, appending to out
+    bool decode(const uint8_t* data, size_t len, HeaderList& out);
+
+    // The last decode() failed on max_list_size, not on the coding
+    bool list_too_large() const { return list_too_large_; }
+
+    size_t table_size() const { return size_; }
+
+private:
+    bool lookup(uint64_t index, HeaderField& out) const;
+    void insert(HeaderField field);
+    void evict_to(size_t limit);
+
+    size_t max_allowed_;    // SETTINGS_HEADER_TABLE_SIZE
+    size_t max_size_;       // current limit (<= max_allowed_)
+    size_t size_;
+    size_t max_list_size_;
+    bool list_too_large_;
+    std::deque<HeaderField> dynamic_;   // front = newest
+};
+
+/*
+ * HpackEncoder
+ * ------------
+ * Stateless header block encoder for responses.
+ *
+ * Uses static-table indexes where possible and literals without
+ * indexing otherwise, so it never needs a dynamic table and never
+ * emits a size update.
+ */
+class HpackEncoder {
+public:
+    static void encode(const HeaderList& headers, std::string& out);
+};
+
+/*
+ * Integer / string primitives (RFC 7541, sections 5.1 and 5.2)
+ */
+namespace hpack {
+
+bool decode_int(const uint8_t*& p, const uint8_t* end, int prefix_bits, uint64_t& out);
+void encode_int(std::string& out, uint8_t first_byte_flags, int prefix_bits, uint64_t value);
+
+bool decode_string(const uint8_t*& p, const uint8_t* end, std::string& out);
+void encode_string(std::string& out, const std::string& value);
+
+} // namespace hpack
@@ -0,0 +1,70 @@
+#include "huffman.h"
+
+#include <vector>
+
+namespace {
+
+/*
+ * Binary decode tree built once from kHuffmanTable.
+ * Leaves carry the symbol; internal nodes have sym == -1.
+ */
+struct Node {
+    int child[2] = {-1, -1};
+    int sym = -1;
+};
+
+const std::vector<Node>& tree() {
+    static const std::vector<Node> nodes = [] {
+        std::vector<Node> t(1);
+        t.reserve(513);
+        for (int sym = 0; sym < 257; ++sym) {
+            const HuffmanSymbol& hs = kHuffmanTable[sym];
+            int cur = 0;
+            for (int i = hs.bits - 1; i >= 0; --i) {
+                int bit = (hs.code >> i) & 1;
+                if (t[cur].child[bit] < 0) {
+                    t[cur].child[bit] = static_cast<int>(t.size());
+                    t.emplace_back();
+                }
+                cur = t[cur].child[bit];
+            }
+            t[cur].sym = sym;
+        }
+        return t;
+    }();
+    return nodes;
+}
+
+} // namespace
+
+bool Huffman::decode(const uint8_t* data, size_t len, std::string& out) {
+    const std::vector<Node>& t = tree();
+
+    int cur = 0;
+    int depth = 0;          // bits consumed since last symbol
+    bool all_ones = true;   // padding must be a prefix of EOS
+
+    for (size_t i = 0; i < len; ++i) {
+        for (int b = 7; b >= 0; --b) {
+            int bit = (data[i] >> b) & 1;
+            cur = t[cur].child[bit];
+            if (cur < 0) {
+                return false;
+            }
+            ++depth;
+            all_ones = all_ones && bit;
+
+            if (t[cur].sym >= 0) {
+                if (t[cur].sym == 256) {
+                    return false;
+                }
+                out.push_back(static_cast<char>(t[cur].sym));
+                cur = 0;
+                depth = 0;
+                all_ones = true;
+            }
+        }
+    }
+
+    return depth <= 7 && all_ones;
+}
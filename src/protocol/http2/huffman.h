@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+struct HuffmanSymbol {
+    uint32_t code;      // right-aligned code bits
+    uint8_t bits;       // code length
+};
+
+extern const HuffmanSymbol kHuffmanTable[257];
+
+/*
+ * Huffman
+ * -------
+ * HPACK string Huffman decoding (RFC 7541, section 5.2).
+ */
+class Huffman {
+public:
+    // Append decoded bytes to out
+    // Returns false on invalid code, EOS in data or bad padding
+    static bool decode(const uint8_t* data, size_t len, std::string& out);
+};
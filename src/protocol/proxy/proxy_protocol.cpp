@@ -0,0 +1,191 @@
+#include "proxy_protocol.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <cstring>
+#include <string>
+
+namespace {
+
+const char kV1Prefix[] = "PROXY ";
+const size_t kV1PrefixLen = sizeof(kV1Prefix) - 1;
+
+const uint8_t kV2Signature[12] = {
+    0x0d, 0x0a, 0x0d, 0x0a, 0x00, 0x0d, 0x0a, 0x51, 0x55, 0x49, 0x54, 0x0a
+};
+
+// True if the first n bytes of data match the first n bytes of sig
+bool prefix_matches(const void* data, size_t len, const void* sig, size_t sig_len) {
+    size_t n = len < sig_len ? len : sig_len;
+    return std::memcmp(data, sig, n) == 0;
+}
+
+// Decimal port without sign or leading zeros, as the spec requires
+bool parse_port(const std::string& s, uint16_t& port) {
+    if (s.empty() || s.size() > 5 || (s.size() > 1 && s[0] == '0')) {
+        return false;
+    }
+    unsigned v = 0;
+    for (char ch : s) {
+        if (ch < '0' || ch > '9') {
+            return false;
+        }
+        v = v * 10 + static_cast<unsigned>(ch - '0');
+    }
+    if (v > 65535) {
+        return false;
+    }
+    port = static_cast<uint16_t>(v);
+    return true;
+}
+
+bool parse_addr(int family, const std::string& ip, uint16_t port, sockaddr_storage& out) {
+    std::memset(&out, 0, sizeof(out));
+    if (family == AF_INET) {
+        auto* sa = reinterpret_cast<sockaddr_in*>(&out);
+        sa->sin_family = AF_INET;
+        sa->sin_port = htons(port);
+        return inet_pton(AF_INET, ip.c_str(), &sa->sin_addr) == 1;
+    }
+    auto* sa = reinterpret_cast<sockaddr_in6*>(&out);
+    sa->sin6_family = AF_INET6;
+    sa->sin6_port = htons(port);
+    return inet_pton(AF_INET6, ip.c_str(), &sa->sin6_addr) == 1;
+}
+
+} // namespace
+
+ProxyHeaderResult ProxyProtocol::parse(const char* data, size_t len, ProxyHeader& out) {
+    if (len == 0) {
+        return ProxyHeaderResult::INCOMPLETE;
+    }
+    if (prefix_matches(data, len, kV2Signature, sizeof(kV2Signature))) {
+        return parse_v2(reinterpret_cast<const uint8_t*>(data), len, out);
+    }
+    if (prefix_matches(data, len, kV1Prefix, kV1PrefixLen)) {
+        return parse_v1(data, len, out);
+    }
+    return ProxyHeaderResult::ERROR;
+}
+
+/*
+ * "PROXY TCP4 192.0.2.1 198.51.100.7 51234 443\r\n"
+ * "PROXY UNKNOWN[ anything]\r\n"
+ */
+ProxyHeaderResult ProxyProtocol::parse_v1(const char* data, size_t len, ProxyHeader& out) {
+    size_t scan = len < kV1MaxBytes ? len : kV1MaxBytes;
+    const char* lf = static_cast<const char*>(std::memchr(data, '\n', scan));
+    if (!lf) {
+        return len >= kV1MaxBytes ? ProxyHeaderResult::ERROR
+                                  : ProxyHeaderResult::INCOMPLETE;
+    }
+    if (lf == data || lf[-1] != '\r') {
+        return ProxyHeaderResult::ERROR;
+    }
+
+    std::string line(data + kV1PrefixLen, lf - 1);
+
+    std::string fields[5];
+    size_t nfields = 0;
+    size_t pos = 0;
+    while (pos <= line.size() && nfields < 5) {
+        size_t sp = line.find(' ', pos);
+        if (sp == std::string::npos) {
+            sp = line.size();
+        }
+        fields[nfields++] = line.substr(pos, sp - pos);
+        pos = sp + 1;
+    }
+
+    out = ProxyHeader();
+    out.version = 1;
+    out.header_bytes = static_cast<size_t>(lf - data) + 1;
+
+    if (fields[0] == "UNKNOWN") {
+        out.local = true;
+        return ProxyHeaderResult::COMPLETE;
+    }
+
+    int family;
+    if (fields[0] == "TCP4") {
+        family = AF_INET;
+    } else if (fields[0] == "TCP6") {
+        family = AF_INET6;
+    } else {
+        return ProxyHeaderResult::ERROR;
+    }
+
+    // Exactly five fields, single spaces
+    uint16_t sport = 0;
+    uint16_t dport = 0;
+    if (nfields != 5 || pos <= line.size() ||
+        !parse_port(fields[3], sport) || !parse_port(fields[4], dport) ||
+        !parse_addr(family, fields[1], sport, out.source) ||
+        !parse_addr(family, fields[2], dport, out.destination)) {
+        return ProxyHeaderResult::ERROR;
+    }
+    return ProxyHeaderResult::COMPLETE;
+}
+
+/*
+ * 12-byte signature, ver_cmd, fam, big-endian length, addresses, TLVs
+ */
+ProxyHeaderResult ProxyProtocol::parse_v2(const uint8_t* data, size_t len, ProxyHeader& out) {
+    if (len < kV2HeaderBytes) {
+        return ProxyHeaderResult::INCOMPLETE;
+    }
+
+    uint8_t ver_cmd = data[12];
+    uint8_t fam = data[13];
+    size_t body = (static_cast<size_t>(data[14]) << 8) | data[15];
+
+    out = ProxyHeader();
+    out.version = 2;
+    out.header_bytes = kV2HeaderBytes + body;
+
+    if ((ver_cmd >> 4) != 2 || (ver_cmd & 0x0f) > 1) {
+        return ProxyHeaderResult::ERROR;
+    }
+    if (len < out.header_bytes) {
+        return ProxyHeaderResult::INCOMPLETE;
+    }
+
+    const uint8_t* a = data + kV2HeaderBytes;
+    bool proxy_cmd = (ver_cmd & 0x0f) == 1;
+    uint8_t family = fam >> 4;
+    uint8_t transport = fam & 0x0f;
+
+    if (!proxy_cmd || transport != 1 || (family != 1 && family != 2)) {
+        // LOCAL (health check), UDP, UNIX or unspecified: keep socket peer
+        out.local = true;
+        return ProxyHeaderResult::COMPLETE;
+    }
+
+    if (family == 1) {
+        if (body < 12) {
+            return ProxyHeaderResult::ERROR;
+        }
+        auto* src = reinterpret_cast<sockaddr_in*>(&out.source);
+        auto* dst = reinterpret_cast<sockaddr_in*>(&out.destination);
+        src->sin_family = AF_INET;
+        dst->sin_family = AF_INET;
+        std::memcpy(&src->sin_addr, a, 4);
+        std::memcpy(&dst->sin_addr, a + 4, 4);
+        std::memcpy(&src->sin_port, a + 8, 2);
+        std::memcpy(&dst->sin_port, a + 10, 2);
+        return ProxyHeaderResult::COMPLETE;
+    }
+
+    if (body < 36) {
+        return ProxyHeaderResult::ERROR;
+    }
+    auto* src = reinterpret_cast<sockaddr_in6*>(&out.source);
+    auto* dst = reinterpret_cast<sockaddr_in6*>(&out.destination);
+    src->sin6_family = AF_INET6;
+    dst->sin6_family = AF_INET6;
+    std::memcpy(&src->sin6_addr, a, 16);
+    std::memcpy(&dst->sin6_addr, a + 16, 16);
+    std::memcpy(&src->sin6_port, a + 32, 2);
+    std::memcpy(&dst->sin6_port, a + 34, 2);
+    return ProxyHeaderResult::COMPLETE;
+}
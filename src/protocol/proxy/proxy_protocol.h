@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <sys/socket.h>
+
+/*
+ * ProxyHeaderResult
+ * -----------------
+ * Result of parsing a PROXY protocol header at the start of a stream.
+ */
+enum class ProxyHeaderResult {
+    INCOMPLETE,     // Need more data (header_bytes may say how much)
+    COMPLETE,       // Header parsed, header_bytes covers it exactly
+    ERROR           // Not a PROXY header, or malformed
+};
+
+/*
+ * ProxyHeader
+ * -----------
+ * Addresses announced by the load balancer in front of us.
+ *
+ * local is set for v1 "UNKNOWN", v2 LOCAL (health checks) and address
+ * families we do not forward (UNIX); the socket's own peer address
+ * should be kept then.
+ */
+struct ProxyHeader {
+    int version = 0;            // 1 or 2
+    bool local = false;
+    sockaddr_storage source{};
+    sockaddr_storage destination{};
+    size_t header_bytes = 0;
+};
+
+/*
+ * ProxyProtocol
+ * -------------
+ * Stateless parser for HAProxy PROXY protocol v1 (text) and v2 (binary).
+ *
+ * Responsibilities:
+ * - Detect and validate either version
+ * - Extract TCP over IPv4 / IPv6 source and destination addresses
+ * - Skip v2 TLVs
+ *
+ * Non-responsibilities:
+ * - Socket I/O (callers peek, then consume header_bytes)
+ * - Deciding which peers may send the header
+ */
+class ProxyProtocol {
+public:
+    // Longest v1 line including CRLF (spec: 107 bytes)
+    static constexpr size_t kV1MaxBytes = 107;
+
+    // v2 fixed part: signature, version/command, family, length
+    static constexpr size_t kV2HeaderBytes = 16;
+
+    // Recommended first read; covers v1 and v2 without large TLVs
+    static constexpr size_t kRecommendedPeek = 536;
+
+    static ProxyHeaderResult parse(const char* data, size_t len, ProxyHeader& out);
+
+private:
+    static ProxyHeaderResult parse_v1(const char* data, size_t len, ProxyHeader& out);
+    static ProxyHeaderResult parse_v2(const uint8_t* data, size_t len, ProxyHeader& out);
+};
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * Shared-memory stats segment (native endianness, same host only)
+ * ---------------------------------------------------------------
+ *
+ *   ShmHeader                       once, at offset 0
+ *   worker region                   from kShmWorkersOffset, repeated
+ *                                   header.workers times,
+ *                                   header.worker_bytes apart
+ *     ShmWorkerHead                 seqlock + counters
+ *     ShmConnEntry[conn_slots]      connection table
+ *
+ * Each worker region has exactly one writer (that worker's loop) and
+ * is guarded by its own sequence counter: odd while an update is in
+ * progress. A reader copies the region and keeps the copy only if the
+ * counter was even and unchanged across the copy; readers never write,
+ * so any number of them cost the proxy nothing.
+ *
+ * Readers must check magic, version and the three sizes.
+ */
+constexpr char kShmMagic[8] = {'P', 'X', 'S', 'T', 'A', 'T', 'S', '\0'};
+constexpr uint32_t kShmVersion = 2;
+constexpr size_t kShmWorkersOffset = 64;
+
+struct ShmHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_bytes;      // sizeof(ShmHeader)
+    uint32_t head_bytes;        // sizeof(ShmWorkerHead)
+    uint32_t entry_bytes;       // sizeof(ShmConnEntry)
+    uint32_t workers;
+    uint32_t conn_slots;        // table entries per worker
+    uint64_t worker_bytes;      // stride between worker regions
+    uint64_t started_unix_ms;
+    int32_t pid;
+    uint32_t reserved;
+};
+
+// Cumulative since start unless marked as a gauge
+struct ShmCounters {
+    uint64_t updated_unix_ms;
+    uint64_t accepted;
+    uint64_t requests;          // request heads parsed (HTTP/1.x)
+    uint64_t responses[6];      // [1..5] = 1xx..5xx, [0] unused
+    uint64_t bytes_in;          // client side, through user space
+    uint64_t bytes_out;
+    uint64_t retries_granted;
+    uint64_t retries_denied;
+    uint64_t tls_handshakes;        // completed
+    uint64_t tls_handshake_failures;
+    uint64_t tls_resumed;
+    uint64_t tls_handshake_ns;      // time inside the handshake
+    uint64_t tls_ktls_tx;           // sessions with kernel TLS send
+    uint64_t tls_ktls_rx;           // sessions with kernel TLS receive
+    uint32_t active;            // gauge: open connections
+    uint32_t tunnels;           // gauge: open tunnels
+    uint32_t conns;             // gauge: valid table entries
+    uint32_t draining;          // gauge: 1 once a drain started
+};
+
+struct ShmConnEntry {
+    uint64_t bytes_in;
+    uint64_t bytes_out;
+    uint32_t conn_id;
+    uint32_t age_ms;
+    uint32_t upstream_addr;     // network order, 0 = none
+    uint16_t upstream_port;
+    uint8_t state;              // ConnectionState
+    uint8_t family;             // AF_INET / AF_INET6, 0 = unknown
+    uint8_t client[16];
+    int32_t fd;
+    uint32_t reserved;
+};
+
+struct alignas(64) ShmWorkerHead {
+    std::atomic<uint64_t> seq;
+    uint64_t reserved[7];       // counters start on their own cache line
+    ShmCounters counters;
+};
+
+static_assert(sizeof(ShmHeader) == 56 && sizeof(ShmHeader) <= kShmWorkersOffset,
+              "shm header layout");
+static_assert(sizeof(ShmConnEntry) == 56, "shm entry layout");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "seqlock needs lock-free atomics");
+
+inline size_t shm_worker_bytes(uint32_t conn_slots) {
+    size_t n = sizeof(ShmWorkerHead) + conn_slots * sizeof(ShmConnEntry);
+    return (n + 63) & ~size_t(63);
+}
+
+inline size_t shm_segment_bytes(uint32_t workers, uint32_t conn_slots) {
+    return kShmWorkersOffset + workers * shm_worker_bytes(conn_slots);
+}
@@ -0,0 +1,192 @@
+#include "shm_stats.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+
+constexpr int kReadAttempts = 64;
+
+ShmWorkerHead* worker_head(void* base, const ShmHeader& h, uint32_t worker) {
+    return reinterpret_cast<ShmWorkerHead*>(static_cast<char*>(base) + kShmWorkersOffset +
+                                            worker * h.worker_bytes);
+}
+
+const ShmWorkerHead* worker_head(const void* base, const ShmHeader& h, uint32_t worker) {
+    return reinterpret_cast<const ShmWorkerHead*>(static_cast<const char*>(base) +
+                                                  kShmWorkersOffset + worker * h.worker_bytes);
+}
+
+} // namespace
+
+ShmStatsWriter::~ShmStatsWriter() {
+    close();
+}
+
+bool ShmStatsWriter::create(const std::string& name, uint32_t workers, uint32_t conn_slots,
+                            std::string& err) {
+    close();
+
+    // A segment with this name belongs to a dead process (or to one
+    // about to exit after handing over): readers that still map it keep
+    // their copy, new readers find ours
+    ::shm_unlink(name.c_str());
+    int fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        err = "cannot create shm " + name + ": " + std::strerror(errno);
+        return false;
+    }
+
+    size_t bytes = shm_segment_bytes(workers, conn_slots);
+    void* base = MAP_FAILED;
+    struct stat st;
+    if (::fstat(fd, &st) == 0 && ::ftruncate(fd, static_cast<off_t>(bytes)) == 0) {
+        base = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    int saved = errno;
+    ::close(fd);
+    if (base == MAP_FAILED) {
+        err = "cannot map shm " + name + ": " + std::strerror(saved);
+        ::shm_unlink(name.c_str());
+        return false;
+    }
+
+    // ftruncate zero-filled it: every seq starts even, every table empty
+    auto* h = static_cast<ShmHeader*>(base);
+    std::memcpy(h->magic, kShmMagic, sizeof(h->magic));
+    h->version = kShmVersion;
+    h->header_bytes = sizeof(ShmHeader);
+    h->head_bytes = sizeof(ShmWorkerHead);
+    h->entry_bytes = sizeof(ShmConnEntry);
+    h->workers = workers;
+    h->conn_slots = conn_slots;
+    h->worker_bytes = shm_worker_bytes(conn_slots);
+    h->started_unix_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    h->pid = ::getpid();
+
+    name_ = name;
+    ino_ = st.st_ino;
+    base_ = base;
+    bytes_ = bytes;
+    header_ = h;
+    return true;
+}
+
+void ShmStatsWriter::close() {
+    if (!base_) {
+        return;
+    }
+    ::munmap(base_, bytes_);
+
+    // After a hand-over the name may already belong to the new process
+    int fd = ::shm_open(name_.c_str(), O_RDONLY | O_CLOEXEC, 0);
+    if (fd >= 0) {
+        struct stat st;
+        if (::fstat(fd, &st) == 0 && st.st_ino == ino_) {
+            ::shm_unlink(name_.c_str());
+        }
+        ::close(fd);
+    }
+    base_ = nullptr;
+    header_ = nullptr;
+}
+
+void ShmStatsWriter::publish(uint32_t worker, const ShmCounters& counters,
+                             const ShmConnEntry* entries, size_t n) {
+    if (!header_ || worker >= header_->workers) {
+        return;
+    }
+    if (n > header_->conn_slots) {
+        n = header_->conn_slots;
+    }
+
+    ShmWorkerHead* w = worker_head(base_, *header_, worker);
+    uint64_t seq = w->seq.load(std::memory_order_relaxed);
+
+    w->seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    w->counters = counters;
+    w->counters.conns = static_cast<uint32_t>(n);
+    std::memcpy(reinterpret_cast<char*>(w) + sizeof(ShmWorkerHead), entries,
+                n * sizeof(ShmConnEntry));
+
+    w->seq.store(seq + 2, std::memory_order_release);
+}
+
+ShmStatsReader::~ShmStatsReader() {
+    if (base_) {
+        ::munmap(const_cast<void*>(base_), bytes_);
+    }
+}
+
+bool ShmStatsReader::open(const std::string& name, std::string& err) {
+    int fd = ::shm_open(name.c_str(), O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0) {
+        err = "cannot open shm " + name + ": " + std::strerror(errno);
+        return false;
+    }
+
+    struct stat st;
+    void* base = MAP_FAILED;
+    if (::fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= kShmWorkersOffset) {
+        base = ::mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (base == MAP_FAILED) {
+        err = "cannot map shm " + name;
+        return false;
+    }
+
+    const auto* h = static_cast<const ShmHeader*>(base);
+    if (std::memcmp(h->magic, kShmMagic, sizeof(h->magic)) != 0 ||
+        h->version != kShmVersion || h->header_bytes != sizeof(ShmHeader) ||
+        h->head_bytes != sizeof(ShmWorkerHead) || h->entry_bytes != sizeof(ShmConnEntry) ||
+        shm_segment_bytes(h->workers, h->conn_slots) > static_cast<size_t>(st.st_size)) {
+        ::munmap(base, st.st_size);
+        err = name + ": not a stats segment (or incompatible version)";
+        return false;
+    }
+
+    base_ = base;
+    bytes_ = st.st_size;
+    header_ = h;
+    return true;
+}
+
+bool ShmStatsReader::read(uint32_t worker, ShmCounters& counters,
+                          std::vector<ShmConnEntry>* entries) const {
+    if (worker >= header_->workers) {
+        return false;
+    }
+    const ShmWorkerHead* w = worker_head(base_, *header_, worker);
+    const auto* table = reinterpret_cast<const ShmConnEntry*>(
+        reinterpret_cast<const char*>(w) + sizeof(ShmWorkerHead));
+
+    for (int attempt = 0; attempt < kReadAttempts; ++attempt) {
+        uint64_t before = w->seq.load(std::memory_order_acquire);
+        if (before & 1) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        counters = w->counters;
+        uint32_t n = counters.conns <= header_->conn_slots ? counters.conns : 0;
+        if (entries) {
+            entries->assign(table, table + n);
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (w->seq.load(std::memory_order_relaxed) == before) {
+            return before != 0;
+        }
+    }
+    return false;
+}
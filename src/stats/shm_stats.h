@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+#include "shm_format.h"
+
+/*
+ * ShmStatsWriter
+ * --------------
+ * Owns the POSIX shared-memory stats segment (see shm_format.h).
+ *
+ * Core rules:
+ * - create() replaces a segment of the same name (left behind by a
+ *   crash, or by the process handing over); the destructor unlinks the
+ *   name only while it still refers to this segment
+ * - publish(worker, ...) is called only from that worker's loop thread:
+ *   one writer per region, so the seqlock needs no other locking
+ * - Publishing is a bounded copy on the writer's own schedule; readers
+ *   never signal, block or wait on the proxy
+ *
+ * Non-responsibilities:
+ * - Collecting the numbers (the caller fills ShmCounters and entries)
+ */
+class ShmStatsWriter {
+public:
+    ShmStatsWriter() = default;
+    ~ShmStatsWriter();
+
+    ShmStatsWriter(const ShmStatsWriter&) = delete;
+    ShmStatsWriter& operator=(const ShmStatsWriter&) = delete;
+
+    // name is a POSIX shm name ("/proxy-stats"); returns false and fills
+    // err on failure
+    bool create(const std::string& name, uint32_t workers, uint32_t conn_slots,
+                std::string& err);
+
+    uint32_t conn_slots() const { return header_ ? header_->conn_slots : 0; }
+
+    // Entries beyond conn_slots are dropped; counters.conns is set here
+    void publish(uint32_t worker, const ShmCounters& counters,
+                 const ShmConnEntry* entries, size_t n);
+
+private:
+    void close();
+
+    std::string name_;
+    ino_t ino_{0};
+    void* base_{nullptr};
+    size_t bytes_{0};
+    ShmHeader* header_{nullptr};
+};
+
+/*
+ * ShmStatsReader
+ * --------------
+ * Read-only view of a segment, for monitoring tools and tests.
+ */
+class ShmStatsReader {
+public:
+    ShmStatsReader() = default;
+    ~ShmStatsReader();
+
+    ShmStatsReader(const ShmStatsReader&) = delete;
+    ShmStatsReader& operator=(const ShmStatsReader&) = delete;
+
+    // Map name read-only; false (with err) if missing or incompatible
+    bool open(const std::string& name, std::string& err);
+
+    const ShmHeader& header() const { return *header_; }
+    uint32_t workers() const { return header_->workers; }
+
+    // Consistent copy of one worker's counters and, if entries is given,
+    // its connection table. False if the writer kept it busy for every
+    // attempt (or never published)
+    bool read(uint32_t worker, ShmCounters& counters,
+              std::vector<ShmConnEntry>* entries = nullptr) const;
+
+private:
+    const void* base_{nullptr};
+    size_t bytes_{0};
+    const ShmHeader* header_{nullptr};
+};
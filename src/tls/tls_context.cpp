@@ -0,0 +1,95 @@
+#include "tls_context.h"
+
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+
+namespace {
+
+std::string last_error() {
+    unsigned long code = ERR_get_error();
+    if (code == 0) {
+        return "unknown error";
+    }
+    char buf[256];
+    ERR_error_string_n(code, buf, sizeof(buf));
+    return buf;
+}
+
+// ALPN wire format: length-prefixed protocol names, in preference order
+const unsigned char kAlpnH2[] = "\x02h2\x08http/1.1";
+const unsigned char kAlpnHttp11[] = "\x08http/1.1";
+
+int select_alpn(SSL*, const unsigned char** out, unsigned char* outlen,
+                const unsigned char* in, unsigned int inlen, void* arg) {
+    bool offer_h2 = *static_cast<bool*>(arg);
+    const unsigned char* ours = offer_h2 ? kAlpnH2 : kAlpnHttp11;
+    unsigned int ours_len = offer_h2 ? sizeof(kAlpnH2) - 1 : sizeof(kAlpnHttp11) - 1;
+
+    unsigned char* selected = nullptr;
+    if (SSL_select_next_proto(&selected, outlen, ours, ours_len, in, inlen) !=
+        OPENSSL_NPN_NEGOTIATED) {
+        return SSL_TLSEXT_ERR_NOACK;
+    }
+    *out = selected;
+    return SSL_TLSEXT_ERR_OK;
+}
+
+} // namespace
+
+TlsContext::TlsContext()
+    : ctx_(nullptr),
+      offer_h2_(false) {}
+
+TlsContext::~TlsContext() {
+    if (ctx_) {
+        SSL_CTX_free(ctx_);
+    }
+}
+
+bool TlsContext::init(const std::string& cert_file,
+                      const std::string& key_file,
+                      size_t session_cache_size,
+                      bool enable_ktls,
+                      bool offer_h2,
+                      std::string& err) {
+    ctx_ = SSL_CTX_new(TLS_server_method());
+    if (!ctx_) {
+        err = last_error();
+        return false;
+    }
+
+    SSL_CTX_set_min_proto_version(ctx_, TLS1_2_VERSION);
+
+    // Writes from Connection buffers may be partial and retried from a
+    // different address after compaction
+    SSL_CTX_set_mode(ctx_, SSL_MODE_ENABLE_PARTIAL_WRITE |
+                           SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER |
+                           SSL_MODE_RELEASE_BUFFERS);
+
+    if (SSL_CTX_use_certificate_chain_file(ctx_, cert_file.c_str()) != 1 ||
+        SSL_CTX_use_PrivateKey_file(ctx_, key_file.c_str(), SSL_FILETYPE_PEM) != 1 ||
+        SSL_CTX_check_private_key(ctx_) != 1) {
+        err = last_error();
+        return false;
+    }
+
+    // Resumption: stateful cache for TLS 1.2 clients without ticket
+    // support, stateless tickets (OpenSSL default) for everyone else
+    static const unsigned char kSessionIdContext[] = "cpp-proxy";
+    SSL_CTX_set_session_id_context(ctx_, kSessionIdContext,
+                                   sizeof(kSessionIdContext) - 1);
+    SSL_CTX_set_session_cache_mode(ctx_, SSL_SESS_CACHE_SERVER);
+    SSL_CTX_sess_set_cache_size(ctx_, static_cast<long>(session_cache_size));
+    SSL_CTX_clear_options(ctx_, SSL_OP_NO_TICKET);
+
+    if (enable_ktls) {
+#ifdef SSL_OP_ENABLE_KTLS
+        SSL_CTX_set_options(ctx_, SSL_OP_ENABLE_KTLS);
+#endif
+    }
+
+    offer_h2_ = offer_h2;
+    SSL_CTX_set_alpn_select_cb(ctx_, select_alpn, &offer_h2_);
+
+    return true;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+typedef struct ssl_ctx_st SSL_CTX;
+
+/*
+ * TlsStats
+ * --------
+ * Handshake counters, kept apart from data-path work so TLS CPU cost
+ * can be attributed. Only touched on the owning loop thread.
+ */
+struct TlsStats {
+    uint64_t handshakes = 0;           // completed
+    uint64_t handshake_failures = 0;
+    uint64_t resumed = 0;              // session cache or ticket hits
+    uint64_t handshake_ns = 0;         // time spent inside SSL_do_handshake
+    uint64_t ktls_tx = 0;              // sessions with kernel TLS send
+    uint64_t ktls_rx = 0;              // sessions with kernel TLS receive
+};
+
+/*
+ * TlsContext
+ * ----------
+ * Server-side OpenSSL context shared by all TLS connections of a loop.
+ *
+ * Responsibilities:
+ * - Load certificate chain and private key
+ * - Enable session resumption (server cache + stateless tickets)
+ * - Request kernel TLS offload when available
+ * - ALPN selection (h2, then http/1.1)
+ * - Hold handshake statistics
+ *
+ * Non-responsibilities:
+ * - Socket I/O (see TlsSession)
+ */
+class TlsContext {
+public:
+    TlsContext();
+    ~TlsContext();
+
+    TlsContext(const TlsContext&) = delete;
+    TlsContext& operator=(const TlsContext&) = delete;
+
+    // Returns false and fills err on failure
+    bool init(const std::string& cert_file,
+              const std::string& key_file,
+              size_t session_cache_size,
+              bool enable_ktls,
+              bool offer_h2,
+              std::string& err);
+
+    SSL_CTX* native() const { return ctx_; }
+
+    TlsStats& stats() { return stats_; }
+    const TlsStats& stats() const { return stats_; }
+
+private:
+    SSL_CTX* ctx_;
+    bool offer_h2_;
+    TlsStats stats_;
+};
@@ -0,0 +1,133 @@
+#include "tls_session.h"
+
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+
+#include <cerrno>
+#include <chrono>
+
+TlsSession::TlsSession(TlsContext& ctx, int fd)
+    : ctx_(ctx),
+      ssl_(SSL_new(ctx.native())) {
+
+    if (ssl_) {
+        SSL_set_fd(ssl_, fd);
+        SSL_set_accept_state(ssl_);
+    }
+}
+
+TlsSession::~TlsSession() {
+    if (ssl_) {
+        SSL_free(ssl_);
+    }
+}
+
+TlsHandshakeResult TlsSession::handshake() {
+    if (!ssl_ || failed_) {
+        return TlsHandshakeResult::ERROR;
+    }
+    if (established_) {
+        return TlsHandshakeResult::DONE;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    ERR_clear_error();
+    int rc = SSL_do_handshake(ssl_);
+    ctx_.stats().handshake_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+
+    if (rc == 1) {
+        established_ = true;
+
+        TlsStats& st = ctx_.stats();
+        ++st.handshakes;
+        if (SSL_session_reused(ssl_)) {
+            ++st.resumed;
+        }
+        if (ktls_send()) {
+            ++st.ktls_tx;
+        }
+        if (ktls_recv()) {
+            ++st.ktls_rx;
+        }
+        return TlsHandshakeResult::DONE;
+    }
+
+    switch (SSL_get_error(ssl_, rc)) {
+    case SSL_ERROR_WANT_READ:
+        return TlsHandshakeResult::WANT_READ;
+    case SSL_ERROR_WANT_WRITE:
+        return TlsHandshakeResult::WANT_WRITE;
+    default:
+        failed_ = true;
+        ++ctx_.stats().handshake_failures;
+        return TlsHandshakeResult::ERROR;
+    }
+}
+
+ssize_t TlsSession::read(void* buf, size_t len) {
+    size_t n = 0;
+    ERR_clear_error();
+    int rc = SSL_read_ex(ssl_, buf, len, &n);
+    if (rc == 1) {
+        return static_cast<ssize_t>(n);
+    }
+
+    switch (SSL_get_error(ssl_, rc)) {
+    case SSL_ERROR_WANT_READ:
+    case SSL_ERROR_WANT_WRITE:
+        errno = EAGAIN;
+        return -1;
+    case SSL_ERROR_ZERO_RETURN:
+        return 0;
+    default:
+        errno = EIO;
+        return -1;
+    }
+}
+
+ssize_t TlsSession::write(const void* buf, size_t len) {
+    size_t n = 0;
+    ERR_clear_error();
+    int rc = SSL_write_ex(ssl_, buf, len, &n);
+    if (rc == 1) {
+        return static_cast<ssize_t>(n);
+    }
+
+    switch (SSL_get_error(ssl_, rc)) {
+    case SSL_ERROR_WANT_READ:
+    case SSL_ERROR_WANT_WRITE:
+        errno = EAGAIN;
+        return -1;
+    default:
+        errno = EIO;
+        return -1;
+    }
+}
+
+bool TlsSession::ktls_send() const {
+#ifndef OPENSSL_NO_KTLS
+    return ssl_ && BIO_get_ktls_send(SSL_get_wbio(ssl_));
+#else
+    return false;
+#endif
+}
+
+bool TlsSession::ktls_recv() const {
+#ifndef OPENSSL_NO_KTLS
+    return ssl_ && BIO_get_ktls_recv(SSL_get_rbio(ssl_));
+#else
+    return false;
+#endif
+}
+
+bool TlsSession::can_splice() const {
+    return established_ && ktls_send() && ktls_recv() && !SSL_has_pending(ssl_);
+}
+
+void TlsSession::shutdown() {
+    if (ssl_ && established_) {
+        ERR_clear_error();
+        SSL_shutdown(ssl_);
+    }
+}
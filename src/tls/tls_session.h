@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <sys/types.h>
+
+#include "tls_context.h"
+
+typedef struct ssl_st SSL;
+
+/*
+ * TlsHandshakeResult
+ * ------------------
+ * Outcome of one non-blocking handshake step.
+ */
+enum class TlsHandshakeResult {
+    DONE,           // Handshake complete, application data may flow
+    WANT_READ,      // Wait for EPOLLIN
+    WANT_WRITE,     // Wait for EPOLLOUT
+    ERROR           // Fatal, close the connection
+};
+
+/*
+ * TlsSession
+ * ----------
+ * Server-side TLS state for one client socket.
+ *
+ * Core rules:
+ * - Does not own the fd (Connection does)
+ * - Never blocks; every call maps OpenSSL WANT_* to errno EAGAIN
+ * - read()/write() follow Socket::read/Socket::write return conventions
+ *
+ * Once the handshake completes with kTLS active, OpenSSL hands record
+ * encryption to the kernel; read()/write() become plain syscalls and,
+ * with offload in both directions, a tunnel can splice() the fd.
+ */
+class TlsSession {
+public:
+    TlsSession(TlsContext& ctx, int fd);
+    ~TlsSession();
+
+    TlsSession(const TlsSession&) = delete;
+    TlsSession& operator=(const TlsSession&) = delete;
+
+    // Advance the handshake; updates ctx stats on completion / failure
+    TlsHandshakeResult handshake();
+
+    bool established() const { return established_; }
+
+    // Returns:
+    //  >0 : bytes
+    //   0 : peer closed (close_notify or EOF)
+    //  -1 : error, errno == EAGAIN when retry is needed
+    ssize_t read(void* buf, size_t len);
+    ssize_t write(const void* buf, size_t len);
+
+    bool ktls_send() const;
+    bool ktls_recv() const;
+
+    // The kernel handles records both ways and OpenSSL holds no data of
+    // its own: the fd may be spliced like a plain socket
+    bool can_splice() const;
+
+    // Best-effort close_notify (non-blocking)
+    void shutdown();
+
+private:
+    TlsContext& ctx_;
+    SSL* ssl_;
+    bool established_{false};
+    bool failed_{false};
+};
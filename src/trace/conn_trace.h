@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+
+#include "trace_clock.h"
+
+/*
+ * TracePoint
+ * ----------
+ * Lifecycle milestones of one client connection, in the order a plain
+ * HTTP/1.1 request normally reaches them. Points a connection never
+ * reaches (no TLS, literal backend, client gave up) stay unset.
+ */
+enum class TracePoint : uint8_t {
+    ACCEPT = 0,
+    TLS_DONE,
+    REQUEST_HEADERS,        // request head fully parsed
+    BACKEND_RESOLVED,       // backend address known (cache hit or DNS answer)
+    BACKEND_CONNECT,        // connect() issued and request forwarded
+    BACKEND_FIRST_BYTE,
+    CLIENT_FIRST_WRITE,     // first response bytes accepted by the client socket
+    CLOSE,
+    COUNT
+};
+
+constexpr int kTracePoints = static_cast<int>(TracePoint::COUNT);
+
+/*
+ * ConnTrace
+ * ---------
+ * Per-connection timestamp slots, embedded in Connection.
+ *
+ * Core rules:
+ * - Only sampled connections take timestamps; for the rest mark() is a
+ *   single predictable branch, so tracing costs nothing when disabled
+ * - Each point records its first occurrence only
+ */
+struct ConnTrace {
+    uint64_t ticks[kTracePoints] = {};
+    uint32_t conn_id{0};
+    bool sampled{false};
+
+    void mark(TracePoint p) {
+        if (__builtin_expect(!sampled, 1)) {
+            return;
+        }
+        uint64_t& slot = ticks[static_cast<int>(p)];
+        if (slot == 0) {
+            slot = TraceClock::now();
+        }
+    }
+};
+
+/*
+ * TraceSampler
+ * ------------
+ * Picks every Nth connection for tracing (0 = none). Loop-thread only.
+ */
+class TraceSampler {
+public:
+    bool sample(uint32_t every) {
+        if (every == 0) {
+            return false;
+        }
+        if (countdown_ == 0 || countdown_ > every) {
+            countdown_ = every;
+        }
+        return --countdown_ == 0;
+    }
+
+private:
+    uint32_t countdown_{0};
+};
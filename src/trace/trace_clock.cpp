@@ -0,0 +1,42 @@
+#include "trace_clock.h"
+
+#include <thread>
+#include <chrono>
+
+static uint64_t clock_ns(clockid_t id) {
+    timespec ts;
+    ::clock_gettime(id, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+}
+
+TraceClock::Calibration TraceClock::calibrate(unsigned sample_ms) {
+    Calibration c;
+
+    uint64_t mono0 = clock_ns(CLOCK_MONOTONIC);
+    uint64_t ticks0 = now();
+    c.base_realtime_ns = clock_ns(CLOCK_REALTIME);
+    c.base_ticks = ticks0;
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(sample_ms));
+
+    uint64_t mono1 = clock_ns(CLOCK_MONOTONIC);
+    uint64_t ticks1 = now();
+
+    if (mono1 > mono0 && ticks1 > ticks0) {
+        c.ticks_per_ns = static_cast<double>(ticks1 - ticks0) /
+                         static_cast<double>(mono1 - mono0);
+    }
+    return c;
+}
+
+uint64_t TraceClock::Calibration::to_ns(uint64_t tick_delta) const {
+    return static_cast<uint64_t>(static_cast<double>(tick_delta) / ticks_per_ns);
+}
+
+uint64_t TraceClock::Calibration::to_realtime_ns(uint64_t ticks) const {
+    // Ticks taken before calibration (early accepts) map backwards
+    if (ticks >= base_ticks) {
+        return base_realtime_ns + to_ns(ticks - base_ticks);
+    }
+    return base_realtime_ns - to_ns(base_ticks - ticks);
+}
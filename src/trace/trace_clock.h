@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/*
+ * TraceClock
+ * ----------
+ * Cheapest available monotonic timestamp for lifecycle tracing.
+ *
+ * Core rules:
+ * - now() is a raw tick count: TSC on x86, CLOCK_MONOTONIC_COARSE
+ *   nanoseconds elsewhere; ticks are only meaningful as differences
+ * - Converting ticks to time needs a Calibration, taken once off the
+ *   hot path (the trace writer does it at startup)
+ * - Assumes an invariant TSC (constant rate, synchronized across cores),
+ *   which every x86 server CPU of the last decade provides
+ */
+class TraceClock {
+public:
+    static uint64_t now() {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        timespec ts;
+        ::clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+        return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+#endif
+    }
+
+    // Maps ticks to wall-clock time
+    struct Calibration {
+        uint64_t base_ticks{0};
+        uint64_t base_realtime_ns{0};
+        double ticks_per_ns{1.0};
+
+        uint64_t to_realtime_ns(uint64_t ticks) const;
+        uint64_t to_ns(uint64_t tick_delta) const;
+    };
+
+    // Blocks for about sample_ms to measure the tick rate
+    static Calibration calibrate(unsigned sample_ms = 20);
+};
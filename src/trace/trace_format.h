@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+
+#include "conn_trace.h"
+
+/*
+ * Trace export file format (little-endian, fixed-size records)
+ * -----------------------------------------------------------
+ *
+ *   TraceFileHeader     once, at offset 0
+ *   TraceFileRecord     repeated until EOF
+ *
+ * A record carries the accept time as wall-clock microseconds and every
+ * other point as microseconds since accept (kTraceUnset when the
+ * connection never reached it). Readers must check magic, version and
+ * record_size, and may ignore a truncated final record.
+ */
+constexpr char kTraceMagic[8] = {'P', 'X', 'T', 'R', 'A', 'C', 'E', '\0'};
+constexpr uint32_t kTraceVersion = 1;
+constexpr uint32_t kTraceUnset = 0xffffffffu;
+
+struct TraceFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+    uint32_t points;            // kTracePoints at write time
+    uint32_t reserved;
+};
+
+struct TraceFileRecord {
+    uint64_t accept_unix_us;
+    uint32_t worker;
+    uint32_t conn_id;
+    uint32_t since_accept_us[kTracePoints];     // [ACCEPT] is always 0
+};
+
+static_assert(sizeof(TraceFileHeader) == 24, "trace header layout");
+static_assert(sizeof(TraceFileRecord) == 16 + 4 * kTracePoints, "trace record layout");
+
+// Short stable names used by the decoder (indexed by TracePoint)
+inline const char* trace_point_name(int p) {
+    static const char* const kNames[kTracePoints] = {
+        "accept", "tls", "headers", "resolved",
+        "connect", "backend_first", "client_first", "close",
+    };
+    return p >= 0 && p < kTracePoints ? kNames[p] : "?";
+}
+
+/*
+ * TraceFileReader
+ * ---------------
+ * Sequential reader over an export file (used by the decoder and tests).
+ */
+class TraceFileReader {
+public:
+    explicit TraceFileReader(FILE* f) : f_(f) {}
+
+    // Returns false if the header is missing or incompatible
+    bool read_header() {
+        TraceFileHeader h{};
+        if (std::fread(&h, sizeof(h), 1, f_) != 1) {
+            return false;
+        }
+        for (int i = 0; i < 8; ++i) {
+            if (h.magic[i] != kTraceMagic[i]) {
+                return false;
+            }
+        }
+        return h.version == kTraceVersion &&
+               h.record_size == sizeof(TraceFileRecord) &&
+               h.points == static_cast<uint32_t>(kTracePoints);
+    }
+
+    // Returns false at EOF (or on a truncated final record)
+    bool next(TraceFileRecord& out) {
+        return std::fread(&out, sizeof(out), 1, f_) == 1;
+    }
+
+private:
+    FILE* f_;
+};
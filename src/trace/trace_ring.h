@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "conn_trace.h"
+#include "core/buffer/spsc_ring.h"
+
+// A completed trace as it travels to the writer thread
+struct TraceEntry {
+    uint64_t ticks[kTracePoints];
+    uint32_t conn_id;
+};
+
+/*
+ * TraceRing
+ * ---------
+ * SpscRing of completed traces, tagged with the worker that feeds it.
+ *
+ * Core rules:
+ * - One ring per event loop: the loop thread is the only producer,
+ *   the trace writer thread the only consumer
+ * - A full ring drops the trace and counts it (tracing must never slow
+ *   the proxy down)
+ */
+class TraceRing : public SpscRing<TraceEntry> {
+public:
+    using Entry = TraceEntry;
+
+    explicit TraceRing(uint32_t worker, size_t capacity = 4096)
+        : SpscRing(capacity),
+          worker_(worker) {}
+
+    // Producer side (loop thread)
+    bool push(const ConnTrace& t) {
+        Entry e;
+        for (int i = 0; i < kTracePoints; ++i) {
+            e.ticks[i] = t.ticks[i];
+        }
+        e.conn_id = t.conn_id;
+        return SpscRing::push(e);
+    }
+
+    uint32_t worker() const { return worker_; }
+
+private:
+    uint32_t worker_;
+};
@@ -0,0 +1,123 @@
+#include "trace_writer.h"
+#include "trace_format.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+TraceWriter::TraceWriter(unsigned flush_interval_ms)
+    : flush_interval_ms_(flush_interval_ms) {
+}
+
+TraceWriter::~TraceWriter() {
+    stop();
+}
+
+bool TraceWriter::open(const std::string& path, std::string& err) {
+    file_ = std::fopen(path.c_str(), "ab");
+    if (!file_) {
+        err = "cannot open " + path + ": " + std::strerror(errno);
+        return false;
+    }
+
+    if (std::ftell(file_) == 0) {
+        TraceFileHeader h{};
+        std::memcpy(h.magic, kTraceMagic, sizeof(h.magic));
+        h.version = kTraceVersion;
+        h.record_size = sizeof(TraceFileRecord);
+        h.points = kTracePoints;
+        if (std::fwrite(&h, sizeof(h), 1, file_) != 1) {
+            err = "cannot write trace header to " + path;
+            std::fclose(file_);
+            file_ = nullptr;
+            return false;
+        }
+        std::fflush(file_);
+    }
+
+    clock_ = TraceClock::calibrate();
+    return true;
+}
+
+TraceRing* TraceWriter::make_ring(uint32_t worker, size_t capacity) {
+    rings_.push_back(std::make_unique<TraceRing>(worker, capacity));
+    return rings_.back().get();
+}
+
+void TraceWriter::start() {
+    thread_ = std::thread([this] { run(); });
+}
+
+void TraceWriter::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        stopping_ = true;
+    }
+    cv_.notify_one();
+
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+
+    if (file_) {
+        drain();
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+}
+
+uint64_t TraceWriter::dropped() const {
+    uint64_t n = 0;
+    for (const auto& r : rings_) {
+        n += r->dropped();
+    }
+    return n;
+}
+
+void TraceWriter::run() {
+    std::unique_lock<std::mutex> lock(mu_);
+    while (!stopping_) {
+        cv_.wait_for(lock, std::chrono::milliseconds(flush_interval_ms_));
+        lock.unlock();
+        drain();
+        lock.lock();
+    }
+}
+
+size_t TraceWriter::drain() {
+    if (!file_) {
+        return 0;
+    }
+
+    size_t n = 0;
+    TraceRing::Entry e;
+    TraceFileRecord rec;
+
+    for (const auto& ring : rings_) {
+        while (ring->pop(e)) {
+            uint64_t accept = e.ticks[static_cast<int>(TracePoint::ACCEPT)];
+
+            rec.accept_unix_us = clock_.to_realtime_ns(accept) / 1000;
+            rec.worker = ring->worker();
+            rec.conn_id = e.conn_id;
+            for (int i = 0; i < kTracePoints; ++i) {
+                if (e.ticks[i] == 0 || e.ticks[i] < accept) {
+                    rec.since_accept_us[i] = kTraceUnset;
+                    continue;
+                }
+                uint64_t us = clock_.to_ns(e.ticks[i] - accept) / 1000;
+                rec.since_accept_us[i] = us < kTraceUnset ? static_cast<uint32_t>(us)
+                                                          : kTraceUnset - 1;
+            }
+
+            std::fwrite(&rec, sizeof(rec), 1, file_);
+            ++n;
+        }
+    }
+
+    if (n > 0) {
+        std::fflush(file_);
+        written_.fetch_add(n, std::memory_order_relaxed);
+    }
+    return n;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "trace_clock.h"
+#include "trace_ring.h"
+
+/*
+ * TraceWriter
+ * -----------
+ * Background thread that drains every loop's TraceRing into a trace
+ * export file (see trace_format.h).
+ *
+ * Core rules:
+ * - Rings are created with make_ring() before start() and owned here,
+ *   so they outlive the loops that push into them
+ * - Tick-to-time conversion and file I/O happen on this thread only
+ * - stop() (or the destructor) drains what is left and closes the file
+ *
+ * Non-responsibilities:
+ * - Sampling decisions (ConnectionManager)
+ * - Rotating or truncating the file
+ */
+class TraceWriter {
+public:
+    explicit TraceWriter(unsigned flush_interval_ms = 100);
+    ~TraceWriter();
+
+    TraceWriter(const TraceWriter&) = delete;
+    TraceWriter& operator=(const TraceWriter&) = delete;
+
+    // Open (append) path and write a header if the file is new
+    // Returns false and fills err on failure
+    bool open(const std::string& path, std::string& err);
+
+    // One ring per producing loop; call before start()
+    TraceRing* make_ring(uint32_t worker, size_t capacity = 4096);
+
+    void start();
+    void stop();
+
+    uint64_t written() const { return written_.load(std::memory_order_relaxed); }
+    uint64_t dropped() const;
+
+private:
+    void run();
+    size_t drain();
+
+    unsigned flush_interval_ms_;
+    FILE* file_{nullptr};
+    TraceClock::Calibration clock_;
+
+    std::vector<std::unique_ptr<TraceRing>> rings_;
+    std::thread thread_;
+
+    std::mutex mu_;
+    std::condition_variable cv_;
+    bool stopping_{false};
+
+    std::atomic<uint64_t> written_{0};
+};
@@ -0,0 +1,144 @@
+#include "handoff.h"
+#include "core/socket/fd_passing.h"
+#include "core/socket/socket.h"
+
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+constexpr char kHello[4] = {'L', 'S', 'N', '1'};
+constexpr char kAck = 'A';
+
+bool make_addr(const std::string& path, sockaddr_un& addr) {
+    if (path.empty() || path.size() >= sizeof(addr.sun_path)) {
+        return false;
+    }
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+} // namespace
+
+HandoffServer::~HandoffServer() {
+    close();
+}
+
+bool HandoffServer::listen(const std::string& path) {
+    sockaddr_un addr;
+    if (!make_addr(path, addr)) {
+        return false;
+    }
+
+    FDWrapper fd(::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0));
+    if (!fd.valid()) {
+        return false;
+    }
+
+    ::unlink(path.c_str());
+
+    if (::bind(fd.get(), reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        return false;
+    }
+
+    if (::listen(fd.get(), 1) < 0) {
+        return false;
+    }
+
+    path_ = path;
+    listen_fd_ = std::move(fd);
+    return true;
+}
+
+int HandoffServer::accept_and_send(const std::vector<int>& listen_fds) {
+    int pfd = ::accept4(listen_fd_.get(), nullptr, nullptr,
+                        SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (pfd < 0) {
+        return -1;
+    }
+
+    // Only one upgrade at a time
+    if (peer_fd_.valid()) {
+        ::close(pfd);
+        return -1;
+    }
+
+    // A fresh Unix socket has an empty send buffer, so this cannot EAGAIN
+    if (FdPassing::send(pfd, kHello, sizeof(kHello), listen_fds) < 0) {
+        ::close(pfd);
+        return -1;
+    }
+
+    peer_fd_.reset(pfd);
+    std::cout << "[upgrade] sent " << listen_fds.size()
+              << " listening fd(s) to new process\n";
+    return pfd;
+}
+
+bool HandoffServer::read_ack() {
+    char c = 0;
+    ssize_t n = Socket::read(peer_fd_.get(), &c, 1);
+    if (n == 1 && c == kAck) {
+        return true;
+    }
+
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+        // New process died before taking over; keep serving
+        std::cerr << "[upgrade] new process went away, continuing\n";
+        peer_fd_.reset();
+    }
+    return false;
+}
+
+void HandoffServer::close() {
+    peer_fd_.reset();
+    listen_fd_.reset();
+}
+
+bool HandoffClient::receive(const std::string& path,
+                            std::vector<int>& fds,
+                            FDWrapper& channel) {
+    sockaddr_un addr;
+    if (!make_addr(path, addr)) {
+        return false;
+    }
+
+    FDWrapper fd(::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0));
+    if (!fd.valid()) {
+        return false;
+    }
+
+    if (::connect(fd.get(), reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        return false;
+    }
+
+    // Startup only: bound the wait so a wedged old process cannot hang us
+    timeval tv{5, 0};
+    ::setsockopt(fd.get(), SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    char hello[sizeof(kHello)] = {};
+    ssize_t n = FdPassing::recv(fd.get(), hello, sizeof(hello), fds);
+    if (n != static_cast<ssize_t>(sizeof(kHello)) ||
+        std::memcmp(hello, kHello, sizeof(kHello)) != 0 ||
+        fds.empty()) {
+        for (int f : fds) {
+            ::close(f);
+        }
+        fds.clear();
+        return false;
+    }
+
+    channel = std::move(fd);
+    return true;
+}
+
+bool HandoffClient::ack(int channel) {
+    return Socket::write(channel, &kAck, 1) == 1;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "core/fd/fd_wrapper.h"
+
+/*
+ * Listening-socket handoff for zero-downtime binary upgrades
+ * ----------------------------------------------------------
+ *
+ * Protocol (over a Unix stream socket at a configured path):
+ *   1. New process connects to the path
+ *   2. Old process sends "LSN1" with its listening fds (SCM_RIGHTS)
+ *   3. New process adopts the fds and replies with a single 'A' byte
+ *   4. Old process stops accepting and drains its connections
+ *   5. New process rebinds the path so it can be upgraded in turn
+ *
+ * The kernel keeps the listening sockets (and their accept queues) alive
+ * across the switch, so no SYN is refused during the upgrade.
+ */
+
+/*
+ * HandoffServer
+ * -------------
+ * Old-process side. Owns the Unix listening socket and at most one peer.
+ *
+ * All sockets are non-blocking and driven by the caller's EpollLoop.
+ */
+class HandoffServer {
+public:
+    HandoffServer() = default;
+    ~HandoffServer();
+
+    HandoffServer(const HandoffServer&) = delete;
+    HandoffServer& operator=(const HandoffServer&) = delete;
+
+    // Unlink any stale path, bind and listen
+    bool listen(const std::string& path);
+
+    // Accept a pending upgrade request and send listen_fds to it.
+    // Returns the peer fd to register for EPOLLIN, or -1.
+    int accept_and_send(const std::vector<int>& listen_fds);
+
+    // Read the peer's acknowledgement
+    // Returns true once the new process confirmed it owns the sockets
+    bool read_ack();
+
+    // Close the Unix socket and peer (path is left to the new owner)
+    void close();
+
+    int fd() const { return listen_fd_.get(); }
+    int peer_fd() const { return peer_fd_.get(); }
+
+private:
+    std::string path_;
+    FDWrapper listen_fd_;
+    FDWrapper peer_fd_;
+};
+
+/*
+ * HandoffClient
+ * -------------
+ * New-process side. Used once at startup, before the event loop runs.
+ */
+class HandoffClient {
+public:
+    // Connect to a running proxy and receive its listening fds.
+    // Returns false if no proxy is listening on path (fresh start).
+    // On success the caller owns every fd in fds.
+    static bool receive(const std::string& path,
+                        std::vector<int>& fds,
+                        FDWrapper& channel);
+
+    // Tell the old process it may stop accepting
+    static bool ack(int channel);
+};
@@ -0,0 +1,66 @@
+#include <cstdint>
+#include <cstdio>
+#include <dirent.h>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+/*
+ * Standalone driver for libFuzzer targets on toolchains without
+ * libFuzzer: runs LLVMFuzzerTestOneInput once per file named on the
+ * command line (directories are expanded one level), e.g.
+ *
+ *   http_parser_fuzz tests/fuzz/corpus/http_parser crash-1234
+ */
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+static bool run_file(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        std::cerr << "cannot read " << path << "\n";
+        return false;
+    }
+    std::vector<char> bytes((std::istreambuf_iterator<char>(in)),
+                            std::istreambuf_iterator<char>());
+    LLVMFuzzerTestOneInput(reinterpret_cast<const uint8_t*>(bytes.data()), bytes.size());
+    return true;
+}
+
+int main(int argc, char** argv) {
+    size_t ran = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        struct stat st{};
+        if (::stat(argv[i], &st) != 0) {
+            std::cerr << "cannot stat " << argv[i] << "\n";
+            return 1;
+        }
+
+        if (!S_ISDIR(st.st_mode)) {
+            if (!run_file(argv[i]))
+                return 1;
+            ++ran;
+            continue;
+        }
+
+        DIR* dir = ::opendir(argv[i]);
+        if (!dir)
+            return 1;
+        while (dirent* e = ::readdir(dir)) {
+            if (e->d_name[0] == '.')
+                continue;
+            if (!run_file(std::string(argv[i]) + "/" + e->d_name)) {
+                ::closedir(dir);
+                return 1;
+            }
+            ++ran;
+        }
+        ::closedir(dir);
+    }
+
+    std::cout << ran << " input(s) replayed\n";
+    return 0;
+}
@@ -0,0 +1,94 @@
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+
+#include "protocol/http/http_parser.h"
+
+/*
+ * libFuzzer target for HttpParser.
+ *
+ * Besides "does not crash" (and whatever ASan/UBSan catch), every input
+ * is checked differentially: the proxy re-parses its growing buffer
+ * after each read, so parsing any prefix must give INCOMPLETE or exactly
+ * the result of parsing the whole input. The helpers must also stay
+ * inside the head the parser reported, and no request carrying
+ * Transfer-Encoding may come back COMPLETE.
+ *
+ * Built with -fsanitize=fuzzer under Clang (PROXY_FUZZ=ON); otherwise
+ * linked with fuzz_replay_main.cpp to replay the seed corpus.
+ */
+static void check(bool cond) {
+    if (!cond) {
+        std::abort();
+    }
+}
+
+// Any header line whose name is Transfer-Encoding (case and whitespace
+// before the colon aside)
+static bool mentions_transfer_encoding(const std::string& head) {
+    static const char kKey[] = "transfer-encoding";
+    size_t p = 0;
+    while (p < head.size()) {
+        size_t eol = head.find('\n', p);
+        if (eol == std::string::npos) {
+            eol = head.size();
+        }
+        size_t k = 0;
+        while (kKey[k] && p + k < eol &&
+               std::tolower(static_cast<unsigned char>(head[p + k])) == kKey[k]) {
+            ++k;
+        }
+        if (!kKey[k]) {
+            size_t c = p + k;
+            while (c < eol && (head[c] == ' ' || head[c] == '\t')) {
+                ++c;
+            }
+            if (c < eol && head[c] == ':') {
+                return true;
+            }
+        }
+        p = eol + 1;
+    }
+    return false;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    // Own copy per call so ASan sees reads past the end
+    std::string full(reinterpret_cast<const char*>(data), size);
+
+    HttpParser parser;
+    HttpRequestInfo whole{};
+    HttpParseResult want = parser.parse(full.data(), full.size(), whole);
+
+    if (want == HttpParseResult::COMPLETE) {
+        check(whole.header_bytes <= size);
+        check(whole.body_bytes <= size - whole.header_bytes);
+
+        // Only Content-Length frames bodies: a TE request is never complete
+        check(!mentions_transfer_encoding(full.substr(0, whole.header_bytes)));
+
+        std::pmr::string value;
+        HttpParser::find_header(full.data(), whole.header_bytes, "Host", value);
+        std::pmr::string method;
+        std::pmr::string target;
+        HttpParser::parse_request_line(full.data(), whole.header_bytes, method, target);
+    }
+
+    for (size_t k = 0; k < size; ++k) {
+        std::string prefix(full.data(), k);
+        HttpRequestInfo part{};
+        HttpParseResult got = parser.parse(prefix.data(), prefix.size(), part);
+
+        if (got == HttpParseResult::INCOMPLETE) {
+            continue;
+        }
+        check(got == want);
+        if (got == HttpParseResult::COMPLETE) {
+            check(part.header_bytes == whole.header_bytes);
+            check(part.body_bytes == whole.body_bytes);
+        }
+    }
+    return 0;
+}
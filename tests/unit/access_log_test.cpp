@@ -0,0 +1,237 @@
+#include <arpa/inet.h>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "access_log/access_log_ring.h"
+#include "access_log/access_log_writer.h"
+#include "access_log/access_record.h"
+
+/*
+ * Unit tests for the access log: request line capture, the SPSC ring,
+ * line formatting and the writer's rotation and reopen handling.
+ */
+
+std::string temp_path() {
+    char path[] = "/tmp/access_log_test_XXXXXX";
+    int fd = ::mkstemp(path);
+    assert(fd >= 0);
+    ::close(fd);
+    ::unlink(path);
+    return path;
+}
+
+std::vector<std::string> read_lines(const std::string& path) {
+    std::vector<std::string> lines;
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line)) {
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+AccessRecord make_record(uint32_t conn_id) {
+    static const char kHead[] = "GET /index.html HTTP/1.1\r\nHost: a\r\n\r\n";
+    AccessRecord r;
+    r.set_request_line(kHead, sizeof(kHead) - 1);
+    r.conn_id = conn_id;
+    r.status = 200;
+    return r;
+}
+
+void test_request_line() {
+    AccessRecord r;
+    const char head[] = "POST /a/b?c=d HTTP/1.1\r\n\r\n";
+    r.set_request_line(head, sizeof(head) - 1);
+    assert(std::string(r.method, r.method_len) == "POST");
+    assert(r.target_len == 8 && std::memcmp(r.target, "/a/b?c=d", 8) == 0);
+
+    // Long targets are cut but keep their length
+    std::string target(300, 'x');
+    std::string req = "GET /" + target + " HTTP/1.1\r\n\r\n";
+    r.set_request_line(req.data(), req.size());
+    assert(r.target_len == 301);
+    assert(r.target[0] == '/' && r.target[AccessRecord::kTargetBytes - 1] == 'x');
+
+    // Not a request line: nothing captured
+    const char bad[] = "GARBAGE\r\n\r\n";
+    r.set_request_line(bad, sizeof(bad) - 1);
+    assert(r.method_len == 0 && r.target_len == 0);
+}
+
+void test_ring_full_drops() {
+    AccessLogRing ring(0, 3);
+    assert(ring.capacity() == 4);
+
+    AccessRecord r;
+    for (int i = 0; i < 4; ++i) {
+        r.conn_id = i;
+        assert(ring.push(r));
+    }
+    assert(!ring.push(r));
+    assert(ring.dropped() == 1);
+
+    AccessRecord out;
+    for (uint32_t i = 0; i < 4; ++i) {
+        assert(ring.pop(out) && out.conn_id == i);
+    }
+    assert(!ring.pop(out));
+    assert(ring.push(r));
+}
+
+void test_format() {
+    AccessRecord r;
+    const char head[] = "GET /q?\"x\"\\\x01 HTTP/1.1\r\n\r\n";
+    r.set_request_line(head, sizeof(head) - 1);
+    r.time_ms = 1700000000123ull;         // 2023-11-14T22:13:20.123Z
+    r.conn_id = 5;
+    r.status = 502;
+    r.bytes_in = 40;
+    r.bytes_out = 90;
+    r.duration_us = 1234;
+    r.family = AF_INET;
+    inet_pton(AF_INET, "10.0.0.1", r.client);
+    inet_pton(AF_INET, "10.0.0.2", &r.upstream_addr);
+    r.upstream_port = 8080;
+    r.flags = AccessRecord::TUNNEL;
+
+    std::string line;
+    AccessLogWriter::format(r, 3, line);
+    assert(line ==
+           "{\"time\":\"2023-11-14T22:13:20.123Z\",\"worker\":3,\"conn\":5,"
+           "\"client\":\"10.0.0.1\",\"method\":\"GET\","
+           "\"target\":\"/q?\\\"x\\\"\\\\\\u0001\",\"status\":502,\"bytes_in\":40,"
+           "\"bytes_out\":90,\"duration_us\":1234,\"upstream\":\"10.0.0.2:8080\","
+           "\"tunnel\":true}\n");
+
+    // No upstream, unknown client, truncated target
+    AccessRecord t;
+    std::string req = "GET /" + std::string(200, 'y') + " HTTP/1.1\r\n\r\n";
+    t.set_request_line(req.data(), req.size());
+    line.clear();
+    AccessLogWriter::format(t, 0, line);
+    assert(line.find("\"client\":\"-\"") != std::string::npos);
+    assert(line.find("\"upstream\":null") != std::string::npos);
+    assert(line.find("yyy...\"") != std::string::npos);
+}
+
+void test_writer_lines() {
+    std::string path = temp_path();
+    {
+        AccessLogWriter writer(10);
+        std::string err;
+        assert(writer.open(path, 0, err));
+        AccessLogRing* a = writer.make_ring(0);
+        AccessLogRing* b = writer.make_ring(1);
+        writer.start();
+
+        std::thread producer([a] {
+            for (uint32_t i = 0; i < 1000; ++i) {
+                while (!a->push(make_record(i))) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+        assert(b->push(make_record(7)));
+        producer.join();
+
+        writer.stop();
+        assert(writer.written() == 1001);
+        assert(writer.dropped() == 0);
+    }
+
+    std::vector<std::string> lines = read_lines(path);
+    assert(lines.size() == 1001);
+    for (const std::string& l : lines) {
+        assert(l.front() == '{' && l.back() == '}');
+        assert(l.find("\"target\":\"/index.html\"") != std::string::npos);
+    }
+    ::unlink(path.c_str());
+}
+
+void test_size_rotation() {
+    std::string path = temp_path();
+    std::string old = path + ".1";
+    {
+        AccessLogWriter writer(5);
+        std::string err;
+        assert(writer.open(path, 1000, err));
+        AccessLogRing* ring = writer.make_ring(0);
+        writer.start();
+
+        // Each line is ~250 bytes: the first batch passes the limit
+        for (uint32_t i = 0; i < 10; ++i) {
+            assert(ring->push(make_record(i)));
+        }
+        while (writer.written() < 10) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        assert(ring->push(make_record(10)));
+        writer.stop();
+        assert(writer.rotations() == 1);
+    }
+
+    assert(read_lines(old).size() == 10);
+    std::vector<std::string> lines = read_lines(path);
+    assert(lines.size() == 1 && lines[0].find("\"conn\":10,") != std::string::npos);
+    ::unlink(path.c_str());
+    ::unlink(old.c_str());
+}
+
+void test_reopen_after_rename() {
+    std::string path = temp_path();
+    std::string moved = path + ".moved";
+    {
+        AccessLogWriter writer(5);
+        std::string err;
+        assert(writer.open(path, 0, err));
+        AccessLogRing* ring = writer.make_ring(0);
+        writer.start();
+
+        assert(ring->push(make_record(1)));
+        while (writer.written() < 1) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        // What logrotate does, then SIGUSR1
+        assert(std::rename(path.c_str(), moved.c_str()) == 0);
+        writer.reopen();
+        assert(ring->push(make_record(2)));
+        writer.stop();
+        assert(writer.write_errors() == 0);
+    }
+
+    assert(read_lines(moved).size() == 1);
+    std::vector<std::string> lines = read_lines(path);
+    assert(lines.size() == 1 && lines[0].find("\"conn\":2,") != std::string::npos);
+    ::unlink(path.c_str());
+    ::unlink(moved.c_str());
+}
+
+void test_open_failure() {
+    AccessLogWriter writer;
+    std::string err;
+    assert(!writer.open("/nonexistent/dir/access.log", 0, err));
+    assert(!err.empty());
+}
+
+int main() {
+    test_request_line();
+    test_ring_full_drops();
+    test_format();
+    test_writer_lines();
+    test_size_rotation();
+    test_reopen_after_rename();
+    test_open_failure();
+
+    std::cout << "Access log tests PASSED\n";
+    return 0;
+}
@@ -0,0 +1,205 @@
+#include <arpa/inet.h>
+#include <cassert>
+#include <iostream>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+
+#include "admin/admin_server.h"
+#include "admin/json_writer.h"
+#include "core/event_loop/epoll_loop.h"
+
+/*
+ * Unit tests for JsonWriter and AdminServer snapshot gathering.
+ * Workers are plain EpollLoops on their own threads; clients talk over
+ * loopback.
+ */
+
+void test_json_structure() {
+    JsonWriter w;
+    w.begin_object();
+    w.key("n").value(3);
+    w.key("neg").value(-2);
+    w.key("big").value(uint64_t(1) << 40);
+    w.key("ok").value(true);
+    w.key("list").begin_array().value(1).value("a").null().begin_object().end_object().end_array();
+    w.key("empty").begin_array().end_array();
+    w.key("raw").raw("{\"x\":1}");
+    w.end_object();
+
+    assert(w.str() == "{\"n\":3,\"neg\":-2,\"big\":1099511627776,\"ok\":true,"
+                      "\"list\":[1,\"a\",null,{}],\"empty\":[],\"raw\":{\"x\":1}}");
+}
+
+void test_json_escaping() {
+    JsonWriter w;
+    w.begin_array();
+    w.value("q\"b\\n\n\x01");
+    w.value(0.5);
+    w.value(1.0 / 0.0);
+    w.end_array();
+    assert(w.str() == "[\"q\\\"b\\\\n\\n\\u0001\",0.5,null]");
+}
+
+// Runs a loop the way a worker does until told to stop
+struct WorkerThread {
+    EpollLoop loop;
+    std::atomic<bool> stop{false};
+    std::thread thread;
+
+    void start() {
+        thread = std::thread([this] {
+            while (!stop.load()) {
+                loop.wait(50);
+            }
+        });
+    }
+    void join() {
+        stop = true;
+        loop.post([] {});
+        thread.join();
+    }
+};
+
+static std::string http_get(uint16_t port, const std::string& path) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in sa{};
+    sa.sin_family = AF_INET;
+    sa.sin_port = htons(port);
+    sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    assert(::connect(fd, reinterpret_cast<sockaddr*>(&sa), sizeof(sa)) == 0);
+
+    std::string req = "GET " + path + " HTTP/1.1\r\nHost: admin\r\n\r\n";
+    assert(::write(fd, req.data(), req.size()) == static_cast<ssize_t>(req.size()));
+
+    std::string out;
+    char buf[4096];
+    ssize_t n;
+    while ((n = ::read(fd, buf, sizeof(buf))) > 0) {
+        out.append(buf, n);
+    }
+    ::close(fd);
+    return out;
+}
+
+void test_snapshots_run_on_worker_threads() {
+    WorkerThread a;
+    WorkerThread b;
+    a.start();
+    b.start();
+
+    std::thread::id seen_a;
+    std::thread::id seen_b;
+
+    AdminServer admin;
+    admin.add_worker(&a.loop, [&](JsonWriter& out, bool connections) {
+        seen_a = std::this_thread::get_id();
+        out.key("name").value("a");
+        if (connections) {
+            out.key("connections").begin_array().value(7).end_array();
+        }
+    });
+    admin.add_worker(&b.loop, [&](JsonWriter& out, bool) {
+        seen_b = std::this_thread::get_id();
+        out.key("name").value("b");
+    });
+    assert(admin.start(0));
+    assert(admin.port() != 0);
+
+    std::string stats = http_get(admin.port(), "/stats");
+    assert(stats.find("HTTP/1.1 200 OK\r\n") == 0);
+    assert(stats.find("Content-Type: application/json") != std::string::npos);
+    assert(stats.find("{\"complete\":true,\"workers\":[{\"worker\":0,\"name\":\"a\"},"
+                      "{\"worker\":1,\"name\":\"b\"}]}") != std::string::npos);
+    assert(seen_a == a.thread.get_id());
+    assert(seen_b == b.thread.get_id());
+
+    std::string conns = http_get(admin.port(), "/connections");
+    assert(conns.find("\"connections\":[7]") != std::string::npos);
+
+    assert(http_get(admin.port(), "/nope").find("HTTP/1.1 404") == 0);
+    assert(admin.served() == 3);
+
+    admin.stop();
+    a.join();
+    b.join();
+}
+
+void test_stuck_worker_times_out() {
+    WorkerThread a;
+    a.start();
+    EpollLoop stuck;            // never runs: its snapshot never comes back
+
+    AdminServer admin;
+    admin.add_worker(&a.loop, [](JsonWriter& out, bool) { out.key("name").value("a"); });
+    admin.add_worker(&stuck, [](JsonWriter&, bool) {});
+    assert(admin.start(0));
+
+    std::string stats = http_get(admin.port(), "/stats");
+    assert(stats.find("{\"complete\":false,\"workers\":[{\"worker\":0,\"name\":\"a\"},null]}") !=
+           std::string::npos);
+
+    admin.stop();
+    a.join();
+}
+
+static int connect_admin(uint16_t port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in sa{};
+    sa.sin_family = AF_INET;
+    sa.sin_port = htons(port);
+    sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    assert(::connect(fd, reinterpret_cast<sockaddr*>(&sa), sizeof(sa)) == 0);
+    return fd;
+}
+
+void test_idle_clients_closed_and_capped() {
+    WorkerThread a;
+    a.start();
+
+    AdminServer admin(2, 300);
+    admin.add_worker(&a.loop, [](JsonWriter& out, bool) { out.key("name").value("a"); });
+    assert(admin.start(0));
+
+    // Two clients that never send a request fill the cap
+    int idle1 = connect_admin(admin.port());
+    int idle2 = connect_admin(admin.port());
+    assert(::write(idle2, "GET /st", 7) == 7);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    // A third is accepted and closed at once
+    int over = connect_admin(admin.port());
+    char buf[64];
+    assert(::read(over, buf, sizeof(buf)) == 0);
+    assert(admin.rejected() == 1);
+    ::close(over);
+
+    // Past the idle deadline both are closed without a reply
+    assert(::read(idle1, buf, sizeof(buf)) == 0);
+    assert(::read(idle2, buf, sizeof(buf)) == 0);
+    assert(admin.timed_out() == 2);
+    assert(admin.served() == 0);
+    ::close(idle1);
+    ::close(idle2);
+
+    // Slots are free again
+    assert(http_get(admin.port(), "/stats").find("HTTP/1.1 200 OK\r\n") == 0);
+
+    admin.stop();
+    a.join();
+}
+
+int main() {
+    test_json_structure();
+    test_json_escaping();
+    test_snapshots_run_on_worker_threads();
+    test_stuck_worker_times_out();
+    test_idle_clients_closed_and_capped();
+
+    std::cout << "Admin tests PASSED\n";
+    return 0;
+}
@@ -0,0 +1,102 @@
+#include <arpa/inet.h>
+#include <cassert>
+#include <iostream>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "admission/admission_control.h"
+#include "core/event_loop/epoll_loop.h"
+
+/*
+ * Unit tests for AdmissionControl against a real listener with a client
+ * waiting in its accept queue. Time is injected.
+ */
+
+int make_listener(sockaddr_in& sa) {
+    int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    assert(fd >= 0);
+    sa = {};
+    sa.sin_family = AF_INET;
+    sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    assert(::bind(fd, reinterpret_cast<sockaddr*>(&sa), sizeof(sa)) == 0);
+    assert(::listen(fd, 16) == 0);
+    socklen_t len = sizeof(sa);
+    assert(::getsockname(fd, reinterpret_cast<sockaddr*>(&sa), &len) == 0);
+    return fd;
+}
+
+// Listener readiness as the main loop would see it
+bool listener_ready(EpollLoop& loop) {
+    return loop.wait(0) > 0 && loop.ready_count() == 1 &&
+           loop.event_at(0).data.ptr == nullptr;
+}
+
+void test_max_connections_pause() {
+    EpollLoop loop;
+    AdmissionControl admission(loop, nullptr, 2, 8);
+
+    sockaddr_in sa;
+    int lfd = make_listener(sa);
+    loop.add(lfd, EPOLLIN, nullptr);
+    int cfd = ::socket(AF_INET, SOCK_STREAM, 0);
+    assert(::connect(cfd, reinterpret_cast<sockaddr*>(&sa), sizeof(sa)) == 0);
+
+    assert(admission.accept_budget(0) == 2);
+    assert(admission.accept_budget(2) == 0);
+
+    admission.update(lfd, 2, 0);
+    assert(admission.listener_paused() && admission.pause_count() == 1);
+    assert(!listener_ready(loop));
+
+    admission.update(lfd, 1, 0);
+    assert(!admission.listener_paused());
+    assert(listener_ready(loop));
+
+    ::close(cfd);
+    ::close(lfd);
+    std::cout << "[OK] listener paused at max_connections, resumed below it\n";
+}
+
+void test_fd_exhaustion_backs_off() {
+    EpollLoop loop;
+    AdmissionControl admission(loop, nullptr, 0, 8);
+
+    sockaddr_in sa;
+    int lfd = make_listener(sa);
+    loop.add(lfd, EPOLLIN, nullptr);
+    int cfd = ::socket(AF_INET, SOCK_STREAM, 0);
+    assert(::connect(cfd, reinterpret_cast<sockaddr*>(&sa), sizeof(sa)) == 0);
+    assert(listener_ready(loop));
+
+    // accept hit EMFILE: the queued client must not wake us every loop
+    admission.back_off(lfd, 1000, 100);
+    assert(admission.listener_paused() && admission.pause_count() == 1);
+    assert(!listener_ready(loop));
+
+    admission.update(lfd, 0, 1050);
+    assert(admission.listener_paused());
+    assert(!listener_ready(loop));
+
+    // Another failure while paused extends the backoff, not the count
+    admission.back_off(lfd, 1050, 100);
+    assert(admission.pause_count() == 1);
+    admission.update(lfd, 0, 1100);
+    assert(admission.listener_paused());
+
+    admission.update(lfd, 0, 1150);
+    assert(!admission.listener_paused());
+    assert(listener_ready(loop));
+
+    ::close(cfd);
+    ::close(lfd);
+    std::cout << "[OK] fd exhaustion pauses the listener until the backoff expires\n";
+}
+
+int main() {
+    test_max_connections_pause();
+    test_fd_exhaustion_backs_off();
+
+    std::cout << "AdmissionControl tests PASSED\n";
+    return 0;
+}
@@ -0,0 +1,129 @@
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "core/memory/arena.h"
+#include "protocol/http/http_parser.h"
+
+/*
+ * Unit tests for the per-request Arena and its chunk pool.
+ * Single thread, no sockets.
+ */
+
+void test_bump_allocation_is_aligned() {
+    Arena arena;
+    void* a = arena.allocate(3, 1);
+    void* b = arena.allocate(8, 8);
+    void* c = arena.allocate(16, 16);
+
+    assert(reinterpret_cast<uintptr_t>(b) % 8 == 0);
+    assert(reinterpret_cast<uintptr_t>(c) % 16 == 0);
+    assert(static_cast<char*>(b) > static_cast<char*>(a));
+    assert(arena.chunks() == 1);
+    assert(arena.used() == 27);
+}
+
+void test_reset_keeps_one_chunk() {
+    Arena arena;
+    for (int i = 0; i < 10; ++i) {
+        (void)arena.allocate(1000, 8);
+    }
+    assert(arena.chunks() >= 3);
+
+    ArenaChunkPool& pool = ArenaChunkPool::local();
+    size_t cached = pool.cached();
+    size_t chunks = arena.chunks();
+    arena.reset();
+
+    assert(arena.chunks() == 1);
+    assert(arena.used() == 0);
+    assert(pool.cached() == cached + chunks - 1);
+}
+
+void test_oversize_gets_own_block() {
+    Arena arena;
+    char* small = static_cast<char*>(arena.allocate(64, 8));
+    char* big = static_cast<char*>(arena.allocate(3 * ArenaChunkPool::kChunkBytes, 64));
+    assert(reinterpret_cast<uintptr_t>(big) % 64 == 0);
+    big[3 * ArenaChunkPool::kChunkBytes - 1] = 'x';
+
+    // The bump chunk is still the one in use
+    char* next = static_cast<char*>(arena.allocate(64, 8));
+    assert(next == small + 64);
+
+    arena.reset();
+    assert(arena.chunks() == 1);
+}
+
+void test_pmr_containers() {
+    Arena arena;
+    std::pmr::vector<int> v(&arena);
+    for (int i = 0; i < 100; ++i) {
+        v.push_back(i);
+    }
+    std::pmr::string s("a header value long enough to leave the SSO buffer", &arena);
+
+    assert(v[99] == 99);
+    assert(s.get_allocator().resource() == &arena);
+    assert(arena.used() > 400);
+}
+
+void test_steady_state_requests_do_not_allocate() {
+    const std::string head =
+        "GET /index.html HTTP/1.1\r\nHost: example.com\r\n"
+        "Accept-Encoding: gzip, deflate, br, zstd, and-a-long-tail-of-codings\r\n\r\n";
+
+    Arena arena;
+    ArenaChunkPool& pool = ArenaChunkPool::local();
+
+    auto request = [&] {
+        arena.reset();
+        std::pmr::string method(&arena);
+        std::pmr::string target(&arena);
+        std::pmr::string accept(&arena);
+        assert(HttpParser::parse_request_line(head.data(), head.size(), method, target));
+        assert(HttpParser::find_header(head.data(), head.size(), "Accept-Encoding", accept));
+        assert(method == "GET" && target == "/index.html");
+        assert(accept.size() > 40);
+    };
+
+    request();
+    size_t allocations = pool.allocations();
+    size_t reuses = pool.reuses();
+    for (int i = 0; i < 1000; ++i) {
+        request();
+    }
+
+    // One chunk is kept across resets: no heap, no free list
+    assert(pool.allocations() == allocations);
+    assert(pool.reuses() == reuses);
+}
+
+void test_chunks_recycled_across_arenas() {
+    ArenaChunkPool& pool = ArenaChunkPool::local();
+    {
+        Arena warm;
+        (void)warm.allocate(100, 8);
+    }
+    size_t allocations = pool.allocations();
+
+    for (int i = 0; i < 100; ++i) {
+        Arena arena;            // one per connection
+        (void)arena.allocate(100, 8);
+    }
+    assert(pool.allocations() == allocations);
+}
+
+int main() {
+    test_bump_allocation_is_aligned();
+    test_reset_keeps_one_chunk();
+    test_oversize_gets_own_block();
+    test_pmr_containers();
+    test_steady_state_requests_do_not_allocate();
+    test_chunks_recycled_across_arenas();
+
+    std::cout << "Arena tests PASSED\n";
+    return 0;
+}
@@ -0,0 +1,184 @@
+#include <cassert>
+#include <iostream>
+#include <vector>
+
+#include "balancer/circuit_breaker.h"
+#include "balancer/outlier_detector.h"
+#include "balancer/retry_budget.h"
+
+/*
+ * Unit tests for circuit breakers, fleet-wide outlier detection and the
+ * retry budget. Time is passed in explicitly; nothing sleeps.
+ */
+
+static BreakerPolicy policy() {
+    BreakerPolicy p;
+    p.failure_ratio = 0.5;
+    p.min_requests = 10;
+    p.open_ms = 1000;
+    p.max_backoff = 4;
+    return p;
+}
+
+void test_blip_does_not_trip() {
+    CircuitBreaker b(policy());
+    for (int i = 0; i < 50; ++i)
+        b.on_success(1000, 0);
+
+    // Two failures among healthy traffic
+    b.on_failure(0);
+    b.on_failure(0);
+    assert(b.state() == BreakerState::CLOSED);
+    assert(b.allow(0));
+}
+
+void test_outage_trips_then_probe_recovers() {
+    CircuitBreaker b(policy());
+    uint64_t now = 10000;
+
+    for (int i = 0; i < 9; ++i)
+        b.on_failure(now);
+    assert(b.state() == BreakerState::CLOSED);     // below min_requests
+    b.on_failure(now);
+    assert(b.state() == BreakerState::OPEN);
+    assert(!b.allow(now + 999));
+
+    // One probe at a time once the interval is over
+    assert(b.allow(now + 1000));
+    assert(b.state() == BreakerState::HALF_OPEN);
+    assert(!b.allow(now + 1001));
+
+    b.on_success(500, now + 1002);
+    assert(b.state() == BreakerState::CLOSED);
+    assert(b.trips() == 0);
+    assert(b.allow(now + 1003));
+}
+
+void test_retrip_backs_off_exponentially() {
+    CircuitBreaker b(policy());
+    uint64_t now = 0;
+
+    for (int i = 0; i < 10; ++i)
+        b.on_failure(now);
+    assert(b.open_until_ms() == 1000);
+
+    uint64_t expect[] = {2000, 4000, 4000};         // capped at 4x
+    for (uint64_t span : expect) {
+        now = b.open_until_ms();
+        assert(b.allow(now));
+        b.on_failure(now);                          // probe fails
+        assert(b.state() == BreakerState::OPEN);
+        assert(b.open_until_ms() == now + span);
+    }
+}
+
+void test_lost_probe_is_written_off() {
+    CircuitBreaker b(policy());
+    for (int i = 0; i < 10; ++i)
+        b.on_failure(0);
+
+    assert(b.allow(1000));      // probe never reports back
+    assert(!b.allow(1500));
+    assert(b.allow(2000));      // another probe after open_ms
+}
+
+void test_latency_outlier_trips() {
+    BreakerPolicy p = policy();
+    p.latency_us = 50000;
+    CircuitBreaker b(p);
+
+    for (int i = 0; i < 20; ++i)
+        b.on_success(2000, 0);
+    assert(b.state() == BreakerState::CLOSED);
+
+    for (int i = 0; i < 20 && b.state() == BreakerState::CLOSED; ++i)
+        b.on_success(200000, 0);
+    assert(b.state() == BreakerState::OPEN);
+    assert(b.latency_ewma_us() > 50000);
+}
+
+void test_fleet_merge_ejects_on_other_worker() {
+    HealthBoard board(1000);
+    OutlierDetector a;
+    OutlierDetector b;
+    a.set_policy(policy());
+    b.set_policy(policy());
+    a.set_board(&board);
+    b.set_board(&board);
+
+    const uint32_t addr = 0x0100007f;
+    const uint16_t port = 9000;
+
+    // Worker a sees only failures, but too few for its own breaker;
+    // worker b sees a mix, also too few on its own
+    for (int i = 0; i < 6; ++i)
+        a.on_failure(addr, port, 100);
+    for (int i = 0; i < 3; ++i) {
+        b.on_failure(addr, port, 100);
+        b.on_success(addr, port, 1000, 100);
+    }
+    assert(a.allow(addr, port, 100) && b.allow(addr, port, 100));
+
+    a.sync(100);
+    b.sync(200);
+    assert(b.ejected() == 0);       // window not complete yet
+
+    // Next window: both see the fleet total (9 of 12 failed)
+    a.sync(1200);
+    b.sync(1300);
+    assert(a.ejected() == 1 && b.ejected() == 1);
+    assert(!b.allow(addr, port, 1400));
+    assert(b.find(addr, port)->state() == BreakerState::OPEN);
+
+    // Other upstreams are untouched
+    assert(b.allow(addr, port + 1, 1400));
+}
+
+void test_retry_budget_ratio() {
+    RetryBudget budget(20, 0);
+
+    for (int i = 0; i < 100; ++i)
+        budget.on_request();
+
+    int granted = 0;
+    for (int i = 0; i < 100; ++i)
+        granted += budget.try_retry(5000) ? 1 : 0;
+
+    // 20% of 100 requests (floating point may leave it one short)
+    assert(granted >= 19 && granted <= 20);
+    assert(budget.denied() >= 80);
+}
+
+void test_retry_budget_minimum_per_second() {
+    RetryBudget budget(0, 3);
+
+    int granted = 0;
+    for (int i = 0; i < 10; ++i)
+        granted += budget.try_retry(1000) ? 1 : 0;
+    assert(granted == 3);
+
+    // Refilled in the next second
+    assert(budget.try_retry(2000));
+}
+
+void test_retry_budget_cap() {
+    RetryBudget budget(100, 0);
+    for (int i = 0; i < 100000; ++i)
+        budget.on_request();
+    assert(budget.balance() <= 100.0);
+}
+
+int main() {
+    test_blip_does_not_trip();
+    test_outage_trips_then_probe_recovers();
+    test_retrip_backs_off_exponentially();
+    test_lost_probe_is_written_off();
+    test_latency_outlier_trips();
+    test_fleet_merge_ejects_on_other_worker();
+    test_retry_budget_ratio();
+    test_retry_budget_minimum_per_second();
+    test_retry_budget_cap();
+
+    std::cout << "Balancer tests PASSED\n";
+    return 0;
+}
@@ -0,0 +1,307 @@
+#include <cassert>
+#include <iostream>
+#include <string>
+
+#include <zlib.h>
+
+#include "compress/compressed_cache.h"
+#include "compress/gzip_encoder.h"
+#include "compress/response_compressor.h"
+#include "core/buffer/buffer.h"
+
+/*
+ * Unit tests for the response compression stage.
+ * Pure buffers in and out; output is checked by inflating it with zlib.
+ */
+
+static std::string gunzip(const std::string& in) {
+    z_stream zs{};
+    assert(inflateInit2(&zs, 15 + 16) == Z_OK);
+
+    std::string out;
+    char chunk[4096];
+    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+    zs.avail_in = static_cast<uInt>(in.size());
+
+    int rc = Z_OK;
+    while (rc == Z_OK) {
+        zs.next_out = reinterpret_cast<Bytef*>(chunk);
+        zs.avail_out = sizeof(chunk);
+        rc = inflate(&zs, Z_NO_FLUSH);
+        out.append(chunk, sizeof(chunk) - zs.avail_out);
+    }
+    assert(rc == Z_STREAM_END);
+    inflateEnd(&zs);
+    return out;
+}
+
+static std::string drain(Buffer& b) {
+    std::string s(b.read_ptr(), b.readable_bytes());
+    b.consume(b.readable_bytes());
+    return s;
+}
+
+static std::string split_body(const std::string& response) {
+    return response.substr(response.find("\r\n\r\n") + 4);
+}
+
+static std::string text_body() {
+    std::string body;
+    for (int i = 0; i < 2000; ++i) {
+        body += "line " + std::to_string(i) + " of a very compressible document\n";
+    }
+    return body;
+}
+
+void test_negotiate() {
+    assert(ResponseCompressor::negotiate("gzip") == ContentCoding::GZIP);
+    assert(ResponseCompressor::negotiate("deflate, gzip;q=0.5") == ContentCoding::GZIP);
+    assert(ResponseCompressor::negotiate("br, GZIP") == ContentCoding::GZIP);
+    assert(ResponseCompressor::negotiate("gzip;q=0") == ContentCoding::IDENTITY);
+    assert(ResponseCompressor::negotiate("identity") == ContentCoding::IDENTITY);
+    assert(ResponseCompressor::negotiate("") == ContentCoding::IDENTITY);
+}
+
+void test_compressible_types() {
+    assert(ResponseCompressor::compressible_type("text/html; charset=utf-8"));
+    assert(ResponseCompressor::compressible_type("application/json"));
+    assert(ResponseCompressor::compressible_type("application/problem+json"));
+    assert(ResponseCompressor::compressible_type("image/svg+xml"));
+    assert(!ResponseCompressor::compressible_type("image/png"));
+    assert(!ResponseCompressor::compressible_type("application/octet-stream"));
+}
+
+void test_gzip_roundtrip_streamed() {
+    GzipEncoder enc(6);
+    assert(enc.valid());
+
+    std::string body = text_body();
+    Buffer out;
+    for (size_t i = 0; i < body.size(); i += 1000) {
+        assert(enc.compress(body.data() + i, std::min<size_t>(1000, body.size() - i),
+                            false, out));
+    }
+    assert(enc.compress(nullptr, 0, true, out));
+
+    std::string gz = drain(out);
+    assert(gz.size() < body.size() / 4);
+    assert(gunzip(gz) == body);
+
+    // Reset keeps the stream usable for the next response
+    enc.reset();
+    assert(enc.compress("abc", 3, true, out));
+    assert(gunzip(drain(out)) == "abc");
+}
+
+void test_pool_reuses_encoders() {
+    EncoderPool pool(2);
+
+    auto a = pool.acquire(6);
+    auto b = pool.acquire(6);
+    pool.release(std::move(a));
+    pool.release(std::move(b));
+    assert(pool.idle() == 2);
+
+    auto c = pool.acquire(6);
+    assert(c && pool.created() == 2 && pool.idle() == 1);
+
+    // A different level never gets a mismatched encoder
+    auto d = pool.acquire(1);
+    assert(d && d->level() == 1 && pool.created() == 3);
+}
+
+void test_chunked_response_compressed() {
+    EncoderPool pool;
+    ResponseCompressor rc(pool, nullptr, 6, 0, false, "");
+
+    std::string body = text_body();
+    std::string upstream =
+        "HTTP/1.1 200 OK\r\n"
+        "Content-Type: text/plain\r\n"
+        "Transfer-Encoding: chunked\r\n"
+        "ETag: \"v1\"\r\n"
+        "\r\n";
+    for (size_t i = 0; i < body.size(); i += 777) {
+        std::string piece = body.substr(i, 777);
+        char size[16];
+        snprintf(size, sizeof(size), "%zx\r\n", piece.size());
+        upstream += size + piece + "\r\n";
+    }
+    upstream += "0\r\n\r\n";
+
+    // Feed in awkward slices so heads and chunk sizes straddle reads
+    Buffer out;
+    for (size_t i = 0; i < upstream.size(); i += 13) {
+        assert(rc.feed(upstream.data() + i, std::min<size_t>(13, upstream.size() - i), out));
+    }
+    assert(rc.done());
+    assert(rc.compressing() == false);      // encoder went back to the pool
+    assert(pool.idle() == 1);
+
+    std::string resp = drain(out);
+    std::string head = resp.substr(0, resp.find("\r\n\r\n"));
+    assert(head.find("HTTP/1.1 200 OK\r\n") == 0);
+    assert(head.find("content-encoding: gzip") != std::string::npos);
+    assert(head.find("vary: Accept-Encoding") != std::string::npos);
+    assert(head.find("etag: W/\"v1\"") != std::string::npos);
+    assert(head.find("transfer-encoding") == std::string::npos);
+    assert(gunzip(split_body(resp)) == body);
+}
+
+void test_passthrough_cases() {
+    EncoderPool pool;
+
+    const char* responses[] = {
+        // Not a compressible type
+        "HTTP/1.1 200 OK\r\nContent-Type: image/png\r\nContent-Length: 4\r\n\r\n\x89PNG",
+        // Already encoded
+        "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nContent-Encoding: br\r\n"
+        "Content-Length: 3\r\n\r\nabc",
+        // Below the minimum length
+        "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nContent-Length: 3\r\n\r\nabc",
+        // Not a 200
+        "HTTP/1.1 404 Not Found\r\nContent-Type: text/plain\r\nContent-Length: 3000\r\n\r\nabc",
+        // Upstream forbids transformation
+        "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nCache-Control: no-transform\r\n"
+        "Content-Length: 3000\r\n\r\nabc",
+    };
+
+    for (const char* r : responses) {
+        ResponseCompressor rc(pool, nullptr, 6, 100, false, "");
+        std::string in(r);
+        Buffer out;
+        assert(rc.feed(in.data(), in.size(), out));
+        assert(!rc.compressing());
+        assert(drain(out) == in);
+    }
+}
+
+void test_close_delimited_needs_eof() {
+    EncoderPool pool;
+    ResponseCompressor rc(pool, nullptr, 6, 0, false, "");
+
+    std::string in = "HTTP/1.0 200 OK\r\nContent-Type: text/html\r\n\r\n<p>hello</p>";
+    Buffer out;
+    assert(rc.feed(in.data(), in.size(), out));
+    assert(!rc.done());
+    assert(rc.on_eof(out));
+    assert(rc.done());
+    assert(gunzip(split_body(drain(out))) == "<p>hello</p>");
+
+    // Truncated Content-Length body is an error, not a short gzip stream
+    ResponseCompressor trunc(pool, nullptr, 6, 0, false, "");
+    std::string t = "HTTP/1.1 200 OK\r\nContent-Type: text/html\r\nContent-Length: 100\r\n\r\nxx";
+    assert(trunc.feed(t.data(), t.size(), out));
+    assert(!trunc.on_eof(out));
+}
+
+void test_cache_hit_and_revalidation() {
+    EncoderPool pool;
+    CompressedCache cache(16, 1 << 20);
+
+    std::string body = text_body();
+    auto response = [&](const char* etag) {
+        return std::string("HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nETag: ") + etag +
+               "\r\nContent-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+    };
+
+    Buffer out;
+    std::string first;
+    {
+        ResponseCompressor rc(pool, &cache, 6, 0, false, "gzip host/doc");
+        std::string r = response("\"a\"");
+        assert(rc.feed(r.data(), r.size(), out));
+        assert(rc.done() && !rc.cache_hit());
+        first = drain(out);
+    }
+    assert(cache.size() == 1);
+
+    // Same validator: served from cache as soon as the head is seen
+    {
+        ResponseCompressor rc(pool, &cache, 6, 0, false, "gzip host/doc");
+        std::string r = response("\"a\"");
+        assert(rc.feed(r.data(), 200, out));
+        assert(rc.done() && rc.cache_hit());
+        assert(drain(out) == first);
+    }
+
+    // Upstream changed the resource: recompressed and replaced
+    {
+        ResponseCompressor rc(pool, &cache, 6, 0, false, "gzip host/doc");
+        std::string r = response("\"b\"");
+        assert(rc.feed(r.data(), r.size(), out));
+        assert(rc.done() && !rc.cache_hit());
+        assert(gunzip(split_body(drain(out))) == body);
+    }
+    assert(cache.size() == 1 && cache.hits() == 1);
+
+    // Private responses are never stored
+    {
+        ResponseCompressor rc(pool, &cache, 6, 0, false, "gzip host/me");
+        std::string r = "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nETag: \"x\"\r\n"
+                        "Cache-Control: private\r\nContent-Length: 5\r\n\r\nhello";
+        assert(rc.feed(r.data(), r.size(), out));
+        drain(out);
+    }
+    assert(cache.size() == 1);
+}
+
+void test_deferred_encoding() {
+    EncoderPool pool;
+    ResponseCompressor rc(pool, nullptr, 6, 0, false, "");
+    rc.set_deferred(true);
+
+    std::string body = text_body();
+    std::string in = "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nContent-Length: " +
+                     std::to_string(body.size()) + "\r\n\r\n";
+
+    Buffer out;
+    assert(rc.feed(in.data(), in.size(), out));
+    assert(!rc.encode_ready());                 // head written, no body yet
+
+    // Feed body in two halves, encoding each "on a worker" in between
+    size_t half = body.size() / 2;
+    for (size_t off : {size_t(0), half}) {
+        size_t len = off == 0 ? half : body.size() - half;
+        assert(rc.feed(body.data() + off, len, out));
+        assert(rc.encode_ready());
+
+        Buffer produced;
+        assert(rc.encode(produced));
+        rc.encoded(produced, out);
+    }
+
+    assert(rc.done() && !rc.encode_ready());
+    assert(pool.idle() == 1);
+    assert(gunzip(split_body(drain(out))) == body);
+}
+
+void test_cache_bounds() {
+    CompressedCache cache(2, 1 << 20);
+
+    for (int i = 0; i < 5; ++i) {
+        auto e = std::make_shared<CompressedCache::Entry>();
+        e->validator = "v";
+        e->body = "x";
+        cache.insert("k" + std::to_string(i), e);
+    }
+    assert(cache.size() == 2);
+    assert(!cache.find("k0", "v"));
+    assert(cache.find("k4", "v"));
+}
+
+int main() {
+    test_negotiate();
+    test_compressible_types();
+    test_gzip_roundtrip_streamed();
+    test_pool_reuses_encoders();
+    test_chunked_response_compressed();
+    test_passthrough_cases();
+    test_close_delimited_needs_eof();
+    test_cache_hit_and_revalidation();
+    test_deferred_encoding();
+    test_cache_bounds();
+
+    std::cout << "Compression tests PASSED\n";
+    return 0;
+}
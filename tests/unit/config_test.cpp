@@ -0,0 +1,211 @@
+#include <arpa/inet.h>
+#include <cassert>
+#include <iostream>
+#include <string>
+
+#include "config/config.h"
+
+/*
+ * Unit tests for ConfigLoader parsing.
+ * No files, no threads, no epoll.
+ */
+
+void test_defaults_kept_for_missing_keys() {
+    ProxyConfig cfg;
+    std::string err;
+
+    bool ok = ConfigLoader::parse("backend_port = 9100\n", cfg, err);
+
+    assert(ok);
+    assert(cfg.backend_port == 9100);
+    assert(cfg.listen_port == 8080);
+    assert(cfg.backend_host == "127.0.0.1");
+}
+
+void test_comments_and_whitespace() {
+    ProxyConfig cfg;
+    std::string err;
+
+    const char* text =
+        "# proxy config\n"
+        "\n"
+        "  listen_port=9090   # inline comment\n"
+        "backend_host =  10.0.0.1\n"
+        "client_read_buf_size = 16384\n";
+
+    bool ok = ConfigLoader::parse(text, cfg, err);
+
+    assert(ok);
+    assert(cfg.listen_port == 9090);
+    assert(cfg.backend_host == "10.0.0.1");
+    assert(cfg.client_read_buf_size == 16384);
+}
+
+void test_unknown_key_rejected() {
+    ProxyConfig cfg;
+    std::string err;
+
+    bool ok = ConfigLoader::parse("no_such_key = 1\n", cfg, err);
+
+    assert(!ok);
+    assert(!err.empty());
+}
+
+void test_invalid_value_leaves_config_untouched() {
+    ProxyConfig cfg;
+    std::string err;
+
+    bool ok = ConfigLoader::parse(
+        "backend_port = 9100\n"
+        "listen_port = 70000\n",
+        cfg, err);
+
+    assert(!ok);
+    assert(cfg.backend_port == 9000);
+    assert(cfg.listen_port == 8080);
+}
+
+void test_port_list() {
+    ProxyConfig cfg;
+    std::string err;
+
+    assert(cfg.connect_ports.size() == 1 && cfg.connect_ports[0] == 443);
+
+    bool ok = ConfigLoader::parse("connect_ports = 443, 8443 ,22\n", cfg, err);
+    assert(ok);
+    assert(cfg.connect_ports.size() == 3);
+    assert(cfg.connect_ports[1] == 8443 && cfg.connect_ports[2] == 22);
+
+    assert(!ConfigLoader::parse("connect_ports = 443,,80\n", cfg, err));
+    assert(!ConfigLoader::parse("connect_ports = 0\n", cfg, err));
+    assert(cfg.connect_ports.size() == 3);
+}
+
+void test_header_rules() {
+    ProxyConfig cfg;
+    std::string err;
+
+    const char* text =
+        "request_header = set Host: internal.example\n"
+        "request_header = add Via: 1.1 proxy\n"
+        "response_header = remove Server\n"
+        "strip_hop_by_hop = on\n";
+
+    bool ok = ConfigLoader::parse(text, cfg, err);
+    assert(ok);
+    assert(cfg.request_headers.rules.size() == 2);
+    assert(cfg.request_headers.rules[0].op == HeaderRule::Op::SET);
+    assert(cfg.request_headers.rules[0].name == "host");
+    assert(cfg.request_headers.rules[0].line == "Host: internal.example\r\n");
+    assert(cfg.request_headers.rules[1].line == "Via: 1.1 proxy\r\n");
+    assert(cfg.response_headers.rules.size() == 1);
+    assert(cfg.response_headers.rules[0].name == "server");
+    assert(cfg.request_headers.strip_hop_by_hop && cfg.response_headers.strip_hop_by_hop);
+
+    // A new file replaces the list instead of appending to it
+    ok = ConfigLoader::parse("request_header = remove Cookie\n", cfg, err);
+    assert(ok);
+    assert(cfg.request_headers.rules.size() == 1);
+    assert(cfg.request_headers.rules[0].op == HeaderRule::Op::REMOVE);
+
+    assert(!ConfigLoader::parse("request_header = set Bad Name: x\n", cfg, err));
+    assert(!ConfigLoader::parse("request_header = add X-Missing-Colon\n", cfg, err));
+    assert(!ConfigLoader::parse("request_header = rename A: B\n", cfg, err));
+}
+
+void test_socket_options() {
+    ProxyConfig cfg;
+    std::string err;
+    assert(cfg.client_socket.nodelay && cfg.upstream_socket.nodelay);
+
+    const char* text =
+        "client_socket = nodelay cork notsent_lowat=16384 keepalive=60,10,5 zerocopy=65536\n"
+        "upstream_socket = none\n";
+    bool ok = ConfigLoader::parse(text, cfg, err);
+    assert(ok);
+    const SocketOptions& c = cfg.client_socket;
+    assert(c.nodelay && c.cork && !c.quickack);
+    assert(c.notsent_lowat == 16384 && c.rcvbuf == 0);
+    assert(c.keepalive_idle_s == 60 && c.keepalive_interval_s == 10 && c.keepalive_count == 5);
+    assert(c.zerocopy_min_bytes == 65536);
+    assert(!cfg.upstream_socket.nodelay);
+
+    ok = ConfigLoader::parse("upstream_socket = keepalive=30 rcvbuf=262144\n", cfg, err);
+    assert(ok);
+    assert(cfg.upstream_socket.keepalive_idle_s == 30 && cfg.upstream_socket.keepalive_count == 0);
+    assert(cfg.upstream_socket.rcvbuf == 262144);
+
+    assert(!ConfigLoader::parse("upstream_socket = zerocopy=1\n", cfg, err));
+    assert(!ConfigLoader::parse("client_socket = nodelay=1\n", cfg, err));
+    assert(!ConfigLoader::parse("client_socket = keepalive=1,2,3,4\n", cfg, err));
+    assert(!ConfigLoader::parse("client_socket = keepalive=0\n", cfg, err));
+    assert(!ConfigLoader::parse("client_socket = fastopen\n", cfg, err));
+}
+
+void test_mirror() {
+    ProxyConfig cfg;
+    std::string err;
+    assert(cfg.mirror_upstream.port == 0);
+
+    const char* text =
+        "mirror_upstream = 10.0.0.9:8081\n"
+        "mirror_percent = 5\n"
+        "mirror_max_inflight = 16\n"
+        "mirror_max_bytes = 65536\n";
+    bool ok = ConfigLoader::parse(text, cfg, err);
+    assert(ok);
+    assert(cfg.mirror_upstream.port == 8081 && cfg.mirror_upstream.addr == inet_addr("10.0.0.9"));
+    assert(cfg.mirror_percent == 5 && cfg.mirror_max_inflight == 16);
+    assert(cfg.mirror_max_bytes == 65536 && cfg.mirror_timeout_ms == 5000);
+
+    ok = ConfigLoader::parse("mirror_upstream = off\n", cfg, err);
+    assert(ok && cfg.mirror_upstream.port == 0);
+
+    assert(!ConfigLoader::parse("mirror_upstream = 10.0.0.1:1, 10.0.0.2:2\n", cfg, err));
+    assert(!ConfigLoader::parse("mirror_upstream = shadow.internal:80\n", cfg, err));
+    assert(!ConfigLoader::parse("mirror_percent = 101\n", cfg, err));
+    assert(!ConfigLoader::parse("mirror_timeout_ms = 0\n", cfg, err));
+}
+
+void test_stats_shm() {
+    ProxyConfig cfg;
+    std::string err;
+    assert(cfg.stats_shm.empty());
+
+    bool ok = ConfigLoader::parse("stats_shm = /proxy-stats\nstats_shm_interval_ms = 250\n", cfg, err);
+    assert(ok);
+    assert(cfg.stats_shm == "/proxy-stats" && cfg.stats_shm_interval_ms == 250);
+
+    assert(!ConfigLoader::parse("stats_shm = proxy-stats\n", cfg, err));
+    assert(!ConfigLoader::parse("stats_shm = /a/b\n", cfg, err));
+    assert(!ConfigLoader::parse("stats_shm = /\n", cfg, err));
+    assert(!ConfigLoader::parse("stats_shm_interval_ms = 0\n", cfg, err));
+}
+
+void test_store_publish() {
+    ConfigStore store(std::make_shared<ProxyConfig>());
+    ConfigSnapshot old = store.current();
+
+    auto next = std::make_shared<ProxyConfig>();
+    next->backend_port = 9200;
+    store.publish(next);
+
+    assert(store.current()->backend_port == 9200);
+    assert(old->backend_port == 9000);
+}
+
+int main() {
+    test_defaults_kept_for_missing_keys();
+    test_comments_and_whitespace();
+    test_unknown_key_rejected();
+    test_invalid_value_leaves_config_untouched();
+    test_port_list();
+    test_header_rules();
+    test_socket_options();
+    test_mirror();
+    test_stats_shm();
+    test_store_publish();
+
+    std::cout << "Config tests PASSED\n";
+    return 0;
+}
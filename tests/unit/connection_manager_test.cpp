@@ -0,0 +1,473 @@
+#include <arpa/inet.h>
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <netinet/in.h>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "admission/rate_limiter.h"
+#include "config/config.h"
+#include "connection/connection_manager.h"
+#include "connection/h2_frontend.h"
+#include "connection/upstream_pool.h"
+#include "core/event_loop/epoll_loop.h"
+#include "protocol/http2/hpack.h"
+
+/*
+ * Unit tests for ConnectionManager request framing: a loopback client
+ * and upstream around one loop. Each upstream connection must carry
+ * exactly one request, and pipelined requests must each be answered,
+ * in order, on the one client connection.
+ * Rate limiting behind a PROXY header is keyed by the source it names.
+ * Also covers the pieces HTTP/2 streams are routed through: the
+ * upstream pool's per-(addr, port) idle lists and H2Frontend's
+ * parking of streams behind a DNS lookup.
+ */
+
+uint64_t now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Listening socket on an ephemeral loopback port
+int listen_any(uint16_t& port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    assert(fd >= 0);
+    sockaddr_in sa{};
+    sa.sin_family = AF_INET;
+    sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    assert(::bind(fd, reinterpret_cast<sockaddr*>(&sa), sizeof(sa)) == 0);
+    assert(::listen(fd, 16) == 0);
+    socklen_t len = sizeof(sa);
+    ::getsockname(fd, reinterpret_cast<sockaddr*>(&sa), &len);
+    port = ntohs(sa.sin_port);
+    return fd;
+}
+
+// Upstream: one request per connection, answered with everything it
+// received as the body, then closed. Collects what each connection saw
+void serve_echo(int lfd, int conns, std::vector<std::string>& seen) {
+    // A connection that never comes fails the caller's asserts, not a join
+    timeval wait{2, 0};
+    ::setsockopt(lfd, SOL_SOCKET, SO_RCVTIMEO, &wait, sizeof(wait));
+
+    for (int i = 0; i < conns; ++i) {
+        int fd = ::accept(lfd, nullptr, nullptr);
+        if (fd < 0)
+            return;
+
+        // Whatever arrives within a short window: a second request
+        // leaked onto this connection would show up here
+        std::string got;
+        char buf[4096];
+        timeval tv{0, 200 * 1000};
+        ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        for (;;) {
+            ssize_t n = ::read(fd, buf, sizeof(buf));
+            if (n <= 0)
+                break;
+            got.append(buf, n);
+        }
+        seen.push_back(got);
+
+        std::string resp = "HTTP/1.1 200 OK\r\nContent-Length: " +
+                           std::to_string(got.size()) + "\r\n\r\n" + got;
+        assert(::write(fd, resp.data(), resp.size()) == static_cast<ssize_t>(resp.size()));
+        ::close(fd);
+    }
+}
+
+// Send raw on a fresh client connection handed to the manager, then run
+// the loop until the proxy closes it; returns everything the client read
+std::string exchange(ConnectionManager& manager, EpollLoop& loop, const std::string& raw) {
+    uint16_t port = 0;
+    int lfd = listen_any(port);
+
+    int client = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in sa{};
+    sa.sin_family = AF_INET;
+    sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    sa.sin_port = htons(port);
+    assert(::connect(client, reinterpret_cast<sockaddr*>(&sa), sizeof(sa)) == 0);
+
+    sockaddr_in peer{};
+    socklen_t plen = sizeof(peer);
+    int cfd = ::accept4(lfd, reinterpret_cast<sockaddr*>(&peer), &plen, SOCK_NONBLOCK);
+    assert(cfd >= 0);
+    ::close(lfd);
+    manager.add_client(cfd, &peer);
+
+    // One write: both requests reach the proxy in the same read
+    assert(::write(client, raw.data(), raw.size()) == static_cast<ssize_t>(raw.size()));
+    ::fcntl(client, F_SETFL, O_NONBLOCK);
+
+    std::string out;
+    bool eof = false;
+    uint64_t deadline = now_ms() + 5000;
+    while (!eof && now_ms() < deadline) {
+        loop.wait(20);
+        for (int i = 0; i < loop.ready_count(); ++i)
+            manager.handle_event(loop.event_at(i).data.ptr, loop.event_at(i).events);
+        manager.sweep_closed();
+
+        char buf[4096];
+        ssize_t n;
+        while ((n = ::read(client, buf, sizeof(buf))) > 0)
+            out.append(buf, n);
+        eof = n == 0;
+    }
+    assert(eof);
+    ::close(client);
+    return out;
+}
+
+void test_pipelined_requests() {
+    uint16_t port = 0;
+    int lfd = listen_any(port);
+    std::vector<std::string> seen;
+    std::thread upstream(serve_echo, lfd, 2, std::ref(seen));
+
+    ProxyConfig cfg;
+    std::string err;
+    assert(ConfigLoader::parse("backend_port = " + std::to_string(port) + "\n"
+                               "request_header = add Via: 1.1 proxy\n", cfg, err));
+
+    EpollLoop loop;
+    ConnectionManager manager(loop, std::make_shared<const ProxyConfig>(cfg));
+
+    const std::string first =
+        "POST /a HTTP/1.1\r\nHost: x\r\nContent-Length: 5\r\n\r\nhello";
+    const std::string second = "GET /b HTTP/1.1\r\nHost: x\r\n\r\n";
+    std::string out = exchange(manager, loop, first + second);
+
+    upstream.join();
+    ::close(lfd);
+
+    // Each upstream saw exactly its own request, edited
+    assert(seen.size() == 2);
+    assert(seen[0].rfind("POST /a ", 0) == 0);
+    assert(seen[0].find("GET /b") == std::string::npos);
+    assert(seen[0].size() >= 5 && seen[0].compare(seen[0].size() - 5, 5, "hello") == 0);
+    assert(seen[0].find("Via: 1.1 proxy\r\n") != std::string::npos);
+    assert(seen[1].rfind("GET /b ", 0) == 0);
+    assert(seen[1].find("Via: 1.1 proxy\r\n") != std::string::npos);
+
+    // And the client got both answers, in order
+    size_t a = out.find("POST /a ");
+    size_t b = out.find("GET /b ");
+    assert(a != std::string::npos && b != std::string::npos && a < b);
+    assert(manager.traffic().requests == 2);
+    assert(manager.traffic().responses[2] == 2);
+    assert(manager.active_count() == 0);
+
+    std::cout << "[OK] pipelined requests forwarded one per upstream, answered in order\n";
+}
+
+void test_partial_pipelined_request() {
+    uint16_t port = 0;
+    int lfd = listen_any(port);
+    std::vector<std::string> seen;
+    std::thread upstream(serve_echo, lfd, 1, std::ref(seen));
+
+    ProxyConfig cfg;
+    cfg.backend_port = port;
+
+    EpollLoop loop;
+    ConnectionManager manager(loop, std::make_shared<const ProxyConfig>(cfg));
+
+    // The trailing head never completes: the first request is still
+    // served alone, then the half-closed client ends the connection
+    const std::string first = "GET /a HTTP/1.1\r\nHost: x\r\n\r\n";
+    uint16_t cport = 0;
+    int clfd = listen_any(cport);
+    int client = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in sa{};
+    sa.sin_family = AF_INET;
+    sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    sa.sin_port = htons(cport);
+    assert(::connect(client, reinterpret_cast<sockaddr*>(&sa), sizeof(sa)) == 0);
+    int cfd = ::accept4(clfd, nullptr, nullptr, SOCK_NONBLOCK);
+    ::close(clfd);
+    manager.add_client(cfd);
+
+    std::string raw = first + "GET /b HTTP/1.1\r\nHo";
+    assert(::write(client, raw.data(), raw.size()) == static_cast<ssize_t>(raw.size()));
+    ::fcntl(client, F_SETFL, O_NONBLOCK);
+
+    std::string out;
+    uint64_t deadline = now_ms() + 5000;
+    while (out.find("GET /a ") == std::string::npos && now_ms() < deadline) {
+        loop.wait(20);
+        for (int i = 0; i < loop.ready_count(); ++i)
+            manager.handle_event(loop.event_at(i).data.ptr, loop.event_at(i).events);
+        manager.sweep_closed();
+        char buf[4096];
+        ssize_t n;
+        while ((n = ::read(client, buf, sizeof(buf))) > 0)
+            out.append(buf, n);
+    }
+
+    upstream.join();
+    ::close(lfd);
+    assert(seen.size() == 1 && seen[0] == first);
+    assert(out.find("GET /a ") != std::string::npos);
+
+    // Counted as soon as the status was read, not when the connection ends
+    assert(manager.traffic().responses[2] == 1);
+
+    // Still waiting for the rest of the second head
+    assert(manager.active_count() == 1);
+    ::shutdown(client, SHUT_WR);
+    deadline = now_ms() + 5000;
+    while (manager.active_count() != 0 && now_ms() < deadline) {
+        loop.wait(20);
+        for (int i = 0; i < loop.ready_count(); ++i)
+            manager.handle_event(loop.event_at(i).data.ptr, loop.event_at(i).events);
+        manager.sweep_closed();
+    }
+    assert(manager.active_count() == 0);
+    ::close(client);
+
+    // The unanswered second request is not a response
+    assert(manager.traffic().responses[2] == 1);
+    assert(manager.traffic().responses[0] == 0);
+
+    std::cout << "[OK] incomplete pipelined head waits for the client\n";
+}
+
+// Loopback connection handed to the manager; returns the client end
+int connect_client(ConnectionManager& manager) {
+    uint16_t port = 0;
+    int lfd = listen_any(port);
+    int client = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in sa{};
+    sa.sin_family = AF_INET;
+    sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    sa.sin_port = htons(port);
+    assert(::connect(client, reinterpret_cast<sockaddr*>(&sa), sizeof(sa)) == 0);
+    sockaddr_in peer{};
+    socklen_t plen = sizeof(peer);
+    int cfd = ::accept4(lfd, reinterpret_cast<sockaddr*>(&peer), &plen, SOCK_NONBLOCK);
+    assert(cfd >= 0);
+    ::close(lfd);
+    manager.add_client(cfd, &peer);
+    return client;
+}
+
+void test_rate_limit_uses_proxy_source() {
+    ProxyConfig cfg;
+    cfg.proxy_protocol = true;
+
+    EpollLoop loop;
+    ConnectionManager manager(loop, std::make_shared<const ProxyConfig>(cfg));
+    RateLimiter limiter(1, 1);
+    manager.set_rate_limiter(&limiter);
+
+    // All three arrive from the same balancer (127.0.0.1); only the
+    // second client named in a header is over its budget
+    const char* sources[] = {"10.0.0.9", "10.0.0.9", "10.0.0.10"};
+    std::vector<int> clients;
+    for (const char* src : sources) {
+        int client = connect_client(manager);
+        std::string hdr = std::string("PROXY TCP4 ") + src + " 10.0.0.1 5000 80\r\n";
+        assert(::write(client, hdr.data(), hdr.size()) == static_cast<ssize_t>(hdr.size()));
+        clients.push_back(client);
+    }
+
+    uint64_t deadline = now_ms() + 2000;
+    while (manager.active_count() != 2 && now_ms() < deadline) {
+        loop.wait(20);
+        for (int i = 0; i < loop.ready_count(); ++i)
+            manager.handle_event(loop.event_at(i).data.ptr, loop.event_at(i).events);
+        manager.sweep_closed();
+    }
+    assert(manager.active_count() == 2);
+
+    // The limited one was closed by the proxy
+    char c;
+    ::fcntl(clients[1], F_SETFL, O_NONBLOCK);
+    assert(::read(clients[1], &c, 1) == 0);
+    ::fcntl(clients[2], F_SETFL, O_NONBLOCK);
+    assert(::read(clients[2], &c, 1) < 0 && errno == EAGAIN);
+
+    manager.close_all();
+    manager.sweep_closed();
+    for (int fd : clients)
+        ::close(fd);
+    std::cout << "[OK] PROXY source, not the balancer, is rate limited\n";
+}
+
+void test_pool_keeps_other_upstreams() {
+    uint16_t port_a = 0;
+    uint16_t port_b = 0;
+    int la = listen_any(port_a);
+    int lb = listen_any(port_b);
+
+    EpollLoop loop;
+    UpstreamPool pool(loop);
+    auto cfg = std::make_shared<const ProxyConfig>();
+    int sv[2];
+    assert(::socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == 0);
+    Connection owner(sv[0], cfg);
+    uint32_t lo = htonl(INADDR_LOOPBACK);
+
+    UpstreamConn* a = pool.acquire(lo, port_a, &owner);
+    assert(a);
+    a->connected = true;
+    pool.release(a, true);
+    assert(pool.idle_count() == 1);
+
+    // Leasing B must leave A's idle connection alone
+    UpstreamConn* b = pool.acquire(lo, port_b, &owner);
+    assert(b && b->port == port_b);
+    assert(pool.idle_count() == 1);
+    b->connected = true;
+    pool.release(b, true);
+    assert(pool.idle_count() == 2);
+
+    UpstreamConn* again = pool.acquire(lo, port_a, &owner);
+    assert(again == a);
+    assert(pool.idle_count() == 1);
+    pool.release(again, false);
+    pool.sweep();
+
+    ::close(sv[1]);
+    ::close(la);
+    ::close(lb);
+    std::cout << "[OK] idle upstreams are kept per address and port\n";
+}
+
+// Preface plus one GET on stream id
+std::string h2_get(uint32_t id) {
+    std::string block;
+    HpackEncoder::encode({{":method", "GET"}, {":scheme", "http"},
+                          {":path", "/"}, {":authority", "x"}}, block);
+    std::string in;
+    if (id == 1)
+        in.assign(h2::kPreface, h2::kPrefaceLen);
+    h2::append_header(in, static_cast<uint32_t>(block.size()), h2::FrameType::HEADERS,
+                      h2::flags::END_HEADERS | h2::flags::END_STREAM, id);
+    return in + block;
+}
+
+// :status of every response HEADERS frame in the frontend's output
+std::vector<std::string> h2_statuses(H2Frontend& fe) {
+    std::vector<std::string> out;
+    Buffer& buf = fe.output();
+    while (buf.readable_bytes() >= h2::kFrameHeaderLen) {
+        auto h = h2::parse_header(reinterpret_cast<const uint8_t*>(buf.read_ptr()));
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(buf.read_ptr()) + h2::kFrameHeaderLen;
+        if (h.type == h2::FrameType::HEADERS) {
+            HpackDecoder dec;
+            HeaderList fields;
+            assert(dec.decode(p, h.length, fields));
+            out.push_back(fields[0].second);
+        }
+        buf.consume(h2::kFrameHeaderLen + h.length);
+    }
+    return out;
+}
+
+void test_h2_streams_wait_for_dns() {
+    uint16_t port = 0;
+    int lfd = listen_any(port);
+
+    EpollLoop loop;
+    UpstreamPool pool(loop);
+    auto cfg = std::make_shared<const ProxyConfig>();
+    int sv[2];
+    assert(::socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == 0);
+    Connection conn(sv[0], cfg);
+
+    int answer = -1;
+    int routed = 0;
+    H2Frontend fe(conn, loop, pool);
+    fe.set_routing(
+        [&](uint32_t& addr, uint16_t& p) {
+            ++routed;
+            addr = htonl(INADDR_LOOPBACK);
+            p = port;
+            return answer;
+        },
+        nullptr);
+
+    // Lookup in flight: both streams wait instead of failing
+    std::string in = h2_get(1) + h2_get(3);
+    size_t used = 0;
+    assert(fe.on_client_data(in.data(), in.size(), used) && used == in.size());
+    assert(fe.parked() && routed == 2);
+    assert(pool.leased_count() == 0);
+    assert(h2_statuses(fe).empty());
+
+    // Answered: routed again and sent upstream
+    answer = 0;
+    fe.resume_parked();
+    assert(!fe.parked() && routed == 4);
+    assert(pool.leased_count() == 2);
+    fe.shutdown();
+    pool.sweep();
+
+    // Timed out: every parked stream gets the status
+    answer = -1;
+    in = h2_get(5);
+    assert(fe.on_client_data(in.data(), in.size(), used));
+    assert(fe.parked());
+    fe.fail_parked(504);
+    assert(!fe.parked());
+    std::vector<std::string> statuses = h2_statuses(fe);
+    assert(statuses.size() == 1 && statuses[0] == "504");
+
+    // Every upstream ejected: answered right away
+    answer = 503;
+    in = h2_get(7);
+    assert(fe.on_client_data(in.data(), in.size(), used));
+    assert(!fe.parked());
+    statuses = h2_statuses(fe);
+    assert(statuses.size() == 1 && statuses[0] == "503");
+
+    ::close(sv[1]);
+    ::close(lfd);
+    std::cout << "[OK] HTTP/2 streams park on DNS and follow the router\n";
+}
+
+void test_transfer_encoding_answered() {
+    ProxyConfig cfg;
+    EpollLoop loop;
+    ConnectionManager manager(loop, std::make_shared<const ProxyConfig>(cfg));
+
+    // Chunked alone: valid HTTP the proxy does not implement
+    std::string out = exchange(manager, loop,
+        "POST / HTTP/1.1\r\nHost: x\r\nTransfer-Encoding: chunked\r\n\r\n"
+        "5\r\nhello\r\n0\r\n\r\n");
+    assert(out.rfind("HTTP/1.1 501 ", 0) == 0);
+
+    // Chunked next to Content-Length: conflicting framing
+    out = exchange(manager, loop,
+        "POST / HTTP/1.1\r\nHost: x\r\nContent-Length: 3\r\n"
+        "Transfer-Encoding: chunked\r\n\r\nabc");
+    assert(out.rfind("HTTP/1.1 400 ", 0) == 0);
+
+    assert(manager.traffic().responses[5] == 1);
+    assert(manager.traffic().responses[4] == 1);
+    assert(manager.active_count() == 0);
+    std::cout << "[OK] Transfer-Encoding answered with 501 / 400, not a bare close\n";
+}
+
+int main() {
+    test_pipelined_requests();
+    test_partial_pipelined_request();
+    test_transfer_encoding_answered();
+    test_rate_limit_uses_proxy_source();
+    test_pool_keeps_other_upstreams();
+    test_h2_streams_wait_for_dns();
+
+    std::cout << "ConnectionManager tests PASSED\n";
+    return 0;
+}
@@ -0,0 +1,99 @@
+#include <cassert>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sched.h>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+#include "core/topology/cpu_topology.h"
+
+/*
+ * Unit tests for CpuTopology.
+ * Fake sysfs trees under /tmp; the binding test uses the real host.
+ */
+
+static void write_file(const std::string& path, const std::string& text) {
+    std::ofstream out(path);
+    out << text;
+}
+
+static std::string make_root() {
+    char tmpl[] = "/tmp/cpu_topology_XXXXXX";
+    char* dir = ::mkdtemp(tmpl);
+    assert(dir);
+    return dir;
+}
+
+void test_parse_cpu_list() {
+    std::vector<int> cpus;
+    assert(CpuTopology::parse_cpu_list("0-3,8,10-11\n", cpus));
+    assert((cpus == std::vector<int>{0, 1, 2, 3, 8, 10, 11}));
+
+    assert(CpuTopology::parse_cpu_list("5", cpus));
+    assert(cpus.size() == 1 && cpus[0] == 5);
+
+    assert(!CpuTopology::parse_cpu_list("", cpus));
+    assert(!CpuTopology::parse_cpu_list("3-1", cpus));
+    assert(!CpuTopology::parse_cpu_list("a-b", cpus));
+}
+
+void test_two_nodes() {
+    std::string root = make_root();
+    ::mkdir((root + "/node").c_str(), 0755);
+    ::mkdir((root + "/node/node0").c_str(), 0755);
+    ::mkdir((root + "/node/node1").c_str(), 0755);
+    ::mkdir((root + "/node/node2").c_str(), 0755);
+    write_file(root + "/node/node0/cpulist", "0-3,8-11\n");
+    write_file(root + "/node/node1/cpulist", "4-7,12-15\n");
+    write_file(root + "/node/node2/cpulist", "\n");     // memory only
+
+    CpuTopology topo;
+    assert(topo.load(root));
+    assert(topo.node_count() == 2);
+    assert(topo.cpus(0).size() == 8);
+    assert(topo.node_of(9) == 0);
+    assert(topo.node_of(12) == 1);
+    assert(topo.node_of(16) == -1);
+    assert(topo.cpus(5).empty());
+    assert(topo.cpu_nodes().size() == 16);
+}
+
+void test_fallback_single_node() {
+    std::string root = make_root();
+    ::mkdir((root + "/cpu").c_str(), 0755);
+    write_file(root + "/cpu/online", "0-5\n");
+
+    CpuTopology topo;
+    assert(topo.load(root));
+    assert(topo.node_count() == 1);
+    assert(topo.cpus(0).size() == 6);
+    assert(topo.node_of(5) == 0);
+
+    CpuTopology none;
+    assert(!none.load(make_root()));
+}
+
+void test_bind_current_thread() {
+    CpuTopology topo;
+    if (!topo.load()) {
+        return;                 // no sysfs in this environment
+    }
+
+    int node = topo.node_of(::sched_getcpu());
+    assert(node >= 0);
+    assert(topo.bind_current_thread(node));
+    assert(topo.node_of(::sched_getcpu()) == node);
+    assert(!topo.bind_current_thread(static_cast<int>(topo.node_count())));
+}
+
+int main() {
+    test_parse_cpu_list();
+    test_two_nodes();
+    test_fallback_single_node();
+    test_bind_current_thread();
+
+    std::cout << "CPU topology tests PASSED\n";
+    return 0;
+}
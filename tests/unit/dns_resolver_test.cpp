@@ -0,0 +1,286 @@
+#include <cassert>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "core/event_loop/epoll_loop.h"
+#include "dns/dns_message.h"
+#include "dns/dns_resolver.h"
+
+/*
+ * Tests for DnsMessage and DnsResolver.
+ * The resolver talks to a stub UDP server on 127.0.0.1 driven inline,
+ * so everything runs on one thread with no real DNS.
+ */
+
+struct StubServer {
+    int fd;
+    sockaddr_in addr{};
+
+    StubServer() {
+        fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = 0;
+        ::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+        socklen_t len = sizeof(addr);
+        ::getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len);
+    }
+
+    ~StubServer() { ::close(fd); }
+
+    // Receive one query and answer it
+    void answer(uint8_t rcode, const std::vector<uint32_t>& addrs, uint32_t ttl) {
+        uint8_t buf[512];
+        sockaddr_in from{};
+        socklen_t len = sizeof(from);
+        ssize_t n = ::recvfrom(fd, buf, sizeof(buf), 0,
+                               reinterpret_cast<sockaddr*>(&from), &len);
+        assert(n > 0);
+
+        std::vector<uint8_t> resp;
+        bool ok = DnsMessage::build_response(buf, n, rcode, addrs, ttl, resp);
+        assert(ok);
+        ::sendto(fd, resp.data(), resp.size(), 0,
+                 reinterpret_cast<sockaddr*>(&from), len);
+    }
+};
+
+uint32_t ip(const char* s) {
+    in_addr a{};
+    inet_pton(AF_INET, s, &a);
+    return a.s_addr;
+}
+
+void pump(EpollLoop& loop, DnsResolver& resolver, uint64_t now_ms) {
+    int n = loop.wait(1000);
+    assert(n > 0);
+    resolver.handle_readable(now_ms);
+}
+
+void test_message_roundtrip() {
+    std::vector<uint8_t> query;
+    assert(DnsMessage::build_query(0x1234, "backend.example.com", query));
+
+    std::vector<uint8_t> resp;
+    assert(DnsMessage::build_response(query.data(), query.size(), 0,
+                                      {ip("10.0.0.1"), ip("10.0.0.2")}, 30, resp));
+
+    DnsAnswer answer;
+    assert(DnsMessage::parse_response(resp.data(), resp.size(), answer));
+    assert(answer.id == 0x1234);
+    assert(answer.qname == "backend.example.com");
+    assert(answer.rcode == 0);
+    assert(answer.addrs.size() == 2);
+    assert(answer.addrs[0] == ip("10.0.0.1"));
+    assert(answer.ttl == 30);
+}
+
+void test_bad_names_rejected() {
+    std::vector<uint8_t> query;
+    assert(!DnsMessage::build_query(1, "", query));
+    assert(!DnsMessage::build_query(1, "a..b", query));
+    assert(!DnsMessage::build_query(1, std::string(64, 'a') + ".com", query));
+}
+
+void test_truncated_response_rejected() {
+    std::vector<uint8_t> query;
+    DnsMessage::build_query(7, "x.test", query);
+    std::vector<uint8_t> resp;
+    DnsMessage::build_response(query.data(), query.size(), 0, {ip("1.2.3.4")}, 5, resp);
+
+    DnsAnswer answer;
+    assert(!DnsMessage::parse_response(resp.data(), resp.size() - 2, answer));
+}
+
+void test_resolve_and_cache() {
+    StubServer stub;
+    EpollLoop loop;
+    DnsResolver resolver(loop, stub.addr);
+
+    int callbacks = 0;
+    resolver.set_callback([&](const std::string& host, bool ok, uint32_t addr) {
+        assert(host == "svc.test");
+        assert(ok);
+        assert(addr == ip("10.1.1.1"));
+        ++callbacks;
+    });
+
+    uint32_t addr = 0;
+    assert(resolver.lookup("svc.test", addr, 0) == DnsLookup::PENDING);
+
+    stub.answer(0, {ip("10.1.1.1")}, 10);
+    pump(loop, resolver, 5);
+
+    assert(callbacks == 1);
+    assert(resolver.lookup("svc.test", addr, 100) == DnsLookup::HIT);
+    assert(addr == ip("10.1.1.1"));
+
+    // Expired after TTL
+    assert(resolver.lookup("svc.test", addr, 10006) == DnsLookup::PENDING);
+}
+
+void test_watched_refresh_before_expiry() {
+    StubServer stub;
+    EpollLoop loop;
+    DnsResolver resolver(loop, stub.addr);
+
+    resolver.watch("svc.test", 0);
+    stub.answer(0, {ip("10.2.2.2")}, 4);
+    pump(loop, resolver, 0);
+
+    // 75% of TTL: background refresh, cached entry still served
+    resolver.tick(3000);
+    uint32_t addr = 0;
+    assert(resolver.lookup("svc.test", addr, 3001) == DnsLookup::HIT);
+
+    stub.answer(0, {ip("10.3.3.3")}, 4);
+    pump(loop, resolver, 3002);
+
+    assert(resolver.lookup("svc.test", addr, 6000) == DnsLookup::HIT);
+    assert(addr == ip("10.3.3.3"));
+}
+
+void test_nxdomain_reports_failure() {
+    StubServer stub;
+    EpollLoop loop;
+    DnsResolver resolver(loop, stub.addr);
+
+    bool failed = false;
+    resolver.set_callback([&](const std::string&, bool ok, uint32_t) {
+        failed = !ok;
+    });
+
+    uint32_t addr = 0;
+    assert(resolver.lookup("missing.test", addr, 0) == DnsLookup::PENDING);
+    stub.answer(3, {}, 0);
+    pump(loop, resolver, 0);
+
+    assert(failed);
+    assert(resolver.lookup("missing.test", addr, 10) == DnsLookup::FAILED);
+}
+
+void test_negative_entry_fails_fast() {
+    StubServer stub;
+    EpollLoop loop;
+    DnsResolver resolver(loop, stub.addr);
+
+    int callbacks = 0;
+    resolver.set_callback([&](const std::string&, bool, uint32_t) { ++callbacks; });
+
+    uint32_t addr = 0;
+    assert(resolver.lookup("missing.test", addr, 0) == DnsLookup::PENDING);
+    stub.answer(3, {}, 0);
+    pump(loop, resolver, 0);
+    assert(callbacks == 1);
+
+    // While the negative entry is live: no query, no callback, a caller
+    // that parked on the name would never be woken
+    for (uint64_t t : {1, 100, 4999}) {
+        assert(resolver.lookup("missing.test", addr, t) == DnsLookup::FAILED);
+    }
+    resolver.tick(4999);
+    uint8_t buf[512];
+    assert(::recv(stub.fd, buf, sizeof(buf), MSG_DONTWAIT) < 0);
+    assert(callbacks == 1);
+
+    // Expired: asked again
+    assert(resolver.lookup("missing.test", addr, 5000) == DnsLookup::PENDING);
+    stub.answer(0, {ip("10.4.4.4")}, 10);
+    pump(loop, resolver, 5001);
+    assert(callbacks == 2);
+    assert(resolver.lookup("missing.test", addr, 5002) == DnsLookup::HIT);
+
+    // Names that cannot be encoded fail synchronously, without a callback
+    assert(resolver.lookup("a..b", addr, 0) == DnsLookup::FAILED);
+    assert(resolver.lookup(std::string(300, 'a'), addr, 0) == DnsLookup::FAILED);
+    assert(callbacks == 2);
+}
+
+void test_answer_for_other_name_ignored() {
+    StubServer stub;
+    EpollLoop loop;
+    DnsResolver resolver(loop, stub.addr);
+
+    int callbacks = 0;
+    resolver.set_callback([&](const std::string&, bool, uint32_t) { ++callbacks; });
+
+    uint32_t addr = 0;
+    assert(resolver.lookup("svc.test", addr, 0) == DnsLookup::PENDING);
+
+    uint8_t buf[512];
+    sockaddr_in from{};
+    socklen_t len = sizeof(from);
+    ssize_t n = ::recvfrom(stub.fd, buf, sizeof(buf), 0,
+                           reinterpret_cast<sockaddr*>(&from), &len);
+    assert(n > 12);
+    uint16_t id = static_cast<uint16_t>((buf[0] << 8) | buf[1]);
+
+    // Right ID, wrong question: dropped
+    std::vector<uint8_t> other;
+    assert(DnsMessage::build_query(id, "evil.test", other));
+    std::vector<uint8_t> resp;
+    assert(DnsMessage::build_response(other.data(), other.size(), 0, {ip("6.6.6.6")}, 300, resp));
+    ::sendto(stub.fd, resp.data(), resp.size(), 0, reinterpret_cast<sockaddr*>(&from), len);
+    pump(loop, resolver, 1);
+    assert(callbacks == 0);
+    assert(resolver.lookup("svc.test", addr, 2) == DnsLookup::PENDING);
+
+    // The real answer (case may differ) still completes the query
+    buf[13] = 'S';
+    assert(DnsMessage::build_response(buf, n, 0, {ip("10.5.5.5")}, 30, resp));
+    ::sendto(stub.fd, resp.data(), resp.size(), 0, reinterpret_cast<sockaddr*>(&from), len);
+    pump(loop, resolver, 3);
+    assert(callbacks == 1);
+    assert(resolver.lookup("svc.test", addr, 4) == DnsLookup::HIT && addr == ip("10.5.5.5"));
+}
+
+void test_cache_bounded() {
+    StubServer stub;
+    EpollLoop loop;
+    DnsResolver resolver(loop, stub.addr);
+    resolver.set_callback([](const std::string&, bool, uint32_t) {});
+
+    // Answered, then expired: dropped by the next tick unless watched
+    uint32_t addr = 0;
+    assert(resolver.lookup("once.test", addr, 0) == DnsLookup::PENDING);
+    stub.answer(0, {ip("10.6.6.6")}, 1);
+    pump(loop, resolver, 0);
+    resolver.watch("kept.test", 0);
+    stub.answer(0, {ip("10.7.7.7")}, 1);
+    pump(loop, resolver, 0);
+    assert(resolver.cached() == 2);
+    resolver.tick(1000);
+    assert(resolver.cached() == 1);
+
+    // Client-chosen names cannot grow the cache past its cap; no
+    // answers arrive, so every entry stays pending
+    size_t before = resolver.cached();
+    int failed = 0;
+    for (int i = 0; i < 5000; ++i) {
+        std::string name = "n" + std::to_string(i) + ".test";
+        failed += resolver.lookup(name, addr, 1000) == DnsLookup::FAILED;
+    }
+    assert(resolver.cached() == 4096);
+    assert(failed == static_cast<int>(5000 - (4096 - before)));
+}
+
+int main() {
+    test_message_roundtrip();
+    test_bad_names_rejected();
+    test_truncated_response_rejected();
+    test_resolve_and_cache();
+    test_watched_refresh_before_expiry();
+    test_nxdomain_reports_failure();
+    test_negative_entry_fails_fast();
+    test_answer_for_other_name_ignored();
+    test_cache_bounded();
+
+    std::cout << "DNS resolver tests PASSED\n";
+    return 0;
+}
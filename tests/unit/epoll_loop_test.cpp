@@ -0,0 +1,281 @@
+#include <atomic>
+#include <chrono>
+#include <cassert>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "core/event_loop/epoll_loop.h"
+#include "core/event_loop/loop_stats.h"
+#include "core/event_loop/mpsc_queue.h"
+#include "core/event_loop/signal_fd.h"
+
+/*
+ * Unit tests for EpollLoop::post and the MPSC inbox behind it, plus
+ * adaptive batch sizing, busy polling, the iteration histograms and
+ * signal delivery through SignalFd.
+ * Real threads; wait() timeouts bound every test.
+ */
+
+void test_mpsc_fifo_single_thread() {
+    MpscQueue<int> q;
+    int v = 0;
+
+    assert(q.pop(v) == MpscQueue<int>::PopResult::EMPTY);
+    for (int i = 0; i < 5; ++i) {
+        q.push(i);
+    }
+    for (int i = 0; i < 5; ++i) {
+        assert(q.pop(v) == MpscQueue<int>::PopResult::OK && v == i);
+    }
+    assert(q.pop(v) == MpscQueue<int>::PopResult::EMPTY);
+
+    // Reusable after draining through the stub
+    q.push(42);
+    assert(q.pop(v) == MpscQueue<int>::PopResult::OK && v == 42);
+}
+
+void test_mpsc_many_producers() {
+    MpscQueue<int> q;
+    const int kThreads = 4;
+    const int kPer = 20000;
+
+    std::vector<std::thread> producers;
+    for (int t = 0; t < kThreads; ++t) {
+        producers.emplace_back([&q, t] {
+            for (int i = 0; i < kPer; ++i) {
+                q.push(t * kPer + i);
+            }
+        });
+    }
+
+    std::vector<int> last(kThreads, -1);
+    int got = 0;
+    while (got < kThreads * kPer) {
+        int v = 0;
+        if (q.pop(v) != MpscQueue<int>::PopResult::OK) {
+            std::this_thread::yield();
+            continue;
+        }
+        int t = v / kPer;
+        assert(v % kPer > last[t]);     // per-producer FIFO
+        last[t] = v % kPer;
+        ++got;
+    }
+
+    for (auto& th : producers) {
+        th.join();
+    }
+}
+
+void test_post_runs_on_loop_thread() {
+    EpollLoop loop;
+    std::thread::id loop_thread = std::this_thread::get_id();
+    std::atomic<int> ran{0};
+
+    std::thread producer([&] {
+        loop.post([&] {
+            assert(std::this_thread::get_id() == loop_thread);
+            ran.fetch_add(1);
+        });
+    });
+    producer.join();
+
+    // Posted tasks run inside wait() and are not reported as events
+    int n = loop.wait(1000);
+    assert(n == 0);
+    assert(ran.load() == 1);
+}
+
+void test_burst_is_one_wakeup() {
+    EpollLoop loop;
+    int ran = 0;
+
+    for (int i = 0; i < 1000; ++i) {
+        loop.post([&ran] { ++ran; });
+    }
+    assert(loop.wakeups() == 1);
+
+    loop.wait(1000);
+    assert(ran == 1000);
+
+    // Next burst signals again
+    loop.post([&ran] { ++ran; });
+    assert(loop.wakeups() == 2);
+    loop.wait(1000);
+    assert(ran == 1001);
+
+    // Nothing pending: wait() times out instead of spinning
+    assert(loop.wait(10) == 0);
+}
+
+void test_concurrent_posters() {
+    EpollLoop loop;
+    const int kThreads = 4;
+    const int kPer = 5000;
+    int ran = 0;
+
+    std::vector<std::thread> producers;
+    for (int t = 0; t < kThreads; ++t) {
+        producers.emplace_back([&] {
+            for (int i = 0; i < kPer; ++i) {
+                loop.post([&ran] { ++ran; });
+            }
+        });
+    }
+
+    for (int i = 0; i < 1000 && ran < kThreads * kPer; ++i) {
+        loop.wait(100);
+    }
+    for (auto& th : producers) {
+        th.join();
+    }
+    while (ran < kThreads * kPer) {
+        assert(loop.wait(1000) >= 0);
+    }
+
+    assert(ran == kThreads * kPer);
+    assert(loop.wakeups() < static_cast<uint64_t>(kThreads * kPer));
+}
+
+void test_histogram_percentiles() {
+    Log2Histogram h;
+    assert(h.percentile(0.5) == 0);
+
+    for (int i = 0; i < 90; ++i) {
+        h.record(3);        // bucket [2, 4)
+    }
+    for (int i = 0; i < 10; ++i) {
+        h.record(1000);     // bucket [512, 1024)
+    }
+
+    assert(h.count() == 100);
+    assert(h.percentile(0.5) == 3);
+    assert(h.percentile(0.9) == 3);
+    assert(h.percentile(0.99) == 1000);     // clamped to the observed max
+    assert(h.max() == 1000);
+
+    h.record(0);
+    assert(h.bucket(0) == 1);
+    h.reset();
+    assert(h.count() == 0 && h.max() == 0);
+}
+
+void test_batch_grows_and_shrinks() {
+    EpollLoop loop;
+    loop.set_batch_limits(32, 256);
+
+    // Level-triggered eventfds stay ready until read
+    std::vector<int> fds;
+    for (int i = 0; i < 300; ++i) {
+        int fd = ::eventfd(1, EFD_NONBLOCK);
+        assert(fd >= 0);
+        loop.add(fd, EPOLLIN, &fds);
+        fds.push_back(fd);
+    }
+
+    for (int i = 0; i < 8; ++i) {
+        loop.wait(0);
+    }
+    assert(loop.batch_capacity() == 256);       // capped at the limit
+    assert(loop.stats().grows >= 1);
+    assert(loop.ready_count() == 256);
+
+    for (int fd : fds) {
+        loop.remove(fd);
+        ::close(fd);
+    }
+
+    // Idle windows halve the array back down to the lower limit
+    for (int i = 0; i < 64 * 8; ++i) {
+        loop.wait(0);
+    }
+    assert(loop.batch_capacity() == 32);
+    assert(loop.stats().shrinks >= 3);
+}
+
+void test_busy_poll_spins_then_blocks() {
+    EpollLoop loop;
+    loop.set_busy_poll(2000);
+
+    // Nothing ready: spins for the budget, then times out
+    assert(loop.wait(5) == 0);
+    assert(loop.stats().spins > 1);
+    assert(loop.stats().wait_us.max() >= 2000);
+
+    // A task posted mid-spin is picked up without blocking
+    std::atomic<int> ran{0};
+    std::thread producer([&] {
+        std::this_thread::sleep_for(std::chrono::microseconds(500));
+        loop.post([&ran] { ran.fetch_add(1); });
+    });
+    for (int i = 0; i < 100 && ran.load() == 0; ++i) {
+        loop.wait(1000);
+    }
+    producer.join();
+    assert(ran.load() == 1);
+
+    // Zero timeout never spins
+    uint64_t spins = loop.stats().spins;
+    loop.wait(0);
+    assert(loop.stats().spins == spins);
+}
+
+void test_iteration_stats() {
+    EpollLoop loop;
+    for (int i = 0; i < 5; ++i) {
+        loop.wait(0);
+    }
+    const LoopStats& st = loop.stats();
+    assert(st.iterations == 5);
+    assert(st.batch.count() == 5);
+    assert(st.busy_us.count() == 4);    // gaps between consecutive waits
+
+    loop.reset_stats();
+    assert(loop.stats().iterations == 0);
+}
+
+void test_signals_become_readiness() {
+    EpollLoop loop;
+    SignalFd signals({SIGUSR1, SIGUSR2});
+    loop.add(signals.fd(), EPOLLIN, &signals);
+
+    assert(loop.wait(0) == 0);
+    assert(signals.read() == 0);
+
+    // Blocked, so both stay pending instead of killing the test
+    raise(SIGUSR2);
+    raise(SIGUSR1);
+    raise(SIGUSR1);
+
+    assert(loop.wait(1000) == 1);
+    assert(loop.event_at(0).data.ptr == &signals);
+
+    int seen = 0;
+    while (int sig = signals.read()) {
+        assert(sig == SIGUSR1 || sig == SIGUSR2);
+        ++seen;
+    }
+    assert(seen == 2);      // the two SIGUSR1 collapsed
+    assert(loop.wait(0) == 0);
+}
+
+int main() {
+    test_mpsc_fifo_single_thread();
+    test_mpsc_many_producers();
+    test_post_runs_on_loop_thread();
+    test_burst_is_one_wakeup();
+    test_concurrent_posters();
+    test_histogram_percentiles();
+    test_batch_grows_and_shrinks();
+    test_busy_poll_spins_then_blocks();
+    test_iteration_stats();
+    test_signals_become_readiness();
+
+    std::cout << "Epoll loop tests PASSED\n";
+    return 0;
+}
@@ -0,0 +1,380 @@
+#include <cassert>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "protocol/http2/h2_session.h"
+#include "protocol/http2/hpack.h"
+
+/*
+ * Unit tests for HPACK and H2Session framing.
+ * HPACK vectors are from RFC 7541 Appendix C. No sockets.
+ */
+
+std::vector<uint8_t> hex(const char* s) {
+    std::vector<uint8_t> out;
+    std::string digits;
+    for (const char* p = s; *p; ++p) {
+        if (*p != ' ') {
+            digits.push_back(*p);
+        }
+    }
+    for (size_t i = 0; i + 1 < digits.size(); i += 2) {
+        out.push_back(static_cast<uint8_t>(std::stoi(digits.substr(i, 2), nullptr, 16)));
+    }
+    return out;
+}
+
+std::string frame(h2::FrameType type, uint8_t flags, uint32_t stream,
+                  const std::string& payload) {
+    std::string f;
+    h2::append_header(f, static_cast<uint32_t>(payload.size()), type, flags, stream);
+    f += payload;
+    return f;
+}
+
+std::string bytes(const std::vector<uint8_t>& v) {
+    return std::string(v.begin(), v.end());
+}
+
+// Parse all frames currently in output, returning their headers
+std::vector<h2::FrameHeader> drain(H2Session& s) {
+    std::vector<h2::FrameHeader> frames;
+    Buffer& out = s.output();
+    while (out.readable_bytes() >= h2::kFrameHeaderLen) {
+        auto h = h2::parse_header(reinterpret_cast<const uint8_t*>(out.read_ptr()));
+        frames.push_back(h);
+        out.consume(h2::kFrameHeaderLen + h.length);
+    }
+    return frames;
+}
+
+void test_hpack_rfc_c3_dynamic_table() {
+    HpackDecoder dec;
+
+    HeaderList first;
+    auto b1 = hex("8286 8441 0f77 7777 2e65 7861 6d70 6c65 2e63 6f6d");
+    assert(dec.decode(b1.data(), b1.size(), first));
+    assert(first.size() == 4);
+    assert(first[3].first == ":authority" && first[3].second == "www.example.com");
+    assert(dec.table_size() == 57);
+
+    HeaderList second;
+    auto b2 = hex("8286 84be 5808 6e6f 2d63 6163 6865");
+    assert(dec.decode(b2.data(), b2.size(), second));
+    assert(second.size() == 5);
+    assert(second[3].second == "www.example.com");
+    assert(second[4].first == "cache-control" && second[4].second == "no-cache");
+    assert(dec.table_size() == 110);
+}
+
+void test_hpack_rfc_c4_huffman() {
+    HpackDecoder dec;
+    HeaderList out;
+    auto b = hex("8286 8441 8cf1 e3c2 e5f2 3a6b a0ab 90f4 ff");
+    assert(dec.decode(b.data(), b.size(), out));
+    assert(out.size() == 4);
+    assert(out[0].first == ":method" && out[0].second == "GET");
+    assert(out[3].second == "www.example.com");
+}
+
+void test_hpack_encoder_roundtrip() {
+    HeaderList in = {{":status", "200"}, {"content-type", "text/plain"},
+                     {"x-custom", "value"}};
+    std::string block;
+    HpackEncoder::encode(in, block);
+
+    HpackDecoder dec;
+    HeaderList out;
+    assert(dec.decode(reinterpret_cast<const uint8_t*>(block.data()), block.size(), out));
+    assert(out == in);
+}
+
+void test_hpack_rejects_bad_index() {
+    HpackDecoder dec;
+    HeaderList out;
+    auto b = hex("ff00");   // index 127, dynamic table empty
+    assert(!dec.decode(b.data(), b.size(), out));
+}
+// One literal indexed into the dynamic table, then refs more times to it
+std::string repeated_field_block(size_t value_len, int refs) {
+    std::string block;
+    block.push_back(0x40);
+    hpack::encode_string(block, "x-big");
+    hpack::encode_string(block, std::string(value_len, 'a'));
+    for (int i = 0; i < refs; ++i) {
+        block.push_back(static_cast<char>(0x80 | 62));
+    }
+    return block;
+}
+
+void test_hpack_header_list_limit() {
+    // 5 + 1000 + 32 per field: two fit in 2100, three do not
+    std::string ok = repeated_field_block(1000, 1);
+    std::string big = repeated_field_block(1000, 2);
+
+    HpackDecoder dec(4096, 2100);
+    HeaderList out;
+    assert(dec.decode(reinterpret_cast<const uint8_t*>(ok.data()), ok.size(), out));
+    assert(out.size() == 2 && !dec.list_too_large());
+
+    HpackDecoder dec2(4096, 2100);
+    out.clear();
+    assert(!dec2.decode(reinterpret_cast<const uint8_t*>(big.data()), big.size(), out));
+    assert(dec2.list_too_large());
+    assert(out.size() == 2);    // stopped at the field that crossed the limit
+
+    // A coding error is not reported as a size problem
+    std::vector<uint8_t> bad = hex("be");
+    HpackDecoder dec3(4096, 2100);
+    assert(!dec3.decode(bad.data(), bad.size(), out));
+    assert(!dec3.list_too_large());
+}
+
+
+std::string request_headers_block() {
+    // :method GET, :scheme http, :path /, :authority www.example.com
+    return bytes(hex("8286 8441 8cf1 e3c2 e5f2 3a6b a0ab 90f4 ff"));
+}
+
+void test_session_request_response() {
+    H2Session s;
+    std::vector<H2Request> got;
+    s.set_callbacks([&](H2Request& r) { got.push_back(r); }, nullptr);
+    s.start();
+
+    std::string in(h2::kPreface, h2::kPrefaceLen);
+    in += frame(h2::FrameType::SETTINGS, 0, 0, "");
+    in += frame(h2::FrameType::HEADERS,
+                h2::flags::END_HEADERS | h2::flags::END_STREAM, 1,
+                request_headers_block());
+
+    ssize_t n = s.feed(in.data(), in.size());
+    assert(n == static_cast<ssize_t>(in.size()));
+    assert(got.size() == 1);
+    assert(got[0].method == "GET" && got[0].path == "/");
+    assert(got[0].authority == "www.example.com");
+
+    auto frames = drain(s);
+    assert(frames.size() == 2);     // our SETTINGS + ACK of theirs
+    assert(frames[1].type == h2::FrameType::SETTINGS && frames[1].flags == h2::flags::ACK);
+
+    s.submit_headers(1, 200, {{"content-type", "text/plain"}}, false);
+    s.submit_data(1, "hello", 5, true);
+
+    frames = drain(s);
+    assert(frames.size() == 2);
+    assert(frames[0].type == h2::FrameType::HEADERS);
+    assert(frames[1].type == h2::FrameType::DATA);
+    assert(frames[1].flags & h2::flags::END_STREAM);
+    assert(s.open_streams() == 0);
+}
+
+void test_session_partial_frames() {
+    H2Session s;
+    int requests = 0;
+    s.set_callbacks([&](H2Request&) { ++requests; }, nullptr);
+
+    std::string in(h2::kPreface, h2::kPrefaceLen);
+    in += frame(h2::FrameType::HEADERS,
+                h2::flags::END_HEADERS | h2::flags::END_STREAM, 1,
+                request_headers_block());
+
+    // Feed byte by byte, keeping unconsumed bytes like the caller does
+    std::string pending;
+    for (char ch : in) {
+        pending.push_back(ch);
+        ssize_t n = s.feed(pending.data(), pending.size());
+        assert(n >= 0);
+        pending.erase(0, n);
+    }
+    assert(pending.empty());
+    assert(requests == 1);
+}
+
+void test_session_flow_control_blocks_data() {
+    H2Session s;
+    s.set_callbacks([](H2Request&) {}, nullptr);
+
+    // Peer allows only 10 bytes per stream
+    std::string settings;
+    settings.push_back(0);
+    settings.push_back(static_cast<char>(h2::Setting::INITIAL_WINDOW_SIZE));
+    h2::append_u32(settings, 10);
+
+    std::string in(h2::kPreface, h2::kPrefaceLen);
+    in += frame(h2::FrameType::SETTINGS, 0, 0, settings);
+    in += frame(h2::FrameType::HEADERS,
+                h2::flags::END_HEADERS | h2::flags::END_STREAM, 1,
+                request_headers_block());
+    s.feed(in.data(), in.size());
+    drain(s);
+
+    std::string body(25, 'x');
+    s.submit_headers(1, 200, {}, false);
+    s.submit_data(1, body.data(), body.size(), true);
+
+    auto frames = drain(s);
+    assert(frames.size() == 2);
+    assert(frames[1].length == 10);
+    assert(s.pending_body_bytes() == 15);
+
+    std::string inc;
+    h2::append_u32(inc, 100);
+    std::string wu = frame(h2::FrameType::WINDOW_UPDATE, 0, 1, inc);
+    s.feed(wu.data(), wu.size());
+
+    frames = drain(s);
+    assert(frames.size() == 1);
+    assert(frames[0].length == 15);
+    assert(frames[0].flags & h2::flags::END_STREAM);
+}
+
+void test_session_ping_ack() {
+    H2Session s;
+    std::string in(h2::kPreface, h2::kPrefaceLen);
+    in += frame(h2::FrameType::PING, 0, 0, "12345678");
+    s.feed(in.data(), in.size());
+
+    auto frames = drain(s);
+    assert(frames.size() == 1);
+    assert(frames[0].type == h2::FrameType::PING && frames[0].flags == h2::flags::ACK);
+}
+
+void test_session_bad_preface() {
+    H2Session s;
+    const char* junk = "GET / HTTP/1.1\r\n\r\n";
+    assert(s.feed(junk, std::strlen(junk)) == -1);
+}
+
+void test_session_even_stream_rejected() {
+    H2Session s;
+    std::string in(h2::kPreface, h2::kPrefaceLen);
+    in += frame(h2::FrameType::HEADERS,
+                h2::flags::END_HEADERS | h2::flags::END_STREAM, 2,
+                request_headers_block());
+    assert(s.feed(in.data(), in.size()) == -1);
+
+    auto frames = drain(s);
+    assert(!frames.empty() && frames.back().type == h2::FrameType::GOAWAY);
+}
+
+void test_session_advertises_header_list_size() {
+    H2Session s;
+    s.start();
+
+    Buffer& out = s.output();
+    auto h = h2::parse_header(reinterpret_cast<const uint8_t*>(out.read_ptr()));
+    assert(h.type == h2::FrameType::SETTINGS && h.length % 6 == 0);
+
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(out.read_ptr()) + h2::kFrameHeaderLen;
+    bool found = false;
+    for (size_t off = 0; off < h.length; off += 6) {
+        uint16_t id = static_cast<uint16_t>((p[off] << 8) | p[off + 1]);
+        if (id == static_cast<uint16_t>(h2::Setting::MAX_HEADER_LIST_SIZE)) {
+            assert(h2::read_u32(p + off + 2) == H2Session::kMaxHeaderListSize);
+            found = true;
+        }
+    }
+    assert(found);
+}
+
+void test_session_header_list_too_large() {
+    H2Session s;
+    int requests = 0;
+    s.set_callbacks([&](H2Request&) { ++requests; }, nullptr);
+
+    // About 1 KiB on the wire, over 40 KiB once decoded
+    std::string block = request_headers_block() + repeated_field_block(1000, 40);
+    assert(block.size() < h2::kDefaultMaxFrameSize);
+
+    std::string in(h2::kPreface, h2::kPrefaceLen);
+    in += frame(h2::FrameType::HEADERS,
+                h2::flags::END_HEADERS | h2::flags::END_STREAM, 1, block);
+    assert(s.feed(in.data(), in.size()) == -1);
+    assert(requests == 0);
+
+    Buffer& out = s.output();
+    h2::FrameHeader last{};
+    const uint8_t* payload = nullptr;
+    while (out.readable_bytes() >= h2::kFrameHeaderLen) {
+        last = h2::parse_header(reinterpret_cast<const uint8_t*>(out.read_ptr()));
+        payload = reinterpret_cast<const uint8_t*>(out.read_ptr()) + h2::kFrameHeaderLen;
+        if (last.type == h2::FrameType::GOAWAY) {
+            break;
+        }
+        out.consume(h2::kFrameHeaderLen + last.length);
+    }
+    assert(last.type == h2::FrameType::GOAWAY);
+    assert(h2::read_u32(payload + 4) == static_cast<uint32_t>(h2::ErrorCode::ENHANCE_YOUR_CALM));
+}
+
+// HEADERS for a body-carrying request on stream id (no END_STREAM)
+std::string open_stream(uint32_t id) {
+    return frame(h2::FrameType::HEADERS, h2::flags::END_HEADERS, id,
+                 request_headers_block());
+}
+
+void test_session_caps_buffered_bodies() {
+    H2Session s(1 << 20, 40000);
+    std::vector<uint32_t> delivered;
+    std::vector<uint32_t> reset;
+    s.set_callbacks([&](H2Request& r) { delivered.push_back(r.stream_id); },
+                    [&](uint32_t id) { reset.push_back(id); });
+
+    std::string chunk(15000, 'x');
+    std::string in(h2::kPreface, h2::kPrefaceLen);
+    in += open_stream(1);
+    in += frame(h2::FrameType::DATA, 0, 1, chunk);
+    in += frame(h2::FrameType::DATA, 0, 1, chunk);
+    in += open_stream(3);
+    in += frame(h2::FrameType::DATA, 0, 3, chunk);
+    assert(s.feed(in.data(), in.size()) == static_cast<ssize_t>(in.size()));
+
+    // Stream 3 would take the connection past its cap: refused, and
+    // only stream 1's bytes stay buffered
+    assert(reset.size() == 1 && reset[0] == 3);
+    assert(s.buffered_body_bytes() == 30000);
+    bool refused = false;
+    Buffer& out = s.output();
+    while (out.readable_bytes() >= h2::kFrameHeaderLen) {
+        auto h = h2::parse_header(reinterpret_cast<const uint8_t*>(out.read_ptr()));
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(out.read_ptr()) + h2::kFrameHeaderLen;
+        if (h.type == h2::FrameType::RST_STREAM && h.stream_id == 3) {
+            refused = h2::read_u32(p) == static_cast<uint32_t>(h2::ErrorCode::REFUSED_STREAM);
+        }
+        out.consume(h2::kFrameHeaderLen + h.length);
+    }
+    assert(refused);
+
+    // Delivery hands the body over and frees the budget for new streams
+    in = frame(h2::FrameType::DATA, h2::flags::END_STREAM, 1, "");
+    in += open_stream(5);
+    in += frame(h2::FrameType::DATA, 0, 5, chunk);
+    in += frame(h2::FrameType::DATA, h2::flags::END_STREAM, 5, chunk);
+    assert(s.feed(in.data(), in.size()) == static_cast<ssize_t>(in.size()));
+    assert(delivered.size() == 2 && delivered[0] == 1 && delivered[1] == 5);
+    assert(reset.size() == 1);
+    assert(s.buffered_body_bytes() == 0);
+}
+
+int main() {
+    test_hpack_rfc_c3_dynamic_table();
+    test_hpack_rfc_c4_huffman();
+    test_hpack_encoder_roundtrip();
+    test_hpack_rejects_bad_index();
+    test_hpack_header_list_limit();
+    test_session_request_response();
+    test_session_partial_frames();
+    test_session_flow_control_blocks_data();
+    test_session_ping_ack();
+    test_session_bad_preface();
+    test_session_even_stream_rejected();
+    test_session_advertises_header_list_size();
+    test_session_header_list_too_large();
+    test_session_caps_buffered_bodies();
+
+    std::cout << "HTTP/2 session tests PASSED\n";
+    return 0;
+}
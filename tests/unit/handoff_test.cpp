@@ -0,0 +1,160 @@
+#include <arpa/inet.h>
+#include <cassert>
+#include <cstring>
+#include <iostream>
+#include <netinet/in.h>
+#include <poll.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "core/fd/fd_wrapper.h"
+#include "core/socket/fd_passing.h"
+#include "upgrade/handoff.h"
+
+/*
+ * Unit tests for listening-socket handoff: FdPassing over a socketpair,
+ * then HandoffServer / HandoffClient over a Unix socket path, with and
+ * without the new process acknowledging.
+ */
+
+static const char* kPath = "/tmp/handoff_test.sock";
+
+int make_listener(uint16_t& port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    assert(fd >= 0);
+    sockaddr_in sa{};
+    sa.sin_family = AF_INET;
+    sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    assert(::bind(fd, reinterpret_cast<sockaddr*>(&sa), sizeof(sa)) == 0);
+    assert(::listen(fd, 16) == 0);
+    socklen_t len = sizeof(sa);
+    assert(::getsockname(fd, reinterpret_cast<sockaddr*>(&sa), &len) == 0);
+    port = ntohs(sa.sin_port);
+    return fd;
+}
+
+bool is_listening(int fd) {
+    int v = 0;
+    socklen_t len = sizeof(v);
+    return ::getsockopt(fd, SOL_SOCKET, SO_ACCEPTCONN, &v, &len) == 0 && v == 1;
+}
+
+uint16_t local_port(int fd) {
+    sockaddr_in sa{};
+    socklen_t len = sizeof(sa);
+    assert(::getsockname(fd, reinterpret_cast<sockaddr*>(&sa), &len) == 0);
+    return ntohs(sa.sin_port);
+}
+
+// Wait for fd to become readable (bounded)
+bool wait_readable(int fd, int ms) {
+    pollfd p{fd, POLLIN, 0};
+    return ::poll(&p, 1, ms) == 1;
+}
+
+void test_fd_passing_listener() {
+    uint16_t port = 0;
+    int lfd = make_listener(port);
+
+    int sv[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == 0);
+    assert(FdPassing::send(sv[0], "LSN1", 4, {lfd}) == 4);
+
+    char buf[4] = {};
+    std::vector<int> fds;
+    assert(FdPassing::recv(sv[1], buf, sizeof(buf), fds) == 4);
+    assert(std::memcmp(buf, "LSN1", 4) == 0);
+    assert(fds.size() == 1 && fds[0] != lfd);
+
+    // Same socket, new descriptor: still listening on the same port
+    assert(is_listening(fds[0]));
+    assert(local_port(fds[0]) == port);
+
+    // Peer close is 0, not an error
+    ::close(sv[0]);
+    std::vector<int> none;
+    assert(FdPassing::recv(sv[1], buf, sizeof(buf), none) == 0 && none.empty());
+
+    ::close(fds[0]);
+    ::close(sv[1]);
+    ::close(lfd);
+    std::cout << "[OK] listening fd passed over a socketpair\n";
+}
+
+void test_receive_without_server() {
+    ::unlink(kPath);
+    std::vector<int> fds;
+    FDWrapper channel;
+    assert(!HandoffClient::receive(kPath, fds, channel));
+    assert(fds.empty() && !channel.valid());
+    std::cout << "[OK] no running proxy: fresh start\n";
+}
+
+// One upgrade attempt; the new process acks or exits without acking
+void run_handoff(bool ack) {
+    uint16_t port = 0;
+    int lfd = make_listener(port);
+
+    HandoffServer server;
+    assert(server.listen(kPath));
+    assert(server.fd() >= 0);
+
+    std::vector<int> fds;
+    bool received = false;
+    std::thread upstart([&] {
+        FDWrapper channel;
+        received = HandoffClient::receive(kPath, fds, channel);
+        if (received && ack) {
+            assert(HandoffClient::ack(channel.get()));
+        }
+        // Without an ack the channel closes here, as when a new
+        // process fails its setup and exits
+    });
+
+    assert(wait_readable(server.fd(), 2000));
+    int pfd = server.accept_and_send({lfd});
+    assert(pfd >= 0 && pfd == server.peer_fd());
+    upstart.join();
+
+    assert(received);
+    assert(fds.size() == 1 && is_listening(fds[0]) && local_port(fds[0]) == port);
+
+    assert(wait_readable(pfd, 2000));
+    if (ack) {
+        assert(server.read_ack());
+    } else {
+        // Old process keeps serving and may be upgraded again
+        assert(!server.read_ack());
+        assert(server.peer_fd() < 0);
+        assert(server.fd() >= 0);
+    }
+
+    server.close();
+    assert(server.fd() < 0 && server.peer_fd() < 0);
+    ::close(fds[0]);
+    ::close(lfd);
+    ::unlink(kPath);
+}
+
+void test_handoff_acked() {
+    run_handoff(true);
+    std::cout << "[OK] new process acks: old process may stop accepting\n";
+}
+
+void test_handoff_not_acked() {
+    run_handoff(false);
+    std::cout << "[OK] new process exits without ack: old process keeps serving\n";
+}
+
+int main() {
+    test_fd_passing_listener();
+    test_receive_without_server();
+    test_handoff_acked();
+    test_handoff_not_acked();
+
+    std::cout << "Handoff tests PASSED\n";
+    return 0;
+}
@@ -0,0 +1,166 @@
+#include <cassert>
+#include <iostream>
+#include <string>
+#include <sys/uio.h>
+
+#include "protocol/http/header_rewrite.h"
+
+/*
+ * Unit tests for HeaderRules / HeaderEditor.
+ * Pure in-memory heads, no sockets.
+ */
+
+static std::string join(const iovec* iov, size_t n) {
+    std::string out;
+    for (size_t i = 0; i < n; ++i) {
+        out.append(static_cast<const char*>(iov[i].iov_base), iov[i].iov_len);
+    }
+    return out;
+}
+
+static HeaderRule rule(HeaderRule::Op op, const std::string& name, const std::string& line = "") {
+    HeaderRule r;
+    r.op = op;
+    r.name = name;
+    r.line = line;
+    return r;
+}
+
+static std::string edit(const std::string& msg, const HeaderRules& rules) {
+    size_t head = msg.find("\r\n\r\n") + 4;
+    HeaderEditor e;
+    iovec iov[HeaderEditor::kMaxIov];
+    assert(e.parse(msg.data(), head));
+    e.apply(rules);
+    size_t n = e.build(msg.size(), iov);
+    assert(n > 0);
+    return join(iov, n);
+}
+
+void test_no_rules_is_one_span() {
+    std::string msg = "GET / HTTP/1.1\r\nHost: a\r\n\r\nbody";
+    HeaderEditor e;
+    iovec iov[HeaderEditor::kMaxIov];
+    assert(e.parse(msg.data(), msg.size() - 4));
+    e.apply(HeaderRules{});
+    assert(e.build(msg.size(), iov) == 1);
+    assert(iov[0].iov_base == msg.data());
+}
+
+void test_remove_every_occurrence() {
+    HeaderRules rules;
+    rules.rules.push_back(rule(HeaderRule::Op::REMOVE, "cookie"));
+
+    std::string out = edit("GET / HTTP/1.1\r\nCookie: a=1\r\nHost: a\r\n"
+                           "COOKIE: b=2\r\nX-Cookie: keep\r\n\r\n", rules);
+    assert(out == "GET / HTTP/1.1\r\nHost: a\r\nX-Cookie: keep\r\n\r\n");
+}
+
+void test_set_and_add() {
+    HeaderRules rules;
+    rules.rules.push_back(rule(HeaderRule::Op::SET, "host", "Host: internal\r\n"));
+    rules.rules.push_back(rule(HeaderRule::Op::ADD, "via", "Via: 1.1 proxy\r\n"));
+
+    std::string out = edit("GET / HTTP/1.1\r\nhost: public\r\nVia: 1.0 edge\r\n\r\nxy", rules);
+    assert(out == "GET / HTTP/1.1\r\nVia: 1.0 edge\r\nHost: internal\r\n"
+                  "Via: 1.1 proxy\r\n\r\nxy");
+}
+
+void test_response_status_line_kept() {
+    HeaderRules rules;
+    rules.rules.push_back(rule(HeaderRule::Op::REMOVE, "server"));
+
+    std::string out = edit("HTTP/1.1 200 OK\r\nServer: x/1.0\r\nContent-Length: 0\r\n\r\n", rules);
+    assert(out == "HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n");
+}
+
+void test_strip_hop_by_hop() {
+    HeaderRules rules;
+    rules.strip_hop_by_hop = true;
+
+    std::string out = edit("GET / HTTP/1.1\r\nConnection: Upgrade\r\nKeep-Alive: 5\r\n"
+                           "Upgrade: websocket\r\nTE: trailers\r\nProxy-Connection: x\r\n"
+                           "Transfer-Encoding: chunked\r\n\r\n", rules);
+    assert(out == "GET / HTTP/1.1\r\nConnection: Upgrade\r\nUpgrade: websocket\r\n"
+                  "Transfer-Encoding: chunked\r\n\r\n");
+
+    assert(rules.removes("te"));
+    assert(!rules.removes("connection"));
+}
+
+void test_rules_for_built_heads() {
+    HeaderRules rules;
+    rules.rules.push_back(rule(HeaderRule::Op::SET, "host", "Host: internal\r\n"));
+    rules.rules.push_back(rule(HeaderRule::Op::REMOVE, "cookie"));
+    rules.rules.push_back(rule(HeaderRule::Op::ADD, "via", "Via: 1.1 proxy\r\n"));
+
+    assert(rules.removes("host"));
+    assert(rules.removes("cookie"));
+    assert(!rules.removes("via"));
+
+    std::string head;
+    rules.append_lines(head);
+    assert(head == "Host: internal\r\nVia: 1.1 proxy\r\n");
+}
+
+void test_append_value_after_removal() {
+    // A removed header is not extended; the value becomes a new line
+    std::string msg = "GET / HTTP/1.1\r\nX-Forwarded-For: 10.0.0.9\r\n\r\n";
+    HeaderEditor e;
+    iovec iov[HeaderEditor::kMaxIov];
+    assert(e.parse(msg.data(), msg.size()));
+    e.remove("x-forwarded-for");
+    e.append_value("X-Forwarded-For", {"192.0.2.1"});
+    assert(join(iov, e.build(msg.size(), iov)) ==
+           "GET / HTTP/1.1\r\nX-Forwarded-For: 192.0.2.1\r\n\r\n");
+}
+
+void test_too_many_lines_fails() {
+    std::string msg = "GET / HTTP/1.1\r\n";
+    for (size_t i = 0; i <= HeaderEditor::kMaxLines; ++i) {
+        msg += "X-H: v\r\n";
+    }
+    msg += "\r\n";
+
+    HeaderEditor e;
+    iovec iov[HeaderEditor::kMaxIov];
+    assert(!e.parse(msg.data(), msg.size()));
+    assert(e.build(msg.size(), iov) == 0);
+}
+
+void test_too_many_additions_fails() {
+    std::string msg = "GET / HTTP/1.1\r\n\r\n";
+    std::string line = "X-A: 1\r\n";
+
+    HeaderEditor e;
+    iovec iov[HeaderEditor::kMaxIov];
+    assert(e.parse(msg.data(), msg.size()));
+    for (size_t i = 0; i < HeaderEditor::kMaxAdded; ++i) {
+        e.add(line.data(), line.size());
+    }
+    assert(e.ok());
+    e.add(line.data(), line.size());
+    assert(!e.ok());
+    assert(e.build(msg.size(), iov) == 0);
+
+    // The arena is bounded too
+    std::string big(HeaderEditor::kArenaBytes, 'v');
+    assert(e.parse(msg.data(), msg.size()));
+    e.append_value("X-Big", {big});
+    assert(!e.ok());
+}
+
+int main() {
+    test_no_rules_is_one_span();
+    test_remove_every_occurrence();
+    test_set_and_add();
+    test_response_status_line_kept();
+    test_strip_hop_by_hop();
+    test_rules_for_built_heads();
+    test_append_value_after_removal();
+    test_too_many_lines_fails();
+    test_too_many_additions_fails();
+
+    std::cout << "Header rewrite tests PASSED\n";
+    return 0;
+}
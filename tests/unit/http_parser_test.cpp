@@ -1,6 +1,8 @@
 #include <cassert>
+#include <cstdint>
 #include <cstring>
 #include <iostream>
+#include <string>
 
 #include "protocol/http/http_parser.h"
 
@@ -87,12 +89,148 @@ void test_multiple_headers_case_insensitive() {
     assert(info.body_bytes == 3);
 }
 
+void test_find_header_keeps_high_bytes() {
+    // Bytes >= 0x80 at either end of a value are not whitespace
+    const std::string head =
+        "GET / HTTP/1.1\r\n"
+        "X-Name: \xc3\xa9t\xc3\xa9 \r\n"
+        "\r\n";
+
+    std::pmr::string value;
+    assert(HttpParser::find_header(head.data(), head.size(), "X-Name", value));
+    assert(value == "\xc3\xa9t\xc3\xa9");
+}
+
+HttpParseResult parse_str(const std::string& req, HttpRequestInfo& info) {
+    HttpParser parser;
+    return parser.parse(req.data(), req.size(), info);
+}
+
+void test_content_length_rejects_malformed() {
+    const char* bad[] = {
+        "Content-Length: 12a",
+        "Content-Length: -1",
+        "Content-Length: +5",
+        "Content-Length: 0x10",
+        "Content-Length: 1 2",
+        "Content-Length:",
+        "Content-Length: 99999999999999999999999",     // > SIZE_MAX
+        "Content-Length : 5",                           // space before colon
+        "Content-Length\t: 5",
+    };
+
+    for (const char* h : bad) {
+        std::string req = std::string("POST / HTTP/1.1\r\n") + h + "\r\n\r\n";
+        HttpRequestInfo info{};
+        assert(parse_str(req, info) == HttpParseResult::ERROR);
+    }
+}
+
+void test_content_length_duplicates() {
+    HttpRequestInfo info{};
+
+    // Conflicting values: the request smuggling classic
+    assert(parse_str("POST / HTTP/1.1\r\nContent-Length: 3\r\n"
+                     "content-length: 4\r\n\r\nabcd", info) == HttpParseResult::ERROR);
+
+    // Identical duplicates are allowed
+    assert(parse_str("POST / HTTP/1.1\r\nContent-Length: 3\r\n"
+                     "Content-Length:  3 \r\n\r\nabc", info) == HttpParseResult::COMPLETE);
+    assert(info.body_bytes == 3);
+
+    // Look-alike header names are not Content-Length
+    assert(parse_str("POST / HTTP/1.1\r\nContent-Lengthy: 3\r\n\r\n", info) ==
+           HttpParseResult::COMPLETE);
+    assert(info.body_bytes == 0);
+}
+
+void test_transfer_encoding_rejected() {
+    const char* bad[] = {
+        // Bodies are framed by Content-Length only: the head alone
+        // must not read as a complete bodiless request
+        "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n5\r\nhello\r\n0\r\n\r\n",
+        // TE plus CL: the classic smuggling pair
+        "POST / HTTP/1.1\r\nContent-Length: 3\r\nTransfer-Encoding: chunked\r\n\r\nabc",
+        "POST / HTTP/1.1\r\ntransfer-encoding: identity\r\nContent-Length: 3\r\n\r\nabc",
+        "POST / HTTP/1.1\r\nTransfer-Encoding : chunked\r\n\r\n",
+        "POST / HTTP/1.1\r\nTransfer-Encoding:\r\n\r\n",
+    };
+
+    // The first and the last two carry TE without any Content-Length:
+    // unsupported rather than malformed
+    const bool unsupported[] = {true, false, false, true, true};
+
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); ++i) {
+        HttpRequestInfo info{};
+        assert(parse_str(bad[i], info) == HttpParseResult::ERROR);
+        assert(info.unsupported_encoding == unsupported[i]);
+    }
+
+    // A malformed length next to TE is still a bad request
+    HttpRequestInfo bad_len{};
+    assert(parse_str("POST / HTTP/1.1\r\nContent-Length : 3\r\n"
+                     "Transfer-Encoding: chunked\r\n\r\nabc", bad_len) ==
+           HttpParseResult::ERROR);
+    assert(!bad_len.unsupported_encoding);
+
+    // Look-alike names are ordinary headers
+    HttpRequestInfo info{};
+    assert(parse_str("GET / HTTP/1.1\r\nTransfer-Encodings: x\r\n"
+                     "X-Transfer-Encoding: chunked\r\n\r\n", info) ==
+           HttpParseResult::COMPLETE);
+}
+
+void test_huge_content_length_does_not_wrap() {
+    // Largest representable length: header_end + length would overflow
+    std::string req = "POST / HTTP/1.1\r\nContent-Length: " +
+                      std::to_string(SIZE_MAX) + "\r\n\r\nabc";
+    HttpRequestInfo info{};
+    assert(parse_str(req, info) == HttpParseResult::INCOMPLETE);
+    assert(info.body_bytes == SIZE_MAX);
+}
+
+void test_split_at_every_boundary() {
+    // The proxy re-parses its growing buffer after every read, so each
+    // prefix must either be INCOMPLETE or already agree with the whole
+    const char* reqs[] = {
+        "GET / HTTP/1.1\r\nHost: a\r\n\r\n",
+        "POST /x HTTP/1.1\r\nHost: a\r\nContent-Length: 5\r\n\r\nhello",
+        "POST /x HTTP/1.1\r\nContent-Length: 2\r\nContent-Length: 3\r\n\r\nabc",
+        "GET / HTTP/1.1\r\n\r\nGET /next HTTP/1.1\r\n\r\n",
+    };
+
+    for (const char* r : reqs) {
+        std::string full(r);
+        HttpRequestInfo whole{};
+        HttpParseResult want = parse_str(full, whole);
+
+        for (size_t k = 0; k <= full.size(); ++k) {
+            HttpRequestInfo part{};
+            HttpParseResult got = parse_str(full.substr(0, k), part);
+            if (got == HttpParseResult::INCOMPLETE && k < full.size()) {
+                continue;
+            }
+            assert(got == want);
+            if (want != HttpParseResult::ERROR) {
+                assert(part.header_bytes == whole.header_bytes);
+                assert(part.body_bytes == whole.body_bytes);
+            }
+        }
+    }
+}
+
 int main() {
     test_incomplete_headers();
     test_complete_headers_no_body();
     test_headers_with_content_length_incomplete_body();
     test_headers_with_content_length_complete_body();
     test_multiple_headers_case_insensitive();
+    test_find_header_keeps_high_bytes();
+    test_content_length_rejects_malformed();
+    test_content_length_duplicates();
+    test_transfer_encoding_rejected();
+    test_huge_content_length_does_not_wrap();
+    test_split_at_every_boundary();
 
     std::cout << "HTTP parser tests PASSED\n";
     return 0;
@@ -0,0 +1,207 @@
+#include <arpa/inet.h>
+#include <cassert>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <sys/uio.h>
+
+#include "protocol/http/forwarded.h"
+#include "protocol/http/header_rewrite.h"
+#include "protocol/proxy/proxy_protocol.h"
+
+/*
+ * Unit tests for PROXY protocol v1/v2 parsing and the X-Forwarded-For /
+ * Forwarded values spliced into request heads. No sockets.
+ */
+
+static std::string ip_of(const sockaddr_storage& ss) {
+    return ForwardedSplicer::format_address(ss);
+}
+
+static uint16_t port_of(const sockaddr_storage& ss) {
+    if (ss.ss_family == AF_INET)
+        return ntohs(reinterpret_cast<const sockaddr_in*>(&ss)->sin_port);
+    return ntohs(reinterpret_cast<const sockaddr_in6*>(&ss)->sin6_port);
+}
+
+static std::string join(const iovec* iov, size_t n) {
+    std::string out;
+    for (size_t i = 0; i < n; ++i)
+        out.append(static_cast<const char*>(iov[i].iov_base), iov[i].iov_len);
+    return out;
+}
+
+static std::string v2_header(uint8_t ver_cmd, uint8_t fam, const std::string& body) {
+    std::string h("\r\n\r\n\0\r\nQUIT\n", 12);
+    h.push_back(static_cast<char>(ver_cmd));
+    h.push_back(static_cast<char>(fam));
+    h.push_back(static_cast<char>(body.size() >> 8));
+    h.push_back(static_cast<char>(body.size() & 0xff));
+    return h + body;
+}
+
+void test_v1_tcp4() {
+    std::string in = "PROXY TCP4 192.0.2.1 198.51.100.7 51234 443\r\nGET / HTTP/1.1\r\n";
+    ProxyHeader h;
+    assert(ProxyProtocol::parse(in.data(), in.size(), h) == ProxyHeaderResult::COMPLETE);
+    assert(h.version == 1 && !h.local);
+    assert(h.header_bytes == in.find("GET"));
+    assert(ip_of(h.source) == "192.0.2.1" && port_of(h.source) == 51234);
+    assert(ip_of(h.destination) == "198.51.100.7" && port_of(h.destination) == 443);
+}
+
+void test_v1_tcp6_and_unknown() {
+    std::string in = "PROXY TCP6 2001:db8::1 2001:db8::2 1000 80\r\n";
+    ProxyHeader h;
+    assert(ProxyProtocol::parse(in.data(), in.size(), h) == ProxyHeaderResult::COMPLETE);
+    assert(ip_of(h.source) == "2001:db8::1");
+
+    std::string unk = "PROXY UNKNOWN ffff::1 ffff::2 1 2\r\n";
+    assert(ProxyProtocol::parse(unk.data(), unk.size(), h) == ProxyHeaderResult::COMPLETE);
+    assert(h.local && h.header_bytes == unk.size());
+}
+
+void test_v1_incomplete_and_malformed() {
+    ProxyHeader h;
+    std::string full = "PROXY TCP4 192.0.2.1 198.51.100.7 51234 443\r\n";
+    for (size_t k = 0; k < full.size(); ++k)
+        assert(ProxyProtocol::parse(full.data(), k, h) == ProxyHeaderResult::INCOMPLETE);
+
+    const char* bad[] = {
+        "PROXY TCP4 192.0.2.1 198.51.100.7 51234\r\n",          // missing port
+        "PROXY TCP4 192.0.2.1 198.51.100.7 51234 443 x\r\n",    // extra field
+        "PROXY TCP4 192.0.2.1  198.51.100.7 51234 443\r\n",     // double space
+        "PROXY TCP4 2001:db8::1 198.51.100.7 1 2\r\n",          // family mismatch
+        "PROXY TCP4 192.0.2.1 198.51.100.7 65536 443\r\n",
+        "PROXY TCP4 192.0.2.1 198.51.100.7 0443 443\r\n",
+        "PROXY UDP4 192.0.2.1 198.51.100.7 1 2\r\n",
+        "PROXY TCP4 192.0.2.1 198.51.100.7 1 2\n",              // bare LF
+        "GET / HTTP/1.1\r\n\r\n",                               // no header at all
+    };
+    for (const char* b : bad)
+        assert(ProxyProtocol::parse(b, std::strlen(b), h) == ProxyHeaderResult::ERROR);
+
+    std::string endless = "PROXY " + std::string(200, 'x');
+    assert(ProxyProtocol::parse(endless.data(), endless.size(), h) == ProxyHeaderResult::ERROR);
+}
+
+void test_v2_inet_with_tlvs() {
+    std::string body;
+    body.append("\xc0\x00\x02\x01", 4);         // 192.0.2.1
+    body.append("\xc6\x33\x64\x07", 4);         // 198.51.100.7
+    body.append("\xc8\x22", 2);                 // 51234
+    body.append("\x01\xbb", 2);                 // 443
+    body.append("\x04\x00\x02hi", 5);           // NOOP TLV, skipped
+
+    std::string in = v2_header(0x21, 0x11, body) + "GET /";
+    ProxyHeader h;
+    assert(ProxyProtocol::parse(in.data(), in.size(), h) == ProxyHeaderResult::COMPLETE);
+    assert(h.version == 2 && !h.local);
+    assert(h.header_bytes == 16 + body.size());
+    assert(ip_of(h.source) == "192.0.2.1" && port_of(h.source) == 51234);
+    assert(port_of(h.destination) == 443);
+
+    // Any shorter prefix is incomplete; once the fixed part is in, the
+    // total length is already reported
+    for (size_t k = 0; k < h.header_bytes; ++k) {
+        ProxyHeader p;
+        assert(ProxyProtocol::parse(in.data(), k, p) == ProxyHeaderResult::INCOMPLETE);
+        if (k >= 16)
+            assert(p.header_bytes == h.header_bytes);
+    }
+}
+
+void test_v2_inet6_local_and_bad() {
+    std::string body(36, '\0');
+    body[15] = 1;                               // ::1
+    body[32] = 0x12;
+    body[33] = 0x34;
+    std::string in = v2_header(0x21, 0x21, body);
+    ProxyHeader h;
+    assert(ProxyProtocol::parse(in.data(), in.size(), h) == ProxyHeaderResult::COMPLETE);
+    assert(ip_of(h.source) == "::1" && port_of(h.source) == 0x1234);
+
+    std::string local = v2_header(0x20, 0x00, "");
+    assert(ProxyProtocol::parse(local.data(), local.size(), h) == ProxyHeaderResult::COMPLETE);
+    assert(h.local && h.header_bytes == 16);
+
+    std::string bad_ver = v2_header(0x11, 0x11, std::string(12, '\0'));
+    assert(ProxyProtocol::parse(bad_ver.data(), bad_ver.size(), h) == ProxyHeaderResult::ERROR);
+
+    std::string short_addr = v2_header(0x21, 0x11, std::string(8, '\0'));
+    assert(ProxyProtocol::parse(short_addr.data(), short_addr.size(), h) ==
+           ProxyHeaderResult::ERROR);
+}
+
+// What the manager does for a request head (see forward_request)
+static size_t splice(HeaderEditor& e, const std::string& req, size_t head,
+                     const std::string& client, iovec* iov) {
+    assert(e.parse(req.data(), head));
+    bool v6 = client.find(':') != std::string::npos;
+    e.append_value("X-Forwarded-For", {client});
+    e.append_value("Forwarded", {v6 ? "for=\"[" : "for=", client, v6 ? "]\"" : ""});
+    return e.build(req.size(), iov);
+}
+
+void test_splice_new_headers() {
+    std::string req = "POST /x HTTP/1.1\r\nHost: a\r\nContent-Length: 2\r\n\r\nhi";
+    size_t head = req.find("\r\n\r\n") + 4;
+
+    HeaderEditor e;
+    iovec iov[HeaderEditor::kMaxIov];
+    size_t n = splice(e, req, head, "192.0.2.1", iov);
+
+    assert(join(iov, n) ==
+           "POST /x HTTP/1.1\r\nHost: a\r\nContent-Length: 2\r\n"
+           "X-Forwarded-For: 192.0.2.1\r\nForwarded: for=192.0.2.1\r\n\r\nhi");
+
+    // Original bytes are referenced, not copied
+    assert(iov[0].iov_base == req.data());
+    assert(n == 4);
+}
+
+void test_splice_appends_to_existing() {
+    std::string req = "GET / HTTP/1.1\r\nx-forwarded-for: 10.0.0.1\r\n"
+                      "Forwarded: for=10.0.0.1\r\nX-Forwarded-For: 10.0.0.2\r\nHost: a\r\n\r\n";
+    size_t head = req.size();
+
+    HeaderEditor e;
+    iovec iov[HeaderEditor::kMaxIov];
+    size_t n = splice(e, req, head, "2001:db8::1", iov);
+
+    assert(join(iov, n) ==
+           "GET / HTTP/1.1\r\nx-forwarded-for: 10.0.0.1\r\n"
+           "Forwarded: for=10.0.0.1, for=\"[2001:db8::1]\"\r\n"
+           "X-Forwarded-For: 10.0.0.2, 2001:db8::1\r\nHost: a\r\n\r\n");
+    assert(n == 5);
+}
+
+void test_splice_disabled_is_one_span() {
+    std::string req = "GET / HTTP/1.1\r\n\r\n";
+    HeaderEditor e;
+    iovec iov[HeaderEditor::kMaxIov];
+    assert(e.parse(req.data(), req.size()));
+    assert(e.build(req.size(), iov) == 1);
+    assert(iov[0].iov_len == req.size());
+}
+
+void test_append_lines_for_h2() {
+    std::string head;
+    ForwardedSplicer::append_lines(head, "192.0.2.1", true, "10.0.0.1", true, "");
+    assert(head == "X-Forwarded-For: 10.0.0.1, 192.0.2.1\r\nForwarded: for=192.0.2.1\r\n");
+}
+
+int main() {
+    test_v1_tcp4();
+    test_v1_tcp6_and_unknown();
+    test_v1_incomplete_and_malformed();
+    test_v2_inet_with_tlvs();
+    test_v2_inet6_local_and_bad();
+    test_splice_new_headers();
+    test_splice_appends_to_existing();
+    test_splice_disabled_is_one_span();
+    test_append_lines_for_h2();
+
+    std::cout << "PROXY protocol tests PASSED\n";
+    return 0;
+}
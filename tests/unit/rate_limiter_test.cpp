@@ -0,0 +1,55 @@
+#include <cassert>
+#include <iostream>
+
+#include "admission/rate_limiter.h"
+
+/*
+ * Unit tests for RateLimiter token buckets.
+ * Time is injected; no clocks, no sockets.
+ */
+
+void test_burst_then_reject() {
+    RateLimiter rl(10, 3);
+
+    assert(rl.allow(1, 0));
+    assert(rl.allow(1, 0));
+    assert(rl.allow(1, 0));
+    assert(!rl.allow(1, 0));
+}
+
+void test_refill_over_time() {
+    RateLimiter rl(10, 1);
+
+    assert(rl.allow(7, 0));
+    assert(!rl.allow(7, 50000));     // 0.5 token after 50ms
+    assert(rl.allow(7, 100000));     // 1 token after 100ms
+    assert(!rl.allow(7, 100000));
+}
+
+void test_clients_independent() {
+    RateLimiter rl(1, 1);
+
+    assert(rl.allow(1, 0));
+    assert(!rl.allow(1, 0));
+    assert(rl.allow(2, 0));
+}
+
+void test_eviction_bounded_memory() {
+    RateLimiter rl(1, 1, 16);
+
+    for (uint32_t ip = 0; ip < 10000; ++ip) {
+        rl.allow(ip, ip);
+    }
+
+    assert(rl.evictions() > 0);
+}
+
+int main() {
+    test_burst_then_reject();
+    test_refill_over_time();
+    test_clients_independent();
+    test_eviction_bounded_memory();
+
+    std::cout << "Rate limiter tests PASSED\n";
+    return 0;
+}
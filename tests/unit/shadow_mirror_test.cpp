@@ -0,0 +1,204 @@
+#include <arpa/inet.h>
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <netinet/in.h>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+#include "connection/shadow_mirror.h"
+#include "core/event_loop/epoll_loop.h"
+
+/*
+ * Unit tests for ShadowMirror: sampling, caps, and full exchanges with
+ * a loopback shadow upstream (response framing, timeouts, failures).
+ */
+
+uint64_t now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Listening socket on an ephemeral loopback port
+int listen_any(uint16_t& port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    assert(fd >= 0);
+    sockaddr_in sa{};
+    sa.sin_family = AF_INET;
+    sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    assert(::bind(fd, reinterpret_cast<sockaddr*>(&sa), sizeof(sa)) == 0);
+    assert(::listen(fd, 16) == 0);
+    socklen_t len = sizeof(sa);
+    ::getsockname(fd, reinterpret_cast<sockaddr*>(&sa), &len);
+    port = ntohs(sa.sin_port);
+    return fd;
+}
+
+ProxyConfig mirror_config(uint16_t port) {
+    ProxyConfig cfg;
+    cfg.mirror_upstream.addr = htonl(INADDR_LOOPBACK);
+    cfg.mirror_upstream.port = port;
+    return cfg;
+}
+
+// Dispatch events until done() or the deadline
+template <typename Done>
+void run(EpollLoop& loop, ShadowMirror& mirror, Done done) {
+    uint64_t deadline = now_ms() + 5000;
+    while (!done() && now_ms() < deadline) {
+        loop.wait(50);
+        for (int i = 0; i < loop.ready_count(); ++i) {
+            const epoll_event& ev = loop.event_at(i);
+            auto* tag = static_cast<Connection::EpollTag*>(ev.data.ptr);
+            mirror.handle_event(tag->shadow, ev.events);
+        }
+        mirror.sweep();
+    }
+    assert(done());
+}
+
+void test_sampling() {
+    EpollLoop loop;
+    ShadowMirror mirror(loop);
+
+    int hits = 0;
+    for (int i = 0; i < 100; ++i)
+        hits += mirror.sample(25);
+    assert(hits == 25);
+
+    hits = 0;
+    for (int i = 0; i < 300; ++i)
+        hits += mirror.sample(33);
+    assert(hits == 99);
+
+    for (int i = 0; i < 10; ++i) {
+        assert(!mirror.sample(0));
+        assert(mirror.sample(100));
+    }
+
+    std::cout << "[OK] sampling is evenly spaced\n";
+}
+
+void test_round_trip() {
+    uint16_t port = 0;
+    int lfd = listen_any(port);
+
+    const std::string head = "GET /a HTTP/1.1\r\nHost: x\r\n";
+    const std::string tail = "X-Edited: 1\r\n\r\n";
+    std::string received;
+
+    // Answers in pieces (head split mid-line) and keeps the connection
+    // open: completion must come from the response framing
+    std::thread upstream([&] {
+        int fd = ::accept(lfd, nullptr, nullptr);
+        char buf[1024];
+        while (received.find("\r\n\r\n") == std::string::npos) {
+            ssize_t n = ::read(fd, buf, sizeof(buf));
+            assert(n > 0);
+            received.append(buf, n);
+        }
+        const char* parts[] = {"HTTP/1.1 200 OK\r\nContent-", "Length: 5\r\n\r\nhel", "lo"};
+        for (const char* p : parts) {
+            assert(::write(fd, p, std::strlen(p)) == static_cast<ssize_t>(std::strlen(p)));
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        ::close(fd);
+    });
+
+    EpollLoop loop;
+    ShadowMirror mirror(loop);
+    ProxyConfig cfg = mirror_config(port);
+
+    iovec iov[2];
+    iov[0].iov_base = const_cast<char*>(head.data());
+    iov[0].iov_len = head.size();
+    iov[1].iov_base = const_cast<char*>(tail.data());
+    iov[1].iov_len = tail.size();
+    assert(mirror.submit(cfg, iov, 2, now_ms()));
+    assert(mirror.inflight() == 1);
+    assert(mirror.payload_bytes() == head.size() + tail.size());
+
+    run(loop, mirror, [&] { return mirror.stats().completed == 1; });
+    assert(mirror.stats().responses[2] == 1);
+    assert(mirror.stats().failed == 0);
+    assert(mirror.inflight() == 0 && mirror.payload_bytes() == 0);
+
+    upstream.join();
+    assert(received == head + tail);
+    ::close(lfd);
+
+    std::cout << "[OK] request mirrored, response framed and discarded\n";
+}
+
+void test_caps() {
+    // Never accepted: the kernel completes the handshake, nobody reads
+    uint16_t port = 0;
+    int lfd = listen_any(port);
+
+    EpollLoop loop;
+    ShadowMirror mirror(loop);
+    ProxyConfig cfg = mirror_config(port);
+    cfg.mirror_max_inflight = 2;
+    cfg.mirror_max_bytes = 100;
+
+    std::string req(40, 'x');
+    iovec iov{const_cast<char*>(req.data()), req.size()};
+
+    assert(mirror.submit(cfg, &iov, 1, now_ms()));
+    assert(mirror.submit(cfg, &iov, 1, now_ms()));
+    assert(!mirror.submit(cfg, &iov, 1, now_ms()));
+    assert(mirror.stats().skipped_inflight == 1);
+
+    cfg.mirror_max_inflight = 8;
+    assert(!mirror.submit(cfg, &iov, 1, now_ms()));      // 80 + 40 > 100
+    assert(mirror.stats().skipped_bytes == 1);
+    assert(mirror.inflight() == 2 && mirror.stats().started == 2);
+
+    // Once written, a shadow no longer holds payload bytes
+    run(loop, mirror, [&] { return mirror.payload_bytes() == 0; });
+    assert(mirror.submit(cfg, &iov, 1, now_ms()));
+
+    // Unanswered shadows are aborted at their deadline
+    mirror.expire(now_ms() + cfg.mirror_timeout_ms);
+    assert(mirror.stats().timed_out == 3);
+    assert(mirror.inflight() == 0 && mirror.payload_bytes() == 0);
+    mirror.sweep();
+
+    ::close(lfd);
+
+    std::cout << "[OK] in-flight and byte caps, timeouts\n";
+}
+
+void test_refused() {
+    uint16_t port = 0;
+    ::close(listen_any(port));
+
+    EpollLoop loop;
+    ShadowMirror mirror(loop);
+    ProxyConfig cfg = mirror_config(port);
+
+    std::string req = "GET / HTTP/1.1\r\n\r\n";
+    iovec iov{const_cast<char*>(req.data()), req.size()};
+    mirror.submit(cfg, &iov, 1, now_ms());
+
+    run(loop, mirror, [&] { return mirror.stats().failed == 1; });
+    assert(mirror.inflight() == 0 && mirror.payload_bytes() == 0);
+    assert(mirror.stats().completed == 0);
+
+    std::cout << "[OK] refused shadow counted as failed\n";
+}
+
+int main() {
+    test_sampling();
+    test_round_trip();
+    test_caps();
+    test_refused();
+
+    std::cout << "Shadow mirror tests PASSED\n";
+    return 0;
+}
@@ -0,0 +1,230 @@
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <string>
+#include <sys/mman.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "stats/shm_stats.h"
+
+/*
+ * Unit tests for the shared-memory stats segment: layout, publish/read
+ * round trips, header validation and seqlock consistency under a
+ * concurrent writer.
+ */
+
+std::string shm_name(const char* tag) {
+    return std::string("/shm_stats_test_") + tag + "_" + std::to_string(::getpid());
+}
+
+ShmConnEntry entry(uint32_t id, uint64_t bytes) {
+    ShmConnEntry e{};
+    e.conn_id = id;
+    e.bytes_in = bytes;
+    e.bytes_out = bytes * 2;
+    e.fd = static_cast<int32_t>(id + 3);
+    return e;
+}
+
+void test_layout() {
+    assert(sizeof(ShmWorkerHead) % 64 == 0);
+    assert(shm_worker_bytes(0) % 64 == 0);
+    assert(shm_worker_bytes(3) % 64 == 0);
+    assert(shm_worker_bytes(3) >= sizeof(ShmWorkerHead) + 3 * sizeof(ShmConnEntry));
+    assert(shm_segment_bytes(2, 3) == kShmWorkersOffset + 2 * shm_worker_bytes(3));
+
+    std::cout << "[OK] segment layout\n";
+}
+
+void test_round_trip() {
+    std::string name = shm_name("rt");
+    ShmStatsWriter writer;
+    std::string err;
+    assert(writer.create(name, 2, 4, err));
+    assert(writer.conn_slots() == 4);
+
+    ShmStatsReader reader;
+    assert(reader.open(name, err));
+    assert(reader.workers() == 2);
+    assert(reader.header().conn_slots == 4);
+    assert(reader.header().pid == ::getpid());
+
+    // Nothing published yet
+    ShmCounters c{};
+    assert(!reader.read(0, c));
+
+    ShmCounters in{};
+    in.accepted = 10;
+    in.requests = 9;
+    in.responses[2] = 7;
+    in.responses[5] = 2;
+    in.bytes_in = 1000;
+    in.bytes_out = 5000;
+    in.tls_handshakes = 4;
+    in.tls_handshake_ns = 123456;
+    in.active = 3;
+    in.conns = 99;          // overwritten by publish
+    ShmConnEntry entries[] = {entry(1, 100), entry(2, 200)};
+    writer.publish(1, in, entries, 2);
+
+    std::vector<ShmConnEntry> out;
+    assert(reader.read(1, c, &out));
+    assert(c.accepted == 10 && c.requests == 9);
+    assert(c.responses[2] == 7 && c.responses[5] == 2);
+    assert(c.bytes_in == 1000 && c.bytes_out == 5000);
+    assert(c.tls_handshakes == 4 && c.tls_handshake_ns == 123456);
+    assert(c.active == 3);
+    assert(c.conns == 2);
+    assert(out.size() == 2);
+    assert(out[0].conn_id == 1 && out[1].bytes_out == 400 && out[1].fd == 5);
+
+    // Worker 0 untouched, out-of-range worker rejected
+    assert(!reader.read(0, c));
+    assert(!reader.read(2, c));
+
+    // A later publish with fewer entries shrinks the table
+    writer.publish(1, in, entries, 1);
+    assert(reader.read(1, c, &out));
+    assert(out.size() == 1 && c.conns == 1);
+
+    std::cout << "[OK] publish/read round trip\n";
+}
+
+void test_table_truncated() {
+    std::string name = shm_name("trunc");
+    ShmStatsWriter writer;
+    std::string err;
+    assert(writer.create(name, 1, 2, err));
+
+    ShmConnEntry entries[] = {entry(1, 1), entry(2, 2), entry(3, 3)};
+    writer.publish(0, ShmCounters{}, entries, 3);
+
+    ShmStatsReader reader;
+    assert(reader.open(name, err));
+    ShmCounters c{};
+    std::vector<ShmConnEntry> out;
+    assert(reader.read(0, c, &out));
+    assert(c.conns == 2 && out.size() == 2);
+    assert(out[1].conn_id == 2);
+
+    std::cout << "[OK] table truncated to conn_slots\n";
+}
+
+void test_reader_rejects() {
+    ShmStatsReader missing;
+    std::string err;
+    assert(!missing.open(shm_name("missing"), err));
+    assert(!err.empty());
+
+    // A segment of the right size but not written by ShmStatsWriter
+    std::string name = shm_name("bogus");
+    int fd = ::shm_open(name.c_str(), O_CREAT | O_RDWR, 0600);
+    assert(fd >= 0);
+    assert(::ftruncate(fd, shm_segment_bytes(1, 1)) == 0);
+    ::close(fd);
+
+    ShmStatsReader bogus;
+    err.clear();
+    assert(!bogus.open(name, err));
+    assert(err.find("not a stats segment") != std::string::npos);
+    ::shm_unlink(name.c_str());
+
+    std::cout << "[OK] reader rejects missing and foreign segments\n";
+}
+
+void test_unlinked_on_destroy() {
+    std::string name = shm_name("unlink");
+    std::string err;
+    {
+        ShmStatsWriter writer;
+        assert(writer.create(name, 1, 1, err));
+    }
+    ShmStatsReader reader;
+    assert(!reader.open(name, err));
+
+    // A stale segment of the same name is replaced
+    int fd = ::shm_open(name.c_str(), O_CREAT | O_RDWR, 0600);
+    assert(fd >= 0);
+    ::close(fd);
+    ShmStatsWriter writer;
+    assert(writer.create(name, 1, 1, err));
+    assert(reader.open(name, err));
+
+    // A replaced writer leaves its successor's segment alone
+    {
+        ShmStatsWriter old;
+        assert(old.create(name, 1, 1, err));
+        assert(writer.create(name, 1, 1, err));
+    }
+    ShmStatsReader after;
+    assert(after.open(name, err));
+
+    std::cout << "[OK] segment replaced on create, unlinked on destroy\n";
+}
+
+void test_concurrent_consistency() {
+    std::string name = shm_name("race");
+    ShmStatsWriter writer;
+    std::string err;
+    assert(writer.create(name, 1, 8, err));
+
+    ShmStatsReader reader;
+    assert(reader.open(name, err));
+
+    // Every publish writes the same value into every field; a torn read
+    // would show a mix
+    std::atomic<bool> stop{false};
+    std::thread t([&] {
+        ShmConnEntry entries[8];
+        for (uint64_t v = 1; !stop.load(std::memory_order_relaxed); ++v) {
+            ShmCounters c{};
+            c.accepted = c.requests = c.bytes_in = c.bytes_out = v;
+            for (ShmConnEntry& e : entries) {
+                e = entry(static_cast<uint32_t>(v), v);
+            }
+            writer.publish(0, c, entries, 1 + v % 8);
+        }
+    });
+
+    size_t ok = 0;
+    uint64_t last = 0;
+    std::vector<ShmConnEntry> out;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (ok < 20000 && std::chrono::steady_clock::now() < deadline) {
+        ShmCounters c{};
+        if (!reader.read(0, c, &out)) {
+            continue;
+        }
+        ++ok;
+        uint64_t v = c.accepted;
+        assert(c.requests == v && c.bytes_in == v && c.bytes_out == v);
+        assert(c.conns == 1 + v % 8 && out.size() == c.conns);
+        for (const ShmConnEntry& e : out) {
+            assert(e.conn_id == static_cast<uint32_t>(v) && e.bytes_in == v);
+        }
+        assert(v >= last);
+        last = v;
+    }
+    stop = true;
+    t.join();
+    assert(ok > 0);
+
+    std::cout << "[OK] concurrent reads are never torn\n";
+}
+
+int main() {
+    test_layout();
+    test_round_trip();
+    test_table_truncated();
+    test_reader_rejects();
+    test_unlinked_on_destroy();
+    test_concurrent_consistency();
+
+    std::cout << "Shared-memory stats tests PASSED\n";
+    return 0;
+}
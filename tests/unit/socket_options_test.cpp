@@ -0,0 +1,173 @@
+#include <arpa/inet.h>
+#include <cassert>
+#include <cerrno>
+#include <chrono>
+#include <iostream>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+#include "core/socket/socket.h"
+#include "core/socket/socket_options.h"
+
+/*
+ * Unit tests for SocketOptions and the Socket tuning helpers, over
+ * loopback connections.
+ */
+
+int get_int(int fd, int level, int name) {
+    int v = -1;
+    socklen_t len = sizeof(v);
+    assert(::getsockopt(fd, level, name, &v, &len) == 0);
+    return v;
+}
+
+int make_listener() {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    assert(fd >= 0);
+    sockaddr_in sa{};
+    sa.sin_family = AF_INET;
+    sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    assert(::bind(fd, reinterpret_cast<sockaddr*>(&sa), sizeof(sa)) == 0);
+    assert(::listen(fd, 16) == 0);
+    return fd;
+}
+
+// Connected pair: client end, accepted end
+void connect_pair(int lfd, int& client, int& accepted) {
+    sockaddr_in sa{};
+    socklen_t len = sizeof(sa);
+    assert(::getsockname(lfd, reinterpret_cast<sockaddr*>(&sa), &len) == 0);
+
+    client = ::socket(AF_INET, SOCK_STREAM, 0);
+    assert(client >= 0);
+    assert(::connect(client, reinterpret_cast<sockaddr*>(&sa), sizeof(sa)) == 0);
+    accepted = ::accept(lfd, nullptr, nullptr);
+    assert(accepted >= 0);
+}
+
+void test_accepted_sockets_inherit() {
+    SocketOptions o;
+    o.nodelay = true;
+    o.rcvbuf = 128 * 1024;
+    o.sndbuf = 128 * 1024;
+    o.notsent_lowat = 16384;
+    o.keepalive_idle_s = 30;
+    o.keepalive_interval_s = 5;
+    o.keepalive_count = 4;
+
+    int lfd = make_listener();
+    assert(o.apply(lfd));
+
+    int client, fd;
+    connect_pair(lfd, client, fd);
+
+    assert(get_int(fd, IPPROTO_TCP, TCP_NODELAY) == 1);
+    assert(get_int(fd, SOL_SOCKET, SO_RCVBUF) >= 128 * 1024);   // kernel doubles it
+    assert(get_int(fd, SOL_SOCKET, SO_SNDBUF) >= 128 * 1024);
+    assert(get_int(fd, IPPROTO_TCP, TCP_NOTSENT_LOWAT) == 16384);
+    assert(get_int(fd, SOL_SOCKET, SO_KEEPALIVE) == 1);
+    assert(get_int(fd, IPPROTO_TCP, TCP_KEEPIDLE) == 30);
+    assert(get_int(fd, IPPROTO_TCP, TCP_KEEPINTVL) == 5);
+    assert(get_int(fd, IPPROTO_TCP, TCP_KEEPCNT) == 4);
+
+    // Re-applying a profile with the flags off clears them
+    SocketOptions off;
+    assert(off.apply(fd));
+    assert(get_int(fd, IPPROTO_TCP, TCP_NODELAY) == 0);
+    assert(get_int(fd, SOL_SOCKET, SO_KEEPALIVE) == 0);
+
+    ::close(client);
+    ::close(fd);
+    ::close(lfd);
+}
+
+void test_apply_reports_failure() {
+    SocketOptions o;
+    assert(!o.apply(-1));
+
+    // Not a TCP socket: TCP_NODELAY is rejected
+    int fds[2];
+    assert(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    o.nodelay = true;
+    assert(!o.apply(fds[0]));
+    ::close(fds[0]);
+    ::close(fds[1]);
+}
+
+void test_cork_and_quickack() {
+    int lfd = make_listener();
+    int client, fd;
+    connect_pair(lfd, client, fd);
+
+    assert(Socket::set_cork(fd, true));
+    assert(get_int(fd, IPPROTO_TCP, TCP_CORK) == 1);
+    assert(Socket::set_cork(fd, false));
+    assert(get_int(fd, IPPROTO_TCP, TCP_CORK) == 0);
+
+    assert(Socket::set_quickack(fd));
+    assert(Socket::set_abort_on_close(fd));
+
+    ::close(client);
+    ::close(fd);
+    ::close(lfd);
+}
+
+void test_zerocopy_completions() {
+    int lfd = make_listener();
+    int client, fd;
+    connect_pair(lfd, client, fd);
+
+    // Nothing sent yet: an empty error queue is reported as such
+    uint32_t completed = 0;
+    bool copied = false;
+    assert(!Socket::reap_zerocopy(fd, completed, copied));
+
+    assert(Socket::set_zerocopy(fd));
+
+    std::thread reader([client] {
+        char buf[65536];
+        while (::read(client, buf, sizeof(buf)) > 0) {
+        }
+    });
+
+    static char payload[256 * 1024];
+    const int kSends = 4;
+    for (int i = 0; i < kSends; ++i) {
+        size_t off = 0;
+        while (off < sizeof(payload)) {
+            ssize_t n = Socket::send_zerocopy(fd, payload + off, sizeof(payload) - off);
+            assert(n > 0);
+            off += n;
+        }
+    }
+    ::shutdown(fd, SHUT_WR);
+    reader.join();
+
+    // Every send was numbered; partial sends count as sends too
+    for (int tries = 0; tries < 100 && completed < kSends; ++tries) {
+        Socket::reap_zerocopy(fd, completed, copied);
+        if (completed < kSends) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    assert(completed >= kSends);
+    assert(copied);             // loopback always copies
+
+    ::close(client);
+    ::close(fd);
+    ::close(lfd);
+}
+
+int main() {
+    test_accepted_sockets_inherit();
+    test_apply_reports_failure();
+    test_cork_and_quickack();
+    test_zerocopy_completions();
+
+    std::cout << "Socket options tests PASSED\n";
+    return 0;
+}
@@ -0,0 +1,196 @@
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+#include "trace/conn_trace.h"
+#include "trace/trace_format.h"
+#include "trace/trace_ring.h"
+#include "trace/trace_writer.h"
+
+/*
+ * Unit tests for connection lifecycle tracing: sampling, the SPSC ring,
+ * the export file round trip and the unsampled fast path.
+ */
+
+void test_sampler_every_nth() {
+    TraceSampler s;
+    int hits = 0;
+    for (int i = 0; i < 100; ++i) {
+        hits += s.sample(10) ? 1 : 0;
+    }
+    assert(hits == 10);
+
+    for (int i = 0; i < 10; ++i) {
+        assert(s.sample(1));
+        assert(!s.sample(0));
+    }
+}
+
+void test_unsampled_marks_nothing() {
+    ConnTrace t;
+    t.mark(TracePoint::ACCEPT);
+    t.mark(TracePoint::CLOSE);
+    for (int i = 0; i < kTracePoints; ++i) {
+        assert(t.ticks[i] == 0);
+    }
+}
+
+void test_sampled_keeps_first_occurrence() {
+    ConnTrace t;
+    t.sampled = true;
+    t.mark(TracePoint::ACCEPT);
+    t.mark(TracePoint::CLIENT_FIRST_WRITE);
+    uint64_t first = t.ticks[static_cast<int>(TracePoint::CLIENT_FIRST_WRITE)];
+    t.mark(TracePoint::CLIENT_FIRST_WRITE);
+
+    assert(t.ticks[static_cast<int>(TracePoint::ACCEPT)] != 0);
+    assert(first >= t.ticks[static_cast<int>(TracePoint::ACCEPT)]);
+    assert(t.ticks[static_cast<int>(TracePoint::CLIENT_FIRST_WRITE)] == first);
+    assert(t.ticks[static_cast<int>(TracePoint::TLS_DONE)] == 0);
+}
+
+void test_ring_full_drops() {
+    TraceRing ring(0, 3);
+    assert(ring.capacity() == 4);
+
+    ConnTrace t;
+    for (uint32_t i = 0; i < 4; ++i) {
+        t.conn_id = i;
+        assert(ring.push(t));
+    }
+    assert(!ring.push(t));
+    assert(ring.dropped() == 1);
+
+    TraceRing::Entry e;
+    for (uint32_t i = 0; i < 4; ++i) {
+        assert(ring.pop(e) && e.conn_id == i);
+    }
+    assert(!ring.pop(e));
+}
+
+void test_ring_cross_thread() {
+    TraceRing ring(0, 64);
+    const uint32_t kCount = 200000;
+
+    std::thread consumer([&ring] {
+        TraceRing::Entry e;
+        uint32_t expect = 0;
+        while (expect < kCount) {
+            if (!ring.pop(e)) {
+                std::this_thread::yield();
+                continue;
+            }
+            assert(e.conn_id == expect);
+            assert(e.ticks[0] == expect);
+            ++expect;
+        }
+    });
+
+    ConnTrace t;
+    for (uint32_t i = 0; i < kCount; ) {
+        t.conn_id = i;
+        t.ticks[0] = i;
+        if (ring.push(t)) {
+            ++i;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    consumer.join();
+}
+
+void test_export_round_trip() {
+    char path[] = "/tmp/trace_test_XXXXXX";
+    int fd = ::mkstemp(path);
+    assert(fd >= 0);
+    ::close(fd);
+    ::unlink(path);
+
+    {
+        TraceWriter writer(10);
+        std::string err;
+        assert(writer.open(path, err));
+        TraceRing* ring = writer.make_ring(7);
+        writer.start();
+
+        ConnTrace t;
+        t.sampled = true;
+        t.conn_id = 42;
+        t.mark(TracePoint::ACCEPT);
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        t.mark(TracePoint::REQUEST_HEADERS);
+        t.mark(TracePoint::CLOSE);
+        assert(ring->push(t));
+
+        writer.stop();
+        assert(writer.written() == 1);
+    }
+
+    FILE* f = std::fopen(path, "rb");
+    assert(f);
+    TraceFileReader reader(f);
+    assert(reader.read_header());
+
+    TraceFileRecord rec;
+    assert(reader.next(rec));
+    assert(rec.worker == 7 && rec.conn_id == 42);
+    assert(rec.since_accept_us[static_cast<int>(TracePoint::ACCEPT)] == 0);
+    assert(rec.since_accept_us[static_cast<int>(TracePoint::TLS_DONE)] == kTraceUnset);
+
+    uint32_t headers = rec.since_accept_us[static_cast<int>(TracePoint::REQUEST_HEADERS)];
+    assert(headers >= 1000 && headers < 1000000);
+    assert(rec.since_accept_us[static_cast<int>(TracePoint::CLOSE)] >= headers);
+
+    // Wall clock of accept is "now-ish"
+    uint64_t now_us = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    assert(rec.accept_unix_us <= now_us && rec.accept_unix_us + 10000000 > now_us);
+
+    assert(!reader.next(rec));
+    std::fclose(f);
+    ::unlink(path);
+}
+
+void test_unsampled_overhead() {
+    // Eight marks per request, as a request goes through the proxy
+    const int kRequests = 1000000;
+    ConnTrace t;
+    TraceSampler sampler;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kRequests; ++i) {
+        t.sampled = sampler.sample(0);
+        for (int p = 0; p < kTracePoints; ++p) {
+            t.mark(static_cast<TracePoint>(p));
+        }
+        asm volatile("" : : "r"(&t) : "memory");
+    }
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+
+    // Timing is reported, not asserted: it depends on the machine
+    double per_request = static_cast<double>(ns) / kRequests;
+    std::cout << "unsampled tracing: " << per_request << " ns/request\n";
+
+    assert(!t.sampled);
+    for (int p = 0; p < kTracePoints; ++p) {
+        assert(t.ticks[p] == 0);
+    }
+}
+
+int main() {
+    test_sampler_every_nth();
+    test_unsampled_marks_nothing();
+    test_sampled_keeps_first_occurrence();
+    test_ring_full_drops();
+    test_ring_cross_thread();
+    test_export_round_trip();
+    test_unsampled_overhead();
+
+    std::cout << "Trace tests PASSED\n";
+    return 0;
+}
@@ -0,0 +1,87 @@
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "core/executor/work_stealing_pool.h"
+
+/*
+ * Unit tests for WorkStealingPool.
+ * Real threads; every wait is bounded so a bug fails instead of hanging.
+ */
+
+static bool wait_until(const std::function<bool()>& cond) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!cond()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+void test_runs_every_task() {
+    WorkStealingPool pool(4);
+    std::atomic<int> sum{0};
+
+    for (int i = 1; i <= 1000; ++i) {
+        while (!pool.submit([&sum, i] { sum.fetch_add(i); })) {
+            std::this_thread::yield();
+        }
+    }
+
+    assert(wait_until([&] { return sum.load() == 500500; }));
+    assert(wait_until([&] { return pool.executed() == 1000; }));
+}
+
+void test_idle_workers_steal() {
+    WorkStealingPool pool(4);
+    std::atomic<int> done{0};
+
+    // One task fans out onto its own worker's deque; the others must steal
+    pool.submit([&pool, &done] {
+        for (int i = 0; i < 64; ++i) {
+            pool.submit([&done] {
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                done.fetch_add(1);
+            });
+        }
+    });
+
+    assert(wait_until([&] { return done.load() == 64; }));
+    assert(pool.steals() > 0);
+}
+
+void test_bounded_queue_rejects() {
+    WorkStealingPool pool(1, 2);
+    std::atomic<bool> release{false};
+    std::atomic<bool> started{false};
+
+    pool.submit([&] {
+        started = true;
+        while (!release) {
+            std::this_thread::yield();
+        }
+    });
+    assert(wait_until([&] { return started.load(); }));
+
+    assert(pool.submit([] {}));
+    assert(pool.submit([] {}));
+    assert(!pool.submit([] {}));
+
+    release = true;
+    assert(wait_until([&] { return pool.executed() == 3; }));
+}
+
+int main() {
+    test_runs_every_task();
+    test_idle_workers_steal();
+    test_bounded_queue_rejects();
+
+    std::cout << "Work-stealing pool tests PASSED\n";
+    return 0;
+}
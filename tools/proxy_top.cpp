@@ -0,0 +1,243 @@
+#include <algorithm>
+#include <arpa/inet.h>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <vector>
+
+#include "connection/connection_state.h"
+#include "stats/shm_stats.h"
+
+/*
+ * Usage: proxy_top <shm_name> [interval_ms] [--once]
+ *
+ * Maps the proxy's stats segment (config key stats_shm) read-only and
+ * redraws every interval (default 1000 ms): per-worker rates since the
+ * previous refresh, totals, and the busiest open connections.
+ *
+ * --once prints cumulative counters and the table a single time, with
+ * no screen control, for scripts.
+ */
+static const size_t kTopConnections = 20;
+
+struct Sample {
+    ShmCounters c{};
+    bool ok = false;
+};
+
+static std::string human_bytes(double v) {
+    static const char* const kUnits[] = {"B", "K", "M", "G", "T"};
+    int u = 0;
+    while (v >= 1024 && u < 4) {
+        v /= 1024;
+        ++u;
+    }
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), u == 0 ? "%.0f%s" : "%.1f%s", v, kUnits[u]);
+    return buf;
+}
+
+static std::string address(uint8_t family, const void* addr) {
+    char buf[INET6_ADDRSTRLEN] = "-";
+    if (family == AF_INET || family == AF_INET6)
+        inet_ntop(family, addr, buf, sizeof(buf));
+    return buf;
+}
+
+// TLS handshake work, on its own line; nothing for plain-only workers
+static void print_tls_counters(const ShmCounters& c) {
+    uint64_t attempts = c.tls_handshakes + c.tls_handshake_failures;
+    if (attempts == 0)
+        return;
+    std::printf("%-8s tls handshakes=%llu failures=%llu resumed=%llu avg_us=%.1f "
+                "ktls_tx=%llu ktls_rx=%llu\n",
+                "",
+                static_cast<unsigned long long>(c.tls_handshakes),
+                static_cast<unsigned long long>(c.tls_handshake_failures),
+                static_cast<unsigned long long>(c.tls_resumed),
+                c.tls_handshake_ns / 1000.0 / attempts,
+                static_cast<unsigned long long>(c.tls_ktls_tx),
+                static_cast<unsigned long long>(c.tls_ktls_rx));
+}
+
+static void print_tls_rates(const ShmCounters& now, const ShmCounters& prev, double secs) {
+    if (now.tls_handshakes + now.tls_handshake_failures == 0)
+        return;
+    auto rate = [secs](uint64_t a, uint64_t b) { return (a - b) / secs; };
+    uint64_t done = now.tls_handshakes - prev.tls_handshakes;
+    uint64_t resumed = now.tls_resumed - prev.tls_resumed;
+    std::printf("%-8s tls hs/s=%-8.1f fail/s=%-6.1f resumed=%3.0f%% handshake_cpu_ms/s=%.1f\n",
+                "",
+                rate(now.tls_handshakes, prev.tls_handshakes),
+                rate(now.tls_handshake_failures, prev.tls_handshake_failures),
+                done ? 100.0 * resumed / done : 0.0,
+                rate(now.tls_handshake_ns, prev.tls_handshake_ns) / 1e6);
+}
+
+static void print_counters(const char* name, const ShmCounters& c) {
+    std::printf("%-8s active=%u tunnels=%u accepted=%llu requests=%llu "
+                "2xx=%llu 4xx=%llu 5xx=%llu in=%s out=%s%s\n",
+                name, c.active, c.tunnels,
+                static_cast<unsigned long long>(c.accepted),
+                static_cast<unsigned long long>(c.requests),
+                static_cast<unsigned long long>(c.responses[2]),
+                static_cast<unsigned long long>(c.responses[4]),
+                static_cast<unsigned long long>(c.responses[5]),
+                human_bytes(static_cast<double>(c.bytes_in)).c_str(),
+                human_bytes(static_cast<double>(c.bytes_out)).c_str(),
+                c.draining ? " DRAINING" : "");
+    print_tls_counters(c);
+}
+
+static void print_rates(const char* name, const ShmCounters& now, const ShmCounters& prev) {
+    double secs = (now.updated_unix_ms - prev.updated_unix_ms) / 1000.0;
+    if (secs <= 0) {
+        std::printf("%-8s active=%u tunnels=%u (no new sample)\n", name, now.active, now.tunnels);
+        return;
+    }
+    auto rate = [secs](uint64_t a, uint64_t b) { return (a - b) / secs; };
+    std::printf("%-8s active=%-6u tunnels=%-4u conn/s=%-8.1f req/s=%-8.1f "
+                "5xx/s=%-6.1f in=%s/s out=%s/s%s\n",
+                name, now.active, now.tunnels,
+                rate(now.accepted, prev.accepted),
+                rate(now.requests, prev.requests),
+                rate(now.responses[5], prev.responses[5]),
+                human_bytes(rate(now.bytes_in, prev.bytes_in)).c_str(),
+                human_bytes(rate(now.bytes_out, prev.bytes_out)).c_str(),
+                now.draining ? " DRAINING" : "");
+    print_tls_rates(now, prev, secs);
+}
+
+static void print_table(std::vector<ShmConnEntry>& conns) {
+    std::sort(conns.begin(), conns.end(), [](const ShmConnEntry& a, const ShmConnEntry& b) {
+        return a.bytes_in + a.bytes_out > b.bytes_in + b.bytes_out;
+    });
+
+    std::printf("\n%-8s %-6s %-20s %9s %8s %8s  %-22s %s\n",
+                "CONN", "FD", "STATE", "AGE_MS", "IN", "OUT", "CLIENT", "UPSTREAM");
+    for (size_t i = 0; i < conns.size() && i < kTopConnections; ++i) {
+        const ShmConnEntry& e = conns[i];
+        std::string upstream = "-";
+        if (e.upstream_addr != 0) {
+            upstream = address(AF_INET, &e.upstream_addr) + ":" + std::to_string(e.upstream_port);
+        }
+        std::printf("%-8u %-6d %-20s %9u %8s %8s  %-22s %s\n",
+                    e.conn_id, e.fd, to_string(static_cast<ConnectionState>(e.state)), e.age_ms,
+                    human_bytes(static_cast<double>(e.bytes_in)).c_str(),
+                    human_bytes(static_cast<double>(e.bytes_out)).c_str(),
+                    address(e.family, e.client).c_str(), upstream.c_str());
+    }
+    if (conns.size() > kTopConnections)
+        std::printf("... %zu more\n", conns.size() - kTopConnections);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "usage: proxy_top <shm_name> [interval_ms] [--once]\n";
+        return 2;
+    }
+    std::string name = argv[1];
+    unsigned interval_ms = 1000;
+    bool once = false;
+    for (int i = 2; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--once") == 0)
+            once = true;
+        else
+            interval_ms = std::max(100, std::atoi(argv[i]));
+    }
+
+    ShmStatsReader reader;
+    std::string err;
+    if (!reader.open(name, err)) {
+        std::cerr << err << "\n";
+        return 1;
+    }
+
+    const ShmHeader& h = reader.header();
+    std::vector<Sample> prev(h.workers);
+    std::vector<ShmConnEntry> conns;
+    std::vector<ShmConnEntry> worker_conns;
+
+    while (true) {
+        std::vector<Sample> cur(h.workers);
+        ShmCounters total{};
+        ShmCounters prev_total{};
+        bool have_prev = true;
+        conns.clear();
+
+        for (uint32_t w = 0; w < h.workers; ++w) {
+            cur[w].ok = reader.read(w, cur[w].c, &worker_conns);
+            if (!cur[w].ok)
+                continue;
+            conns.insert(conns.end(), worker_conns.begin(), worker_conns.end());
+
+            const ShmCounters& c = cur[w].c;
+            total.updated_unix_ms = std::max(total.updated_unix_ms, c.updated_unix_ms);
+            total.accepted += c.accepted;
+            total.requests += c.requests;
+            for (int i = 0; i < 6; ++i)
+                total.responses[i] += c.responses[i];
+            total.bytes_in += c.bytes_in;
+            total.bytes_out += c.bytes_out;
+            total.tls_handshakes += c.tls_handshakes;
+            total.tls_handshake_failures += c.tls_handshake_failures;
+            total.tls_resumed += c.tls_resumed;
+            total.tls_handshake_ns += c.tls_handshake_ns;
+            total.tls_ktls_tx += c.tls_ktls_tx;
+            total.tls_ktls_rx += c.tls_ktls_rx;
+            total.active += c.active;
+            total.tunnels += c.tunnels;
+            total.draining |= c.draining;
+
+            const ShmCounters& p = prev[w].c;
+            have_prev = have_prev && prev[w].ok;
+            prev_total.updated_unix_ms = std::max(prev_total.updated_unix_ms, p.updated_unix_ms);
+            prev_total.accepted += p.accepted;
+            prev_total.requests += p.requests;
+            for (int i = 0; i < 6; ++i)
+                prev_total.responses[i] += p.responses[i];
+            prev_total.bytes_in += p.bytes_in;
+            prev_total.bytes_out += p.bytes_out;
+            prev_total.tls_handshakes += p.tls_handshakes;
+            prev_total.tls_handshake_failures += p.tls_handshake_failures;
+            prev_total.tls_resumed += p.tls_resumed;
+            prev_total.tls_handshake_ns += p.tls_handshake_ns;
+            prev_total.tls_ktls_tx += p.tls_ktls_tx;
+            prev_total.tls_ktls_rx += p.tls_ktls_rx;
+        }
+
+        if (!once)
+            std::printf("\x1b[H\x1b[2J");
+        std::printf("pid %d, %u worker(s), up %llus\n\n", h.pid, h.workers,
+                    static_cast<unsigned long long>(
+                        (total.updated_unix_ms - std::min(total.updated_unix_ms, h.started_unix_ms)) / 1000));
+
+        for (uint32_t w = 0; w < h.workers; ++w) {
+            char label[24];       // "worker" + up to 10 digits
+            std::snprintf(label, sizeof(label), "worker%u", w);
+            if (!cur[w].ok)
+                std::printf("%-8s (no data)\n", label);
+            else if (once || !prev[w].ok)
+                print_counters(label, cur[w].c);
+            else
+                print_rates(label, cur[w].c, prev[w].c);
+        }
+        if (h.workers > 1) {
+            if (once || !have_prev)
+                print_counters("total", total);
+            else
+                print_rates("total", total, prev_total);
+        }
+        print_table(conns);
+        std::fflush(stdout);
+
+        if (once)
+            return 0;
+        prev = cur;
+        std::this_thread::sleep_for(std::chrono::milliseconds(interval_ms));
+    }
+}
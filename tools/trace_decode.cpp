@@ -0,0 +1,87 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "trace/trace_format.h"
+
+/*
+ * Usage: trace_decode <trace_file> [--summary]
+ *
+ * Prints one line per traced connection: accept time (unix us), worker,
+ * connection id, then each lifecycle point as microseconds since accept
+ * ("-" when the connection never reached it).
+ *
+ * --summary prints only per-point latency percentiles instead.
+ */
+static uint32_t percentile(std::vector<uint32_t>& v, double p) {
+    size_t i = static_cast<size_t>(p * static_cast<double>(v.size() - 1));
+    std::nth_element(v.begin(), v.begin() + i, v.end());
+    return v[i];
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "usage: trace_decode <trace_file> [--summary]\n";
+        return 2;
+    }
+    bool summary = argc > 2 && std::strcmp(argv[2], "--summary") == 0;
+
+    FILE* f = std::fopen(argv[1], "rb");
+    if (!f) {
+        std::perror(argv[1]);
+        return 1;
+    }
+
+    TraceFileReader reader(f);
+    if (!reader.read_header()) {
+        std::cerr << argv[1] << ": not a trace file (or incompatible version)\n";
+        std::fclose(f);
+        return 1;
+    }
+
+    std::vector<std::vector<uint32_t>> samples(kTracePoints);
+    size_t records = 0;
+    TraceFileRecord rec;
+
+    while (reader.next(rec)) {
+        ++records;
+
+        if (summary) {
+            for (int p = 1; p < kTracePoints; ++p) {
+                if (rec.since_accept_us[p] != kTraceUnset)
+                    samples[p].push_back(rec.since_accept_us[p]);
+            }
+            continue;
+        }
+
+        std::cout << rec.accept_unix_us << " worker=" << rec.worker
+                  << " conn=" << rec.conn_id;
+        for (int p = 1; p < kTracePoints; ++p) {
+            std::cout << " " << trace_point_name(p) << "=";
+            if (rec.since_accept_us[p] == kTraceUnset)
+                std::cout << "-";
+            else
+                std::cout << rec.since_accept_us[p];
+        }
+        std::cout << "\n";
+    }
+    std::fclose(f);
+
+    if (summary) {
+        std::cout << records << " connection(s); us since accept\n";
+        std::printf("%-14s %8s %10s %10s %10s %10s\n",
+                    "point", "count", "p50", "p90", "p99", "max");
+        for (int p = 1; p < kTracePoints; ++p) {
+            std::vector<uint32_t>& v = samples[p];
+            if (v.empty())
+                continue;
+            uint32_t mx = *std::max_element(v.begin(), v.end());
+            std::printf("%-14s %8zu %10u %10u %10u %10u\n",
+                        trace_point_name(p), v.size(), percentile(v, 0.5),
+                        percentile(v, 0.9), percentile(v, 0.99), mx);
+        }
+    }
+    return 0;
+}